@@ -0,0 +1,61 @@
+#ifndef AGPTRACER_ACCELERATIONSTRUCTURES_BVHBUILDER_T_HPP
+#define AGPTRACER_ACCELERATIONSTRUCTURES_BVHBUILDER_T_HPP
+
+#include "acceleration_structures/BVHNode_t.hpp"
+#include "entities/Vec3.hpp"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace AGPTracer::AccelerationStructures {
+    /**
+     * @brief The BVH builder class builds a bounding volume hierarchy on the host, using the binned surface area heuristic.
+     *
+     * The builder only works with bounding boxes, so it can be used for any object that can provide its minimum and maximum
+     * coordinates. At each node, the centroids of the boxes are sorted into bins along the three axes, and the split minimising
+     * the surface area heuristic is chosen. Nodes are stored in a flat array, with the two children of a node next to each other.
+     * The leaves point to ranges of the indices_ array, which contains the indices of the input boxes.
+     *
+     * @tparam T Floating point datatype to use
+     */
+    template<typename T = double>
+    class BVHBuilder_t {
+        public:
+            /**
+             * @brief Construct a new BVHBuilder_t object, building a hierarchy around the given bounding boxes.
+             *
+             * @param mins Minimum coordinates of the bounding boxes to sort.
+             * @param maxs Maximum coordinates of the bounding boxes to sort.
+             * @param max_leaf_size Maximum number of boxes in a leaf. Leaves with fewer boxes will be created if it is cheaper according to the surface area heuristic.
+             */
+            BVHBuilder_t(std::span<const Entities::Vec3<T>> mins, std::span<const Entities::Vec3<T>> maxs, uint32_t max_leaf_size = 4);
+
+            std::vector<BVHNode_t<T>> nodes_; /**< @brief Flattened nodes of the hierarchy. The root is the first node.*/
+            std::vector<uint32_t> indices_; /**< @brief Indices of the input boxes, in the order referenced by the leaves.*/
+
+        private:
+            /**
+             * @brief Finds the best split of a range of boxes according to the binned surface area heuristic.
+             *
+             * @param mins Minimum coordinates of the bounding boxes.
+             * @param maxs Maximum coordinates of the bounding boxes.
+             * @param node Node containing the range, with its bounding box already computed.
+             * @param begin Index of the first box of the range in indices_.
+             * @param end Index past the last box of the range in indices_.
+             * @param[out] axis Axis of the best split.
+             * @param[out] position Centroid coordinate along the axis separating the two children.
+             * @return T Cost of the best split, relative to the cost of intersecting a single box. Infinite if the range can't be split.
+             */
+            auto find_split(std::span<const Entities::Vec3<T>> mins,
+                            std::span<const Entities::Vec3<T>> maxs,
+                            const BVHNode_t<T>& node,
+                            uint32_t begin,
+                            uint32_t end,
+                            unsigned int& axis,
+                            T& position) const -> T;
+    };
+}
+
+#include "acceleration_structures/BVHBuilder_t.tpp"
+
+#endif
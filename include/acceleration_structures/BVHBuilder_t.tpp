@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <limits>
+#include <numeric>
+
+template<typename T>
+AGPTracer::AccelerationStructures::BVHBuilder_t<T>::BVHBuilder_t(std::span<const Entities::Vec3<T>> mins, std::span<const Entities::Vec3<T>> maxs, uint32_t max_leaf_size) :
+        indices_(mins.size()) {
+    struct BuildTask {
+            uint32_t node;
+            uint32_t begin;
+            uint32_t end;
+            uint32_t depth;
+    };
+
+    std::iota(indices_.begin(), indices_.end(), uint32_t{0});
+    nodes_.reserve(2 * std::max(mins.size(), size_t{1}));
+    nodes_.emplace_back();
+
+    if (mins.empty()) {
+        return;
+    }
+
+    std::vector<BuildTask> tasks{
+        {0, 0, static_cast<uint32_t>(mins.size()), 0}
+    };
+
+    while (!tasks.empty()) {
+        const BuildTask task = tasks.back();
+        tasks.pop_back();
+
+        BVHNode_t<T> node;
+        for (uint32_t i = task.begin; i < task.end; ++i) {
+            node.min_.min(mins[indices_[i]]);
+            node.max_.max(maxs[indices_[i]]);
+        }
+
+        const uint32_t count = task.end - task.begin;
+        uint32_t middle      = task.begin + count / 2;
+
+        if (count > 1) {
+            unsigned int axis = 0;
+            T position{};
+            const T split_cost = find_split(mins, maxs, node, task.begin, task.end, axis, position);
+
+            // Splitting in the middle at every level reaches leaves of one box after bit_width(count - 1) levels. Once the depth
+            // leaves just that many levels, nodes are split in the middle, so that no leaf is deeper than max_depth_.
+            const bool depth_limited = task.depth + static_cast<uint32_t>(std::bit_width(count - 1)) >= BVHNode_t<T>::max_depth_;
+
+            if ((split_cost < static_cast<T>(count)) || (count > max_leaf_size)) {
+                bool median_split = (split_cost == std::numeric_limits<T>::infinity()) || depth_limited;
+
+                if (!median_split) {
+                    const auto split = std::partition(indices_.begin() + task.begin, indices_.begin() + task.end, [&](uint32_t index) {
+                        return (mins[index][axis] + maxs[index][axis]) / T{2} < position;
+                    });
+                    middle           = static_cast<uint32_t>(split - indices_.begin());
+                    median_split     = (middle == task.begin) || (middle == task.end);
+                }
+
+                if (median_split) {
+                    // Splits along the longest axis of the centroids, in the middle of the range
+                    Entities::Vec3<T> centroid_min(std::numeric_limits<T>::max());
+                    Entities::Vec3<T> centroid_max(std::numeric_limits<T>::lowest());
+                    for (uint32_t i = task.begin; i < task.end; ++i) {
+                        const Entities::Vec3<T> centroid = (mins[indices_[i]] + maxs[indices_[i]]) / T{2};
+                        centroid_min.min(centroid);
+                        centroid_max.max(centroid);
+                    }
+                    const Entities::Vec3<T> extent = centroid_max - centroid_min;
+                    axis                           = (extent[0] > extent[1]) ? ((extent[0] > extent[2]) ? 0 : 2) : ((extent[1] > extent[2]) ? 1 : 2);
+                    middle                         = task.begin + count / 2;
+
+                    std::nth_element(indices_.begin() + task.begin, indices_.begin() + middle, indices_.begin() + task.end, [&](uint32_t index_a, uint32_t index_b) {
+                        return mins[index_a][axis] + maxs[index_a][axis] < mins[index_b][axis] + maxs[index_b][axis];
+                    });
+                }
+
+                const auto first = static_cast<uint32_t>(nodes_.size());
+                nodes_.emplace_back();
+                nodes_.emplace_back();
+                nodes_[task.node] = BVHNode_t<T>(node.min_, node.max_, first, 0);
+
+                tasks.push_back({first + 1, middle, task.end, task.depth + 1});
+                tasks.push_back({first, task.begin, middle, task.depth + 1});
+                continue;
+            }
+        }
+
+        nodes_[task.node] = BVHNode_t<T>(node.min_, node.max_, task.begin, count);
+    }
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::BVHBuilder_t<T>::find_split(std::span<const Entities::Vec3<T>> mins,
+                                                                   std::span<const Entities::Vec3<T>> maxs,
+                                                                   const BVHNode_t<T>& node,
+                                                                   uint32_t begin,
+                                                                   uint32_t end,
+                                                                   unsigned int& axis,
+                                                                   T& position) const -> T {
+    constexpr size_t n_bins     = 16;
+    constexpr T traversal_cost  = 1; // Relative to the cost of intersecting a shape
+    T best_cost                 = std::numeric_limits<T>::infinity();
+    const T parent_surface_area = node.surface_area();
+
+    Entities::Vec3<T> centroid_min(std::numeric_limits<T>::max());
+    Entities::Vec3<T> centroid_max(std::numeric_limits<T>::lowest());
+    for (uint32_t i = begin; i < end; ++i) {
+        const Entities::Vec3<T> centroid = (mins[indices_[i]] + maxs[indices_[i]]) / T{2};
+        centroid_min.min(centroid);
+        centroid_max.max(centroid);
+    }
+
+    if (parent_surface_area <= T{0}) {
+        return best_cost;
+    }
+
+    for (unsigned int current_axis = 0; current_axis < 3; ++current_axis) {
+        const T extent = centroid_max[current_axis] - centroid_min[current_axis];
+        if (extent <= T{0}) {
+            continue;
+        }
+        const T scale = static_cast<T>(n_bins) / extent;
+
+        std::array<BVHNode_t<T>, n_bins> bins{};
+        std::array<uint32_t, n_bins> bin_counts{};
+        for (uint32_t i = begin; i < end; ++i) {
+            const uint32_t index = indices_[i];
+            const T centroid     = (mins[index][current_axis] + maxs[index][current_axis]) / T{2};
+            const auto bin       = std::min(static_cast<size_t>((centroid - centroid_min[current_axis]) * scale), n_bins - 1);
+            ++bin_counts[bin];
+            bins[bin].min_.min(mins[index]);
+            bins[bin].max_.max(maxs[index]);
+        }
+
+        // Sweeps from the right to get the cost of the right side of every split
+        std::array<T, n_bins - 1> right_costs{};
+        BVHNode_t<T> right_box;
+        uint32_t right_count = 0;
+        for (size_t bin = n_bins - 1; bin > 0; --bin) {
+            right_box.min_.min(bins[bin].min_);
+            right_box.max_.max(bins[bin].max_);
+            right_count += bin_counts[bin];
+            right_costs[bin - 1] = right_box.surface_area() * static_cast<T>(right_count);
+        }
+
+        BVHNode_t<T> left_box;
+        uint32_t left_count = 0;
+        for (size_t bin = 0; bin < n_bins - 1; ++bin) {
+            left_box.min_.min(bins[bin].min_);
+            left_box.max_.max(bins[bin].max_);
+            left_count += bin_counts[bin];
+
+            if ((left_count == 0) || (left_count == end - begin)) {
+                continue;
+            }
+
+            const T cost = traversal_cost + (left_box.surface_area() * static_cast<T>(left_count) + right_costs[bin]) / parent_surface_area;
+            if (cost < best_cost) {
+                best_cost = cost;
+                axis      = current_axis;
+                position  = centroid_min[current_axis] + static_cast<T>(bin + 1) / scale;
+            }
+        }
+    }
+
+    return best_cost;
+}
@@ -0,0 +1,126 @@
+#ifndef AGPTRACER_ACCELERATIONSTRUCTURES_BVHCACHE_T_HPP
+#define AGPTRACER_ACCELERATIONSTRUCTURES_BVHCACHE_T_HPP
+
+#include "acceleration_structures/BVHNode_t.hpp"
+#include "entities/Vec3.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+namespace AGPTracer::AccelerationStructures {
+    /**
+     * @brief The BVH cache class stores hierarchies built on the host in a directory, so that they don't have to be built again on the next run.
+     *
+     * Hierarchies are keyed by a hash of the bounding boxes of their shapes, which is all the host builder uses. Each hierarchy is
+     * a binary file holding a small header, the flattened nodes and the shape indices, written as they are in memory. On the next
+     * run with the same shapes, the file is memory-mapped and the nodes and indices are copied straight to the device buffers, so
+     * loading a scene costs the time to read the file. Files are only valid on machines with the same floating point datatype and
+     * byte order, and are rebuilt otherwise.
+     *
+     * @tparam T Floating point datatype to use
+     */
+    template<typename T = double>
+    class BVHCache_t {
+        public:
+            /**
+             * @brief A hierarchy loaded from the cache. The file is mapped as long as the entry exists.
+             */
+            class Entry_t {
+                public:
+                    /**
+                     * @brief Construct a new Entry_t object by mapping the cache file of a key.
+                     *
+                     * If the file doesn't exist, or if it isn't a valid hierarchy for this key, the entry is empty.
+                     *
+                     * @param path Path of the cache file.
+                     * @param key Hash of the shapes the hierarchy must have been built with.
+                     */
+                    Entry_t(const std::filesystem::path& path, uint64_t key);
+
+                    /**
+                     * @brief Destroy the Entry_t object, unmapping the file.
+                     */
+                    ~Entry_t();
+
+                    Entry_t(const Entry_t&)                    = delete;
+                    Entry_t(Entry_t&&)                         = delete;
+                    auto operator=(const Entry_t&) -> Entry_t& = delete;
+                    auto operator=(Entry_t&&) -> Entry_t&      = delete;
+
+                    std::span<const BVHNode_t<T>> nodes_; /**< @brief Flattened nodes of the hierarchy, in the mapped file. Empty if the entry is empty.*/
+                    std::span<const uint32_t> indices_; /**< @brief Indices of the shapes, in the mapped file.*/
+
+                    /**
+                     * @brief Returns whether a valid hierarchy was loaded.
+                     *
+                     * @return true The file was found and matches the key, the nodes and indices can be used.
+                     * @return false The hierarchy has to be built.
+                     */
+                    auto valid() const -> bool;
+
+                private:
+                    std::byte* data_; /**< @brief Start of the mapped file.*/
+                    size_t size_; /**< @brief Size of the mapped file.*/
+                    std::vector<std::byte> buffer_; /**< @brief Content of the file, on systems where it is read instead of mapped.*/
+            };
+
+            /**
+             * @brief Construct a new BVHCache_t object storing its files in a directory.
+             *
+             * @param directory Directory in which the cache files are read and written. It is created when the first file is written.
+             */
+            explicit BVHCache_t(std::filesystem::path directory);
+
+            std::filesystem::path directory_; /**< @brief Directory in which the cache files are read and written.*/
+
+            /**
+             * @brief Computes the key of a set of shapes, a 64 bit FNV-1a hash of their bounding boxes.
+             *
+             * @param mins Minimum coordinates of the bounding boxes of the shapes.
+             * @param maxs Maximum coordinates of the bounding boxes of the shapes.
+             * @return uint64_t Key of the hierarchy of the shapes.
+             */
+            static auto hash(std::span<const Entities::Vec3<T>> mins, std::span<const Entities::Vec3<T>> maxs) -> uint64_t;
+
+            /**
+             * @brief Returns the path of the cache file of a key.
+             *
+             * @param key Key of the hierarchy.
+             * @return std::filesystem::path Path of the cache file, which may not exist.
+             */
+            auto path(uint64_t key) const -> std::filesystem::path;
+
+            /**
+             * @brief Writes a hierarchy to the cache file of a key.
+             *
+             * The file is written under a temporary name and renamed, so that other processes never map a partial file.
+             *
+             * @param key Key of the hierarchy.
+             * @param nodes Flattened nodes of the hierarchy.
+             * @param indices Indices of the shapes, in the order referenced by the leaves.
+             * @return true The file was written.
+             * @return false The file could not be written, the hierarchy will be built again on the next run.
+             */
+            auto save(uint64_t key, std::span<const BVHNode_t<T>> nodes, std::span<const uint32_t> indices) const -> bool;
+
+        private:
+            /**
+             * @brief Header at the start of each cache file.
+             */
+            struct Header_t {
+                    uint64_t magic_; /**< @brief Identifies the file format and its version.*/
+                    uint64_t key_; /**< @brief Hash of the shapes the hierarchy was built with.*/
+                    uint64_t node_size_; /**< @brief Size of a node, which differs with the floating point datatype.*/
+                    uint64_t n_nodes_; /**< @brief Number of nodes following the header.*/
+                    uint64_t n_indices_; /**< @brief Number of shape indices following the nodes.*/
+            };
+
+            constexpr static uint64_t magic_ = 0x3230485642504741; /**< @brief "AGPBVH02" read as a little endian integer.*/
+    };
+}
+
+#include "acceleration_structures/BVHCache_t.tpp"
+
+#endif
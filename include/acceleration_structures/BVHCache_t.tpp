@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+template<typename T>
+AGPTracer::AccelerationStructures::BVHCache_t<T>::BVHCache_t(std::filesystem::path directory) : directory_(std::move(directory)) {}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::BVHCache_t<T>::hash(std::span<const Entities::Vec3<T>> mins, std::span<const Entities::Vec3<T>> maxs) -> uint64_t {
+    constexpr uint64_t offset_basis = 0xcbf29ce484222325;
+    constexpr uint64_t prime        = 0x100000001b3;
+
+    uint64_t key   = offset_basis;
+    const auto add = [&key](auto value) {
+        for (const unsigned char byte: std::bit_cast<std::array<unsigned char, sizeof(value)>>(value)) {
+            key ^= byte;
+            key *= prime;
+        }
+    };
+
+    add(static_cast<uint64_t>(mins.size()));
+    for (size_t i = 0; i < mins.size(); ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+            add(mins[i][j]);
+            add(maxs[i][j]);
+        }
+    }
+    return key;
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::BVHCache_t<T>::path(uint64_t key) const -> std::filesystem::path {
+    constexpr size_t n_digits = 16;
+    std::string name(n_digits, '0');
+    for (size_t i = 0; i < n_digits; ++i) {
+        name[n_digits - 1 - i] = "0123456789abcdef"[(key >> (4 * i)) & 0xF];
+    }
+    return directory_ / (name + ".bvh");
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::BVHCache_t<T>::save(uint64_t key, std::span<const BVHNode_t<T>> nodes, std::span<const uint32_t> indices) const -> bool {
+    std::error_code error;
+    std::filesystem::create_directories(directory_, error);
+    if (error) {
+        std::cerr << "Warning: cache directory '" << directory_ << "' could not be created. The acceleration structure will not be cached." << std::endl;
+        return false;
+    }
+
+    // A random suffix keeps concurrent processes from writing to the same temporary file
+    const std::filesystem::path destination = path(key);
+    std::filesystem::path temporary         = destination;
+    temporary += ".tmp" + std::to_string(std::random_device()());
+
+    {
+        const Header_t header{magic_, key, sizeof(BVHNode_t<T>), nodes.size(), indices.size()};
+        std::ofstream file(temporary, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(Header_t)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+        file.write(reinterpret_cast<const char*>(nodes.data()), static_cast<std::streamsize>(nodes.size_bytes())); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+        file.write(reinterpret_cast<const char*>(indices.data()), static_cast<std::streamsize>(indices.size_bytes())); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+        if (!file) {
+            file.close();
+            std::filesystem::remove(temporary, error);
+            std::cerr << "Warning: cache file '" << temporary << "' could not be written. The acceleration structure will not be cached." << std::endl;
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temporary, destination, error);
+    if (error) {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
+
+template<typename T>
+AGPTracer::AccelerationStructures::BVHCache_t<T>::Entry_t::Entry_t(const std::filesystem::path& path, uint64_t key) : data_(nullptr), size_(0) {
+#ifdef _WIN32
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return;
+    }
+    buffer_ = std::vector<std::byte>(static_cast<size_t>(file.tellg()));
+    file.seekg(0, std::ios::beg);
+    if (!file.read(reinterpret_cast<char*>(buffer_.data()), static_cast<std::streamsize>(buffer_.size()))) { // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+        return;
+    }
+    const std::byte* data = buffer_.data();
+    const size_t size     = buffer_.size();
+#else
+    const int descriptor = open(path.c_str(), O_RDONLY); // NOLINT(cppcoreguidelines-pro-type-vararg,hicpp-vararg)
+    if (descriptor < 0) {
+        return;
+    }
+    struct stat status {};
+    if (fstat(descriptor, &status) != 0 || status.st_size <= 0) {
+        close(descriptor);
+        return;
+    }
+    void* mapping = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+    if (mapping == MAP_FAILED) { // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+        return;
+    }
+    data_                 = static_cast<std::byte*>(mapping);
+    size_                 = static_cast<size_t>(status.st_size);
+    const std::byte* data = data_;
+    const size_t size     = size_;
+#endif
+
+    if (size < sizeof(Header_t)) {
+        return;
+    }
+    Header_t header{};
+    std::copy(data, data + sizeof(Header_t), reinterpret_cast<std::byte*>(&header)); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+    if (header.magic_ != magic_ || header.key_ != key || header.node_size_ != sizeof(BVHNode_t<T>) || header.n_nodes_ == 0
+        || size != sizeof(Header_t) + header.n_nodes_ * sizeof(BVHNode_t<T>) + header.n_indices_ * sizeof(uint32_t)) {
+        return;
+    }
+
+    const std::byte* node_data  = data + sizeof(Header_t);
+    const std::byte* index_data = node_data + header.n_nodes_ * sizeof(BVHNode_t<T>);
+    nodes_                      = std::span<const BVHNode_t<T>>(reinterpret_cast<const BVHNode_t<T>*>(node_data), header.n_nodes_); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+    indices_                    = std::span<const uint32_t>(reinterpret_cast<const uint32_t*>(index_data), header.n_indices_); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+}
+
+template<typename T>
+AGPTracer::AccelerationStructures::BVHCache_t<T>::Entry_t::~Entry_t() {
+#ifndef _WIN32
+    if (data_ != nullptr) {
+        munmap(data_, size_);
+    }
+#endif
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::BVHCache_t<T>::Entry_t::valid() const -> bool {
+    return !nodes_.empty();
+}
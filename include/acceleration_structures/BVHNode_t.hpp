@@ -0,0 +1,104 @@
+#ifndef AGPTRACER_ACCELERATIONSTRUCTURES_BVHNODE_T_HPP
+#define AGPTRACER_ACCELERATIONSTRUCTURES_BVHNODE_T_HPP
+
+#include "entities/Vec3.hpp"
+#include "entities/Visibility.hpp"
+#include <cstdint>
+#include <limits>
+
+namespace AGPTracer::AccelerationStructures {
+    /**
+     * @brief The BVH node class represents a node of a flattened bounding volume hierarchy.
+     *
+     * A node is an axis-aligned bounding box around all the shapes it contains. Inner nodes point to
+     * their two children, which are always stored next to each other, at first_ and first_ + 1. Leaf
+     * nodes point to a range of count_ shape indices, starting at first_. This layout keeps nodes small
+     * and trivially copyable, so that the whole hierarchy can live in a single device buffer. Nodes also
+     * hold the union of the visibility masks of their shapes, so that rays skip the subtrees they can't see.
+     * New nodes can be seen by every ray until their masks are fitted.
+     *
+     * @tparam T Floating point datatype to use
+     */
+    template<typename T = double>
+    class BVHNode_t {
+        public:
+            /**
+             * @brief Construct a new empty BVHNode_t object, whose bounding box can't be intersected.
+             */
+            constexpr BVHNode_t();
+
+            /**
+             * @brief Construct a new BVHNode_t object from its bounding box and contents.
+             *
+             * @param minimum Minimum coordinates of the bounding box of the node.
+             * @param maximum Maximum coordinates of the bounding box of the node.
+             * @param first Index of the first child if the node is an inner node, or of the first shape index if it is a leaf.
+             * @param count Number of shapes in the leaf, 0 for inner nodes.
+             */
+            constexpr BVHNode_t(const Entities::Vec3<T>& minimum, const Entities::Vec3<T>& maximum, uint32_t first, uint32_t count);
+
+            constexpr static uint32_t max_depth_ = 64; /**< @brief Maximum depth of a hierarchy, the root being at depth 0. The traversal stacks hold this many nodes.*/
+
+            Entities::Vec3<T> min_; /**< @brief Minimum coordinates of the bounding box of the node.*/
+            Entities::Vec3<T> max_; /**< @brief Maximum coordinates of the bounding box of the node.*/
+            uint32_t first_; /**< @brief Index of the first of the two children for inner nodes, index of the first shape index for leaves.*/
+            uint32_t count_; /**< @brief Number of shapes in the leaf. Inner nodes have a count of 0.*/
+            uint32_t mask_; /**< @brief Union of the visibility masks of the shapes in the node. Rays whose visibility has no bit in common with it skip the node.*/
+
+            /**
+             * @brief Returns whether the node is a leaf, containing shapes, or an inner node, containing other nodes.
+             *
+             * @return true The node is a leaf, first_ and count_ describe a range of shape indices.
+             * @return false The node is an inner node, its children are at first_ and first_ + 1.
+             */
+            constexpr auto is_leaf() const -> bool;
+
+            /**
+             * @brief Returns whether a ray with the given visibility can see any of the shapes of the node.
+             *
+             * @param visibility Visibility mask of the ray.
+             * @return true The mask of the node has a bit in common with the visibility of the ray, the node has to be traversed.
+             * @return false None of the shapes of the node are visible to the ray, the node can be skipped.
+             */
+            constexpr auto visible(uint32_t visibility) const -> bool;
+
+            /**
+             * @brief Intersects a ray with the bounding box of the node, using the slab method.
+             *
+             * The inverse of the ray direction is passed instead of the ray itself, as it is reused for all the nodes
+             * visited by a ray.
+             *
+             * @param origin Origin of the ray.
+             * @param inverse_direction Component-wise inverse of the direction of the ray.
+             * @param t_max Distance past which intersections are ignored, usually the closest intersection found so far.
+             * @param[out] t Distance at which the ray enters the bounding box. Undefined if not intersected.
+             * @return true The ray intersects the bounding box before t_max.
+             * @return false The ray misses the bounding box, or hits it past t_max.
+             */
+            constexpr auto intersection(const Entities::Vec3<T>& origin, const Entities::Vec3<T>& inverse_direction, T t_max, T& t) const -> bool;
+
+            /**
+             * @brief Returns the surface area of the bounding box of the node.
+             *
+             * Used by the surface area heuristic to estimate the probability of a ray hitting the node.
+             *
+             * @return T Surface area of the bounding box, 0 for empty nodes.
+             */
+            constexpr auto surface_area() const -> T;
+
+            /**
+             * @brief Returns the contribution of the node to the surface area heuristic cost of the hierarchy.
+             *
+             * Inner nodes cost the traversal of their box, and leaves cost the intersection of each of their shapes, both
+             * weighted by the surface area of the node. The sum over all nodes, divided by the area of the root, gives the
+             * expected cost of a ray relative to the cost of intersecting a single shape.
+             *
+             * @return T Unnormalised surface area heuristic cost of the node.
+             */
+            constexpr auto sah_cost() const -> T;
+    };
+}
+
+#include "acceleration_structures/BVHNode_t.tpp"
+
+#endif
@@ -0,0 +1,49 @@
+#include <algorithm>
+
+template<typename T>
+constexpr AGPTracer::AccelerationStructures::BVHNode_t<T>::BVHNode_t() :
+        min_(std::numeric_limits<T>::max()), max_(std::numeric_limits<T>::lowest()), first_(0), count_(0), mask_(Entities::Visibility::all) {}
+
+template<typename T>
+constexpr AGPTracer::AccelerationStructures::BVHNode_t<T>::BVHNode_t(const Entities::Vec3<T>& minimum, const Entities::Vec3<T>& maximum, uint32_t first, uint32_t count) :
+        min_(minimum), max_(maximum), first_(first), count_(count), mask_(Entities::Visibility::all) {}
+
+template<typename T>
+constexpr auto AGPTracer::AccelerationStructures::BVHNode_t<T>::is_leaf() const -> bool {
+    return count_ > 0;
+}
+
+template<typename T>
+constexpr auto AGPTracer::AccelerationStructures::BVHNode_t<T>::visible(uint32_t visibility) const -> bool {
+    return (mask_ & visibility) != 0;
+}
+
+template<typename T>
+constexpr auto AGPTracer::AccelerationStructures::BVHNode_t<T>::intersection(const Entities::Vec3<T>& origin, const Entities::Vec3<T>& inverse_direction, T t_max, T& t) const -> bool {
+    const T tx1 = (min_[0] - origin[0]) * inverse_direction[0];
+    const T tx2 = (max_[0] - origin[0]) * inverse_direction[0];
+    const T ty1 = (min_[1] - origin[1]) * inverse_direction[1];
+    const T ty2 = (max_[1] - origin[1]) * inverse_direction[1];
+    const T tz1 = (min_[2] - origin[2]) * inverse_direction[2];
+    const T tz2 = (max_[2] - origin[2]) * inverse_direction[2];
+
+    const T t_enter = std::max(std::max(std::min(tx1, tx2), std::min(ty1, ty2)), std::max(std::min(tz1, tz2), T{0}));
+    const T t_exit  = std::min(std::min(std::max(tx1, tx2), std::max(ty1, ty2)), std::min(std::max(tz1, tz2), t_max));
+
+    t = t_enter;
+    return t_enter <= t_exit;
+}
+
+template<typename T>
+constexpr auto AGPTracer::AccelerationStructures::BVHNode_t<T>::surface_area() const -> T {
+    const Entities::Vec3<T> extent = max_ - min_;
+    if ((extent[0] < T{0}) || (extent[1] < T{0}) || (extent[2] < T{0})) {
+        return T{0};
+    }
+    return T{2} * (extent[0] * extent[1] + extent[1] * extent[2] + extent[2] * extent[0]);
+}
+
+template<typename T>
+constexpr auto AGPTracer::AccelerationStructures::BVHNode_t<T>::sah_cost() const -> T {
+    return surface_area() * (is_leaf() ? static_cast<T>(count_) : T{1});
+}
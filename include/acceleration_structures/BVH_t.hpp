@@ -0,0 +1,484 @@
+#ifndef AGPTRACER_ACCELERATIONSTRUCTURES_BVH_T_HPP
+#define AGPTRACER_ACCELERATIONSTRUCTURES_BVH_T_HPP
+
+#include "acceleration_structures/BVHCache_t.hpp"
+#include "acceleration_structures/BVHNode_t.hpp"
+#include "acceleration_structures/LBVHBuilder_t.hpp"
+#include "entities/Ray_t.hpp"
+#include "entities/Shape.hpp"
+#include "entities/Vec3.hpp"
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <sycl/sycl.hpp>
+#include <vector>
+
+namespace AGPTracer::AccelerationStructures {
+    /**
+     * @brief The BVH class is a bounding volume hierarchy acceleration structure, used to quickly find which shapes a ray intersects.
+     *
+     * The hierarchy can be built on the host with the binned surface area heuristic, from the bounding boxes of the shapes, or on the
+     * device from the Morton codes of the shapes, which is much faster but gives a lower quality hierarchy. It is flattened in a node
+     * buffer and an index buffer, which are read on the device to traverse the hierarchy. The acceleration structure doesn't own the
+     * shapes, it only stores their indices. It must be refitted or rebuilt when the shapes move, but a few shapes can be inserted
+     * or removed without rebuilding it.
+     *
+     * @tparam T Floating point datatype to use
+     */
+    template<typename T = double>
+    class BVH_t {
+        public:
+            class Accessor_t {
+                public:
+                    /**
+                     * @brief Construct a new Accessor_t object with the given buffers.
+                     *
+                     * @param cgh Device handler.
+                     * @param nodes Node buffer to access.
+                     * @param indices Shape index buffer to access.
+                     * @param parents Parent index buffer to access.
+                     */
+                    Accessor_t(sycl::handler& cgh, sycl::buffer<BVHNode_t<T>, 1>& nodes, sycl::buffer<uint32_t, 1>& indices, sycl::buffer<uint32_t, 1>& parents);
+
+                    /**
+                     * @brief Construct a new Accessor_t object with the given buffers, which caches the top levels of the hierarchy in local memory.
+                     *
+                     * The cache holds 2^cached_levels - 1 nodes per work-group, and has to be filled with load before traversing.
+                     * It can only be used in kernels launched over an nd_range. At most max_cached_levels_ levels are cached, and
+                     * max_cached_levels gives how many fit in the local memory of a device.
+                     *
+                     * @param cgh Device handler.
+                     * @param nodes Node buffer to access.
+                     * @param indices Shape index buffer to access.
+                     * @param parents Parent index buffer to access.
+                     * @param cached_levels Number of levels of the hierarchy, starting from the root, to copy to local memory.
+                     */
+                    Accessor_t(sycl::handler& cgh, sycl::buffer<BVHNode_t<T>, 1>& nodes, sycl::buffer<uint32_t, 1>& indices, sycl::buffer<uint32_t, 1>& parents, size_t cached_levels);
+
+                    /**
+                     * @brief Copies the top levels of the hierarchy to the local memory of the work-group.
+                     *
+                     * The nodes are stored in heap order, the children of the node in slot i being in slots 2i + 1 and 2i + 2, so
+                     * that the traversal can find them without reading their parent's indices. The work items of the group share
+                     * the copy, and wait for each other at the end, so all of them have to call this before traversing. Does
+                     * nothing if the accessor has no cache.
+                     *
+                     * @tparam D Number of dimensions of the kernel
+                     * @param item Work item calling the function.
+                     */
+                    template<int D>
+                    auto load(const sycl::nd_item<D>& item) const -> void;
+
+                    /**
+                     * @brief Traverses the hierarchy with a ray, calling a function for each shape whose leaf is hit by the ray.
+                     *
+                     * Nodes are visited front to back, and nodes further than t are skipped. The leaf function is called with
+                     * the index of a shape and a reference to t, and should lower t when it finds a closer intersection. It returns
+                     * true to stop the traversal, for example when any intersection is enough.
+                     *
+                     * This uses traverse_cached if the accessor caches the top levels of the hierarchy. Otherwise, this uses
+                     * traverse_stackless if AGPTRACER_STACKLESS_TRAVERSAL is defined, and traverse_stack otherwise.
+                     *
+                     * @tparam N Number of mediums in the ray's medium list
+                     * @tparam F Leaf function type, callable as bool(size_t index, T& t)
+                     * @param[in] ray Ray to traverse the hierarchy with.
+                     * @param[in, out] t Distance past which nodes are skipped. Lowered by the leaf function.
+                     * @param[in] leaf Function called for each shape of the leaves hit by the ray.
+                     */
+                    template<size_t N, class F>
+                    auto traverse(const Entities::Ray_t<T, N>& ray, T& t, F leaf) const -> void;
+
+                    /**
+                     * @brief Traverses the hierarchy with a stack of the far children left to visit.
+                     *
+                     * Each node's children are intersected together, and the far child is pushed on the stack when both are hit.
+                     * The stack holds max_depth_ node indices per work item, enough for any hierarchy the builders make.
+                     *
+                     * @tparam N Number of mediums in the ray's medium list
+                     * @tparam F Leaf function type, callable as bool(size_t index, T& t)
+                     * @param[in] ray Ray to traverse the hierarchy with.
+                     * @param[in, out] t Distance past which nodes are skipped. Lowered by the leaf function.
+                     * @param[in] leaf Function called for each shape of the leaves hit by the ray.
+                     */
+                    template<size_t N, class F>
+                    auto traverse_stack(const Entities::Ray_t<T, N>& ray, T& t, F leaf) const -> void;
+
+                    /**
+                     * @brief Traverses the hierarchy without a stack, going back up through the parents of the nodes.
+                     *
+                     * The traversal is a state machine over the current node and the direction it was reached from, its parent,
+                     * its sibling or one of its children. The near child of a node is the one whose box the ray enters first,
+                     * which doesn't depend on t, so it is found again on the way back up to know whether the far child is left to
+                     * visit. This keeps a few registers per work item instead of a stack, at the cost of intersecting the children
+                     * of a node again when leaving it.
+                     *
+                     * @tparam N Number of mediums in the ray's medium list
+                     * @tparam F Leaf function type, callable as bool(size_t index, T& t)
+                     * @param[in] ray Ray to traverse the hierarchy with.
+                     * @param[in, out] t Distance past which nodes are skipped. Lowered by the leaf function.
+                     * @param[in] leaf Function called for each shape of the leaves hit by the ray.
+                     */
+                    template<size_t N, class F>
+                    auto traverse_stackless(const Entities::Ray_t<T, N>& ray, T& t, F leaf) const -> void;
+
+                    /**
+                     * @brief Traverses the hierarchy with a stack, reading the top levels of the hierarchy from the local memory cache.
+                     *
+                     * This is the same traversal as traverse_stack, which also keeps track of the slot of the current node in the
+                     * cache while it is in the cached levels. All the rays of a work-group start with the same few nodes, so reading
+                     * them from local memory saves global memory bandwidth. load has to be called before.
+                     *
+                     * @tparam N Number of mediums in the ray's medium list
+                     * @tparam F Leaf function type, callable as bool(size_t index, T& t)
+                     * @param[in] ray Ray to traverse the hierarchy with.
+                     * @param[in, out] t Distance past which nodes are skipped. Lowered by the leaf function.
+                     * @param[in] leaf Function called for each shape of the leaves hit by the ray.
+                     */
+                    template<size_t N, class F>
+                    auto traverse_cached(const Entities::Ray_t<T, N>& ray, T& t, F leaf) const -> void;
+
+                    /**
+                     * @brief Traverses the hierarchy with a packet of coherent rays, calling a function for each ray that hits a leaf and each shape of the leaf.
+                     *
+                     * The rays share a single traversal. Inner nodes are culled for the whole packet with interval arithmetic, from
+                     * the bounds of the origins and inverse directions of the rays, and nodes further than the furthest t of the
+                     * packet are skipped. Each ray is intersected with the box of a leaf before its shapes, so the leaf function
+                     * is only called for the rays that hit the leaf. Axes on which the directions of the packet change sign can't
+                     * cull nodes, so packets should hold rays with close directions, such as camera rays in a tile of pixels.
+                     *
+                     * @tparam N Number of mediums in the rays' medium list
+                     * @tparam P Maximum number of rays in the packet
+                     * @tparam F Leaf function type, callable as void(size_t ray, size_t index, T& t)
+                     * @param[in] rays Rays of the packet.
+                     * @param[in] n_rays Number of rays used in the packet, at most P.
+                     * @param[in, out] t Distance past which nodes are skipped for each ray. Lowered by the leaf function.
+                     * @param[in] leaf Function called for each ray and each shape of the leaves hit by the ray.
+                     */
+                    template<size_t N, size_t P, class F>
+                    auto traverse_packet(const std::array<Entities::Ray_t<T, N>, P>& rays, size_t n_rays, std::array<T, P>& t, F leaf) const -> void;
+
+                private:
+                    sycl::accessor<BVHNode_t<T>, 1, sycl::access::mode::read> nodes_; /**< @brief Accessor to the nodes.*/
+                    sycl::accessor<uint32_t, 1, sycl::access::mode::read> indices_; /**< @brief Accessor to the shape indices.*/
+                    sycl::accessor<uint32_t, 1, sycl::access::mode::read> parents_; /**< @brief Accessor to the parent of each node.*/
+                    sycl::local_accessor<BVHNode_t<T>, 1> cache_; /**< @brief Top levels of the hierarchy in local memory, in heap order. Empty if the accessor has no cache.*/
+                    uint32_t n_cached_; /**< @brief Number of slots in the cache, 0 if the accessor has no cache.*/
+            };
+
+            /**
+             * @brief Construct a new empty BVH_t object, which no ray can intersect.
+             *
+             * @param rebuild_threshold Ratio of the current cost to the cost at build past which update rebuilds the hierarchy instead of refitting it.
+             */
+            explicit BVH_t(T rebuild_threshold = 1.5);
+
+            constexpr static uint32_t no_reference_    = std::numeric_limits<uint32_t>::max(); /**< @brief Ends the lists of shape indices referencing a shape.*/
+            constexpr static size_t max_cached_levels_ = 31; /**< @brief Maximum number of levels of the hierarchy cached in local memory, so that the slots of the cache fit in 32 bits.*/
+
+            sycl::buffer<BVHNode_t<T>, 1> nodes_; /**< @brief Flattened nodes of the hierarchy. The root is the first node. Only the first n_nodes_ are used, the rest is room for insertions.*/
+            sycl::buffer<uint32_t, 1> indices_; /**< @brief Indices of the shapes, in the order referenced by the leaves. Only the first n_indices_ are used.*/
+            sycl::buffer<uint32_t, 1> parents_; /**< @brief Index of the parent of each node. The root is its own parent.*/
+            sycl::buffer<uint32_t, 1> heights_; /**< @brief Height of each node, the number of levels below it. Leaves have a height of 0.*/
+            sycl::buffer<uint32_t, 1> leaves_; /**< @brief Leaf referencing each shape index, to find the leaves of the removed shapes.*/
+            sycl::buffer<uint32_t, 1> references_; /**< @brief First shape index referencing each shape, or no_reference_.*/
+            sycl::buffer<uint32_t, 1> next_references_; /**< @brief Next shape index referencing the same shape, or no_reference_. Spatial splits can put a shape in several leaves.*/
+            sycl::buffer<uint32_t, 1> flags_; /**< @brief Per node counters used to fit the nodes bottom-up, when both children are done.*/
+            sycl::buffer<T, 1> costs_; /**< @brief Partial sums of the surface area heuristic cost of the nodes, one per block of nodes, then the cost itself in the first element.*/
+            LBVHBuilder_t<T> device_builder_; /**< @brief Device builder, keeping its temporary buffers between builds.*/
+            size_t n_nodes_; /**< @brief Number of nodes used in nodes_.*/
+            size_t n_indices_; /**< @brief Number of shape indices used in indices_. Removals leave unused shape indices in the middle until the next build.*/
+            size_t n_shapes_; /**< @brief Number of shapes in the hierarchy when it was last built.*/
+            size_t n_builds_; /**< @brief Number of times the nodes were rebuilt or rearranged, by builds, insertions, removals and reorder, but not by refits.*/
+            T build_cost_; /**< @brief Surface area heuristic cost of the hierarchy when it was last built.*/
+            T rebuild_threshold_; /**< @brief Ratio of the current cost to the cost at build past which update rebuilds the hierarchy instead of refitting it.*/
+            bool cost_pending_; /**< @brief Whether the cost of the hierarchy was submitted by the last build or update, to be read by the next update.*/
+            bool build_cost_pending_; /**< @brief Whether the submitted cost is the cost at build, which build_cost_ doesn't hold yet.*/
+
+            /**
+             * @brief Builds the hierarchy around the given shapes, on the host.
+             *
+             * @tparam S Shape type
+             * @param shapes Shapes to sort in the hierarchy.
+             */
+            template<template<typename> typename S>
+            requires Entities::Coordinates<S, T> auto build(sycl::buffer<S<T>, 1>& shapes) -> void;
+
+            /**
+             * @brief Builds the hierarchy around the given shapes on the host, or loads it from a cache if it was built before.
+             *
+             * The key of the shapes is computed from their bounding boxes. If the cache holds a hierarchy for this key, it is
+             * mapped and copied to the buffers. Otherwise the hierarchy is built as with build, and written to the cache for the
+             * next run.
+             *
+             * @tparam S Shape type
+             * @param shapes Shapes to sort in the hierarchy.
+             * @param cache Cache in which to look for the hierarchy, and to write it if it isn't found.
+             * @return true The hierarchy was loaded from the cache.
+             * @return false The hierarchy was built.
+             */
+            template<template<typename> typename S>
+            requires Entities::Coordinates<S, T> auto build(sycl::buffer<S<T>, 1>& shapes, const BVHCache_t<T>& cache) -> bool;
+
+            /**
+             * @brief Builds the hierarchy around the given triangles on the host, with spatial splits.
+             *
+             * This uses the spatial split builder, which cuts the triangles crossing split planes when it lowers the surface area
+             * heuristic cost. It is slower to build, but gives much better hierarchies for long and thin triangles. Triangles can
+             * be referenced by several leaves, up to reference_budget times the number of triangles in total. The hierarchy is
+             * also built without spatial splits, to measure the improvement.
+             *
+             * @tparam S Shape type
+             * @param shapes Shapes to sort in the hierarchy.
+             * @param reference_budget Maximum number of references to shapes in the leaves, relative to the number of shapes. Bounds the memory used by the index buffer.
+             * @return T Ratio of the surface area heuristic cost of the hierarchy built without spatial splits to the cost of this one. Higher than 1 if spatial splits improved the hierarchy.
+             */
+            template<template<typename> typename S>
+            requires Entities::Coordinates<S, T>&& Entities::Triangular<S, T> auto build_spatial(sycl::buffer<S<T>, 1>& shapes, T reference_budget = 1.5) -> T;
+
+            /**
+             * @brief Builds the hierarchy around the given shapes, on the device.
+             *
+             * This uses the linear BVH builder, where shapes are sorted by the Morton code of their centroid. It is meant to be
+             * used when the shapes change every frame, as it is much faster than the host build. Every step runs in kernels
+             * submitted to the queue, so the shapes are not copied back to the host.
+             *
+             * @tparam S Shape type
+             * @param queue Queue on which to submit the build.
+             * @param shapes Shapes to sort in the hierarchy.
+             */
+            template<template<typename> typename S>
+            requires Entities::Coordinates<S, T> auto build(sycl::queue& queue, sycl::buffer<S<T>, 1>& shapes) -> void;
+
+            /**
+             * @brief Recomputes the bounding boxes of all the nodes from the shapes, bottom-up, on the device.
+             *
+             * Each leaf is fitted around its shapes by a work item, which then walks up the tree. The first work item to reach
+             * a node stops there, and the second one fits the node around its two children and continues, so every node is
+             * computed once, after both its children. The visibility masks of the nodes are fitted the same way. The topology of
+             * the tree is kept, so this is only valid if the shapes moved but none were added or removed. The hierarchy gets worse
+             * as shapes move away from where they were at build.
+             *
+             * @tparam S Shape type
+             * @param queue Queue on which to submit the refit.
+             * @param shapes Shapes contained in the hierarchy.
+             */
+            template<template<typename> typename S>
+            requires Entities::Coordinates<S, T> auto refit(sycl::queue& queue, sycl::buffer<S<T>, 1>& shapes) -> void;
+
+            /**
+             * @brief Updates the hierarchy after the shapes have changed, by refitting it or rebuilding it on the device.
+             *
+             * The hierarchy is refitted, which costs a single pass over the nodes. If shapes were added or removed, or if the
+             * surface area heuristic cost of the refitted hierarchy is more than rebuild_threshold_ times its cost at build, it
+             * is rebuilt on the device instead. The cost is computed on the device after the refit, and only read at the next
+             * update, so the host never waits for it. A hierarchy that got too costly is then rebuilt one update late.
+             *
+             * @tparam S Shape type
+             * @param queue Queue on which to submit the update.
+             * @param shapes Shapes contained in the hierarchy.
+             */
+            template<template<typename> typename S>
+            requires Entities::Coordinates<S, T> auto update(sycl::queue& queue, sycl::buffer<S<T>, 1>& shapes) -> void;
+
+            /**
+             * @brief Inserts shapes in the hierarchy on the device, without rebuilding it.
+             *
+             * Each shape gets a new leaf, paired with the node whose surface area grows the least when the shape is added to it
+             * and to its ancestors. That sibling is found with a branch and bound search from the root, which usually stops after
+             * a few levels. The sibling is moved to a new pair of nodes at the end of the buffer along with the new leaf, and the
+             * ancestors are grown to contain the shape. This runs in a single work item, which only touches the nodes on the way,
+             * so the work is proportional to the number of shapes inserted. The buffers keep room for more nodes, and double in
+             * size when they are full. Only the bounding boxes of the shapes are known, so the new leaves and their ancestors can
+             * be seen by every ray until the next refit.
+             *
+             * Siblings that would put leaves deeper than BVHNode_t::max_depth_ are skipped, so the hierarchy stays within the
+             * traversal stacks. The ancestors are balanced on the way up, by swapping the shorter child of a node with the taller
+             * grandchild when their heights differ by more than one, so inserting shapes in order doesn't make long chains.
+             *
+             * The hierarchy must contain the first first shapes, otherwise nothing is done and it has to be rebuilt. The cost at
+             * build is kept, so that update rebuilds the hierarchy once insertions have made it too costly.
+             *
+             * @param queue Queue on which to submit the insertion, the one the hierarchy is updated and traversed with.
+             * @param first Index of the first inserted shape, which must be the number of shapes in the hierarchy.
+             * @param mins Minimum coordinates of the bounding boxes of the inserted shapes.
+             * @param maxs Maximum coordinates of the bounding boxes of the inserted shapes.
+             */
+            auto insert(sycl::queue& queue, size_t first, std::span<const Entities::Vec3<T>> mins, std::span<const Entities::Vec3<T>> maxs) -> void;
+
+            /**
+             * @brief Removes shapes from the hierarchy on the device, without rebuilding it.
+             *
+             * The references to each removed shape are taken out of their leaves, which are found through references_ and leaves_.
+             * Leaves left empty are replaced by their sibling in their parent, and the last pair of nodes is moved in the two freed
+             * nodes so that the buffer stays packed. Then the last shape takes the index of the removed shape, going through the
+             * removed shapes from the last to the first, which is how Scene_t::remove_shapes packs the shapes. This runs in a single
+             * work item, and only the number of nodes left is read back. The bounding boxes are not shrunk, which would need the
+             * remaining shapes, they are tightened by the next refit.
+             *
+             * The hierarchy must contain n_shapes shapes, otherwise nothing is done and it has to be rebuilt.
+             *
+             * @param queue Queue on which to submit the removal, the one the hierarchy is updated and traversed with.
+             * @param n_shapes Number of shapes before the removal.
+             * @param removed Indices of the removed shapes, without duplicates.
+             */
+            auto remove(sycl::queue& queue, size_t n_shapes, std::span<const uint32_t> removed) -> void;
+
+            /**
+             * @brief Renumbers the shapes after they were moved in memory, keeping the hierarchy as it is.
+             *
+             * Each leaf keeps the same shapes, so the nodes are untouched, whichever way the hierarchy was built or reordered. Only
+             * the shape indices and the references to each shape are rewritten, on the device.
+             *
+             * The hierarchy must contain as many shapes as the order, otherwise nothing is done and it has to be rebuilt.
+             *
+             * @param queue Queue on which to submit the kernels, the one the hierarchy is updated and traversed with.
+             * @param order Previous index of the shape now at each index.
+             */
+            auto permute(sycl::queue& queue, sycl::buffer<uint32_t, 1>& order) -> void;
+
+            /**
+             * @brief Reorders the nodes in treelets, so that the nodes a ray is likely to visit one after the other are close in memory.
+             *
+             * This is a pass on the host after the hierarchy is built. Starting from the root, each treelet takes the pairs of
+             * sibling nodes with the largest parent surface area, which are the most likely to be hit, until it holds treelet_size
+             * bytes of nodes. The pairs left out become the roots of the next treelets, which are laid out depth first after their
+             * parent treelet. Inside a treelet, pairs are laid out depth first, and siblings are kept next to each other. The shapes
+             * are renumbered in the depth first order of the leaves, so that the shapes can be reordered to match: shapes referenced
+             * by neighbouring leaves end up next to each other in memory too.
+             *
+             * The layout is lost when the hierarchy is rebuilt, by build or update.
+             *
+             * @param treelet_size Size of a treelet in bytes, for example the size of a page or of a few cache lines.
+             * @return std::vector<uint32_t> Previous index of each shape in the new order. The shapes must be reordered this way for the hierarchy to reference the right shapes.
+             */
+            auto reorder(size_t treelet_size = 4096) -> std::vector<uint32_t>;
+
+            /**
+             * @brief Computes the surface area heuristic cost of the hierarchy on the device.
+             *
+             * This is the expected cost of intersecting a ray with the hierarchy, relative to the cost of intersecting a single shape.
+             *
+             * This waits for the result, so update uses the non-blocking submit_cost and read_cost instead.
+             *
+             * @param queue Queue on which to submit the computation.
+             * @return T Surface area heuristic cost of the hierarchy.
+             */
+            auto cost(sycl::queue& queue) -> T;
+
+            /**
+             * @brief Get a Accessor_t object attached to this acceleration structure
+             *
+             * @param cgh Device handler.
+             * @return Accessor_t Accessor that can be used on the device to traverse the acceleration structure
+             */
+            auto getAccessor(sycl::handler& cgh) -> Accessor_t;
+
+            /**
+             * @brief Get a Accessor_t object attached to this acceleration structure, which caches the top levels of the hierarchy in local memory.
+             *
+             * @param cgh Device handler.
+             * @param cached_levels Number of levels of the hierarchy, starting from the root, to copy to local memory. The cache uses 2^cached_levels - 1 nodes per work-group.
+             * @return Accessor_t Accessor that can be used on the device to traverse the acceleration structure, in kernels launched over an nd_range
+             */
+            auto getAccessor(sycl::handler& cgh, size_t cached_levels) -> Accessor_t;
+
+            /**
+             * @brief Gives the largest number of levels whose nodes fit in the given amount of local memory, for getAccessor.
+             *
+             * @param local_memory Local memory available to a work-group, in bytes, as given by sycl::info::device::local_mem_size.
+             * @return size_t Largest number of levels whose 2^levels - 1 nodes fit in local_memory, at most max_cached_levels_.
+             */
+            constexpr static auto max_cached_levels(size_t local_memory) -> size_t;
+
+            /**
+             * @brief Fits the visibility masks of a hierarchy on the host, bottom-up from its leaves.
+             *
+             * Each leaf takes the union of the masks of its shapes, and each inner node the union of the masks of its children.
+             *
+             * @param nodes Flattened nodes of the hierarchy.
+             * @param indices Indices of the shapes, in the order referenced by the leaves.
+             * @param masks Visibility mask of each shape.
+             * @param root Root node of the hierarchy to fit.
+             */
+            static auto fit_masks(std::span<BVHNode_t<T>> nodes, std::span<const uint32_t> indices, std::span<const uint32_t> masks, uint32_t root = 0) -> void;
+
+        private:
+            /**
+             * @brief Copies the nodes and indices built on the host to the buffers, and computes the parents of the nodes, the references to the shapes and the cost of the hierarchy.
+             *
+             * @param nodes Flattened nodes of the hierarchy. The root is the first node.
+             * @param indices Indices of the shapes, in the order referenced by the leaves.
+             * @param n_shapes Number of shapes in the hierarchy.
+             */
+            auto upload(std::span<const BVHNode_t<T>> nodes, std::span<const uint32_t> indices, size_t n_shapes) -> void;
+
+            /**
+             * @brief Finds the leaf of each shape index and the shape indices referencing each shape, after the hierarchy was built on the device.
+             *
+             * @param queue Queue on which to submit the kernels.
+             */
+            auto link(sycl::queue& queue) -> void;
+
+            /**
+             * @brief Submits the computation of the surface area heuristic cost of the hierarchy, without waiting for it.
+             *
+             * The cost ends up in the first element of costs_, to be read with read_cost.
+             *
+             * @param queue Queue on which to submit the kernels.
+             */
+            auto submit_cost(sycl::queue& queue) -> void;
+
+            /**
+             * @brief Reads the cost computed by the last call to submit_cost, waiting for it if needed.
+             *
+             * @return T Surface area heuristic cost of the hierarchy.
+             */
+            auto read_cost() -> T;
+
+            /**
+             * @brief Grows the buffers if they are too small for the given numbers of nodes, shape indices and shapes, keeping their content.
+             *
+             * @param queue Queue on which to submit the copies.
+             * @param n_nodes Number of nodes to make room for.
+             * @param n_indices Number of shape indices to make room for.
+             * @param n_shapes Number of shapes to make room for.
+             */
+            auto reserve(sycl::queue& queue, size_t n_nodes, size_t n_indices, size_t n_shapes) -> void;
+
+            /**
+             * @brief Replaces a buffer by one holding at least size elements, at least twice as large, if it is smaller. The used elements are copied on the device.
+             *
+             * @tparam U Element type of the buffer
+             * @param queue Queue on which to submit the copy.
+             * @param buffer Buffer to grow.
+             * @param n_used Number of elements to keep, at the start of the buffer.
+             * @param size Number of elements the buffer must hold.
+             */
+            template<typename U>
+            static auto grow(sycl::queue& queue, sycl::buffer<U, 1>& buffer, size_t n_used, size_t size) -> void;
+
+            /**
+             * @brief Fits the visibility masks of the nodes around the masks of the shapes, after the hierarchy was built on the host.
+             *
+             * Nothing is done if the shapes have no mask, and the nodes can be seen by every ray.
+             *
+             * @tparam S Shape type
+             * @param shapes Shapes contained in the hierarchy.
+             */
+            template<template<typename> typename S>
+            auto fit_masks(sycl::buffer<S<T>, 1>& shapes) -> void;
+
+            /**
+             * @brief Computes the surface area heuristic cost of nodes on the host.
+             *
+             * @param nodes Flattened nodes of a hierarchy. The root is the first node.
+             * @return T Surface area heuristic cost of the hierarchy.
+             */
+            static auto cost(std::span<const BVHNode_t<T>> nodes) -> T;
+    };
+}
+
+#include "acceleration_structures/BVH_t.tpp"
+
+#endif
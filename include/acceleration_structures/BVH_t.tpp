@@ -0,0 +1,1340 @@
+#include "acceleration_structures/BVHBuilder_t.hpp"
+#include "acceleration_structures/SBVHBuilder_t.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <utility>
+#include <vector>
+
+template<typename T>
+AGPTracer::AccelerationStructures::BVH_t<T>::BVH_t(T rebuild_threshold) :
+        nodes_(sycl::range<1>{1}),
+        indices_(sycl::range<1>{1}),
+        parents_(sycl::range<1>{1}),
+        heights_(sycl::range<1>{1}),
+        leaves_(sycl::range<1>{1}),
+        references_(sycl::range<1>{1}),
+        next_references_(sycl::range<1>{1}),
+        flags_(sycl::range<1>{1}),
+        costs_(sycl::range<1>{1}),
+        n_nodes_(1),
+        n_indices_(0),
+        n_shapes_(0),
+        n_builds_(0),
+        build_cost_(0),
+        rebuild_threshold_(rebuild_threshold),
+        cost_pending_(false),
+        build_cost_pending_(false) {
+    const sycl::host_accessor<BVHNode_t<T>, 1, sycl::access_mode::write> node_accessor(nodes_, sycl::no_init);
+    node_accessor[0] = BVHNode_t<T>();
+
+    const sycl::host_accessor<uint32_t, 1, sycl::access_mode::write> index_accessor(indices_, sycl::no_init);
+    index_accessor[0] = 0;
+
+    const sycl::host_accessor<uint32_t, 1, sycl::access_mode::write> parent_accessor(parents_, sycl::no_init);
+    parent_accessor[0] = 0;
+
+    const sycl::host_accessor<uint32_t, 1, sycl::access_mode::write> height_accessor(heights_, sycl::no_init);
+    height_accessor[0] = 0;
+}
+
+template<typename T>
+template<template<typename> typename S>
+requires AGPTracer::Entities::Coordinates<S, T> auto AGPTracer::AccelerationStructures::BVH_t<T>::build(sycl::buffer<S<T>, 1>& shapes) -> void {
+    std::vector<Entities::Vec3<T>> mins(shapes.get_range()[0]);
+    std::vector<Entities::Vec3<T>> maxs(shapes.get_range()[0]);
+    {
+        const sycl::host_accessor<S<T>, 1, sycl::access_mode::read> shape_accessor(shapes);
+        for (size_t i = 0; i < mins.size(); ++i) {
+            mins[i] = shape_accessor[i].mincoord();
+            maxs[i] = shape_accessor[i].maxcoord();
+        }
+    }
+
+    const BVHBuilder_t<T> builder(mins, maxs);
+    upload(builder.nodes_, builder.indices_, mins.size());
+    fit_masks(shapes);
+}
+
+template<typename T>
+template<template<typename> typename S>
+requires AGPTracer::Entities::Coordinates<S, T> auto AGPTracer::AccelerationStructures::BVH_t<T>::build(sycl::buffer<S<T>, 1>& shapes, const BVHCache_t<T>& cache) -> bool {
+    std::vector<Entities::Vec3<T>> mins(shapes.get_range()[0]);
+    std::vector<Entities::Vec3<T>> maxs(shapes.get_range()[0]);
+    {
+        const sycl::host_accessor<S<T>, 1, sycl::access_mode::read> shape_accessor(shapes);
+        for (size_t i = 0; i < mins.size(); ++i) {
+            mins[i] = shape_accessor[i].mincoord();
+            maxs[i] = shape_accessor[i].maxcoord();
+        }
+    }
+
+    const uint64_t key = BVHCache_t<T>::hash(mins, maxs);
+    {
+        const typename BVHCache_t<T>::Entry_t entry(cache.path(key), key);
+        if (entry.valid()) {
+            upload(entry.nodes_, entry.indices_, mins.size());
+            fit_masks(shapes);
+            return true;
+        }
+    }
+
+    const BVHBuilder_t<T> builder(mins, maxs);
+    upload(builder.nodes_, builder.indices_, mins.size());
+    cache.save(key, builder.nodes_, builder.indices_);
+    fit_masks(shapes);
+    return false;
+}
+
+template<typename T>
+template<template<typename> typename S>
+requires AGPTracer::Entities::Coordinates<S, T>&& AGPTracer::Entities::Triangular<S, T> auto AGPTracer::AccelerationStructures::BVH_t<T>::build_spatial(sycl::buffer<S<T>, 1>& shapes,
+                                                                                                                                                        T reference_budget) -> T {
+    std::vector<std::array<Entities::Vec3<T>, 3>> triangles(shapes.get_range()[0]);
+    std::vector<Entities::Vec3<T>> mins(triangles.size());
+    std::vector<Entities::Vec3<T>> maxs(triangles.size());
+    {
+        const sycl::host_accessor<S<T>, 1, sycl::access_mode::read> shape_accessor(shapes);
+        for (size_t i = 0; i < triangles.size(); ++i) {
+            triangles[i] = shape_accessor[i].points_;
+            mins[i]      = shape_accessor[i].mincoord();
+            maxs[i]      = shape_accessor[i].maxcoord();
+        }
+    }
+
+    // The hierarchy without spatial splits is built too, to measure the improvement
+    const T object_cost = cost(BVHBuilder_t<T>(mins, maxs).nodes_);
+
+    const SBVHBuilder_t<T> builder(triangles, reference_budget);
+    upload(builder.nodes_, builder.indices_, triangles.size());
+    fit_masks(shapes);
+
+    return (build_cost_ > T{0}) ? object_cost / build_cost_ : T{1};
+}
+
+template<typename T>
+template<template<typename> typename S>
+requires AGPTracer::Entities::Coordinates<S, T> auto AGPTracer::AccelerationStructures::BVH_t<T>::build(sycl::queue& queue, sycl::buffer<S<T>, 1>& shapes) -> void {
+    const size_t n_shapes = shapes.get_range()[0];
+    if (n_shapes == 0) {
+        const size_t n_builds = n_builds_;
+        *this                 = BVH_t<T>(rebuild_threshold_);
+        n_builds_             = n_builds + 1;
+        return;
+    }
+
+    const size_t n_nodes = 2 * n_shapes - 1;
+    if (nodes_.get_range()[0] != n_nodes) {
+        nodes_   = sycl::buffer<BVHNode_t<T>, 1>(sycl::range<1>{n_nodes});
+        parents_ = sycl::buffer<uint32_t, 1>(sycl::range<1>{n_nodes});
+        heights_ = sycl::buffer<uint32_t, 1>(sycl::range<1>{n_nodes});
+        flags_   = sycl::buffer<uint32_t, 1>(sycl::range<1>{n_nodes});
+    }
+    if (indices_.get_range()[0] != n_shapes) {
+        indices_         = sycl::buffer<uint32_t, 1>(sycl::range<1>{n_shapes});
+        leaves_          = sycl::buffer<uint32_t, 1>(sycl::range<1>{n_shapes});
+        references_      = sycl::buffer<uint32_t, 1>(sycl::range<1>{n_shapes});
+        next_references_ = sycl::buffer<uint32_t, 1>(sycl::range<1>{n_shapes});
+    }
+    n_nodes_   = n_nodes;
+    n_indices_ = n_shapes;
+    n_shapes_  = n_shapes;
+    ++n_builds_;
+
+    device_builder_.build(queue, shapes, nodes_, indices_, parents_);
+    link(queue);
+    refit(queue, shapes);
+
+    // The cost at build is read at the next update, when it is long computed
+    submit_cost(queue);
+    cost_pending_       = true;
+    build_cost_pending_ = true;
+}
+
+template<typename T>
+template<template<typename> typename S>
+requires AGPTracer::Entities::Coordinates<S, T> auto AGPTracer::AccelerationStructures::BVH_t<T>::refit(sycl::queue& queue, sycl::buffer<S<T>, 1>& shapes) -> void {
+    const sycl::range<1> num_work_items{n_nodes_};
+
+    queue.submit([&](sycl::handler& cgh) {
+        auto flag_accessor = flags_.template get_access<sycl::access::mode::discard_write>(cgh);
+
+        cgh.parallel_for<class ResetBVHFlags>(num_work_items, [=](sycl::id<1> WIid) { flag_accessor[WIid] = 0; });
+    });
+
+    queue.submit([&](sycl::handler& cgh) {
+        auto shape_accessor  = shapes.template get_access<sycl::access::mode::read>(cgh);
+        auto node_accessor   = nodes_.template get_access<sycl::access::mode::read_write>(cgh);
+        auto index_accessor  = indices_.template get_access<sycl::access::mode::read>(cgh);
+        auto parent_accessor = parents_.template get_access<sycl::access::mode::read>(cgh);
+        auto height_accessor = heights_.template get_access<sycl::access::mode::read_write>(cgh);
+        auto flag_accessor   = flags_.template get_access<sycl::access::mode::read_write>(cgh);
+
+        cgh.parallel_for<class FitBVH>(num_work_items, [=](sycl::id<1> WIid) {
+            BVHNode_t<T>& leaf = node_accessor[WIid];
+            if (!leaf.is_leaf()) {
+                return;
+            }
+
+            leaf.min_ = Entities::Vec3<T>(std::numeric_limits<T>::max());
+            leaf.max_ = Entities::Vec3<T>(std::numeric_limits<T>::lowest());
+            for (uint32_t i = leaf.first_; i < leaf.first_ + leaf.count_; ++i) {
+                leaf.min_.min(shape_accessor[index_accessor[i]].mincoord());
+                leaf.max_.max(shape_accessor[index_accessor[i]].maxcoord());
+            }
+            if constexpr (Entities::Masked<S, T>) {
+                leaf.mask_ = 0;
+                for (uint32_t i = leaf.first_; i < leaf.first_ + leaf.count_; ++i) {
+                    leaf.mask_ |= shape_accessor[index_accessor[i]].mask_;
+                }
+            }
+            height_accessor[WIid] = 0;
+
+            // The second work item to reach a node fits it, once both its children are done
+            auto node_index = static_cast<uint32_t>(WIid[0]);
+            while (node_index != 0) {
+                node_index = parent_accessor[node_index];
+                sycl::atomic_ref<uint32_t, sycl::memory_order::acq_rel, sycl::memory_scope::device, sycl::access::address_space::global_space> flag(flag_accessor[node_index]);
+                if (flag.fetch_add(1) == 0) {
+                    return;
+                }
+
+                BVHNode_t<T>& node          = node_accessor[node_index];
+                const BVHNode_t<T>& left    = node_accessor[node.first_];
+                const BVHNode_t<T>& right   = node_accessor[node.first_ + 1];
+                node.min_                   = left.min_.getMin(right.min_);
+                node.max_                   = left.max_.getMax(right.max_);
+                node.mask_                  = left.mask_ | right.mask_;
+                height_accessor[node_index] = std::max(height_accessor[node.first_], height_accessor[node.first_ + 1]) + 1;
+            }
+        });
+    });
+}
+
+template<typename T>
+template<template<typename> typename S>
+requires AGPTracer::Entities::Coordinates<S, T> auto AGPTracer::AccelerationStructures::BVH_t<T>::update(sycl::queue& queue, sycl::buffer<S<T>, 1>& shapes) -> void {
+    if (shapes.get_range()[0] != n_shapes_) {
+        build(queue, shapes);
+        return;
+    }
+
+    // The cost submitted by the previous update is read instead of the one of this refit, so that the host doesn't wait for
+    // the device. A hierarchy that got too costly is rebuilt one update late.
+    if (cost_pending_) {
+        const T previous_cost = read_cost();
+        cost_pending_         = false;
+        if (build_cost_pending_) {
+            build_cost_         = previous_cost;
+            build_cost_pending_ = false;
+        }
+        else if (previous_cost > rebuild_threshold_ * build_cost_) {
+            build(queue, shapes);
+            return;
+        }
+    }
+
+    refit(queue, shapes);
+    submit_cost(queue);
+    cost_pending_ = true;
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::BVH_t<T>::insert(sycl::queue& queue, size_t first, std::span<const Entities::Vec3<T>> mins, std::span<const Entities::Vec3<T>> maxs) -> void {
+    if ((first != n_shapes_) || mins.empty()) {
+        return;
+    }
+
+    // The root of an empty hierarchy is replaced by the first leaf
+    const size_t n_nodes = (n_shapes_ > 0) ? n_nodes_ : 0;
+    std::vector<BVHNode_t<T>> leaves(mins.size());
+    for (size_t i = 0; i < leaves.size(); ++i) {
+        leaves[i] = BVHNode_t<T>(mins[i], maxs[i], static_cast<uint32_t>(n_indices_ + i), 1);
+    }
+
+    reserve(queue, n_nodes + 2 * leaves.size(), n_indices_ + leaves.size(), n_shapes_ + leaves.size());
+    sycl::buffer<BVHNode_t<T>, 1> leaf_buffer(leaves.data(), sycl::range<1>{leaves.size()});
+
+    queue.submit([&](sycl::handler& cgh) {
+        auto new_leaf_accessor       = leaf_buffer.template get_access<sycl::access::mode::read>(cgh);
+        auto node_accessor           = nodes_.template get_access<sycl::access::mode::read_write>(cgh);
+        auto index_accessor          = indices_.template get_access<sycl::access::mode::write>(cgh);
+        auto parent_accessor         = parents_.template get_access<sycl::access::mode::read_write>(cgh);
+        auto height_accessor         = heights_.template get_access<sycl::access::mode::read_write>(cgh);
+        auto leaf_accessor           = leaves_.template get_access<sycl::access::mode::write>(cgh);
+        auto reference_accessor      = references_.template get_access<sycl::access::mode::write>(cgh);
+        auto next_reference_accessor = next_references_.template get_access<sycl::access::mode::write>(cgh);
+        const auto first_shape       = static_cast<uint32_t>(first);
+        const auto first_pair        = static_cast<uint32_t>(n_nodes);
+        const auto n_inserted        = static_cast<uint32_t>(leaves.size());
+
+        cgh.single_task<class InsertBVH>([=]() {
+            constexpr size_t max_stack_size = BVHNode_t<T>::max_depth_ + 1;
+            uint32_t n_used                 = first_pair;
+
+            const auto relink = [&](uint32_t node_index) {
+                const BVHNode_t<T>& node = node_accessor[node_index];
+                if (node.is_leaf()) {
+                    for (uint32_t j = node.first_; j < node.first_ + node.count_; ++j) {
+                        leaf_accessor[j] = node_index;
+                    }
+                }
+                else {
+                    parent_accessor[node.first_]     = node_index;
+                    parent_accessor[node.first_ + 1] = node_index;
+                }
+            };
+
+            // A child more than one level taller than its sibling gives its taller child to the node, and gets the sibling in exchange
+            const auto balance = [&](uint32_t node_index) {
+                const uint32_t first = node_accessor[node_index].first_;
+                const uint32_t tall  = (height_accessor[first] >= height_accessor[first + 1]) ? first : first + 1;
+                const uint32_t small = (tall == first) ? first + 1 : first;
+                if (height_accessor[tall] > height_accessor[small] + 1) {
+                    const uint32_t grandchildren = node_accessor[tall].first_;
+                    const uint32_t grandchild    = (height_accessor[grandchildren] >= height_accessor[grandchildren + 1]) ? grandchildren : grandchildren + 1;
+                    const uint32_t other         = (grandchild == grandchildren) ? grandchildren + 1 : grandchildren;
+                    std::swap(node_accessor[small], node_accessor[grandchild]);
+                    std::swap(height_accessor[small], height_accessor[grandchild]);
+                    relink(small);
+                    relink(grandchild);
+
+                    BVHNode_t<T>& node    = node_accessor[tall];
+                    node.min_             = node_accessor[grandchild].min_.getMin(node_accessor[other].min_);
+                    node.max_             = node_accessor[grandchild].max_.getMax(node_accessor[other].max_);
+                    node.mask_            = node_accessor[grandchild].mask_ | node_accessor[other].mask_;
+                    height_accessor[tall] = std::max(height_accessor[grandchild], height_accessor[other]) + 1;
+                }
+                height_accessor[node_index] = std::max(height_accessor[first], height_accessor[first + 1]) + 1;
+            };
+
+            for (uint32_t i = 0; i < n_inserted; ++i) {
+                const BVHNode_t<T> leaf              = new_leaf_accessor[i];
+                index_accessor[leaf.first_]          = first_shape + i;
+                reference_accessor[first_shape + i]  = leaf.first_;
+                next_reference_accessor[leaf.first_] = no_reference_;
+                if (n_used == 0) {
+                    node_accessor[0]           = leaf;
+                    parent_accessor[0]         = 0;
+                    height_accessor[0]         = 0;
+                    leaf_accessor[leaf.first_] = 0;
+                    n_used                     = 1;
+                    continue;
+                }
+
+                // The cost of a sibling is the area of its box grown around the leaf, plus the growth of its ancestors. Children
+                // can't cost less than the growth of their ancestors plus the area of the leaf, which bounds the search. Nodes
+                // whose leaves would end up deeper than max_depth_ are not taken, there are always leaves higher up to take.
+                struct Candidate_t {
+                        T cost;
+                        uint32_t node;
+                        uint32_t depth;
+                };
+                const T leaf_area = leaf.surface_area();
+                uint32_t sibling  = 0;
+                T best_cost       = std::numeric_limits<T>::max();
+                std::array<Candidate_t, max_stack_size> stack; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+                size_t stack_size   = 0;
+                stack[stack_size++] = {T{0}, 0, 0};
+                while (stack_size > 0) {
+                    const Candidate_t candidate = stack[--stack_size];
+                    if (candidate.cost + leaf_area >= best_cost) {
+                        continue;
+                    }
+
+                    const BVHNode_t<T>& node = node_accessor[candidate.node];
+                    const T grown_area       = BVHNode_t<T>(node.min_.getMin(leaf.min_), node.max_.getMax(leaf.max_), 0, 0).surface_area();
+                    if ((grown_area + candidate.cost < best_cost) && (candidate.depth + height_accessor[candidate.node] < BVHNode_t<T>::max_depth_)) {
+                        best_cost = grown_area + candidate.cost;
+                        sibling   = candidate.node;
+                    }
+
+                    const T child_cost = candidate.cost + grown_area - node.surface_area();
+                    if (!node.is_leaf() && (child_cost + leaf_area < best_cost) && (stack_size + 2 <= max_stack_size)) {
+                        stack[stack_size++] = {child_cost, node.first_, candidate.depth + 1};
+                        stack[stack_size++] = {child_cost, node.first_ + 1, candidate.depth + 1};
+                    }
+                }
+
+                // The sibling moves to a new pair with the leaf, and its node becomes their parent
+                const uint32_t pair         = n_used;
+                const BVHNode_t<T> previous = node_accessor[sibling];
+                n_used += 2;
+                node_accessor[pair]        = previous;
+                node_accessor[pair + 1]    = leaf;
+                parent_accessor[pair]      = sibling;
+                parent_accessor[pair + 1]  = sibling;
+                height_accessor[pair]      = height_accessor[sibling];
+                height_accessor[pair + 1]  = 0;
+                leaf_accessor[leaf.first_] = pair + 1;
+                relink(pair);
+                node_accessor[sibling] = BVHNode_t<T>(previous.min_.getMin(leaf.min_), previous.max_.getMax(leaf.max_), pair, 0);
+
+                // Balancing on the way up keeps the hierarchy shallow when shapes are inserted in order, along a line for example
+                for (uint32_t node_index = sibling;; node_index = parent_accessor[node_index]) {
+                    BVHNode_t<T>& node = node_accessor[node_index];
+                    node.min_.min(leaf.min_);
+                    node.max_.max(leaf.max_);
+                    node.mask_ |= leaf.mask_;
+                    balance(node_index);
+                    if (node_index == 0) {
+                        break;
+                    }
+                }
+            }
+        });
+    });
+
+    n_nodes_ = (n_nodes > 0) ? n_nodes + 2 * leaves.size() : 2 * leaves.size() - 1;
+    n_indices_ += leaves.size();
+    n_shapes_ += leaves.size();
+    ++n_builds_;
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::BVH_t<T>::remove(sycl::queue& queue, size_t n_shapes, std::span<const uint32_t> removed) -> void {
+    if ((n_shapes != n_shapes_) || removed.empty()) {
+        return;
+    }
+    if (removed.size() == n_shapes_) {
+        const size_t n_builds = n_builds_;
+        *this                 = BVH_t<T>(rebuild_threshold_);
+        n_builds_             = n_builds + 1;
+        return;
+    }
+
+    std::vector<uint32_t> sorted(removed.begin(), removed.end());
+    std::sort(sorted.begin(), sorted.end(), std::greater<>());
+    sycl::buffer<uint32_t, 1> removed_buffer(sorted.data(), sycl::range<1>{sorted.size()});
+    sycl::buffer<uint32_t, 1> count_buffer(sycl::range<1>{1});
+
+    queue.submit([&](sycl::handler& cgh) {
+        auto removed_accessor        = removed_buffer.template get_access<sycl::access::mode::read>(cgh);
+        auto count_accessor          = count_buffer.template get_access<sycl::access::mode::discard_write>(cgh);
+        auto node_accessor           = nodes_.template get_access<sycl::access::mode::read_write>(cgh);
+        auto index_accessor          = indices_.template get_access<sycl::access::mode::read_write>(cgh);
+        auto parent_accessor         = parents_.template get_access<sycl::access::mode::read_write>(cgh);
+        auto height_accessor         = heights_.template get_access<sycl::access::mode::read_write>(cgh);
+        auto leaf_accessor           = leaves_.template get_access<sycl::access::mode::read_write>(cgh);
+        auto reference_accessor      = references_.template get_access<sycl::access::mode::read_write>(cgh);
+        auto next_reference_accessor = next_references_.template get_access<sycl::access::mode::read_write>(cgh);
+        const auto n_nodes           = static_cast<uint32_t>(n_nodes_);
+        const auto n_total           = static_cast<uint32_t>(n_shapes_);
+        const auto n_removed         = static_cast<uint32_t>(sorted.size());
+
+        cgh.single_task<class RemoveBVH>([=]() {
+            uint32_t n_used      = n_nodes;
+            uint32_t n_remaining = n_total;
+
+            const auto relink = [&](uint32_t node_index) {
+                const BVHNode_t<T>& node = node_accessor[node_index];
+                if (node.is_leaf()) {
+                    for (uint32_t j = node.first_; j < node.first_ + node.count_; ++j) {
+                        leaf_accessor[j] = node_index;
+                    }
+                }
+                else {
+                    parent_accessor[node.first_]     = node_index;
+                    parent_accessor[node.first_ + 1] = node_index;
+                }
+            };
+
+            const auto remove_leaf = [&](uint32_t leaf_index) {
+                const uint32_t parent   = parent_accessor[leaf_index];
+                const uint32_t pair     = node_accessor[parent].first_;
+                const uint32_t sibling  = (leaf_index == pair) ? pair + 1 : pair;
+                node_accessor[parent]   = node_accessor[sibling];
+                height_accessor[parent] = height_accessor[sibling];
+                relink(parent);
+
+                // Ancestors are updated before the last pair moves, as the parent can be in it
+                for (uint32_t node_index = parent; node_index != 0;) {
+                    node_index                  = parent_accessor[node_index];
+                    const uint32_t first        = node_accessor[node_index].first_;
+                    height_accessor[node_index] = std::max(height_accessor[first], height_accessor[first + 1]) + 1;
+                }
+
+                const uint32_t last_pair = n_used - 2;
+                if (pair != last_pair) {
+                    node_accessor[pair]                              = node_accessor[last_pair];
+                    node_accessor[pair + 1]                          = node_accessor[last_pair + 1];
+                    parent_accessor[pair]                            = parent_accessor[last_pair];
+                    parent_accessor[pair + 1]                        = parent_accessor[last_pair];
+                    height_accessor[pair]                            = height_accessor[last_pair];
+                    height_accessor[pair + 1]                        = height_accessor[last_pair + 1];
+                    node_accessor[parent_accessor[last_pair]].first_ = pair;
+                    relink(pair);
+                    relink(pair + 1);
+                }
+                n_used = last_pair;
+            };
+
+            for (uint32_t r = 0; r < n_removed; ++r) {
+                const uint32_t shape = removed_accessor[r];
+                for (uint32_t slot = reference_accessor[shape]; slot != no_reference_;) {
+                    const uint32_t next_slot  = next_reference_accessor[slot];
+                    const uint32_t leaf_index = leaf_accessor[slot];
+                    BVHNode_t<T>& leaf        = node_accessor[leaf_index];
+                    const uint32_t last       = leaf.first_ + leaf.count_ - 1;
+
+                    // The last reference of the leaf takes the place of the removed one, in the leaf and in the list of its shape
+                    if (slot != last) {
+                        const uint32_t moved          = index_accessor[last];
+                        index_accessor[slot]          = moved;
+                        next_reference_accessor[slot] = next_reference_accessor[last];
+                        if (reference_accessor[moved] == last) {
+                            reference_accessor[moved] = slot;
+                        }
+                        else {
+                            uint32_t previous = reference_accessor[moved];
+                            while (next_reference_accessor[previous] != last) {
+                                previous = next_reference_accessor[previous];
+                            }
+                            next_reference_accessor[previous] = slot;
+                        }
+                    }
+                    --leaf.count_;
+                    if (leaf.count_ == 0) {
+                        remove_leaf(leaf_index);
+                    }
+                    slot = next_slot;
+                }
+
+                // The last shape takes the index of the removed one
+                --n_remaining;
+                if (shape != n_remaining) {
+                    for (uint32_t slot = reference_accessor[n_remaining]; slot != no_reference_; slot = next_reference_accessor[slot]) {
+                        index_accessor[slot] = shape;
+                    }
+                    reference_accessor[shape] = reference_accessor[n_remaining];
+                }
+            }
+            count_accessor[0] = n_used;
+        });
+    });
+
+    const sycl::host_accessor<uint32_t, 1, sycl::access_mode::read> count_accessor(count_buffer);
+    n_nodes_ = count_accessor[0];
+    n_shapes_ -= sorted.size();
+    ++n_builds_;
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::BVH_t<T>::permute(sycl::queue& queue, sycl::buffer<uint32_t, 1>& order) -> void {
+    const size_t n_shapes = n_shapes_;
+    if ((order.get_range()[0] != n_shapes) || (n_shapes == 0)) {
+        return;
+    }
+
+    sycl::buffer<uint32_t, 1> positions(sycl::range<1>{n_shapes});
+    sycl::buffer<uint32_t, 1> references(references_.get_range());
+    queue.submit([&](sycl::handler& cgh) {
+        auto order_accessor         = order.template get_access<sycl::access::mode::read>(cgh);
+        auto reference_accessor     = references_.template get_access<sycl::access::mode::read>(cgh);
+        auto position_accessor      = positions.template get_access<sycl::access::mode::discard_write>(cgh);
+        auto new_reference_accessor = references.template get_access<sycl::access::mode::discard_write>(cgh);
+
+        cgh.parallel_for<class PermuteBVHReferences>(sycl::range<1>{n_shapes}, [=](sycl::id<1> WIid) {
+            const uint32_t previous      = order_accessor[WIid];
+            position_accessor[previous]  = static_cast<uint32_t>(WIid[0]);
+            new_reference_accessor[WIid] = reference_accessor[previous];
+        });
+    });
+
+    // Unused shape indices left by removals are not referenced by any leaf, and are left as they are
+    queue.submit([&](sycl::handler& cgh) {
+        auto position_accessor = positions.template get_access<sycl::access::mode::read>(cgh);
+        auto index_accessor    = indices_.template get_access<sycl::access::mode::read_write>(cgh);
+
+        cgh.parallel_for<class PermuteBVHIndices>(sycl::range<1>{n_indices_}, [=](sycl::id<1> WIid) {
+            if (index_accessor[WIid] < n_shapes) {
+                index_accessor[WIid] = position_accessor[index_accessor[WIid]];
+            }
+        });
+    });
+    references_ = std::move(references);
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::BVH_t<T>::reorder(size_t treelet_size) -> std::vector<uint32_t> {
+    std::vector<BVHNode_t<T>> nodes(n_nodes_);
+    std::vector<uint32_t> indices(n_indices_);
+    {
+        const sycl::host_accessor<BVHNode_t<T>, 1, sycl::access_mode::read> node_accessor(nodes_);
+        std::copy(node_accessor.begin(), node_accessor.begin() + static_cast<std::ptrdiff_t>(nodes.size()), nodes.begin());
+
+        const sycl::host_accessor<uint32_t, 1, sycl::access_mode::read> index_accessor(indices_);
+        std::copy(index_accessor.begin(), index_accessor.begin() + static_cast<std::ptrdiff_t>(indices.size()), indices.begin());
+    }
+
+    std::vector<uint32_t> shape_order(n_shapes_);
+    std::iota(shape_order.begin(), shape_order.end(), uint32_t{0});
+    if ((n_shapes_ == 0) || nodes[0].is_leaf()) {
+        return shape_order;
+    }
+
+    // Old index of each node in the new layout. The root stays first, then come the treelets.
+    const size_t pairs_per_treelet = std::max(treelet_size / (2 * sizeof(BVHNode_t<T>)), size_t{1});
+    std::vector<uint32_t> layout;
+    layout.reserve(nodes.size());
+    layout.push_back(0);
+
+    // Treelets are laid out depth first, so that each one is followed by the treelets below it
+    std::vector<uint32_t> treelet_roots{nodes[0].first_};
+    std::vector<bool> in_treelet(nodes.size(), false);
+    std::vector<uint32_t> stack;
+    while (!treelet_roots.empty()) {
+        const uint32_t treelet_root = treelet_roots.back();
+        treelet_roots.pop_back();
+        std::priority_queue<std::pair<T, uint32_t>> candidates;
+        candidates.emplace(T{0}, treelet_root);
+
+        for (size_t n_pairs = 0; (n_pairs < pairs_per_treelet) && !candidates.empty(); ++n_pairs) {
+            const uint32_t first = candidates.top().second;
+            candidates.pop();
+            in_treelet[first] = true;
+
+            for (const uint32_t child: {first, first + 1}) {
+                if (!nodes[child].is_leaf()) {
+                    candidates.emplace(nodes[child].surface_area(), nodes[child].first_);
+                }
+            }
+        }
+
+        // Inside a treelet, pairs are laid out depth first so that a pair is often in the same cache line as its parent
+        stack.push_back(treelet_root);
+        while (!stack.empty()) {
+            const uint32_t first = stack.back();
+            stack.pop_back();
+            layout.push_back(first);
+            layout.push_back(first + 1);
+
+            for (const uint32_t child: {first + 1, first}) {
+                if (!nodes[child].is_leaf() && in_treelet[nodes[child].first_]) {
+                    stack.push_back(nodes[child].first_);
+                }
+            }
+        }
+
+        // The largest pairs left out are pushed last, to be the first treelets below this one
+        const size_t n_roots = treelet_roots.size();
+        while (!candidates.empty()) {
+            treelet_roots.push_back(candidates.top().second);
+            candidates.pop();
+        }
+        std::reverse(treelet_roots.begin() + static_cast<std::ptrdiff_t>(n_roots), treelet_roots.end());
+    }
+
+    std::vector<uint32_t> new_index(nodes.size());
+    for (size_t i = 0; i < layout.size(); ++i) {
+        new_index[layout[i]] = static_cast<uint32_t>(i);
+    }
+
+    // Shapes are numbered depth first, so that shapes close in space are close in memory whatever the treelet they are in
+    constexpr uint32_t unassigned = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> shape_index(n_shapes_, unassigned);
+    uint32_t n_ordered = 0;
+    stack.push_back(0);
+    while (!stack.empty()) {
+        const BVHNode_t<T>& node = nodes[stack.back()];
+        stack.pop_back();
+        if (node.is_leaf()) {
+            for (uint32_t j = node.first_; j < node.first_ + node.count_; ++j) {
+                if (shape_index[indices[j]] == unassigned) {
+                    shape_index[indices[j]]  = n_ordered;
+                    shape_order[n_ordered++] = indices[j];
+                }
+            }
+        }
+        else {
+            stack.push_back(node.first_ + 1);
+            stack.push_back(node.first_);
+        }
+    }
+
+    // Shapes that no leaf references keep their relative order, at the end
+    for (uint32_t i = 0; i < n_shapes_; ++i) {
+        if (shape_index[i] == unassigned) {
+            shape_index[i]           = n_ordered;
+            shape_order[n_ordered++] = i;
+        }
+    }
+
+    std::vector<BVHNode_t<T>> new_nodes(layout.size());
+    std::vector<uint32_t> new_indices;
+    new_indices.reserve(indices.size());
+    for (size_t i = 0; i < layout.size(); ++i) {
+        BVHNode_t<T> node = nodes[layout[i]];
+        if (node.is_leaf()) {
+            const auto first = static_cast<uint32_t>(new_indices.size());
+            for (uint32_t j = node.first_; j < node.first_ + node.count_; ++j) {
+                new_indices.push_back(shape_index[indices[j]]);
+            }
+            node.first_ = first;
+        }
+        else {
+            node.first_ = new_index[node.first_];
+        }
+        new_nodes[i] = node;
+    }
+
+    upload(new_nodes, new_indices, n_shapes_);
+    return shape_order;
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::BVH_t<T>::cost(sycl::queue& queue) -> T {
+    submit_cost(queue);
+    return read_cost();
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::BVH_t<T>::submit_cost(sycl::queue& queue) -> void {
+    constexpr size_t block_size = 1024;
+    const size_t n_nodes        = n_nodes_;
+    const size_t n_blocks       = (n_nodes + block_size - 1) / block_size;
+
+    // The last element receives the area of the root
+    if (costs_.get_range()[0] < n_blocks + 1) {
+        costs_ = sycl::buffer<T, 1>(sycl::range<1>{n_blocks + 1});
+    }
+
+    queue.submit([&](sycl::handler& cgh) {
+        auto node_accessor = nodes_.template get_access<sycl::access::mode::read>(cgh);
+        auto cost_accessor = costs_.template get_access<sycl::access::mode::write>(cgh);
+
+        cgh.parallel_for<class BVHCost>(sycl::range<1>{n_blocks}, [=](sycl::id<1> WIid) {
+            const size_t begin = WIid[0] * block_size;
+            const size_t end   = std::min(begin + block_size, n_nodes);
+            T sum              = 0;
+            for (size_t i = begin; i < end; ++i) {
+                sum += node_accessor[i].sah_cost();
+            }
+            cost_accessor[WIid] = sum;
+            if (WIid[0] == 0) {
+                cost_accessor[n_blocks] = node_accessor[0].surface_area();
+            }
+        });
+    });
+
+    // The partial sums are added on the device, so that a single value is left to read
+    queue.submit([&](sycl::handler& cgh) {
+        auto cost_accessor = costs_.template get_access<sycl::access::mode::read_write>(cgh);
+
+        cgh.single_task<class BVHCostSum>([=]() {
+            T total_cost = 0;
+            for (size_t i = 0; i < n_blocks; ++i) {
+                total_cost += cost_accessor[i];
+            }
+            const T root_area = cost_accessor[n_blocks];
+            cost_accessor[0]  = (root_area > T{0}) ? total_cost / root_area : T{0};
+        });
+    });
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::BVH_t<T>::read_cost() -> T {
+    const sycl::host_accessor<T, 1, sycl::access_mode::read> cost_accessor(costs_);
+    return cost_accessor[0];
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::BVH_t<T>::upload(std::span<const BVHNode_t<T>> nodes, std::span<const uint32_t> indices, size_t n_shapes) -> void {
+    nodes_           = sycl::buffer<BVHNode_t<T>, 1>(sycl::range<1>{nodes.size()});
+    indices_         = sycl::buffer<uint32_t, 1>(sycl::range<1>{std::max(indices.size(), size_t{1})});
+    parents_         = sycl::buffer<uint32_t, 1>(sycl::range<1>{nodes.size()});
+    leaves_          = sycl::buffer<uint32_t, 1>(sycl::range<1>{std::max(indices.size(), size_t{1})});
+    references_      = sycl::buffer<uint32_t, 1>(sycl::range<1>{std::max(n_shapes, size_t{1})});
+    next_references_ = sycl::buffer<uint32_t, 1>(sycl::range<1>{std::max(indices.size(), size_t{1})});
+    heights_         = sycl::buffer<uint32_t, 1>(sycl::range<1>{nodes.size()});
+    flags_           = sycl::buffer<uint32_t, 1>(sycl::range<1>{nodes.size()});
+    n_nodes_         = nodes.size();
+    n_indices_       = indices.size();
+    n_shapes_        = n_shapes;
+    ++n_builds_;
+
+    const sycl::host_accessor<BVHNode_t<T>, 1, sycl::access_mode::write> node_accessor(nodes_, sycl::no_init);
+    std::copy(nodes.begin(), nodes.end(), node_accessor.begin());
+
+    const sycl::host_accessor<uint32_t, 1, sycl::access_mode::write> index_accessor(indices_, sycl::no_init);
+    std::copy(indices.begin(), indices.end(), index_accessor.begin());
+
+    const sycl::host_accessor<uint32_t, 1, sycl::access_mode::write> parent_accessor(parents_, sycl::no_init);
+    const sycl::host_accessor<uint32_t, 1, sycl::access_mode::write> leaf_accessor(leaves_, sycl::no_init);
+    const sycl::host_accessor<uint32_t, 1, sycl::access_mode::write> reference_accessor(references_, sycl::no_init);
+    const sycl::host_accessor<uint32_t, 1, sycl::access_mode::write> next_reference_accessor(next_references_, sycl::no_init);
+    parent_accessor[0] = 0;
+    std::fill(reference_accessor.begin(), reference_accessor.end(), no_reference_);
+    for (size_t i = 0; (i < nodes.size()) && (n_shapes > 0); ++i) {
+        if (nodes[i].is_leaf()) {
+            for (uint32_t j = nodes[i].first_; j < nodes[i].first_ + nodes[i].count_; ++j) {
+                leaf_accessor[j]               = static_cast<uint32_t>(i);
+                next_reference_accessor[j]     = reference_accessor[indices[j]];
+                reference_accessor[indices[j]] = j;
+            }
+        }
+        else {
+            parent_accessor[nodes[i].first_]     = static_cast<uint32_t>(i);
+            parent_accessor[nodes[i].first_ + 1] = static_cast<uint32_t>(i);
+        }
+    }
+
+    // Nodes in depth first order, so that going backwards reaches every node after its children
+    const sycl::host_accessor<uint32_t, 1, sycl::access_mode::write> height_accessor(heights_, sycl::no_init);
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> stack{0};
+    while (!stack.empty() && (n_shapes > 0)) {
+        const uint32_t node_index = stack.back();
+        stack.pop_back();
+        order.push_back(node_index);
+        if (!nodes[node_index].is_leaf()) {
+            stack.push_back(nodes[node_index].first_);
+            stack.push_back(nodes[node_index].first_ + 1);
+        }
+    }
+    height_accessor[0] = 0;
+    for (auto node_index = order.rbegin(); node_index != order.rend(); ++node_index) {
+        const BVHNode_t<T>& node     = nodes[*node_index];
+        height_accessor[*node_index] = node.is_leaf() ? 0 : std::max(height_accessor[node.first_], height_accessor[node.first_ + 1]) + 1;
+    }
+
+    build_cost_         = cost(nodes);
+    cost_pending_       = false;
+    build_cost_pending_ = false;
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::BVH_t<T>::link(sycl::queue& queue) -> void {
+    using atomic_uint = sycl::atomic_ref<uint32_t, sycl::memory_order::relaxed, sycl::memory_scope::device, sycl::access::address_space::global_space>;
+
+    queue.submit([&](sycl::handler& cgh) {
+        auto reference_accessor = references_.template get_access<sycl::access::mode::discard_write>(cgh);
+
+        cgh.parallel_for<class ResetBVHReferences>(sycl::range<1>{n_shapes_}, [=](sycl::id<1> WIid) { reference_accessor[WIid] = no_reference_; });
+    });
+
+    // Each shape index is pushed on the list of its shape, in any order
+    queue.submit([&](sycl::handler& cgh) {
+        auto node_accessor           = nodes_.template get_access<sycl::access::mode::read>(cgh);
+        auto index_accessor          = indices_.template get_access<sycl::access::mode::read>(cgh);
+        auto leaf_accessor           = leaves_.template get_access<sycl::access::mode::write>(cgh);
+        auto reference_accessor      = references_.template get_access<sycl::access::mode::read_write>(cgh);
+        auto next_reference_accessor = next_references_.template get_access<sycl::access::mode::write>(cgh);
+
+        cgh.parallel_for<class LinkBVH>(sycl::range<1>{n_nodes_}, [=](sycl::id<1> WIid) {
+            const BVHNode_t<T>& node = node_accessor[WIid];
+            if (!node.is_leaf()) {
+                return;
+            }
+
+            for (uint32_t j = node.first_; j < node.first_ + node.count_; ++j) {
+                leaf_accessor[j]           = static_cast<uint32_t>(WIid[0]);
+                next_reference_accessor[j] = atomic_uint(reference_accessor[index_accessor[j]]).exchange(j);
+            }
+        });
+    });
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::BVH_t<T>::reserve(sycl::queue& queue, size_t n_nodes, size_t n_indices, size_t n_shapes) -> void {
+    grow(queue, nodes_, n_nodes_, n_nodes);
+    grow(queue, parents_, n_nodes_, n_nodes);
+    grow(queue, heights_, n_nodes_, n_nodes);
+    grow(queue, indices_, n_indices_, n_indices);
+    grow(queue, leaves_, n_indices_, n_indices);
+    grow(queue, next_references_, n_indices_, n_indices);
+    grow(queue, references_, n_shapes_, n_shapes);
+    if (flags_.get_range()[0] < n_nodes) {
+        flags_ = sycl::buffer<uint32_t, 1>(nodes_.get_range());
+    }
+}
+
+template<typename T>
+template<typename U>
+auto AGPTracer::AccelerationStructures::BVH_t<T>::grow(sycl::queue& queue, sycl::buffer<U, 1>& buffer, size_t n_used, size_t size) -> void {
+    if (buffer.get_range()[0] >= size) {
+        return;
+    }
+
+    // The capacity doubles, so that inserting shapes one at a time copies each element a constant number of times on average
+    sycl::buffer<U, 1> new_buffer(sycl::range<1>{std::max(size, 2 * buffer.get_range()[0])});
+    if (n_used > 0) {
+        queue.submit([&](sycl::handler& cgh) {
+            auto accessor     = buffer.template get_access<sycl::access::mode::read>(cgh);
+            auto new_accessor = new_buffer.template get_access<sycl::access::mode::discard_write>(cgh);
+
+            cgh.parallel_for<class GrowBVHBuffer>(sycl::range<1>{n_used}, [=](sycl::id<1> WIid) { new_accessor[WIid] = accessor[WIid]; });
+        });
+    }
+    buffer = std::move(new_buffer);
+}
+
+template<typename T>
+template<template<typename> typename S>
+auto AGPTracer::AccelerationStructures::BVH_t<T>::fit_masks(sycl::buffer<S<T>, 1>& shapes) -> void {
+    if constexpr (Entities::Masked<S, T>) {
+        if (n_shapes_ == 0) {
+            return;
+        }
+
+        std::vector<uint32_t> masks(shapes.get_range()[0]);
+        std::vector<BVHNode_t<T>> nodes(n_nodes_);
+        std::vector<uint32_t> indices(n_indices_);
+        {
+            const sycl::host_accessor<S<T>, 1, sycl::access_mode::read> shape_accessor(shapes);
+            const sycl::host_accessor<BVHNode_t<T>, 1, sycl::access_mode::read> node_accessor(nodes_);
+            const sycl::host_accessor<uint32_t, 1, sycl::access_mode::read> index_accessor(indices_);
+            for (size_t i = 0; i < masks.size(); ++i) {
+                masks[i] = shape_accessor[i].mask_;
+            }
+            std::copy(node_accessor.begin(), node_accessor.begin() + static_cast<std::ptrdiff_t>(nodes.size()), nodes.begin());
+            std::copy(index_accessor.begin(), index_accessor.begin() + static_cast<std::ptrdiff_t>(indices.size()), indices.begin());
+        }
+
+        fit_masks(nodes, indices, masks);
+
+        const sycl::host_accessor<BVHNode_t<T>, 1, sycl::access_mode::write> node_accessor(nodes_);
+        std::copy(nodes.begin(), nodes.end(), node_accessor.begin());
+    }
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::BVH_t<T>::fit_masks(std::span<BVHNode_t<T>> nodes, std::span<const uint32_t> indices, std::span<const uint32_t> masks, uint32_t root) -> void {
+    // Nodes in depth first order, so that going backwards reaches every node after its children
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> stack{root};
+    while (!stack.empty()) {
+        const uint32_t node_index = stack.back();
+        stack.pop_back();
+        order.push_back(node_index);
+        if (!nodes[node_index].is_leaf()) {
+            stack.push_back(nodes[node_index].first_);
+            stack.push_back(nodes[node_index].first_ + 1);
+        }
+    }
+
+    for (auto node_index = order.rbegin(); node_index != order.rend(); ++node_index) {
+        BVHNode_t<T>& node = nodes[*node_index];
+        if (node.is_leaf()) {
+            node.mask_ = 0;
+            for (uint32_t i = node.first_; i < node.first_ + node.count_; ++i) {
+                node.mask_ |= masks[indices[i]];
+            }
+        }
+        else {
+            node.mask_ = nodes[node.first_].mask_ | nodes[node.first_ + 1].mask_;
+        }
+    }
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::BVH_t<T>::cost(std::span<const BVHNode_t<T>> nodes) -> T {
+    const T total_cost = std::accumulate(nodes.begin(), nodes.end(), T{0}, [](T sum, const BVHNode_t<T>& node) { return sum + node.sah_cost(); });
+    const T root_area  = nodes[0].surface_area();
+    return (root_area > T{0}) ? total_cost / root_area : T{0};
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::BVH_t<T>::getAccessor(sycl::handler& cgh) -> Accessor_t {
+    return Accessor_t(cgh, nodes_, indices_, parents_);
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::BVH_t<T>::getAccessor(sycl::handler& cgh, size_t cached_levels) -> Accessor_t {
+    return Accessor_t(cgh, nodes_, indices_, parents_, cached_levels);
+}
+
+template<typename T>
+constexpr auto AGPTracer::AccelerationStructures::BVH_t<T>::max_cached_levels(size_t local_memory) -> size_t {
+    size_t levels = 0;
+    while ((levels < max_cached_levels_) && (((size_t{1} << (levels + 1)) - 1) * sizeof(BVHNode_t<T>) <= local_memory)) {
+        ++levels;
+    }
+    return levels;
+}
+
+template<typename T>
+AGPTracer::AccelerationStructures::BVH_t<T>::Accessor_t::Accessor_t(sycl::handler& cgh,
+                                                                    sycl::buffer<BVHNode_t<T>, 1>& nodes,
+                                                                    sycl::buffer<uint32_t, 1>& indices,
+                                                                    sycl::buffer<uint32_t, 1>& parents) :
+        nodes_(nodes.template get_access<sycl::access::mode::read>(cgh)),
+        indices_(indices.template get_access<sycl::access::mode::read>(cgh)),
+        parents_(parents.template get_access<sycl::access::mode::read>(cgh)),
+        n_cached_(0) {}
+
+template<typename T>
+AGPTracer::AccelerationStructures::BVH_t<T>::Accessor_t::Accessor_t(sycl::handler& cgh,
+                                                                    sycl::buffer<BVHNode_t<T>, 1>& nodes,
+                                                                    sycl::buffer<uint32_t, 1>& indices,
+                                                                    sycl::buffer<uint32_t, 1>& parents,
+                                                                    size_t cached_levels) :
+        nodes_(nodes.template get_access<sycl::access::mode::read>(cgh)),
+        indices_(indices.template get_access<sycl::access::mode::read>(cgh)),
+        parents_(parents.template get_access<sycl::access::mode::read>(cgh)),
+        n_cached_((uint32_t{1} << std::min(cached_levels, max_cached_levels_)) - 1) {
+    if (n_cached_ > 0) {
+        cache_ = sycl::local_accessor<BVHNode_t<T>, 1>(sycl::range<1>{n_cached_}, cgh);
+    }
+}
+
+template<typename T>
+template<int D>
+auto AGPTracer::AccelerationStructures::BVH_t<T>::Accessor_t::load(const sycl::nd_item<D>& item) const -> void {
+    if (n_cached_ == 0) {
+        return;
+    }
+
+    const size_t group_size = item.get_group().get_local_linear_range();
+    for (size_t slot = item.get_local_linear_id(); slot < n_cached_; slot += group_size) {
+        // The bits of the heap position after the leading one are the path from the root, 0 for the left child and 1 for the right child
+        const auto position = static_cast<uint32_t>(slot + 1);
+        uint32_t node_index = 0;
+        bool exists         = true;
+        for (int level = std::bit_width(position) - 2; level >= 0; --level) {
+            const BVHNode_t<T>& node = nodes_[node_index];
+            if (node.is_leaf() || (nodes_.get_range()[0] == 1)) {
+                exists = false;
+                break;
+            }
+            node_index = node.first_ + ((position >> static_cast<uint32_t>(level)) & 1U);
+        }
+        cache_[slot] = exists ? nodes_[node_index] : BVHNode_t<T>();
+    }
+    sycl::group_barrier(item.get_group());
+}
+
+template<typename T>
+template<size_t N, class F>
+auto AGPTracer::AccelerationStructures::BVH_t<T>::Accessor_t::traverse(const Entities::Ray_t<T, N>& ray, T& t, F leaf) const -> void {
+    if (n_cached_ > 0) {
+        traverse_cached(ray, t, leaf);
+        return;
+    }
+#ifdef AGPTRACER_STACKLESS_TRAVERSAL
+    traverse_stackless(ray, t, leaf);
+#else
+    traverse_stack(ray, t, leaf);
+#endif
+}
+
+template<typename T>
+template<size_t N, class F>
+auto AGPTracer::AccelerationStructures::BVH_t<T>::Accessor_t::traverse_stack(const Entities::Ray_t<T, N>& ray, T& t, F leaf) const -> void {
+    constexpr size_t max_stack_size = BVHNode_t<T>::max_depth_;
+    const Entities::Vec3<T> inverse_direction(T{1} / ray.direction_[0], T{1} / ray.direction_[1], T{1} / ray.direction_[2]);
+
+    std::array<uint32_t, max_stack_size> stack; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+    size_t stack_size   = 0;
+    uint32_t node_index = 0;
+    T t_node{};
+
+    // The empty box of an empty hierarchy is hit by every ray, and its root would be taken for an inner node
+    if ((nodes_.get_range()[0] == 1) && !nodes_[0].is_leaf()) {
+        return;
+    }
+    if (!nodes_[0].visible(ray.visibility_) || !nodes_[0].intersection(ray.origin_, inverse_direction, t, t_node)) {
+        return;
+    }
+
+    while (true) {
+        const BVHNode_t<T>& node = nodes_[node_index];
+
+        if (node.is_leaf()) {
+            for (uint32_t i = node.first_; i < node.first_ + node.count_; ++i) {
+                if (leaf(static_cast<size_t>(indices_[i]), t)) {
+                    return;
+                }
+            }
+        }
+        else {
+            T t_left{};
+            T t_right{};
+            const bool hit_left  = nodes_[node.first_].visible(ray.visibility_) && nodes_[node.first_].intersection(ray.origin_, inverse_direction, t, t_left);
+            const bool hit_right = nodes_[node.first_ + 1].visible(ray.visibility_) && nodes_[node.first_ + 1].intersection(ray.origin_, inverse_direction, t, t_right);
+
+            if (hit_left && hit_right) {
+                const bool left_first = t_left <= t_right;
+                // Hierarchies are at most max_depth_ deep, so the stack never fills up. The check only keeps a deeper one from writing past it.
+                if (stack_size < max_stack_size) {
+                    stack[stack_size++] = left_first ? node.first_ + 1 : node.first_;
+                }
+                node_index = left_first ? node.first_ : node.first_ + 1;
+                continue;
+            }
+            if (hit_left || hit_right) {
+                node_index = hit_left ? node.first_ : node.first_ + 1;
+                continue;
+            }
+        }
+
+        if (stack_size == 0) {
+            return;
+        }
+        node_index = stack[--stack_size];
+    }
+}
+
+template<typename T>
+template<size_t N, class F>
+auto AGPTracer::AccelerationStructures::BVH_t<T>::Accessor_t::traverse_cached(const Entities::Ray_t<T, N>& ray, T& t, F leaf) const -> void {
+    constexpr size_t max_stack_size = BVHNode_t<T>::max_depth_;
+    const Entities::Vec3<T> inverse_direction(T{1} / ray.direction_[0], T{1} / ray.direction_[1], T{1} / ray.direction_[2]);
+
+    // Nodes past the cached levels have the slot n_cached_
+    std::array<uint32_t, max_stack_size> stack; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+    std::array<uint32_t, max_stack_size> stack_slots; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+    size_t stack_size   = 0;
+    uint32_t node_index = 0;
+    uint32_t slot       = 0;
+    T t_node{};
+
+    // The empty box of an empty hierarchy is hit by every ray, and its root would be taken for an inner node
+    if ((nodes_.get_range()[0] == 1) && !nodes_[0].is_leaf()) {
+        return;
+    }
+    if (!cache_[0].visible(ray.visibility_) || !cache_[0].intersection(ray.origin_, inverse_direction, t, t_node)) {
+        return;
+    }
+
+    while (true) {
+        const BVHNode_t<T>& node = (slot < n_cached_) ? cache_[slot] : nodes_[node_index];
+
+        if (node.is_leaf()) {
+            for (uint32_t i = node.first_; i < node.first_ + node.count_; ++i) {
+                if (leaf(static_cast<size_t>(indices_[i]), t)) {
+                    return;
+                }
+            }
+        }
+        else {
+            const uint32_t left_slot  = (slot < n_cached_) ? 2 * slot + 1 : n_cached_;
+            const bool cached         = left_slot < n_cached_;
+            const uint32_t right_slot = cached ? left_slot + 1 : n_cached_;
+            const BVHNode_t<T>& left  = cached ? cache_[left_slot] : nodes_[node.first_];
+            const BVHNode_t<T>& right = cached ? cache_[right_slot] : nodes_[node.first_ + 1];
+
+            T t_left{};
+            T t_right{};
+            const bool hit_left  = left.visible(ray.visibility_) && left.intersection(ray.origin_, inverse_direction, t, t_left);
+            const bool hit_right = right.visible(ray.visibility_) && right.intersection(ray.origin_, inverse_direction, t, t_right);
+
+            if (hit_left && hit_right) {
+                const bool left_first = t_left <= t_right;
+                if (stack_size < max_stack_size) {
+                    stack[stack_size]         = left_first ? node.first_ + 1 : node.first_;
+                    stack_slots[stack_size++] = left_first ? right_slot : left_slot;
+                }
+                node_index = left_first ? node.first_ : node.first_ + 1;
+                slot       = left_first ? left_slot : right_slot;
+                continue;
+            }
+            if (hit_left || hit_right) {
+                node_index = hit_left ? node.first_ : node.first_ + 1;
+                slot       = hit_left ? left_slot : right_slot;
+                continue;
+            }
+        }
+
+        if (stack_size == 0) {
+            return;
+        }
+        --stack_size;
+        node_index = stack[stack_size];
+        slot       = stack_slots[stack_size];
+    }
+}
+
+template<typename T>
+template<size_t N, class F>
+auto AGPTracer::AccelerationStructures::BVH_t<T>::Accessor_t::traverse_stackless(const Entities::Ray_t<T, N>& ray, T& t, F leaf) const -> void {
+    enum class From : unsigned int {
+        parent,
+        sibling,
+        child
+    };
+
+    const Entities::Vec3<T> inverse_direction(T{1} / ray.direction_[0], T{1} / ray.direction_[1], T{1} / ray.direction_[2]);
+    T t_node{};
+
+    // The empty box of an empty hierarchy is hit by every ray, and its root would be taken for an inner node
+    if ((nodes_.get_range()[0] == 1) && !nodes_[0].is_leaf()) {
+        return;
+    }
+    if (!nodes_[0].visible(ray.visibility_) || !nodes_[0].intersection(ray.origin_, inverse_direction, t, t_node)) {
+        return;
+    }
+    if (nodes_[0].is_leaf()) {
+        for (uint32_t i = nodes_[0].first_; i < nodes_[0].first_ + nodes_[0].count_; ++i) {
+            if (leaf(static_cast<size_t>(indices_[i]), t)) {
+                return;
+            }
+        }
+        return;
+    }
+
+    // The entry distance of a box doesn't depend on t, only whether it is hit does
+    const auto near_child = [&](uint32_t node_index) -> uint32_t {
+        const uint32_t first = nodes_[node_index].first_;
+        T t_left{};
+        T t_right{};
+        nodes_[first].intersection(ray.origin_, inverse_direction, t, t_left);
+        nodes_[first + 1].intersection(ray.origin_, inverse_direction, t, t_right);
+        return (t_left <= t_right) ? first : first + 1;
+    };
+    const auto sibling = [&](uint32_t node_index) -> uint32_t {
+        return (node_index == nodes_[parents_[node_index]].first_) ? node_index + 1 : node_index - 1;
+    };
+
+    uint32_t node_index = near_child(0);
+    From from           = From::parent;
+
+    while (true) {
+        if (from == From::child) {
+            if (node_index == 0) {
+                return;
+            }
+            const uint32_t parent = parents_[node_index];
+            if (node_index == near_child(parent)) {
+                node_index = sibling(node_index);
+                from       = From::sibling;
+            }
+            else {
+                node_index = parent;
+            }
+            continue;
+        }
+
+        const BVHNode_t<T>& node = nodes_[node_index];
+        if (node.visible(ray.visibility_) && node.intersection(ray.origin_, inverse_direction, t, t_node)) {
+            if (!node.is_leaf()) {
+                node_index = near_child(node_index);
+                from       = From::parent;
+                continue;
+            }
+            for (uint32_t i = node.first_; i < node.first_ + node.count_; ++i) {
+                if (leaf(static_cast<size_t>(indices_[i]), t)) {
+                    return;
+                }
+            }
+        }
+
+        // The near child goes on to its sibling, the far child goes back up
+        if (from == From::parent) {
+            node_index = sibling(node_index);
+            from       = From::sibling;
+        }
+        else {
+            node_index = parents_[node_index];
+            from       = From::child;
+        }
+    }
+}
+
+template<typename T>
+template<size_t N, size_t P, class F>
+auto AGPTracer::AccelerationStructures::BVH_t<T>::Accessor_t::traverse_packet(const std::array<Entities::Ray_t<T, N>, P>& rays, size_t n_rays, std::array<T, P>& t, F leaf) const -> void {
+    constexpr size_t max_stack_size = BVHNode_t<T>::max_depth_;
+
+    // The empty box of an empty hierarchy is hit by every ray, and its root would be taken for an inner node
+    if ((n_rays == 0) || ((nodes_.get_range()[0] == 1) && !nodes_[0].is_leaf())) {
+        return;
+    }
+
+    std::array<Entities::Vec3<T>, P> inverse_directions;
+    Entities::Vec3<T> origin_min(std::numeric_limits<T>::max());
+    Entities::Vec3<T> origin_max(std::numeric_limits<T>::lowest());
+    Entities::Vec3<T> inverse_min(std::numeric_limits<T>::max());
+    Entities::Vec3<T> inverse_max(std::numeric_limits<T>::lowest());
+    uint32_t visibility = 0;
+    T t_packet          = T{0};
+    for (size_t i = 0; i < n_rays; ++i) {
+        inverse_directions[i] = Entities::Vec3<T>(T{1} / rays[i].direction_[0], T{1} / rays[i].direction_[1], T{1} / rays[i].direction_[2]);
+        origin_min.min(rays[i].origin_);
+        origin_max.max(rays[i].origin_);
+        inverse_min.min(inverse_directions[i]);
+        inverse_max.max(inverse_directions[i]);
+        visibility |= rays[i].visibility_;
+        t_packet = std::max(t_packet, t[i]);
+    }
+
+    // Lower and upper bounds of the distances to a plane over all the rays, as the product of two intervals
+    const auto plane_distances = [&](size_t axis, T plane) -> std::array<T, 2> {
+        const T offset_low              = plane - origin_max[axis];
+        const T offset_high             = plane - origin_min[axis];
+        const std::array<T, 4> products = {offset_low * inverse_min[axis], offset_high * inverse_min[axis], offset_low * inverse_max[axis], offset_high * inverse_max[axis]};
+        return {std::min(std::min(products[0], products[1]), std::min(products[2], products[3])), std::max(std::max(products[0], products[1]), std::max(products[2], products[3]))};
+    };
+
+    // A node is culled when the latest entry of any ray is after the earliest exit of any ray. Axes on which the
+    // directions change sign have unbounded inverse directions, and are left out.
+    const auto frustum_intersection = [&](const BVHNode_t<T>& node, T& t_enter) -> bool {
+        T t_exit = t_packet;
+        t_enter  = T{0};
+        for (size_t axis = 0; axis < 3; ++axis) {
+            const bool positive = inverse_min[axis] > T{0};
+            if (!positive && (inverse_max[axis] >= T{0})) {
+                continue;
+            }
+            t_enter = std::max(t_enter, plane_distances(axis, positive ? node.min_[axis] : node.max_[axis])[0]);
+            t_exit  = std::min(t_exit, plane_distances(axis, positive ? node.max_[axis] : node.min_[axis])[1]);
+        }
+        return node.visible(visibility) && (t_enter <= t_exit);
+    };
+
+    std::array<uint32_t, max_stack_size> stack; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+    size_t stack_size   = 0;
+    uint32_t node_index = 0;
+    T t_node{};
+
+    if (!frustum_intersection(nodes_[0], t_node)) {
+        return;
+    }
+
+    while (true) {
+        const BVHNode_t<T>& node = nodes_[node_index];
+
+        if (node.is_leaf()) {
+            // Each ray is tested against the box of the leaf, which is cheaper than the shapes it holds
+            t_packet = T{0};
+            for (size_t j = 0; j < n_rays; ++j) {
+                if (node.visible(rays[j].visibility_) && node.intersection(rays[j].origin_, inverse_directions[j], t[j], t_node)) {
+                    for (uint32_t i = node.first_; i < node.first_ + node.count_; ++i) {
+                        leaf(j, static_cast<size_t>(indices_[i]), t[j]);
+                    }
+                }
+                t_packet = std::max(t_packet, t[j]);
+            }
+        }
+        else {
+            T t_left{};
+            T t_right{};
+            const bool hit_left  = frustum_intersection(nodes_[node.first_], t_left);
+            const bool hit_right = frustum_intersection(nodes_[node.first_ + 1], t_right);
+
+            if (hit_left && hit_right) {
+                const bool left_first = t_left <= t_right;
+                // Same bound as traverse_stack
+                if (stack_size < max_stack_size) {
+                    stack[stack_size++] = left_first ? node.first_ + 1 : node.first_;
+                }
+                node_index = left_first ? node.first_ : node.first_ + 1;
+                continue;
+            }
+            if (hit_left || hit_right) {
+                node_index = hit_left ? node.first_ : node.first_ + 1;
+                continue;
+            }
+        }
+
+        if (stack_size == 0) {
+            return;
+        }
+        node_index = stack[--stack_size];
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef AGPTRACER_ACCELERATIONSTRUCTURES_COMPRESSEDBVHNODE_T_HPP
+#define AGPTRACER_ACCELERATIONSTRUCTURES_COMPRESSEDBVHNODE_T_HPP
+
+#include "acceleration_structures/WideBVHNode_t.hpp"
+#include "entities/Vec3.hpp"
+#include <array>
+#include <cstdint>
+#include <sycl/sycl.hpp>
+
+namespace AGPTracer::AccelerationStructures {
+    /**
+     * @brief The compressed BVH node class represents a node of a wide bounding volume hierarchy whose child bounding boxes are quantised.
+     *
+     * The node stores the minimum corner of the box around all its children at full precision, and a power of two scale per axis,
+     * as a shared exponent. The bounding box of each child is then stored as 8 bit integer offsets from that corner, in units of
+     * the scale. Offsets are rounded outwards when the node is compressed, so the decoded boxes always contain the original ones,
+     * and a ray can't miss a shape. Decoding costs a multiply-add per coordinate during traversal, but a node with 8 children is
+     * about a quarter of the size of the full precision node for doubles, so much more of the hierarchy fits in cache and in memory.
+     *
+     * @tparam T Floating point datatype to use
+     * @tparam W Maximum number of children of a node
+     */
+    template<typename T = double, size_t W = 4>
+    class CompressedBVHNode_t {
+        public:
+            /**
+             * @brief Construct a new CompressedBVHNode_t object without children, which no ray can intersect.
+             */
+            CompressedBVHNode_t();
+
+            /**
+             * @brief Construct a new CompressedBVHNode_t object by quantising the bounding boxes of the children of a full precision node.
+             *
+             * @param node Node to compress.
+             */
+            explicit CompressedBVHNode_t(const WideBVHNode_t<T, W>& node);
+
+            Entities::Vec3<T> origin_; /**< @brief Minimum coordinates of the bounding box around all the children, from which the offsets are measured.*/
+            std::array<int8_t, 3> exponent_; /**< @brief Exponent of the power of two size of an offset unit, for each coordinate.*/
+            uint8_t n_children_; /**< @brief Number of children of the node, stored in the first slots.*/
+            std::array<std::array<uint8_t, W>, 3> min_; /**< @brief Quantised minimum coordinates of the bounding boxes of the children, rounded down, by coordinate then by child.*/
+            std::array<std::array<uint8_t, W>, 3> max_; /**< @brief Quantised maximum coordinates of the bounding boxes of the children, rounded up, by coordinate then by child.*/
+            std::array<uint8_t, W> count_; /**< @brief Number of shapes in each leaf. Inner children have a count of 0.*/
+            std::array<uint32_t, W> first_; /**< @brief Index of the node of each inner child, or index of the first shape index of each leaf.*/
+
+            /**
+             * @brief Returns whether a child is a leaf, containing shapes, or an inner node, containing other nodes.
+             *
+             * @param child Slot of the child.
+             * @return true The child is a leaf, first_ and count_ describe a range of shape indices.
+             * @return false The child is an inner node, stored at first_.
+             */
+            constexpr auto is_leaf(uint32_t child) const -> bool;
+
+            /**
+             * @brief Intersects a ray with the decoded bounding boxes of all the children, using the slab method.
+             *
+             * @param origin Origin of the ray.
+             * @param inverse_direction Component-wise inverse of the direction of the ray.
+             * @param t_max Distance past which intersections are ignored, usually the closest intersection found so far.
+             * @param[out] t Distance at which the ray enters the bounding box of each child. Undefined for the children not intersected.
+             * @return uint32_t Bit mask of the children intersected before t_max, with the bit i set if the child i is intersected.
+             */
+            auto intersection(const Entities::Vec3<T>& origin, const Entities::Vec3<T>& inverse_direction, T t_max, std::array<T, W>& t) const -> uint32_t;
+    };
+}
+
+#include "acceleration_structures/CompressedBVHNode_t.tpp"
+
+#endif
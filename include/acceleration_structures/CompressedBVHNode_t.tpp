@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+template<typename T, size_t W>
+AGPTracer::AccelerationStructures::CompressedBVHNode_t<T, W>::CompressedBVHNode_t() : origin_(0), exponent_{}, n_children_(0), min_{}, max_{}, count_{}, first_{} {}
+
+template<typename T, size_t W>
+AGPTracer::AccelerationStructures::CompressedBVHNode_t<T, W>::CompressedBVHNode_t(const WideBVHNode_t<T, W>& node) :
+        origin_(0), exponent_{}, n_children_(static_cast<uint8_t>(node.n_children_)), min_{}, max_{}, count_{}, first_{} {
+    constexpr int min_exponent = std::numeric_limits<int8_t>::min();
+    constexpr int max_exponent = std::numeric_limits<int8_t>::max();
+    constexpr int max_offset   = std::numeric_limits<uint8_t>::max();
+
+    for (uint32_t i = 0; i < n_children_; ++i) {
+        count_[i] = static_cast<uint8_t>(node.count_[i]);
+        first_[i] = node.first_[i];
+    }
+
+    for (size_t j = 0; j < 3; ++j) {
+        T minimum = std::numeric_limits<T>::max();
+        T maximum = std::numeric_limits<T>::lowest();
+        for (uint32_t i = 0; i < n_children_; ++i) {
+            minimum = std::min(minimum, node.min_[j][i]);
+            maximum = std::max(maximum, node.max_[j][i]);
+        }
+        if (n_children_ == 0) {
+            continue;
+        }
+
+        int exponent = min_exponent;
+        if (maximum > minimum) {
+            std::frexp((maximum - minimum) / static_cast<T>(max_offset), &exponent);
+            exponent = std::clamp(exponent, min_exponent, max_exponent);
+        }
+        // The decoded coordinates are rounded, so the largest offset has to be checked against the maximum
+        while ((exponent < max_exponent) && (minimum + static_cast<T>(max_offset) * std::ldexp(T{1}, exponent) < maximum)) {
+            ++exponent;
+        }
+
+        const T scale = std::ldexp(T{1}, exponent);
+        origin_[j]    = minimum;
+        exponent_[j]  = static_cast<int8_t>(exponent);
+
+        // Offsets are rounded outwards, then moved until the decoded box contains the child's box
+        for (uint32_t i = 0; i < n_children_; ++i) {
+            auto low  = std::clamp(static_cast<int>(std::floor((node.min_[j][i] - minimum) / scale)), 0, max_offset);
+            auto high = std::clamp(static_cast<int>(std::ceil((node.max_[j][i] - minimum) / scale)), 0, max_offset);
+            while ((low > 0) && (minimum + static_cast<T>(low) * scale > node.min_[j][i])) {
+                --low;
+            }
+            while ((high < max_offset) && (minimum + static_cast<T>(high) * scale < node.max_[j][i])) {
+                ++high;
+            }
+            min_[j][i] = static_cast<uint8_t>(low);
+            max_[j][i] = static_cast<uint8_t>(high);
+        }
+    }
+}
+
+template<typename T, size_t W>
+constexpr auto AGPTracer::AccelerationStructures::CompressedBVHNode_t<T, W>::is_leaf(uint32_t child) const -> bool {
+    return count_[child] > 0;
+}
+
+template<typename T, size_t W>
+auto AGPTracer::AccelerationStructures::CompressedBVHNode_t<T, W>::intersection(const Entities::Vec3<T>& origin, const Entities::Vec3<T>& inverse_direction, T t_max, std::array<T, W>& t) const
+    -> uint32_t {
+    const Entities::Vec3<T> scale(sycl::ldexp(T{1}, static_cast<int>(exponent_[0])), sycl::ldexp(T{1}, static_cast<int>(exponent_[1])), sycl::ldexp(T{1}, static_cast<int>(exponent_[2])));
+    uint32_t hits = 0;
+
+    for (uint32_t i = 0; i < W; ++i) {
+        const T tx1 = (origin_[0] + static_cast<T>(min_[0][i]) * scale[0] - origin[0]) * inverse_direction[0];
+        const T tx2 = (origin_[0] + static_cast<T>(max_[0][i]) * scale[0] - origin[0]) * inverse_direction[0];
+        const T ty1 = (origin_[1] + static_cast<T>(min_[1][i]) * scale[1] - origin[1]) * inverse_direction[1];
+        const T ty2 = (origin_[1] + static_cast<T>(max_[1][i]) * scale[1] - origin[1]) * inverse_direction[1];
+        const T tz1 = (origin_[2] + static_cast<T>(min_[2][i]) * scale[2] - origin[2]) * inverse_direction[2];
+        const T tz2 = (origin_[2] + static_cast<T>(max_[2][i]) * scale[2] - origin[2]) * inverse_direction[2];
+
+        const T t_enter = std::max(std::max(std::min(tx1, tx2), std::min(ty1, ty2)), std::max(std::min(tz1, tz2), T{0}));
+        const T t_exit  = std::min(std::min(std::max(tx1, tx2), std::max(ty1, ty2)), std::min(std::max(tz1, tz2), t_max));
+
+        t[i] = t_enter;
+        hits |= (static_cast<uint32_t>(t_enter <= t_exit) & static_cast<uint32_t>(i < n_children_)) << i;
+    }
+
+    return hits;
+}
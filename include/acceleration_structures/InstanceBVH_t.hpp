@@ -0,0 +1,158 @@
+#ifndef AGPTRACER_ACCELERATIONSTRUCTURES_INSTANCEBVH_T_HPP
+#define AGPTRACER_ACCELERATIONSTRUCTURES_INSTANCEBVH_T_HPP
+
+#include "acceleration_structures/BVHNode_t.hpp"
+#include "acceleration_structures/BVH_t.hpp"
+#include "entities/Ray_t.hpp"
+#include "entities/Shape.hpp"
+#include "shapes/MeshTop_t.hpp"
+#include <array>
+#include <cstdint>
+#include <span>
+#include <sycl/sycl.hpp>
+
+namespace AGPTracer::AccelerationStructures {
+    /**
+     * @brief The instance BVH class is a two-level bounding volume hierarchy, used to intersect many instances of a few meshes.
+     *
+     * The bottom level holds one hierarchy per mesh, built once on the host around the mesh's shapes in object space. All of them
+     * are stored in the same node and index buffers, and the root of each is kept in roots_. The top level is a BVH_t around the
+     * instances in world space, which is refitted or rebuilt on the device when instances move. A ray traverses the top level, and
+     * for each instance it hits, it is moved to object space and traverses the hierarchy of the instance's mesh. Memory grows with
+     * the number of shapes in the meshes, and only by an instance and a top-level node per instance.
+     *
+     * @tparam T Floating point datatype to use
+     */
+    template<typename T = double>
+    class InstanceBVH_t {
+        public:
+            class Accessor_t {
+                public:
+                    /**
+                     * @brief Construct a new Accessor_t object with the given buffers.
+                     *
+                     * @param cgh Device handler.
+                     * @param top Top-level hierarchy to access.
+                     * @param nodes Bottom-level node buffer to access.
+                     * @param indices Bottom-level shape index buffer to access.
+                     * @param roots Mesh root buffer to access.
+                     * @param instances Instance buffer to access.
+                     */
+                    Accessor_t(sycl::handler& cgh,
+                               BVH_t<T>& top,
+                               sycl::buffer<BVHNode_t<T>, 1>& nodes,
+                               sycl::buffer<uint32_t, 1>& indices,
+                               sycl::buffer<uint32_t, 1>& roots,
+                               sycl::buffer<Shapes::MeshTop_t<T>, 1>& instances);
+
+                    /**
+                     * @brief Traverses both levels of the hierarchy with a ray, calling a function for each shape whose leaf is hit by the ray.
+                     *
+                     * The leaf function is called with the index of an instance, the index of a shape of the instance's mesh, the
+                     * ray in the object space of the instance and a reference to t. Distances are the same in world and object space,
+                     * so t is shared by both levels. The function should lower t when it finds a closer intersection, and return true
+                     * to stop the traversal. Instances and mesh nodes that the ray can't see, according to their visibility masks, are
+                     * skipped.
+                     *
+                     * @tparam N Number of mediums in the ray's medium list
+                     * @tparam F Leaf function type, callable as bool(size_t instance, size_t index, const Entities::Ray_t<T, N>& object_ray, T& t)
+                     * @param[in] ray Ray to traverse the hierarchy with, in world space.
+                     * @param[in, out] t Distance past which nodes are skipped. Lowered by the leaf function.
+                     * @param[in] leaf Function called for each shape of the leaves hit by the ray.
+                     */
+                    template<size_t N, class F>
+                    auto traverse(const Entities::Ray_t<T, N>& ray, T& t, F leaf) const -> void;
+
+                private:
+                    typename BVH_t<T>::Accessor_t top_; /**< @brief Accessor to the top-level hierarchy.*/
+                    sycl::accessor<BVHNode_t<T>, 1, sycl::access::mode::read> nodes_; /**< @brief Accessor to the bottom-level nodes.*/
+                    sycl::accessor<uint32_t, 1, sycl::access::mode::read> indices_; /**< @brief Accessor to the bottom-level shape indices.*/
+                    sycl::accessor<uint32_t, 1, sycl::access::mode::read> roots_; /**< @brief Accessor to the root node of each mesh.*/
+                    sycl::accessor<Shapes::MeshTop_t<T>, 1, sycl::access::mode::read> instances_; /**< @brief Accessor to the instances.*/
+
+                    /**
+                     * @brief Traverses the hierarchy of a mesh with a ray in its object space.
+                     *
+                     * @tparam N Number of mediums in the ray's medium list
+                     * @tparam F Leaf function type, callable as bool(size_t index, T& t)
+                     * @param[in] ray Ray to traverse the hierarchy with, in object space.
+                     * @param[in] root Root node of the mesh's hierarchy.
+                     * @param[in, out] t Distance past which nodes are skipped. Lowered by the leaf function.
+                     * @param[in] leaf Function called for each shape of the leaves hit by the ray.
+                     * @return true The leaf function stopped the traversal.
+                     * @return false The traversal went through all the nodes hit by the ray.
+                     */
+                    template<size_t N, class F>
+                    auto traverse_mesh(const Entities::Ray_t<T, N>& ray, uint32_t root, T& t, F leaf) const -> bool;
+            };
+
+            /**
+             * @brief Construct a new empty InstanceBVH_t object, which no ray can intersect.
+             *
+             * @param rebuild_threshold Ratio of the current cost to the cost at build past which update rebuilds the top-level hierarchy instead of refitting it.
+             */
+            explicit InstanceBVH_t(T rebuild_threshold = 1.5);
+
+            BVH_t<T> top_; /**< @brief Top-level hierarchy, containing the instances.*/
+            sycl::buffer<BVHNode_t<T>, 1> nodes_; /**< @brief Flattened nodes of the hierarchies of all the meshes.*/
+            sycl::buffer<uint32_t, 1> indices_; /**< @brief Indices of the shapes of all the meshes, in the order referenced by the leaves.*/
+            sycl::buffer<uint32_t, 1> roots_; /**< @brief Index of the root node of the hierarchy of each mesh. Empty meshes have no root, and a root of std::numeric_limits<uint32_t>::max().*/
+
+            /**
+             * @brief Builds the hierarchies of the meshes and the top-level hierarchy, on the host.
+             *
+             * The shapes of mesh i are the shapes from offsets[i] to offsets[i + 1]. The bounding boxes of the instances are updated
+             * before the top-level hierarchy is built around them.
+             *
+             * @tparam S Shape type
+             * @param shapes Shapes of all the meshes, in object space.
+             * @param offsets Index of the first shape of each mesh, followed by the total number of shapes.
+             * @param instances Instances to sort in the top-level hierarchy.
+             */
+            template<template<typename> typename S>
+            requires Entities::Coordinates<S, T> auto build(sycl::buffer<S<T>, 1>& shapes, std::span<const size_t> offsets, sycl::buffer<Shapes::MeshTop_t<T>, 1>& instances) -> void;
+
+            /**
+             * @brief Builds the hierarchies of the meshes and the top-level hierarchy from the bounding boxes of their shapes, on the host.
+             *
+             * This is used for meshes whose shapes aren't stored as standalone shapes. The shapes of mesh i are the count shapes
+             * starting at first, given as meshes[i] = [first, count], and the leaves reference shapes by their index in mins.
+             *
+             * @param mins Minimum coordinates of the bounding box of each shape of all the meshes, in object space.
+             * @param maxs Maximum coordinates of the bounding box of each shape of all the meshes, in object space.
+             * @param masks Visibility mask of each shape of all the meshes.
+             * @param meshes Index of the first shape and number of shapes of each mesh. [first, count]
+             * @param instances Instances to sort in the top-level hierarchy.
+             */
+            auto build(std::span<const Entities::Vec3<T>> mins,
+                       std::span<const Entities::Vec3<T>> maxs,
+                       std::span<const uint32_t> masks,
+                       std::span<const std::array<size_t, 2>> meshes,
+                       sycl::buffer<Shapes::MeshTop_t<T>, 1>& instances) -> void;
+
+            /**
+             * @brief Updates the top-level hierarchy after the instances have moved, on the device.
+             *
+             * The bounding boxes of the instances are recomputed from the roots of their meshes, then the top-level hierarchy is
+             * refitted or rebuilt as with BVH_t::update. The meshes are not changed, they have to be built again if their shapes
+             * change or if meshes are added.
+             *
+             * @param queue Queue on which to submit the update.
+             * @param instances Instances contained in the top-level hierarchy.
+             */
+            auto update(sycl::queue& queue, sycl::buffer<Shapes::MeshTop_t<T>, 1>& instances) -> void;
+
+            /**
+             * @brief Get a Accessor_t object attached to this acceleration structure
+             *
+             * @param cgh Device handler.
+             * @param instances Instances contained in the top-level hierarchy.
+             * @return Accessor_t Accessor that can be used on the device to traverse the acceleration structure
+             */
+            auto getAccessor(sycl::handler& cgh, sycl::buffer<Shapes::MeshTop_t<T>, 1>& instances) -> Accessor_t;
+    };
+}
+
+#include "acceleration_structures/InstanceBVH_t.tpp"
+
+#endif
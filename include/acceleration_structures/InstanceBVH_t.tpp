@@ -0,0 +1,214 @@
+#include "acceleration_structures/BVHBuilder_t.hpp"
+#include "entities/Visibility.hpp"
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <vector>
+
+template<typename T>
+AGPTracer::AccelerationStructures::InstanceBVH_t<T>::InstanceBVH_t(T rebuild_threshold) :
+        top_(rebuild_threshold), nodes_(sycl::range<1>{1}), indices_(sycl::range<1>{1}), roots_(sycl::range<1>{1}) {
+    const sycl::host_accessor<BVHNode_t<T>, 1, sycl::access_mode::write> node_accessor(nodes_, sycl::no_init);
+    node_accessor[0] = BVHNode_t<T>();
+
+    const sycl::host_accessor<uint32_t, 1, sycl::access_mode::write> index_accessor(indices_, sycl::no_init);
+    index_accessor[0] = 0;
+
+    const sycl::host_accessor<uint32_t, 1, sycl::access_mode::write> root_accessor(roots_, sycl::no_init);
+    root_accessor[0] = std::numeric_limits<uint32_t>::max();
+}
+
+template<typename T>
+template<template<typename> typename S>
+requires AGPTracer::Entities::Coordinates<S, T> auto
+    AGPTracer::AccelerationStructures::InstanceBVH_t<T>::build(sycl::buffer<S<T>, 1>& shapes, std::span<const size_t> offsets, sycl::buffer<Shapes::MeshTop_t<T>, 1>& instances) -> void {
+    std::vector<Entities::Vec3<T>> mins(shapes.get_range()[0]);
+    std::vector<Entities::Vec3<T>> maxs(shapes.get_range()[0]);
+    std::vector<uint32_t> masks(shapes.get_range()[0], Entities::Visibility::all);
+    {
+        const sycl::host_accessor<S<T>, 1, sycl::access_mode::read> shape_accessor(shapes);
+        for (size_t i = 0; i < mins.size(); ++i) {
+            mins[i] = shape_accessor[i].mincoord();
+            maxs[i] = shape_accessor[i].maxcoord();
+            if constexpr (Entities::Masked<S, T>) {
+                masks[i] = shape_accessor[i].mask_;
+            }
+        }
+    }
+
+    const size_t n_meshes = offsets.empty() ? 0 : offsets.size() - 1;
+    std::vector<std::array<size_t, 2>> meshes(n_meshes);
+    for (size_t i = 0; i < n_meshes; ++i) {
+        meshes[i] = {offsets[i], offsets[i + 1] - offsets[i]};
+    }
+
+    build(mins, maxs, masks, meshes, instances);
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::InstanceBVH_t<T>::build(std::span<const Entities::Vec3<T>> mins,
+                                                                std::span<const Entities::Vec3<T>> maxs,
+                                                                std::span<const uint32_t> masks,
+                                                                std::span<const std::array<size_t, 2>> meshes,
+                                                                sycl::buffer<Shapes::MeshTop_t<T>, 1>& instances) -> void {
+    // The hierarchies of the meshes are built separately, then appended to the same buffers
+    std::vector<BVHNode_t<T>> nodes;
+    std::vector<uint32_t> indices;
+    std::vector<uint32_t> roots(meshes.size(), std::numeric_limits<uint32_t>::max());
+    nodes.reserve(2 * mins.size());
+    indices.reserve(mins.size());
+
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        const auto [begin, count] = meshes[i];
+        if (count == 0) {
+            continue;
+        }
+
+        const BVHBuilder_t<T> builder(mins.subspan(begin, count), maxs.subspan(begin, count));
+        const auto node_offset  = static_cast<uint32_t>(nodes.size());
+        const auto index_offset = static_cast<uint32_t>(indices.size());
+        roots[i]                = node_offset;
+
+        for (BVHNode_t<T> node: builder.nodes_) {
+            node.first_ += node.is_leaf() ? index_offset : node_offset;
+            nodes.push_back(node);
+        }
+        for (const uint32_t index: builder.indices_) {
+            indices.push_back(index + static_cast<uint32_t>(begin));
+        }
+        BVH_t<T>::fit_masks(nodes, indices, masks, node_offset);
+    }
+
+    nodes_   = sycl::buffer<BVHNode_t<T>, 1>(sycl::range<1>{std::max(nodes.size(), size_t{1})});
+    indices_ = sycl::buffer<uint32_t, 1>(sycl::range<1>{std::max(indices.size(), size_t{1})});
+    roots_   = sycl::buffer<uint32_t, 1>(sycl::range<1>{std::max(roots.size(), size_t{1})});
+    {
+        const sycl::host_accessor<BVHNode_t<T>, 1, sycl::access_mode::write> node_accessor(nodes_, sycl::no_init);
+        std::copy(nodes.begin(), nodes.end(), node_accessor.begin());
+
+        const sycl::host_accessor<uint32_t, 1, sycl::access_mode::write> index_accessor(indices_, sycl::no_init);
+        std::copy(indices.begin(), indices.end(), index_accessor.begin());
+
+        const sycl::host_accessor<uint32_t, 1, sycl::access_mode::write> root_accessor(roots_, sycl::no_init);
+        std::copy(roots.begin(), roots.end(), root_accessor.begin());
+    }
+
+    {
+        const sycl::host_accessor<Shapes::MeshTop_t<T>, 1, sycl::access_mode::read_write> instance_accessor(instances);
+        for (auto& instance: instance_accessor) {
+            const uint32_t root = roots[instance.mesh_];
+            if (root != std::numeric_limits<uint32_t>::max()) {
+                instance.update(nodes[root].min_, nodes[root].max_);
+            }
+        }
+    }
+
+    top_.build(instances);
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::InstanceBVH_t<T>::update(sycl::queue& queue, sycl::buffer<Shapes::MeshTop_t<T>, 1>& instances) -> void {
+    const sycl::range<1> num_work_items{instances.get_range()};
+
+    queue.submit([&](sycl::handler& cgh) {
+        auto instance_accessor = instances.template get_access<sycl::access::mode::read_write>(cgh);
+        auto node_accessor     = nodes_.template get_access<sycl::access::mode::read>(cgh);
+        auto root_accessor     = roots_.template get_access<sycl::access::mode::read>(cgh);
+
+        cgh.parallel_for<class UpdateInstances>(num_work_items, [=](sycl::id<1> WIid) {
+            Shapes::MeshTop_t<T>& instance = instance_accessor[WIid];
+            const uint32_t root            = root_accessor[instance.mesh_];
+            if (root != std::numeric_limits<uint32_t>::max()) {
+                instance.update(node_accessor[root].min_, node_accessor[root].max_);
+            }
+        });
+    });
+
+    top_.update(queue, instances);
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::InstanceBVH_t<T>::getAccessor(sycl::handler& cgh, sycl::buffer<Shapes::MeshTop_t<T>, 1>& instances) -> Accessor_t {
+    return Accessor_t(cgh, top_, nodes_, indices_, roots_, instances);
+}
+
+template<typename T>
+AGPTracer::AccelerationStructures::InstanceBVH_t<T>::Accessor_t::Accessor_t(sycl::handler& cgh,
+                                                                            BVH_t<T>& top,
+                                                                            sycl::buffer<BVHNode_t<T>, 1>& nodes,
+                                                                            sycl::buffer<uint32_t, 1>& indices,
+                                                                            sycl::buffer<uint32_t, 1>& roots,
+                                                                            sycl::buffer<Shapes::MeshTop_t<T>, 1>& instances) :
+        top_(top.getAccessor(cgh)),
+        nodes_(nodes.template get_access<sycl::access::mode::read>(cgh)),
+        indices_(indices.template get_access<sycl::access::mode::read>(cgh)),
+        roots_(roots.template get_access<sycl::access::mode::read>(cgh)),
+        instances_(instances.template get_access<sycl::access::mode::read>(cgh)) {}
+
+template<typename T>
+template<size_t N, class F>
+auto AGPTracer::AccelerationStructures::InstanceBVH_t<T>::Accessor_t::traverse(const Entities::Ray_t<T, N>& ray, T& t, F leaf) const -> void {
+    top_.traverse(ray, t, [&](size_t instance, T& t_max) {
+        const Shapes::MeshTop_t<T>& mesh_top = instances_[instance];
+        const uint32_t root                  = roots_[mesh_top.mesh_];
+        if ((root == std::numeric_limits<uint32_t>::max()) || ((mesh_top.mask_ & ray.visibility_) == 0)) {
+            return false;
+        }
+
+        const Entities::Ray_t<T, N> object_ray = mesh_top.to_object(ray);
+        return traverse_mesh(object_ray, root, t_max, [&](size_t index, T& t_leaf) { return leaf(instance, index, object_ray, t_leaf); });
+    });
+}
+
+template<typename T>
+template<size_t N, class F>
+auto AGPTracer::AccelerationStructures::InstanceBVH_t<T>::Accessor_t::traverse_mesh(const Entities::Ray_t<T, N>& ray, uint32_t root, T& t, F leaf) const -> bool {
+    constexpr size_t max_stack_size = BVHNode_t<T>::max_depth_;
+    const Entities::Vec3<T> inverse_direction(T{1} / ray.direction_[0], T{1} / ray.direction_[1], T{1} / ray.direction_[2]);
+
+    std::array<uint32_t, max_stack_size> stack; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+    size_t stack_size   = 0;
+    uint32_t node_index = root;
+    T t_node{};
+
+    if (!nodes_[root].visible(ray.visibility_) || !nodes_[root].intersection(ray.origin_, inverse_direction, t, t_node)) {
+        return false;
+    }
+
+    while (true) {
+        const BVHNode_t<T>& node = nodes_[node_index];
+
+        if (node.is_leaf()) {
+            for (uint32_t i = node.first_; i < node.first_ + node.count_; ++i) {
+                if (leaf(static_cast<size_t>(indices_[i]), t)) {
+                    return true;
+                }
+            }
+        }
+        else {
+            T t_left{};
+            T t_right{};
+            const bool hit_left  = nodes_[node.first_].visible(ray.visibility_) && nodes_[node.first_].intersection(ray.origin_, inverse_direction, t, t_left);
+            const bool hit_right = nodes_[node.first_ + 1].visible(ray.visibility_) && nodes_[node.first_ + 1].intersection(ray.origin_, inverse_direction, t, t_right);
+
+            if (hit_left && hit_right) {
+                const bool left_first = t_left <= t_right;
+                // Meshes are built at most max_depth_ deep, the check only keeps the stack in bounds
+                if (stack_size < max_stack_size) {
+                    stack[stack_size++] = left_first ? node.first_ + 1 : node.first_;
+                }
+                node_index = left_first ? node.first_ : node.first_ + 1;
+                continue;
+            }
+            if (hit_left || hit_right) {
+                node_index = hit_left ? node.first_ : node.first_ + 1;
+                continue;
+            }
+        }
+
+        if (stack_size == 0) {
+            return false;
+        }
+        node_index = stack[--stack_size];
+    }
+}
@@ -0,0 +1,127 @@
+#ifndef AGPTRACER_ACCELERATIONSTRUCTURES_LBVHBUILDER_T_HPP
+#define AGPTRACER_ACCELERATIONSTRUCTURES_LBVHBUILDER_T_HPP
+
+#include "acceleration_structures/BVHNode_t.hpp"
+#include "entities/Shape.hpp"
+#include "entities/Vec3.hpp"
+#include <cstdint>
+#include <sycl/sycl.hpp>
+
+namespace AGPTracer::AccelerationStructures {
+    /**
+     * @brief The linear BVH builder class builds a bounding volume hierarchy on the device, from the Morton codes of the shapes.
+     *
+     * The centroids of the shapes are mapped to 30 bit Morton codes, which are radix sorted on the device. The hierarchy is then
+     * emitted in parallel from the sorted codes, one inner node per work item, using the longest common prefix of neighbouring codes
+     * to find the range and split of each node. The inner node with index i always has its two children at nodes 2i + 1 and 2i + 2,
+     * so that the layout matches the one of the host builder, with one shape per leaf. Every step is a kernel, so the build time scales
+     * with the number of cores of the device. The bounding boxes of the nodes are not computed here, they are fitted bottom-up afterwards.
+     *
+     * The builder keeps its temporary buffers between builds, so that rebuilding a scene of the same size every frame doesn't allocate.
+     *
+     * @tparam T Floating point datatype to use
+     */
+    template<typename T = double>
+    class LBVHBuilder_t {
+        public:
+            /**
+             * @brief Construct a new LBVHBuilder_t object, with empty temporary buffers.
+             */
+            LBVHBuilder_t();
+
+            /**
+             * @brief Builds the hierarchy of the given shapes on the device, in the given node, index and parent buffers.
+             *
+             * @tparam S Shape type
+             * @param queue Queue on which to submit the build.
+             * @param shapes Shapes to sort in the hierarchy.
+             * @param nodes Buffer receiving the nodes, must contain 2n - 1 nodes for n shapes. Only the links of the nodes are written, not their bounding boxes.
+             * @param indices Buffer receiving the indices of the shapes in leaf order, must contain n indices.
+             * @param parents Buffer receiving the index of the parent of each node, must contain 2n - 1 indices.
+             */
+            template<template<typename> typename S>
+            requires Entities::Coordinates<S, T> auto build(sycl::queue& queue,
+                                                            sycl::buffer<S<T>, 1>& shapes,
+                                                            sycl::buffer<BVHNode_t<T>, 1>& nodes,
+                                                            sycl::buffer<uint32_t, 1>& indices,
+                                                            sycl::buffer<uint32_t, 1>& parents) -> void;
+
+            /**
+             * @brief Sorts the shapes by the Morton code of their centroid on the device, and writes their indices in that order.
+             *
+             * Shapes close to each other in space are close to each other in that order. This is the order of the leaves of the hierarchy.
+             *
+             * @tparam S Shape type
+             * @param queue Queue on which to submit the sort.
+             * @param shapes Shapes to sort.
+             * @param indices Buffer receiving the indices of the shapes in Morton order, must contain n indices.
+             */
+            template<template<typename> typename S>
+            requires Entities::Coordinates<S, T> auto order(sycl::queue& queue, sycl::buffer<S<T>, 1>& shapes, sycl::buffer<uint32_t, 1>& indices) -> void;
+
+        private:
+            constexpr static size_t block_size_ = 1024; /**< @brief Number of elements processed serially by each work item of the reduction, histogram and scatter kernels.*/
+            constexpr static size_t radix_bits_ = 8; /**< @brief Number of bits sorted by each pass of the radix sort.*/
+            constexpr static size_t n_buckets_  = size_t{1} << radix_bits_; /**< @brief Number of buckets of each pass of the radix sort.*/
+
+            sycl::buffer<uint64_t, 1> keys_; /**< @brief Morton codes of the shapes in the upper 32 bits, and index of the shapes in the lower 32 bits.*/
+            sycl::buffer<uint64_t, 1> keys_swap_; /**< @brief Destination of every other pass of the radix sort.*/
+            sycl::buffer<uint32_t, 1> histograms_; /**< @brief Bucket counts of every block, bucket-major, scanned into scatter offsets.*/
+            sycl::buffer<uint32_t, 1> block_sums_; /**< @brief Partial sums used by the scan of the histograms.*/
+            sycl::buffer<BVHNode_t<T>, 1> block_bounds_; /**< @brief Bounding box of the centroids of every block, reduced to the first element.*/
+            sycl::buffer<uint32_t, 1> inner_slots_; /**< @brief Position in the node buffer of each inner node, by order of emission.*/
+
+            /**
+             * @brief Resizes the temporary buffers if they are too small for the given number of shapes.
+             *
+             * @param n_shapes Number of shapes to build the hierarchy of.
+             */
+            auto reserve(size_t n_shapes) -> void;
+
+            /**
+             * @brief Computes the keys of the shapes on the device, from the Morton code of their centroid within the bounding box of all the centroids.
+             *
+             * @tparam S Shape type
+             * @param queue Queue on which to submit the computation.
+             * @param shapes Shapes of which to compute the keys.
+             */
+            template<template<typename> typename S>
+            requires Entities::Coordinates<S, T> auto compute_keys(sycl::queue& queue, sycl::buffer<S<T>, 1>& shapes) -> void;
+
+            /**
+             * @brief Sorts the keys on the device, by their upper 32 bits. The lower 32 bits are already sorted, and their order is kept.
+             *
+             * @param queue Queue on which to submit the sort.
+             * @param n_keys Number of keys to sort.
+             */
+            auto sort(sycl::queue& queue, size_t n_keys) -> void;
+
+            /**
+             * @brief Computes the exclusive prefix sum of the histograms on the device.
+             *
+             * @param queue Queue on which to submit the scan.
+             * @param n_values Number of values to scan.
+             */
+            auto scan(sycl::queue& queue, size_t n_values) -> void;
+
+            /**
+             * @brief Spreads the lower 10 bits of a value so that there are two zero bits between each of them.
+             *
+             * @param value Value to spread.
+             * @return uint32_t Spread value.
+             */
+            constexpr static auto expand_bits(uint32_t value) -> uint32_t;
+
+            /**
+             * @brief Computes the 30 bit Morton code of a point within the unit cube.
+             *
+             * @param point Point within the unit cube.
+             * @return uint32_t Morton code of the point, interleaving 10 bits of each coordinate.
+             */
+            constexpr static auto morton_code(const Entities::Vec3<T>& point) -> uint32_t;
+    };
+}
+
+#include "acceleration_structures/LBVHBuilder_t.tpp"
+
+#endif
@@ -0,0 +1,346 @@
+#include <algorithm>
+#include <array>
+#include <limits>
+
+template<typename T>
+AGPTracer::AccelerationStructures::LBVHBuilder_t<T>::LBVHBuilder_t() :
+        keys_(sycl::range<1>{1}),
+        keys_swap_(sycl::range<1>{1}),
+        histograms_(sycl::range<1>{1}),
+        block_sums_(sycl::range<1>{1}),
+        block_bounds_(sycl::range<1>{1}),
+        inner_slots_(sycl::range<1>{1}) {}
+
+template<typename T>
+template<template<typename> typename S>
+requires AGPTracer::Entities::Coordinates<S, T> auto AGPTracer::AccelerationStructures::LBVHBuilder_t<T>::build(sycl::queue& queue,
+                                                                                                               sycl::buffer<S<T>, 1>& shapes,
+                                                                                                               sycl::buffer<BVHNode_t<T>, 1>& nodes,
+                                                                                                               sycl::buffer<uint32_t, 1>& indices,
+                                                                                                               sycl::buffer<uint32_t, 1>& parents) -> void {
+    const size_t n_shapes = shapes.get_range()[0];
+    if (n_shapes == 0) {
+        return;
+    }
+
+    if (n_shapes == 1) {
+        queue.submit([&](sycl::handler& cgh) {
+            auto node_accessor   = nodes.template get_access<sycl::access::mode::write>(cgh);
+            auto index_accessor  = indices.template get_access<sycl::access::mode::write>(cgh);
+            auto parent_accessor = parents.template get_access<sycl::access::mode::write>(cgh);
+
+            cgh.single_task<class LBVHSingleLeaf>([=]() {
+                node_accessor[0]   = BVHNode_t<T>(Entities::Vec3<T>(std::numeric_limits<T>::max()), Entities::Vec3<T>(std::numeric_limits<T>::lowest()), 0, 1);
+                index_accessor[0]  = 0;
+                parent_accessor[0] = 0;
+            });
+        });
+        return;
+    }
+
+    reserve(n_shapes);
+    compute_keys(queue, shapes);
+    sort(queue, n_shapes);
+
+    // Hierarchy, one inner node per work item. Children of inner node i are at 2i + 1 and 2i + 2.
+    const size_t n_inner = n_shapes - 1;
+    queue.submit([&](sycl::handler& cgh) {
+        auto key_accessor        = keys_.template get_access<sycl::access::mode::read>(cgh);
+        auto node_accessor       = nodes.template get_access<sycl::access::mode::write>(cgh);
+        auto index_accessor      = indices.template get_access<sycl::access::mode::write>(cgh);
+        auto inner_slot_accessor = inner_slots_.template get_access<sycl::access::mode::write>(cgh);
+
+        cgh.parallel_for<class LBVHHierarchy>(sycl::range<1>{n_inner}, [=](sycl::id<1> WIid) {
+            const auto n     = static_cast<int64_t>(n_shapes);
+            const auto i     = static_cast<int64_t>(WIid[0]);
+            const auto delta = [&](int64_t j) -> int64_t {
+                if ((j < 0) || (j >= n)) {
+                    return -1;
+                }
+                return static_cast<int64_t>(sycl::clz(key_accessor[i] ^ key_accessor[j]));
+            };
+
+            // Direction and extent of the range covered by the node
+            const int64_t direction = (delta(i + 1) > delta(i - 1)) ? 1 : -1;
+            const int64_t delta_min = delta(i - direction);
+            int64_t max_length      = 2;
+            while (delta(i + max_length * direction) > delta_min) {
+                max_length *= 2;
+            }
+            int64_t length = 0;
+            for (int64_t step = max_length / 2; step >= 1; step /= 2) {
+                if (delta(i + (length + step) * direction) > delta_min) {
+                    length += step;
+                }
+            }
+            const int64_t j          = i + length * direction;
+            const int64_t delta_node = delta(j);
+
+            // Split position, where the common prefix changes
+            int64_t split = 0;
+            for (int64_t divisor = 2;; divisor *= 2) {
+                const int64_t step = (length + divisor - 1) / divisor;
+                if (delta(i + (split + step) * direction) > delta_node) {
+                    split += step;
+                }
+                if (step == 1) {
+                    break;
+                }
+            }
+            const int64_t gamma = i + split * direction + std::min(direction, int64_t{0});
+
+            const std::array<int64_t, 2> children{gamma, gamma + 1};
+            const std::array<bool, 2> leaves{std::min(i, j) == gamma, std::max(i, j) == gamma + 1};
+            for (size_t k = 0; k < 2; ++k) {
+                const auto slot = static_cast<uint32_t>(2 * i + 1 + static_cast<int64_t>(k));
+                if (leaves[k]) {
+                    node_accessor[slot] = BVHNode_t<T>(Entities::Vec3<T>(std::numeric_limits<T>::max()), Entities::Vec3<T>(std::numeric_limits<T>::lowest()), static_cast<uint32_t>(children[k]), 1);
+                }
+                else {
+                    inner_slot_accessor[children[k]] = slot;
+                }
+            }
+            if (i == 0) {
+                inner_slot_accessor[0] = 0;
+            }
+            index_accessor[i] = static_cast<uint32_t>(key_accessor[i]);
+            if (i == n - 2) {
+                index_accessor[i + 1] = static_cast<uint32_t>(key_accessor[i + 1]);
+            }
+        });
+    });
+
+    queue.submit([&](sycl::handler& cgh) {
+        auto inner_slot_accessor = inner_slots_.template get_access<sycl::access::mode::read>(cgh);
+        auto node_accessor       = nodes.template get_access<sycl::access::mode::write>(cgh);
+        auto parent_accessor     = parents.template get_access<sycl::access::mode::write>(cgh);
+
+        cgh.parallel_for<class LBVHLinks>(sycl::range<1>{n_inner}, [=](sycl::id<1> WIid) {
+            const uint32_t slot        = inner_slot_accessor[WIid];
+            const auto first           = static_cast<uint32_t>(2 * WIid[0] + 1);
+            node_accessor[slot]        = BVHNode_t<T>(Entities::Vec3<T>(std::numeric_limits<T>::max()), Entities::Vec3<T>(std::numeric_limits<T>::lowest()), first, 0);
+            parent_accessor[first]     = slot;
+            parent_accessor[first + 1] = slot;
+            if (WIid[0] == 0) {
+                parent_accessor[0] = 0;
+            }
+        });
+    });
+}
+
+template<typename T>
+template<template<typename> typename S>
+requires AGPTracer::Entities::Coordinates<S, T> auto AGPTracer::AccelerationStructures::LBVHBuilder_t<T>::order(sycl::queue& queue,
+                                                                                                                sycl::buffer<S<T>, 1>& shapes,
+                                                                                                                sycl::buffer<uint32_t, 1>& indices) -> void {
+    const size_t n_shapes = shapes.get_range()[0];
+    if (n_shapes == 0) {
+        return;
+    }
+
+    reserve(n_shapes);
+    compute_keys(queue, shapes);
+    sort(queue, n_shapes);
+
+    queue.submit([&](sycl::handler& cgh) {
+        auto key_accessor   = keys_.template get_access<sycl::access::mode::read>(cgh);
+        auto index_accessor = indices.template get_access<sycl::access::mode::write>(cgh);
+
+        cgh.parallel_for<class LBVHOrder>(sycl::range<1>{n_shapes}, [=](sycl::id<1> WIid) { index_accessor[WIid] = static_cast<uint32_t>(key_accessor[WIid]); });
+    });
+}
+
+template<typename T>
+template<template<typename> typename S>
+requires AGPTracer::Entities::Coordinates<S, T> auto AGPTracer::AccelerationStructures::LBVHBuilder_t<T>::compute_keys(sycl::queue& queue, sycl::buffer<S<T>, 1>& shapes) -> void {
+    const size_t n_shapes = shapes.get_range()[0];
+    const size_t n_blocks = (n_shapes + block_size_ - 1) / block_size_;
+
+    // Bounding box of the centroids, reduced per block then on a single work item
+    queue.submit([&](sycl::handler& cgh) {
+        auto shape_accessor  = shapes.template get_access<sycl::access::mode::read>(cgh);
+        auto bounds_accessor = block_bounds_.template get_access<sycl::access::mode::write>(cgh);
+
+        cgh.parallel_for<class LBVHCentroidBounds>(sycl::range<1>{n_blocks}, [=](sycl::id<1> WIid) {
+            const size_t begin = WIid[0] * block_size_;
+            const size_t end   = std::min(begin + block_size_, n_shapes);
+            BVHNode_t<T> bounds;
+            for (size_t i = begin; i < end; ++i) {
+                const Entities::Vec3<T> centroid = (shape_accessor[i].mincoord() + shape_accessor[i].maxcoord()) / T{2};
+                bounds.min_.min(centroid);
+                bounds.max_.max(centroid);
+            }
+            bounds_accessor[WIid] = bounds;
+        });
+    });
+
+    queue.submit([&](sycl::handler& cgh) {
+        auto bounds_accessor = block_bounds_.template get_access<sycl::access::mode::read_write>(cgh);
+
+        cgh.single_task<class LBVHReduceBounds>([=]() {
+            for (size_t i = 1; i < n_blocks; ++i) {
+                bounds_accessor[0].min_.min(bounds_accessor[i].min_);
+                bounds_accessor[0].max_.max(bounds_accessor[i].max_);
+            }
+        });
+    });
+
+    // Morton codes, with the shape index in the lower bits so that all keys are unique
+    queue.submit([&](sycl::handler& cgh) {
+        auto shape_accessor  = shapes.template get_access<sycl::access::mode::read>(cgh);
+        auto bounds_accessor = block_bounds_.template get_access<sycl::access::mode::read>(cgh);
+        auto key_accessor    = keys_.template get_access<sycl::access::mode::write>(cgh);
+
+        cgh.parallel_for<class LBVHMortonCodes>(sycl::range<1>{n_shapes}, [=](sycl::id<1> WIid) {
+            const BVHNode_t<T> bounds        = bounds_accessor[0];
+            const Entities::Vec3<T> centroid = (shape_accessor[WIid].mincoord() + shape_accessor[WIid].maxcoord()) / T{2};
+            Entities::Vec3<T> point;
+            for (unsigned int axis = 0; axis < 3; ++axis) {
+                const T extent = bounds.max_[axis] - bounds.min_[axis];
+                point[axis]    = (extent > T{0}) ? (centroid[axis] - bounds.min_[axis]) / extent : T{0};
+            }
+            key_accessor[WIid] = (static_cast<uint64_t>(morton_code(point)) << 32U) | static_cast<uint64_t>(WIid[0]);
+        });
+    });
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::LBVHBuilder_t<T>::reserve(size_t n_shapes) -> void {
+    const size_t n_blocks     = (n_shapes + block_size_ - 1) / block_size_;
+    const size_t n_histograms = n_buckets_ * n_blocks;
+    const size_t n_sums       = (n_histograms + block_size_ - 1) / block_size_;
+
+    if (keys_.get_range()[0] < n_shapes) {
+        keys_      = sycl::buffer<uint64_t, 1>(sycl::range<1>{n_shapes});
+        keys_swap_ = sycl::buffer<uint64_t, 1>(sycl::range<1>{n_shapes});
+    }
+    if (histograms_.get_range()[0] < n_histograms) {
+        histograms_ = sycl::buffer<uint32_t, 1>(sycl::range<1>{n_histograms});
+    }
+    if (block_sums_.get_range()[0] < n_sums) {
+        block_sums_ = sycl::buffer<uint32_t, 1>(sycl::range<1>{n_sums});
+    }
+    if (block_bounds_.get_range()[0] < n_blocks) {
+        block_bounds_ = sycl::buffer<BVHNode_t<T>, 1>(sycl::range<1>{n_blocks});
+    }
+    if (inner_slots_.get_range()[0] < n_shapes - 1) {
+        inner_slots_ = sycl::buffer<uint32_t, 1>(sycl::range<1>{n_shapes - 1});
+    }
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::LBVHBuilder_t<T>::sort(sycl::queue& queue, size_t n_keys) -> void {
+    constexpr size_t key_bits = 64;
+    const size_t n_blocks     = (n_keys + block_size_ - 1) / block_size_;
+
+    // Only the Morton codes are sorted. The input is ordered by shape index, and the sort is stable, so the lower bits stay sorted.
+    for (size_t shift = key_bits / 2; shift < key_bits; shift += radix_bits_) {
+        const bool swapped                  = ((shift - key_bits / 2) / radix_bits_) % 2 == 1;
+        sycl::buffer<uint64_t, 1>& keys_in  = swapped ? keys_swap_ : keys_;
+        sycl::buffer<uint64_t, 1>& keys_out = swapped ? keys_ : keys_swap_;
+
+        queue.submit([&](sycl::handler& cgh) {
+            auto key_accessor       = keys_in.template get_access<sycl::access::mode::read>(cgh);
+            auto histogram_accessor = histograms_.template get_access<sycl::access::mode::write>(cgh);
+
+            cgh.parallel_for<class LBVHRadixHistogram>(sycl::range<1>{n_blocks}, [=](sycl::id<1> WIid) {
+                std::array<uint32_t, n_buckets_> counts{};
+                const size_t begin = WIid[0] * block_size_;
+                const size_t end   = std::min(begin + block_size_, n_keys);
+                for (size_t i = begin; i < end; ++i) {
+                    ++counts[(key_accessor[i] >> shift) & (n_buckets_ - 1)];
+                }
+                for (size_t bucket = 0; bucket < n_buckets_; ++bucket) {
+                    histogram_accessor[bucket * n_blocks + WIid[0]] = counts[bucket];
+                }
+            });
+        });
+
+        scan(queue, n_buckets_ * n_blocks);
+
+        queue.submit([&](sycl::handler& cgh) {
+            auto key_accessor       = keys_in.template get_access<sycl::access::mode::read>(cgh);
+            auto histogram_accessor = histograms_.template get_access<sycl::access::mode::read>(cgh);
+            auto output_accessor    = keys_out.template get_access<sycl::access::mode::write>(cgh);
+
+            cgh.parallel_for<class LBVHRadixScatter>(sycl::range<1>{n_blocks}, [=](sycl::id<1> WIid) {
+                std::array<uint32_t, n_buckets_> offsets{};
+                for (size_t bucket = 0; bucket < n_buckets_; ++bucket) {
+                    offsets[bucket] = histogram_accessor[bucket * n_blocks + WIid[0]];
+                }
+                const size_t begin = WIid[0] * block_size_;
+                const size_t end   = std::min(begin + block_size_, n_keys);
+                for (size_t i = begin; i < end; ++i) {
+                    const uint64_t key                                            = key_accessor[i];
+                    output_accessor[offsets[(key >> shift) & (n_buckets_ - 1)]++] = key;
+                }
+            });
+        });
+    }
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::LBVHBuilder_t<T>::scan(sycl::queue& queue, size_t n_values) -> void {
+    const size_t n_chunks = (n_values + block_size_ - 1) / block_size_;
+
+    queue.submit([&](sycl::handler& cgh) {
+        auto value_accessor = histograms_.template get_access<sycl::access::mode::read_write>(cgh);
+        auto sum_accessor   = block_sums_.template get_access<sycl::access::mode::write>(cgh);
+
+        cgh.parallel_for<class LBVHScanChunks>(sycl::range<1>{n_chunks}, [=](sycl::id<1> WIid) {
+            const size_t begin = WIid[0] * block_size_;
+            const size_t end   = std::min(begin + block_size_, n_values);
+            uint32_t sum       = 0;
+            for (size_t i = begin; i < end; ++i) {
+                const uint32_t value = value_accessor[i];
+                value_accessor[i]    = sum;
+                sum += value;
+            }
+            sum_accessor[WIid] = sum;
+        });
+    });
+
+    queue.submit([&](sycl::handler& cgh) {
+        auto sum_accessor = block_sums_.template get_access<sycl::access::mode::read_write>(cgh);
+
+        cgh.single_task<class LBVHScanSums>([=]() {
+            uint32_t sum = 0;
+            for (size_t i = 0; i < n_chunks; ++i) {
+                const uint32_t value = sum_accessor[i];
+                sum_accessor[i]      = sum;
+                sum += value;
+            }
+        });
+    });
+
+    queue.submit([&](sycl::handler& cgh) {
+        auto value_accessor = histograms_.template get_access<sycl::access::mode::read_write>(cgh);
+        auto sum_accessor   = block_sums_.template get_access<sycl::access::mode::read>(cgh);
+
+        cgh.parallel_for<class LBVHScanAdd>(sycl::range<1>{n_chunks}, [=](sycl::id<1> WIid) {
+            const size_t begin = WIid[0] * block_size_;
+            const size_t end   = std::min(begin + block_size_, n_values);
+            for (size_t i = begin; i < end; ++i) {
+                value_accessor[i] += sum_accessor[WIid];
+            }
+        });
+    });
+}
+
+template<typename T>
+constexpr auto AGPTracer::AccelerationStructures::LBVHBuilder_t<T>::expand_bits(uint32_t value) -> uint32_t {
+    value = (value * 0x00010001U) & 0xFF0000FFU;
+    value = (value * 0x00000101U) & 0x0F00F00FU;
+    value = (value * 0x00000011U) & 0xC30C30C3U;
+    value = (value * 0x00000005U) & 0x49249249U;
+    return value;
+}
+
+template<typename T>
+constexpr auto AGPTracer::AccelerationStructures::LBVHBuilder_t<T>::morton_code(const Entities::Vec3<T>& point) -> uint32_t {
+    constexpr T resolution = 1024;
+    const auto x           = static_cast<uint32_t>(std::min(std::max(point[0] * resolution, T{0}), resolution - 1));
+    const auto y           = static_cast<uint32_t>(std::min(std::max(point[1] * resolution, T{0}), resolution - 1));
+    const auto z           = static_cast<uint32_t>(std::min(std::max(point[2] * resolution, T{0}), resolution - 1));
+    return expand_bits(x) * 4 + expand_bits(y) * 2 + expand_bits(z);
+}
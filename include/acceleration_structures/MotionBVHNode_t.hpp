@@ -0,0 +1,64 @@
+#ifndef AGPTRACER_ACCELERATIONSTRUCTURES_MOTIONBVHNODE_T_HPP
+#define AGPTRACER_ACCELERATIONSTRUCTURES_MOTIONBVHNODE_T_HPP
+
+#include "acceleration_structures/BVHNode_t.hpp"
+#include "entities/Vec3.hpp"
+#include <cstdint>
+
+namespace AGPTracer::AccelerationStructures {
+    /**
+     * @brief The motion BVH node class represents a node of a flattened bounding volume hierarchy whose shapes move during the exposure.
+     *
+     * A node holds two axis-aligned bounding boxes around all the shapes it contains, one at the start of the exposure and
+     * one at the end. The box at a given time is linearly interpolated between the two. As the points of the shapes move
+     * linearly too, the interpolated box contains the shapes at every time of the exposure, while being much tighter than a
+     * box around the shapes during the whole exposure. Children and shape indices are stored as in BVHNode_t.
+     *
+     * @tparam T Floating point datatype to use
+     */
+    template<typename T = double>
+    class MotionBVHNode_t {
+        public:
+            /**
+             * @brief Construct a new empty MotionBVHNode_t object, whose bounding boxes can't be intersected.
+             */
+            constexpr MotionBVHNode_t();
+
+            /**
+             * @brief Construct a new MotionBVHNode_t object from its bounding boxes at the start and at the end of the exposure, and its contents.
+             *
+             * @param start Bounding box of the node at the start of the exposure, whose contents are ignored.
+             * @param end Bounding box of the node at the end of the exposure, whose contents are ignored.
+             * @param first Index of the first child if the node is an inner node, or of the first shape index if it is a leaf.
+             * @param count Number of shapes in the leaf, 0 for inner nodes.
+             */
+            constexpr MotionBVHNode_t(const BVHNode_t<T>& start, const BVHNode_t<T>& end, uint32_t first, uint32_t count);
+
+            Entities::Vec3<T> min_start_; /**< @brief Minimum coordinates of the bounding box of the node at the start of the exposure.*/
+            Entities::Vec3<T> max_start_; /**< @brief Maximum coordinates of the bounding box of the node at the start of the exposure.*/
+            Entities::Vec3<T> min_end_; /**< @brief Minimum coordinates of the bounding box of the node at the end of the exposure.*/
+            Entities::Vec3<T> max_end_; /**< @brief Maximum coordinates of the bounding box of the node at the end of the exposure.*/
+            uint32_t first_; /**< @brief Index of the first of the two children for inner nodes, index of the first shape index for leaves.*/
+            uint32_t count_; /**< @brief Number of shapes in the leaf. Inner nodes have a count of 0.*/
+
+            /**
+             * @brief Returns whether the node is a leaf, containing shapes, or an inner node, containing other nodes.
+             *
+             * @return true The node is a leaf, first_ and count_ describe a range of shape indices.
+             * @return false The node is an inner node, its children are at first_ and first_ + 1.
+             */
+            constexpr auto is_leaf() const -> bool;
+
+            /**
+             * @brief Returns the node at a given time of the exposure, with its bounding box interpolated between the start and the end.
+             *
+             * @param time Time at which we want the node, from 0 for the start of the exposure to 1 for the end.
+             * @return BVHNode_t<T> Node with the bounding box at that time, and the same contents.
+             */
+            constexpr auto at(T time) const -> BVHNode_t<T>;
+    };
+}
+
+#include "acceleration_structures/MotionBVHNode_t.tpp"
+
+#endif
@@ -0,0 +1,24 @@
+#include <limits>
+
+template<typename T>
+constexpr AGPTracer::AccelerationStructures::MotionBVHNode_t<T>::MotionBVHNode_t() :
+        min_start_(std::numeric_limits<T>::max()),
+        max_start_(std::numeric_limits<T>::lowest()),
+        min_end_(std::numeric_limits<T>::max()),
+        max_end_(std::numeric_limits<T>::lowest()),
+        first_(0),
+        count_(0) {}
+
+template<typename T>
+constexpr AGPTracer::AccelerationStructures::MotionBVHNode_t<T>::MotionBVHNode_t(const BVHNode_t<T>& start, const BVHNode_t<T>& end, uint32_t first, uint32_t count) :
+        min_start_(start.min_), max_start_(start.max_), min_end_(end.min_), max_end_(end.max_), first_(first), count_(count) {}
+
+template<typename T>
+constexpr auto AGPTracer::AccelerationStructures::MotionBVHNode_t<T>::is_leaf() const -> bool {
+    return count_ > 0;
+}
+
+template<typename T>
+constexpr auto AGPTracer::AccelerationStructures::MotionBVHNode_t<T>::at(T time) const -> BVHNode_t<T> {
+    return BVHNode_t<T>(min_end_ * time + min_start_ * (T{1} - time), max_end_ * time + max_start_ * (T{1} - time), first_, count_);
+}
@@ -0,0 +1,103 @@
+#ifndef AGPTRACER_ACCELERATIONSTRUCTURES_MOTIONBVH_T_HPP
+#define AGPTRACER_ACCELERATIONSTRUCTURES_MOTIONBVH_T_HPP
+
+#include "acceleration_structures/MotionBVHNode_t.hpp"
+#include "entities/Ray_t.hpp"
+#include "entities/Shape.hpp"
+#include <cstdint>
+#include <sycl/sycl.hpp>
+
+namespace AGPTracer::AccelerationStructures {
+    /**
+     * @brief The motion BVH class is a bounding volume hierarchy acceleration structure for shapes moving during the exposure, used to quickly find which shapes a ray intersects.
+     *
+     * The hierarchy is built on the host with the binned surface area heuristic, from the bounding boxes of the shapes during the
+     * whole exposure. Each node then stores its bounding boxes at the start and at the end of the exposure, and rays intersect
+     * the box interpolated at their time. This keeps the boxes tight around fast moving shapes, where a static hierarchy would
+     * have large boxes around the whole path of the shapes, overlapping most of the scene. Rays at different times can then
+     * be traced through the same hierarchy, so that a motion blurred frame costs about as much as a static one with the same
+     * number of samples.
+     *
+     * @tparam T Floating point datatype to use
+     */
+    template<typename T = double>
+    class MotionBVH_t {
+        public:
+            class Accessor_t {
+                public:
+                    /**
+                     * @brief Construct a new Accessor_t object with the given buffers.
+                     *
+                     * @param cgh Device handler.
+                     * @param nodes Node buffer to access.
+                     * @param indices Shape index buffer to access.
+                     */
+                    Accessor_t(sycl::handler& cgh, sycl::buffer<MotionBVHNode_t<T>, 1>& nodes, sycl::buffer<uint32_t, 1>& indices);
+
+                    /**
+                     * @brief Traverses the hierarchy with a ray at its time, calling a function for each shape whose leaf is hit by the ray.
+                     *
+                     * Nodes are interpolated at the time of the ray, then visited front to back, and nodes further than t are
+                     * skipped. The leaf function is called with the index of a shape and a reference to t, and should lower t
+                     * when it finds a closer intersection. It returns true to stop the traversal, for example when any
+                     * intersection is enough.
+                     *
+                     * @tparam N Number of mediums in the ray's medium list
+                     * @tparam F Leaf function type, callable as bool(size_t index, T& t)
+                     * @param[in] ray Ray to traverse the hierarchy with.
+                     * @param[in, out] t Distance past which nodes are skipped. Lowered by the leaf function.
+                     * @param[in] leaf Function called for each shape of the leaves hit by the ray.
+                     */
+                    template<size_t N, class F>
+                    auto traverse(const Entities::Ray_t<T, N>& ray, T& t, F leaf) const -> void;
+
+                private:
+                    sycl::accessor<MotionBVHNode_t<T>, 1, sycl::access::mode::read> nodes_; /**< @brief Accessor to the nodes.*/
+                    sycl::accessor<uint32_t, 1, sycl::access::mode::read> indices_; /**< @brief Accessor to the shape indices.*/
+            };
+
+            /**
+             * @brief Construct a new empty MotionBVH_t object, which no ray can intersect.
+             */
+            MotionBVH_t();
+
+            sycl::buffer<MotionBVHNode_t<T>, 1> nodes_; /**< @brief Flattened nodes of the hierarchy. The root is the first node.*/
+            sycl::buffer<uint32_t, 1> indices_; /**< @brief Indices of the shapes, in the order referenced by the leaves.*/
+
+            /**
+             * @brief Builds the hierarchy around the given shapes, on the host.
+             *
+             * The hierarchy is built from the bounding boxes of the shapes during the whole exposure. The boxes of the nodes at
+             * the start and at the end of the exposure are then fitted bottom-up around the boxes of the shapes at these times.
+             *
+             * @tparam S Shape type
+             * @param shapes Shapes to sort in the hierarchy.
+             */
+            template<template<typename> typename S>
+            requires Entities::Coordinates<S, T>&& Entities::Moving<S, T> auto build(sycl::buffer<S<T>, 1>& shapes) -> void;
+
+            /**
+             * @brief Updates the hierarchy after the shapes have moved, by rebuilding it on the host.
+             *
+             * Shapes usually move to a new place on each update, so the hierarchy is built again around their new path.
+             *
+             * @tparam S Shape type
+             * @param queue Queue on which the shapes were updated.
+             * @param shapes Shapes contained in the hierarchy.
+             */
+            template<template<typename> typename S>
+            requires Entities::Coordinates<S, T>&& Entities::Moving<S, T> auto update(sycl::queue& queue, sycl::buffer<S<T>, 1>& shapes) -> void;
+
+            /**
+             * @brief Get a Accessor_t object attached to this acceleration structure
+             *
+             * @param cgh Device handler.
+             * @return Accessor_t Accessor that can be used on the device to traverse the acceleration structure
+             */
+            auto getAccessor(sycl::handler& cgh) -> Accessor_t;
+    };
+}
+
+#include "acceleration_structures/MotionBVH_t.tpp"
+
+#endif
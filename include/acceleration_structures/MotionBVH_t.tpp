@@ -0,0 +1,142 @@
+#include "acceleration_structures/BVHBuilder_t.hpp"
+#include <algorithm>
+#include <array>
+#include <vector>
+
+template<typename T>
+AGPTracer::AccelerationStructures::MotionBVH_t<T>::MotionBVH_t() : nodes_(sycl::range<1>{1}), indices_(sycl::range<1>{1}) {
+    const sycl::host_accessor<MotionBVHNode_t<T>, 1, sycl::access_mode::write> node_accessor(nodes_, sycl::no_init);
+    node_accessor[0] = MotionBVHNode_t<T>();
+
+    const sycl::host_accessor<uint32_t, 1, sycl::access_mode::write> index_accessor(indices_, sycl::no_init);
+    index_accessor[0] = 0;
+}
+
+template<typename T>
+template<template<typename> typename S>
+requires AGPTracer::Entities::Coordinates<S, T>&& AGPTracer::Entities::Moving<S, T> auto AGPTracer::AccelerationStructures::MotionBVH_t<T>::build(sycl::buffer<S<T>, 1>& shapes) -> void {
+    std::vector<Entities::Vec3<T>> mins(shapes.get_range()[0]);
+    std::vector<Entities::Vec3<T>> maxs(shapes.get_range()[0]);
+    std::vector<BVHNode_t<T>> starts(shapes.get_range()[0]);
+    std::vector<BVHNode_t<T>> ends(shapes.get_range()[0]);
+    {
+        const sycl::host_accessor<S<T>, 1, sycl::access_mode::read> shape_accessor(shapes);
+        for (size_t i = 0; i < mins.size(); ++i) {
+            mins[i]   = shape_accessor[i].mincoord();
+            maxs[i]   = shape_accessor[i].maxcoord();
+            starts[i] = BVHNode_t<T>(shape_accessor[i].mincoord(T{0}), shape_accessor[i].maxcoord(T{0}), 0, 0);
+            ends[i]   = BVHNode_t<T>(shape_accessor[i].mincoord(T{1}), shape_accessor[i].maxcoord(T{1}), 0, 0);
+        }
+    }
+
+    const BVHBuilder_t<T> builder(mins, maxs);
+    std::vector<MotionBVHNode_t<T>> nodes(builder.nodes_.size());
+
+    // Children are always after their parent, so going backwards fits every node after its children
+    for (size_t i = nodes.size(); i-- > 0;) {
+        const BVHNode_t<T>& node = builder.nodes_[i];
+        BVHNode_t<T> start;
+        BVHNode_t<T> end;
+        if (node.is_leaf()) {
+            for (uint32_t j = node.first_; j < node.first_ + node.count_; ++j) {
+                const uint32_t index = builder.indices_[j];
+                start.min_.min(starts[index].min_);
+                start.max_.max(starts[index].max_);
+                end.min_.min(ends[index].min_);
+                end.max_.max(ends[index].max_);
+            }
+        }
+        else {
+            for (const uint32_t child: {node.first_, node.first_ + 1}) {
+                start.min_.min(nodes[child].min_start_);
+                start.max_.max(nodes[child].max_start_);
+                end.min_.min(nodes[child].min_end_);
+                end.max_.max(nodes[child].max_end_);
+            }
+        }
+        nodes[i] = MotionBVHNode_t<T>(start, end, node.first_, node.count_);
+    }
+
+    nodes_   = sycl::buffer<MotionBVHNode_t<T>, 1>(sycl::range<1>{nodes.size()});
+    indices_ = sycl::buffer<uint32_t, 1>(sycl::range<1>{std::max(builder.indices_.size(), size_t{1})});
+
+    const sycl::host_accessor<MotionBVHNode_t<T>, 1, sycl::access_mode::write> node_accessor(nodes_, sycl::no_init);
+    std::copy(nodes.begin(), nodes.end(), node_accessor.begin());
+
+    const sycl::host_accessor<uint32_t, 1, sycl::access_mode::write> index_accessor(indices_, sycl::no_init);
+    std::copy(builder.indices_.begin(), builder.indices_.end(), index_accessor.begin());
+}
+
+template<typename T>
+template<template<typename> typename S>
+requires AGPTracer::Entities::Coordinates<S, T>&& AGPTracer::Entities::Moving<S, T> auto AGPTracer::AccelerationStructures::MotionBVH_t<T>::update(sycl::queue& queue, sycl::buffer<S<T>, 1>& shapes)
+    -> void {
+    queue.wait();
+    build(shapes);
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::MotionBVH_t<T>::getAccessor(sycl::handler& cgh) -> Accessor_t {
+    return Accessor_t(cgh, nodes_, indices_);
+}
+
+template<typename T>
+AGPTracer::AccelerationStructures::MotionBVH_t<T>::Accessor_t::Accessor_t(sycl::handler& cgh, sycl::buffer<MotionBVHNode_t<T>, 1>& nodes, sycl::buffer<uint32_t, 1>& indices) :
+        nodes_(nodes.template get_access<sycl::access::mode::read>(cgh)), indices_(indices.template get_access<sycl::access::mode::read>(cgh)) {}
+
+template<typename T>
+template<size_t N, class F>
+auto AGPTracer::AccelerationStructures::MotionBVH_t<T>::Accessor_t::traverse(const Entities::Ray_t<T, N>& ray, T& t, F leaf) const -> void {
+    constexpr size_t max_stack_size = BVHNode_t<T>::max_depth_;
+    const Entities::Vec3<T> inverse_direction(T{1} / ray.direction_[0], T{1} / ray.direction_[1], T{1} / ray.direction_[2]);
+
+    std::array<uint32_t, max_stack_size> stack; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+    size_t stack_size   = 0;
+    uint32_t node_index = 0;
+    T t_node{};
+
+    // The empty box of an empty hierarchy is hit by every ray, and its root would be taken for an inner node
+    if ((nodes_.get_range()[0] == 1) && !nodes_[0].is_leaf()) {
+        return;
+    }
+    if (!nodes_[0].at(ray.time_).intersection(ray.origin_, inverse_direction, t, t_node)) {
+        return;
+    }
+
+    while (true) {
+        const MotionBVHNode_t<T>& node = nodes_[node_index];
+
+        if (node.is_leaf()) {
+            for (uint32_t i = node.first_; i < node.first_ + node.count_; ++i) {
+                if (leaf(static_cast<size_t>(indices_[i]), t)) {
+                    return;
+                }
+            }
+        }
+        else {
+            T t_left{};
+            T t_right{};
+            const bool hit_left  = nodes_[node.first_].at(ray.time_).intersection(ray.origin_, inverse_direction, t, t_left);
+            const bool hit_right = nodes_[node.first_ + 1].at(ray.time_).intersection(ray.origin_, inverse_direction, t, t_right);
+
+            if (hit_left && hit_right) {
+                const bool left_first = t_left <= t_right;
+                // The host builder keeps the hierarchy at most max_depth_ deep, the check only keeps the stack in bounds
+                if (stack_size < max_stack_size) {
+                    stack[stack_size++] = left_first ? node.first_ + 1 : node.first_;
+                }
+                node_index = left_first ? node.first_ : node.first_ + 1;
+                continue;
+            }
+            if (hit_left || hit_right) {
+                node_index = hit_left ? node.first_ : node.first_ + 1;
+                continue;
+            }
+        }
+
+        if (stack_size == 0) {
+            return;
+        }
+        node_index = stack[--stack_size];
+    }
+}
@@ -0,0 +1,210 @@
+#ifndef AGPTRACER_ACCELERATIONSTRUCTURES_MULTIGRID_T_HPP
+#define AGPTRACER_ACCELERATIONSTRUCTURES_MULTIGRID_T_HPP
+
+#include "acceleration_structures/BVHNode_t.hpp"
+#include "entities/Ray_t.hpp"
+#include "entities/Shape.hpp"
+#include "entities/Vec3.hpp"
+#include <array>
+#include <cstdint>
+#include <sycl/sycl.hpp>
+
+namespace AGPTracer::AccelerationStructures {
+    /**
+     * @brief The multi grid class is a two-level uniform grid acceleration structure, used to quickly find which shapes a ray intersects.
+     *
+     * The bounding box of the shapes is cut in cells of the same size, about one per shape and at most max_resolution_ per axis. Each
+     * cell references every shape whose bounding box overlaps it. Cells referencing more than max_cell_content_ shapes are cut again
+     * in a finer grid of their own, so that dense parts of the scene don't make whole cells slow to intersect. The grid is built on
+     * the device in a few passes: shapes count the cells they overlap, the counts are scanned into offsets, and shapes scatter their
+     * index in the cells. Rays walk the cells in order with a 3D-DDA, and stop at the first cell containing an intersection.
+     *
+     * A grid can't be refitted, it is rebuilt on the device when shapes change. This is fast, as each pass is a single kernel, which
+     * makes grids a good fit for scenes where most of the shapes move every frame.
+     *
+     * @tparam T Floating point datatype to use
+     */
+    template<typename T = double>
+    class MultiGrid_t {
+        public:
+            class Accessor_t {
+                public:
+                    /**
+                     * @brief Construct a new Accessor_t object with the given buffers.
+                     *
+                     * @param cgh Device handler.
+                     * @param grid Grid whose buffers to access, and whose dimensions to copy.
+                     */
+                    Accessor_t(sycl::handler& cgh, MultiGrid_t<T>& grid);
+
+                    /**
+                     * @brief Traverses the grid with a ray, calling a function for each shape referenced by the cells hit by the ray.
+                     *
+                     * Cells are visited front to back, and the traversal stops after the first cell containing an intersection,
+                     * once t is lower than the distance at which the ray leaves the cell. The leaf function is called with the index
+                     * of a shape and a reference to t, and should lower t when it finds a closer intersection. It returns true to stop
+                     * the traversal, for example when any intersection is enough. Shapes overlapping several cells can be passed to
+                     * the leaf function more than once.
+                     *
+                     * @tparam N Number of mediums in the ray's medium list
+                     * @tparam F Leaf function type, callable as bool(size_t index, T& t)
+                     * @param[in] ray Ray to traverse the grid with.
+                     * @param[in, out] t Distance past which cells are skipped. Lowered by the leaf function.
+                     * @param[in] leaf Function called for each shape of the cells hit by the ray.
+                     */
+                    template<size_t N, class F>
+                    auto traverse(const Entities::Ray_t<T, N>& ray, T& t, F leaf) const -> void;
+
+                private:
+                    Entities::Vec3<T> min_; /**< @brief Minimum coordinates of the grid.*/
+                    Entities::Vec3<T> cell_size_; /**< @brief Size of the top-level cells.*/
+                    std::array<uint32_t, 3> resolution_; /**< @brief Number of top-level cells along each axis.*/
+                    sycl::accessor<uint32_t, 1, sycl::access::mode::read> cells_; /**< @brief Accessor to the reference offsets of the top-level cells.*/
+                    sycl::accessor<uint32_t, 1, sycl::access::mode::read> references_; /**< @brief Accessor to the shape references of the top-level cells.*/
+                    sycl::accessor<uint32_t, 1, sycl::access::mode::read> sub_resolutions_; /**< @brief Accessor to the resolution of the subgrid of each top-level cell.*/
+                    sycl::accessor<uint32_t, 1, sycl::access::mode::read> subgrids_; /**< @brief Accessor to the first subcell of each top-level cell.*/
+                    sycl::accessor<uint32_t, 1, sycl::access::mode::read> subcells_; /**< @brief Accessor to the reference offsets of the subcells.*/
+                    sycl::accessor<uint32_t, 1, sycl::access::mode::read> sub_references_; /**< @brief Accessor to the shape references of the subcells.*/
+
+                    /**
+                     * @brief Walks the cells of a grid hit by a ray, front to back, with a 3D-DDA.
+                     *
+                     * This is used for the top-level grid, and for the subgrid of each top-level cell, between the distances at which
+                     * the ray enters and leaves the cell.
+                     *
+                     * @tparam N Number of mediums in the ray's medium list
+                     * @tparam V Visit function type, callable as bool(const std::array<uint32_t, 3>& cell, T t_enter, T t_exit)
+                     * @param ray Ray to walk the grid with.
+                     * @param inverse_direction Inverse of the direction of the ray.
+                     * @param minimum Minimum coordinates of the grid.
+                     * @param cell_size Size of the cells of the grid.
+                     * @param resolution Number of cells of the grid along each axis.
+                     * @param t_min Distance at which the ray enters the grid.
+                     * @param t_max Distance past which the walk stops, at most the distance at which the ray leaves the grid.
+                     * @param visit Function called for each cell hit by the ray, with the distances at which the ray enters and leaves the cell. Returns true to stop the walk.
+                     * @return true The visit function stopped the walk.
+                     * @return false The walk went through all the cells hit by the ray.
+                     */
+                    template<size_t N, class V>
+                    static auto march(const Entities::Ray_t<T, N>& ray,
+                                      const Entities::Vec3<T>& inverse_direction,
+                                      const Entities::Vec3<T>& minimum,
+                                      const Entities::Vec3<T>& cell_size,
+                                      const std::array<uint32_t, 3>& resolution,
+                                      T t_min,
+                                      T t_max,
+                                      V visit) -> bool;
+            };
+
+            /**
+             * @brief Construct a new empty MultiGrid_t object, which no ray can intersect.
+             *
+             * @param max_resolution Maximum number of cells along each axis, for the top-level grid and for the subgrids.
+             * @param max_cell_content Number of references past which a top-level cell is cut in a subgrid.
+             */
+            explicit MultiGrid_t(uint32_t max_resolution = 128, uint32_t max_cell_content = 32);
+
+            Entities::Vec3<T> min_; /**< @brief Minimum coordinates of the grid, the minimum coordinates of the shapes.*/
+            Entities::Vec3<T> cell_size_; /**< @brief Size of the top-level cells.*/
+            std::array<uint32_t, 3> resolution_; /**< @brief Number of top-level cells along each axis. Zero for an empty grid.*/
+            sycl::buffer<uint32_t, 1> cells_; /**< @brief Index of the first reference of each top-level cell, followed by the total number of references.*/
+            sycl::buffer<uint32_t, 1> references_; /**< @brief Indices of the shapes overlapping each top-level cell, cell after cell.*/
+            sycl::buffer<uint32_t, 1> sub_resolutions_; /**< @brief Number of subcells along each axis of the subgrid of each top-level cell. Zero if the cell is not cut.*/
+            sycl::buffer<uint32_t, 1> subgrids_; /**< @brief Index of the first subcell of each top-level cell, followed by the total number of subcells.*/
+            sycl::buffer<uint32_t, 1> subcells_; /**< @brief Index of the first reference of each subcell, followed by the total number of references.*/
+            sycl::buffer<uint32_t, 1> sub_references_; /**< @brief Indices of the shapes overlapping each subcell, subcell after subcell.*/
+            sycl::buffer<uint32_t, 1> cursors_; /**< @brief Next free reference of each cell while the references are scattered.*/
+            sycl::buffer<uint32_t, 1> block_sums_; /**< @brief Partial sums used by the scans of the counts.*/
+            sycl::buffer<BVHNode_t<T>, 1> block_bounds_; /**< @brief Bounding box of the shapes of every block, reduced to the first element.*/
+            uint32_t max_resolution_; /**< @brief Maximum number of cells along each axis, for the top-level grid and for the subgrids.*/
+            uint32_t max_cell_content_; /**< @brief Number of references past which a top-level cell is cut in a subgrid.*/
+
+            /**
+             * @brief Builds the grid around the given shapes, on the default device.
+             *
+             * The grid has no host build, as every pass is a simple kernel. This submits the build to a new queue and waits for it.
+             *
+             * @tparam S Shape type
+             * @param shapes Shapes to sort in the grid.
+             */
+            template<template<typename> typename S>
+            requires Entities::Coordinates<S, T> auto build(sycl::buffer<S<T>, 1>& shapes) -> void;
+
+            /**
+             * @brief Builds the grid around the given shapes, on the device.
+             *
+             * The bounding box of the shapes is reduced on the device and read back to choose the resolution of the grid. The
+             * shapes then count the top-level cells they overlap, the counts are scanned into offsets and the shapes scatter
+             * their index in the cells. Cells with too many references get a subgrid, whose resolution grows with the cube root
+             * of the number of references, and the same count, scan and scatter passes are done for the subcells of each cell.
+             * The totals of the scans are read back to size the reference buffers.
+             *
+             * @tparam S Shape type
+             * @param queue Queue on which to submit the build.
+             * @param shapes Shapes to sort in the grid.
+             */
+            template<template<typename> typename S>
+            requires Entities::Coordinates<S, T> auto build(sycl::queue& queue, sycl::buffer<S<T>, 1>& shapes) -> void;
+
+            /**
+             * @brief Updates the grid after the shapes have changed, by rebuilding it on the device.
+             *
+             * @tparam S Shape type
+             * @param queue Queue on which to submit the update.
+             * @param shapes Shapes contained in the grid.
+             */
+            template<template<typename> typename S>
+            requires Entities::Coordinates<S, T> auto update(sycl::queue& queue, sycl::buffer<S<T>, 1>& shapes) -> void;
+
+            /**
+             * @brief Get a Accessor_t object attached to this acceleration structure
+             *
+             * @param cgh Device handler.
+             * @return Accessor_t Accessor that can be used on the device to traverse the acceleration structure
+             */
+            auto getAccessor(sycl::handler& cgh) -> Accessor_t;
+
+        private:
+            constexpr static size_t block_size_ = 1024; /**< @brief Number of elements processed serially by each work item of the reduction and scan kernels.*/
+
+            /**
+             * @brief Resizes a buffer if it is too small for the given number of elements.
+             *
+             * @param buffer Buffer to resize. Its content is lost if it is resized.
+             * @param size Number of elements the buffer must hold.
+             */
+            static auto reserve(sycl::buffer<uint32_t, 1>& buffer, size_t size) -> void;
+
+            /**
+             * @brief Finds the cells of a grid overlapped by a bounding box.
+             *
+             * The box is padded by a small part of a cell, so that shapes lying on the boundary between two cells are in both.
+             *
+             * @param minimum Minimum coordinates of the bounding box.
+             * @param maximum Maximum coordinates of the bounding box.
+             * @param grid_min Minimum coordinates of the grid.
+             * @param cell_size Size of the cells of the grid.
+             * @param resolution Number of cells of the grid along each axis.
+             * @return std::array<std::array<uint32_t, 3>, 2> First and last cell overlapped along each axis, both included.
+             */
+            static auto overlap(const Entities::Vec3<T>& minimum,
+                                const Entities::Vec3<T>& maximum,
+                                const Entities::Vec3<T>& grid_min,
+                                const Entities::Vec3<T>& cell_size,
+                                const std::array<uint32_t, 3>& resolution) -> std::array<std::array<uint32_t, 3>, 2>;
+
+            /**
+             * @brief Computes the exclusive prefix sum of a buffer on the device, and returns the total.
+             *
+             * @param queue Queue on which to submit the scan.
+             * @param values Buffer to scan in place.
+             * @param n_values Number of values to scan.
+             * @return uint32_t Sum of all the values, read back from the device.
+             */
+            auto scan(sycl::queue& queue, sycl::buffer<uint32_t, 1>& values, size_t n_values) -> uint32_t;
+    };
+}
+
+#include "acceleration_structures/MultiGrid_t.tpp"
+
+#endif
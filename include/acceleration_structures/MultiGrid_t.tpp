@@ -0,0 +1,477 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+template<typename T>
+AGPTracer::AccelerationStructures::MultiGrid_t<T>::MultiGrid_t(uint32_t max_resolution, uint32_t max_cell_content) :
+        min_(0),
+        cell_size_(1),
+        resolution_{0, 0, 0},
+        cells_(sycl::range<1>{1}),
+        references_(sycl::range<1>{1}),
+        sub_resolutions_(sycl::range<1>{1}),
+        subgrids_(sycl::range<1>{1}),
+        subcells_(sycl::range<1>{1}),
+        sub_references_(sycl::range<1>{1}),
+        cursors_(sycl::range<1>{1}),
+        block_sums_(sycl::range<1>{1}),
+        block_bounds_(sycl::range<1>{1}),
+        max_resolution_(max_resolution),
+        max_cell_content_(max_cell_content) {}
+
+template<typename T>
+template<template<typename> typename S>
+requires AGPTracer::Entities::Coordinates<S, T> auto AGPTracer::AccelerationStructures::MultiGrid_t<T>::build(sycl::buffer<S<T>, 1>& shapes) -> void {
+    sycl::queue queue(sycl::default_selector_v);
+    build(queue, shapes);
+    queue.wait();
+}
+
+template<typename T>
+template<template<typename> typename S>
+requires AGPTracer::Entities::Coordinates<S, T> auto AGPTracer::AccelerationStructures::MultiGrid_t<T>::build(sycl::queue& queue, sycl::buffer<S<T>, 1>& shapes) -> void {
+    using atomic_uint = sycl::atomic_ref<uint32_t, sycl::memory_order::relaxed, sycl::memory_scope::device, sycl::access::address_space::global_space>;
+
+    const size_t n_shapes = shapes.get_range()[0];
+    if (n_shapes == 0) {
+        resolution_ = {0, 0, 0};
+        return;
+    }
+
+    const size_t n_blocks = (n_shapes + block_size_ - 1) / block_size_;
+    if (block_bounds_.get_range()[0] < n_blocks) {
+        block_bounds_ = sycl::buffer<BVHNode_t<T>, 1>(sycl::range<1>{n_blocks});
+    }
+
+    // Bounding box of the shapes, reduced per block then on a single work item
+    queue.submit([&](sycl::handler& cgh) {
+        auto shape_accessor  = shapes.template get_access<sycl::access::mode::read>(cgh);
+        auto bounds_accessor = block_bounds_.template get_access<sycl::access::mode::write>(cgh);
+
+        cgh.parallel_for<class GridBounds>(sycl::range<1>{n_blocks}, [=](sycl::id<1> WIid) {
+            const size_t begin = WIid[0] * block_size_;
+            const size_t end   = std::min(begin + block_size_, n_shapes);
+            BVHNode_t<T> bounds;
+            for (size_t i = begin; i < end; ++i) {
+                bounds.min_.min(shape_accessor[i].mincoord());
+                bounds.max_.max(shape_accessor[i].maxcoord());
+            }
+            bounds_accessor[WIid] = bounds;
+        });
+    });
+
+    queue.submit([&](sycl::handler& cgh) {
+        auto bounds_accessor = block_bounds_.template get_access<sycl::access::mode::read_write>(cgh);
+
+        cgh.single_task<class GridReduceBounds>([=]() {
+            for (size_t i = 1; i < n_blocks; ++i) {
+                bounds_accessor[0].min_.min(bounds_accessor[i].min_);
+                bounds_accessor[0].max_.max(bounds_accessor[i].max_);
+            }
+        });
+    });
+
+    BVHNode_t<T> bounds;
+    {
+        const sycl::host_accessor<BVHNode_t<T>, 1, sycl::access_mode::read> bounds_accessor(block_bounds_);
+        bounds = bounds_accessor[0];
+    }
+
+    // About one cell per shape, with cells as close to cubes as possible. Flat scenes get a thin slab of cells.
+    constexpr T min_extent_ratio = static_cast<T>(1e-3);
+    Entities::Vec3<T> extent     = bounds.max_ - bounds.min_;
+    const T max_extent           = std::max(std::max(extent[0], extent[1]), extent[2]);
+    for (size_t i = 0; i < 3; ++i) {
+        extent[i] = std::max(extent[i], max_extent > T{0} ? max_extent * min_extent_ratio : T{1});
+    }
+    const T cells_per_length = std::cbrt(static_cast<T>(n_shapes) / (extent[0] * extent[1] * extent[2]));
+    for (size_t i = 0; i < 3; ++i) {
+        resolution_[i] = static_cast<uint32_t>(std::clamp(std::ceil(extent[i] * cells_per_length), T{1}, static_cast<T>(max_resolution_)));
+    }
+    min_       = bounds.min_;
+    cell_size_ = Entities::Vec3<T>(extent[0] / static_cast<T>(resolution_[0]), extent[1] / static_cast<T>(resolution_[1]), extent[2] / static_cast<T>(resolution_[2]));
+
+    const size_t n_cells                     = size_t{resolution_[0]} * resolution_[1] * resolution_[2];
+    const Entities::Vec3<T> grid_min         = min_;
+    const Entities::Vec3<T> cell_size        = cell_size_;
+    const std::array<uint32_t, 3> resolution = resolution_;
+    const uint32_t max_resolution            = max_resolution_;
+    const uint32_t max_cell_content          = max_cell_content_;
+    reserve(cells_, n_cells + 1);
+    reserve(sub_resolutions_, n_cells);
+    reserve(subgrids_, n_cells + 1);
+    reserve(cursors_, n_cells);
+
+    // Top-level cells: count, scan, scatter
+    queue.submit([&](sycl::handler& cgh) {
+        auto cell_accessor = cells_.template get_access<sycl::access::mode::write>(cgh);
+
+        cgh.parallel_for<class GridClearCells>(sycl::range<1>{n_cells + 1}, [=](sycl::id<1> WIid) { cell_accessor[WIid] = 0; });
+    });
+
+    queue.submit([&](sycl::handler& cgh) {
+        auto shape_accessor = shapes.template get_access<sycl::access::mode::read>(cgh);
+        auto cell_accessor  = cells_.template get_access<sycl::access::mode::read_write>(cgh);
+
+        cgh.parallel_for<class GridCountCells>(sycl::range<1>{n_shapes}, [=](sycl::id<1> WIid) {
+            const std::array<std::array<uint32_t, 3>, 2> range = overlap(shape_accessor[WIid].mincoord(), shape_accessor[WIid].maxcoord(), grid_min, cell_size, resolution);
+            for (uint32_t z = range[0][2]; z <= range[1][2]; ++z) {
+                for (uint32_t y = range[0][1]; y <= range[1][1]; ++y) {
+                    for (uint32_t x = range[0][0]; x <= range[1][0]; ++x) {
+                        atomic_uint(cell_accessor[(size_t{z} * resolution[1] + y) * resolution[0] + x]).fetch_add(1);
+                    }
+                }
+            }
+        });
+    });
+
+    const uint32_t n_references = scan(queue, cells_, n_cells + 1);
+    reserve(references_, std::max(size_t{n_references}, size_t{1}));
+
+    queue.submit([&](sycl::handler& cgh) {
+        auto cell_accessor   = cells_.template get_access<sycl::access::mode::read>(cgh);
+        auto cursor_accessor = cursors_.template get_access<sycl::access::mode::write>(cgh);
+
+        cgh.parallel_for<class GridCellCursors>(sycl::range<1>{n_cells}, [=](sycl::id<1> WIid) { cursor_accessor[WIid] = cell_accessor[WIid]; });
+    });
+
+    queue.submit([&](sycl::handler& cgh) {
+        auto shape_accessor     = shapes.template get_access<sycl::access::mode::read>(cgh);
+        auto cursor_accessor    = cursors_.template get_access<sycl::access::mode::read_write>(cgh);
+        auto reference_accessor = references_.template get_access<sycl::access::mode::write>(cgh);
+
+        cgh.parallel_for<class GridScatterCells>(sycl::range<1>{n_shapes}, [=](sycl::id<1> WIid) {
+            const std::array<std::array<uint32_t, 3>, 2> range = overlap(shape_accessor[WIid].mincoord(), shape_accessor[WIid].maxcoord(), grid_min, cell_size, resolution);
+            for (uint32_t z = range[0][2]; z <= range[1][2]; ++z) {
+                for (uint32_t y = range[0][1]; y <= range[1][1]; ++y) {
+                    for (uint32_t x = range[0][0]; x <= range[1][0]; ++x) {
+                        const uint32_t slot      = atomic_uint(cursor_accessor[(size_t{z} * resolution[1] + y) * resolution[0] + x]).fetch_add(1);
+                        reference_accessor[slot] = static_cast<uint32_t>(WIid[0]);
+                    }
+                }
+            }
+        });
+    });
+
+    // Subgrids, with a resolution growing with the cube root of the number of references of the cell
+    queue.submit([&](sycl::handler& cgh) {
+        auto cell_accessor           = cells_.template get_access<sycl::access::mode::read>(cgh);
+        auto sub_resolution_accessor = sub_resolutions_.template get_access<sycl::access::mode::write>(cgh);
+        auto subgrid_accessor        = subgrids_.template get_access<sycl::access::mode::write>(cgh);
+
+        cgh.parallel_for<class GridSubdivide>(sycl::range<1>{n_cells + 1}, [=](sycl::id<1> WIid) {
+            if (WIid[0] == n_cells) {
+                subgrid_accessor[WIid] = 0;
+                return;
+            }
+            const uint32_t count = cell_accessor[WIid[0] + 1] - cell_accessor[WIid];
+            const uint32_t sub_resolution
+                                          = (count > max_cell_content) ? static_cast<uint32_t>(sycl::clamp(sycl::ceil(sycl::cbrt(static_cast<T>(count))), T{2}, static_cast<T>(max_resolution))) : 0;
+            sub_resolution_accessor[WIid] = sub_resolution;
+            subgrid_accessor[WIid]        = sub_resolution * sub_resolution * sub_resolution;
+        });
+    });
+
+    const uint32_t n_subcells = scan(queue, subgrids_, n_cells + 1);
+    if (n_subcells == 0) {
+        return;
+    }
+    reserve(subcells_, size_t{n_subcells} + 1);
+    reserve(cursors_, n_subcells);
+
+    // Subcells: count, scan, scatter. Each top-level cell is done by a single work item, so no atomics are needed.
+    queue.submit([&](sycl::handler& cgh) {
+        auto subcell_accessor = subcells_.template get_access<sycl::access::mode::write>(cgh);
+
+        cgh.parallel_for<class GridClearSubcells>(sycl::range<1>{size_t{n_subcells} + 1}, [=](sycl::id<1> WIid) { subcell_accessor[WIid] = 0; });
+    });
+
+    queue.submit([&](sycl::handler& cgh) {
+        auto shape_accessor          = shapes.template get_access<sycl::access::mode::read>(cgh);
+        auto cell_accessor           = cells_.template get_access<sycl::access::mode::read>(cgh);
+        auto reference_accessor      = references_.template get_access<sycl::access::mode::read>(cgh);
+        auto sub_resolution_accessor = sub_resolutions_.template get_access<sycl::access::mode::read>(cgh);
+        auto subgrid_accessor        = subgrids_.template get_access<sycl::access::mode::read>(cgh);
+        auto subcell_accessor        = subcells_.template get_access<sycl::access::mode::read_write>(cgh);
+
+        cgh.parallel_for<class GridCountSubcells>(sycl::range<1>{n_cells}, [=](sycl::id<1> WIid) {
+            const uint32_t sub_resolution = sub_resolution_accessor[WIid];
+            if (sub_resolution == 0) {
+                return;
+            }
+            const size_t x                                = WIid[0] % resolution[0];
+            const size_t y                                = (WIid[0] / resolution[0]) % resolution[1];
+            const size_t z                                = WIid[0] / (size_t{resolution[0]} * resolution[1]);
+            const Entities::Vec3<T> cell_min              = grid_min + cell_size * Entities::Vec3<T>(static_cast<T>(x), static_cast<T>(y), static_cast<T>(z));
+            const Entities::Vec3<T> sub_size              = cell_size / static_cast<T>(sub_resolution);
+            const std::array<uint32_t, 3> sub_resolution3 = {sub_resolution, sub_resolution, sub_resolution};
+
+            for (uint32_t i = cell_accessor[WIid]; i < cell_accessor[WIid[0] + 1]; ++i) {
+                const uint32_t index                               = reference_accessor[i];
+                const std::array<std::array<uint32_t, 3>, 2> range = overlap(shape_accessor[index].mincoord(), shape_accessor[index].maxcoord(), cell_min, sub_size, sub_resolution3);
+                for (uint32_t k = range[0][2]; k <= range[1][2]; ++k) {
+                    for (uint32_t j = range[0][1]; j <= range[1][1]; ++j) {
+                        for (uint32_t l = range[0][0]; l <= range[1][0]; ++l) {
+                            ++subcell_accessor[subgrid_accessor[WIid] + (k * sub_resolution + j) * sub_resolution + l];
+                        }
+                    }
+                }
+            }
+        });
+    });
+
+    const uint32_t n_sub_references = scan(queue, subcells_, size_t{n_subcells} + 1);
+    reserve(sub_references_, std::max(size_t{n_sub_references}, size_t{1}));
+
+    queue.submit([&](sycl::handler& cgh) {
+        auto subcell_accessor = subcells_.template get_access<sycl::access::mode::read>(cgh);
+        auto cursor_accessor  = cursors_.template get_access<sycl::access::mode::write>(cgh);
+
+        cgh.parallel_for<class GridSubcellCursors>(sycl::range<1>{n_subcells}, [=](sycl::id<1> WIid) { cursor_accessor[WIid] = subcell_accessor[WIid]; });
+    });
+
+    queue.submit([&](sycl::handler& cgh) {
+        auto shape_accessor          = shapes.template get_access<sycl::access::mode::read>(cgh);
+        auto cell_accessor           = cells_.template get_access<sycl::access::mode::read>(cgh);
+        auto reference_accessor      = references_.template get_access<sycl::access::mode::read>(cgh);
+        auto sub_resolution_accessor = sub_resolutions_.template get_access<sycl::access::mode::read>(cgh);
+        auto subgrid_accessor        = subgrids_.template get_access<sycl::access::mode::read>(cgh);
+        auto cursor_accessor         = cursors_.template get_access<sycl::access::mode::read_write>(cgh);
+        auto sub_reference_accessor  = sub_references_.template get_access<sycl::access::mode::write>(cgh);
+
+        cgh.parallel_for<class GridScatterSubcells>(sycl::range<1>{n_cells}, [=](sycl::id<1> WIid) {
+            const uint32_t sub_resolution = sub_resolution_accessor[WIid];
+            if (sub_resolution == 0) {
+                return;
+            }
+            const size_t x                                = WIid[0] % resolution[0];
+            const size_t y                                = (WIid[0] / resolution[0]) % resolution[1];
+            const size_t z                                = WIid[0] / (size_t{resolution[0]} * resolution[1]);
+            const Entities::Vec3<T> cell_min              = grid_min + cell_size * Entities::Vec3<T>(static_cast<T>(x), static_cast<T>(y), static_cast<T>(z));
+            const Entities::Vec3<T> sub_size              = cell_size / static_cast<T>(sub_resolution);
+            const std::array<uint32_t, 3> sub_resolution3 = {sub_resolution, sub_resolution, sub_resolution};
+
+            for (uint32_t i = cell_accessor[WIid]; i < cell_accessor[WIid[0] + 1]; ++i) {
+                const uint32_t index                               = reference_accessor[i];
+                const std::array<std::array<uint32_t, 3>, 2> range = overlap(shape_accessor[index].mincoord(), shape_accessor[index].maxcoord(), cell_min, sub_size, sub_resolution3);
+                for (uint32_t k = range[0][2]; k <= range[1][2]; ++k) {
+                    for (uint32_t j = range[0][1]; j <= range[1][1]; ++j) {
+                        for (uint32_t l = range[0][0]; l <= range[1][0]; ++l) {
+                            sub_reference_accessor[cursor_accessor[subgrid_accessor[WIid] + (k * sub_resolution + j) * sub_resolution + l]++] = index;
+                        }
+                    }
+                }
+            }
+        });
+    });
+}
+
+template<typename T>
+template<template<typename> typename S>
+requires AGPTracer::Entities::Coordinates<S, T> auto AGPTracer::AccelerationStructures::MultiGrid_t<T>::update(sycl::queue& queue, sycl::buffer<S<T>, 1>& shapes) -> void {
+    build(queue, shapes);
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::MultiGrid_t<T>::getAccessor(sycl::handler& cgh) -> Accessor_t {
+    return Accessor_t(cgh, *this);
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::MultiGrid_t<T>::reserve(sycl::buffer<uint32_t, 1>& buffer, size_t size) -> void {
+    if (buffer.get_range()[0] < size) {
+        buffer = sycl::buffer<uint32_t, 1>(sycl::range<1>{size});
+    }
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::MultiGrid_t<T>::scan(sycl::queue& queue, sycl::buffer<uint32_t, 1>& values, size_t n_values) -> uint32_t {
+    const size_t n_chunks = (n_values + block_size_ - 1) / block_size_;
+    reserve(block_sums_, n_chunks + 1);
+
+    queue.submit([&](sycl::handler& cgh) {
+        auto value_accessor = values.template get_access<sycl::access::mode::read_write>(cgh);
+        auto sum_accessor   = block_sums_.template get_access<sycl::access::mode::write>(cgh);
+
+        cgh.parallel_for<class GridScanChunks>(sycl::range<1>{n_chunks}, [=](sycl::id<1> WIid) {
+            const size_t begin = WIid[0] * block_size_;
+            const size_t end   = std::min(begin + block_size_, n_values);
+            uint32_t sum       = 0;
+            for (size_t i = begin; i < end; ++i) {
+                const uint32_t value = value_accessor[i];
+                value_accessor[i]    = sum;
+                sum += value;
+            }
+            sum_accessor[WIid] = sum;
+        });
+    });
+
+    // The total is written after the partial sums, to be read back
+    queue.submit([&](sycl::handler& cgh) {
+        auto sum_accessor = block_sums_.template get_access<sycl::access::mode::read_write>(cgh);
+
+        cgh.single_task<class GridScanSums>([=]() {
+            uint32_t sum = 0;
+            for (size_t i = 0; i < n_chunks; ++i) {
+                const uint32_t value = sum_accessor[i];
+                sum_accessor[i]      = sum;
+                sum += value;
+            }
+            sum_accessor[n_chunks] = sum;
+        });
+    });
+
+    queue.submit([&](sycl::handler& cgh) {
+        auto value_accessor = values.template get_access<sycl::access::mode::read_write>(cgh);
+        auto sum_accessor   = block_sums_.template get_access<sycl::access::mode::read>(cgh);
+
+        cgh.parallel_for<class GridScanAdd>(sycl::range<1>{n_chunks}, [=](sycl::id<1> WIid) {
+            const size_t begin = WIid[0] * block_size_;
+            const size_t end   = std::min(begin + block_size_, n_values);
+            for (size_t i = begin; i < end; ++i) {
+                value_accessor[i] += sum_accessor[WIid];
+            }
+        });
+    });
+
+    const sycl::host_accessor<uint32_t, 1, sycl::access_mode::read> sum_accessor(block_sums_);
+    return sum_accessor[n_chunks];
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::MultiGrid_t<T>::overlap(const Entities::Vec3<T>& minimum,
+                                                                const Entities::Vec3<T>& maximum,
+                                                                const Entities::Vec3<T>& grid_min,
+                                                                const Entities::Vec3<T>& cell_size,
+                                                                const std::array<uint32_t, 3>& resolution) -> std::array<std::array<uint32_t, 3>, 2> {
+    constexpr T padding = static_cast<T>(1e-4);
+    std::array<std::array<uint32_t, 3>, 2> range{};
+    for (size_t i = 0; i < 3; ++i) {
+        const T last_cell = static_cast<T>(resolution[i] - 1);
+        range[0][i]       = static_cast<uint32_t>(sycl::clamp(sycl::floor((minimum[i] - grid_min[i]) / cell_size[i] - padding), T{0}, last_cell));
+        range[1][i]       = static_cast<uint32_t>(sycl::clamp(sycl::floor((maximum[i] - grid_min[i]) / cell_size[i] + padding), T{0}, last_cell));
+    }
+    return range;
+}
+
+template<typename T>
+AGPTracer::AccelerationStructures::MultiGrid_t<T>::Accessor_t::Accessor_t(sycl::handler& cgh, MultiGrid_t<T>& grid) :
+        min_(grid.min_),
+        cell_size_(grid.cell_size_),
+        resolution_(grid.resolution_),
+        cells_(grid.cells_.template get_access<sycl::access::mode::read>(cgh)),
+        references_(grid.references_.template get_access<sycl::access::mode::read>(cgh)),
+        sub_resolutions_(grid.sub_resolutions_.template get_access<sycl::access::mode::read>(cgh)),
+        subgrids_(grid.subgrids_.template get_access<sycl::access::mode::read>(cgh)),
+        subcells_(grid.subcells_.template get_access<sycl::access::mode::read>(cgh)),
+        sub_references_(grid.sub_references_.template get_access<sycl::access::mode::read>(cgh)) {}
+
+template<typename T>
+template<size_t N, class F>
+auto AGPTracer::AccelerationStructures::MultiGrid_t<T>::Accessor_t::traverse(const Entities::Ray_t<T, N>& ray, T& t, F leaf) const -> void {
+    if (resolution_[0] == 0) {
+        return;
+    }
+
+    const Entities::Vec3<T> inverse_direction(T{1} / ray.direction_[0], T{1} / ray.direction_[1], T{1} / ray.direction_[2]);
+    const BVHNode_t<T> bounds(min_, min_ + cell_size_ * Entities::Vec3<T>(static_cast<T>(resolution_[0]), static_cast<T>(resolution_[1]), static_cast<T>(resolution_[2])), 0, 0);
+    T t_enter{};
+    if (!bounds.intersection(ray.origin_, inverse_direction, t, t_enter)) {
+        return;
+    }
+
+    march(ray, inverse_direction, min_, cell_size_, resolution_, t_enter, t, [&](const std::array<uint32_t, 3>& cell, T t_cell_enter, T t_cell_exit) {
+        const size_t index            = (size_t{cell[2]} * resolution_[1] + cell[1]) * resolution_[0] + cell[0];
+        const uint32_t sub_resolution = sub_resolutions_[index];
+
+        if (sub_resolution == 0) {
+            for (uint32_t i = cells_[index]; i < cells_[index + 1]; ++i) {
+                if (leaf(static_cast<size_t>(references_[i]), t)) {
+                    return true;
+                }
+            }
+            return t <= t_cell_exit;
+        }
+
+        const Entities::Vec3<T> cell_min = min_ + cell_size_ * Entities::Vec3<T>(static_cast<T>(cell[0]), static_cast<T>(cell[1]), static_cast<T>(cell[2]));
+        const uint32_t first             = subgrids_[index];
+        return march(ray,
+                     inverse_direction,
+                     cell_min,
+                     cell_size_ / static_cast<T>(sub_resolution),
+                     {sub_resolution, sub_resolution, sub_resolution},
+                     t_cell_enter,
+                     t_cell_exit,
+                     [&](const std::array<uint32_t, 3>& subcell, T /*t_subcell_enter*/, T t_subcell_exit) {
+                         const size_t sub_index = first + (size_t{subcell[2]} * sub_resolution + subcell[1]) * sub_resolution + subcell[0];
+                         for (uint32_t i = subcells_[sub_index]; i < subcells_[sub_index + 1]; ++i) {
+                             if (leaf(static_cast<size_t>(sub_references_[i]), t)) {
+                                 return true;
+                             }
+                         }
+                         return t <= t_subcell_exit;
+                     });
+    });
+}
+
+template<typename T>
+template<size_t N, class V>
+auto AGPTracer::AccelerationStructures::MultiGrid_t<T>::Accessor_t::march(const Entities::Ray_t<T, N>& ray,
+                                                                          const Entities::Vec3<T>& inverse_direction,
+                                                                          const Entities::Vec3<T>& minimum,
+                                                                          const Entities::Vec3<T>& cell_size,
+                                                                          const std::array<uint32_t, 3>& resolution,
+                                                                          T t_min,
+                                                                          T t_max,
+                                                                          V visit) -> bool {
+    std::array<uint32_t, 3> cell{};
+    std::array<T, 3> t_next{};
+    std::array<T, 3> t_delta{};
+
+    // The first cell is found from the entry point, clamped to the grid in case it is rounded outside of it
+    for (size_t i = 0; i < 3; ++i) {
+        const T position = ray.origin_[i] + ray.direction_[i] * t_min;
+        cell[i]          = static_cast<uint32_t>(sycl::clamp(sycl::floor((position - minimum[i]) / cell_size[i]), T{0}, static_cast<T>(resolution[i] - 1)));
+
+        if (ray.direction_[i] > T{0}) {
+            t_next[i]  = (minimum[i] + static_cast<T>(cell[i] + 1) * cell_size[i] - ray.origin_[i]) * inverse_direction[i];
+            t_delta[i] = cell_size[i] * inverse_direction[i];
+        }
+        else if (ray.direction_[i] < T{0}) {
+            t_next[i]  = (minimum[i] + static_cast<T>(cell[i]) * cell_size[i] - ray.origin_[i]) * inverse_direction[i];
+            t_delta[i] = -cell_size[i] * inverse_direction[i];
+        }
+        else {
+            t_next[i]  = std::numeric_limits<T>::max();
+            t_delta[i] = std::numeric_limits<T>::max();
+        }
+    }
+
+    T t_enter = t_min;
+    while (true) {
+        const size_t axis = (t_next[0] < t_next[1]) ? ((t_next[0] < t_next[2]) ? 0 : 2) : ((t_next[1] < t_next[2]) ? 1 : 2);
+        const T t_exit    = std::min(t_next[axis], t_max);
+
+        if (visit(cell, t_enter, t_exit)) {
+            return true;
+        }
+        if (t_next[axis] >= t_max) {
+            return false;
+        }
+
+        if (ray.direction_[axis] > T{0}) {
+            if (++cell[axis] == resolution[axis]) {
+                return false;
+            }
+        }
+        else {
+            if (cell[axis] == 0) {
+                return false;
+            }
+            --cell[axis];
+        }
+        t_enter = t_next[axis];
+        t_next[axis] += t_delta[axis];
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef AGPTRACER_ACCELERATIONSTRUCTURES_SBVHBUILDER_T_HPP
+#define AGPTRACER_ACCELERATIONSTRUCTURES_SBVHBUILDER_T_HPP
+
+#include "acceleration_structures/BVHNode_t.hpp"
+#include "entities/Vec3.hpp"
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace AGPTracer::AccelerationStructures {
+    /**
+     * @brief The spatial split BVH builder class builds a bounding volume hierarchy on the host, splitting triangles that straddle split planes.
+     *
+     * Long and thin triangles have large bounding boxes that overlap those of their neighbours, so that any partition of the triangles
+     * into two children gives children that overlap a lot, and rays have to visit both. At each node, this builder compares the best
+     * binned object split, as in BVHBuilder_t, with the best binned spatial split, where the node is cut by a plane and the triangles
+     * crossing it are referenced in both children, each with the bounding box of the part of the triangle on its side. Spatial splits
+     * are only tried when the children of the object split overlap, and stop once the number of references reaches the given budget.
+     * The leaves point to ranges of the indices_ array, in which a triangle can appear more than once.
+     *
+     * @tparam T Floating point datatype to use
+     */
+    template<typename T = double>
+    class SBVHBuilder_t {
+        public:
+            /**
+             * @brief Construct a new SBVHBuilder_t object, building a hierarchy around the given triangles.
+             *
+             * @param triangles Points of the triangles to sort.
+             * @param reference_budget Maximum number of references to triangles in the leaves, relative to the number of triangles. Spatial splits are not used past this.
+             * @param max_leaf_size Maximum number of triangles in a leaf. Leaves with fewer triangles will be created if it is cheaper according to the surface area heuristic.
+             */
+            SBVHBuilder_t(std::span<const std::array<Entities::Vec3<T>, 3>> triangles, T reference_budget = 1.5, uint32_t max_leaf_size = 4);
+
+            std::vector<BVHNode_t<T>> nodes_; /**< @brief Flattened nodes of the hierarchy. The root is the first node.*/
+            std::vector<uint32_t> indices_; /**< @brief Indices of the input triangles, in the order referenced by the leaves. Split triangles appear once per leaf containing them.*/
+
+        private:
+            /**
+             * @brief Reference to a triangle, or to the part of a triangle contained in a node.
+             */
+            struct Reference {
+                    uint32_t index; /**< @brief Index of the triangle.*/
+                    BVHNode_t<T> box; /**< @brief Bounding box of the referenced part of the triangle.*/
+            };
+
+            /**
+             * @brief Split of a node in two children.
+             */
+            struct Split {
+                    T cost; /**< @brief Cost of the split, relative to the cost of intersecting a single triangle. Infinite if the node can't be split.*/
+                    unsigned int axis; /**< @brief Axis of the split.*/
+                    T position; /**< @brief Coordinate along the axis separating the children. For object splits, this is a centroid coordinate.*/
+                    BVHNode_t<T> left; /**< @brief Bounding box of the left child.*/
+                    BVHNode_t<T> right; /**< @brief Bounding box of the right child.*/
+            };
+
+            /**
+             * @brief Finds the best split of the references in two sets, according to the binned surface area heuristic on their centroids.
+             *
+             * @param references References contained in the node.
+             * @param node Node to split, with its bounding box already computed.
+             * @return Split Best object split of the node.
+             */
+            auto find_object_split(const std::vector<Reference>& references, const BVHNode_t<T>& node) const -> Split;
+
+            /**
+             * @brief Finds the best plane cutting the node in two, according to the binned surface area heuristic on the clipped references.
+             *
+             * @param triangles Points of the triangles.
+             * @param references References contained in the node.
+             * @param node Node to split, with its bounding box already computed.
+             * @param[out] n_duplicates Number of references crossing the best plane, which would be duplicated by the split.
+             * @return Split Best spatial split of the node.
+             */
+            auto find_spatial_split(std::span<const std::array<Entities::Vec3<T>, 3>> triangles, const std::vector<Reference>& references, const BVHNode_t<T>& node, size_t& n_duplicates) const
+                -> Split;
+
+            /**
+             * @brief Computes the bounding box of the part of a triangle between two planes, within a bounding box.
+             *
+             * @param triangle Points of the triangle.
+             * @param box Bounding box of the referenced part of the triangle.
+             * @param axis Axis normal to the planes.
+             * @param low Coordinate of the first plane along the axis.
+             * @param high Coordinate of the second plane along the axis.
+             * @return BVHNode_t<T> Bounding box of the clipped triangle. Empty if the triangle doesn't cross the slab.
+             */
+            static auto clip(const std::array<Entities::Vec3<T>, 3>& triangle, const BVHNode_t<T>& box, unsigned int axis, T low, T high) -> BVHNode_t<T>;
+    };
+}
+
+#include "acceleration_structures/SBVHBuilder_t.tpp"
+
+#endif
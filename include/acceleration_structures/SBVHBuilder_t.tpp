@@ -0,0 +1,338 @@
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <utility>
+
+template<typename T>
+AGPTracer::AccelerationStructures::SBVHBuilder_t<T>::SBVHBuilder_t(std::span<const std::array<Entities::Vec3<T>, 3>> triangles, T reference_budget, uint32_t max_leaf_size) {
+    constexpr T min_overlap = 1e-5; // Spatial splits are only tried if the object split children overlap by this fraction of the root area
+
+    struct BuildTask {
+            uint32_t node;
+            std::vector<Reference> references;
+            uint32_t depth;
+    };
+
+    const auto is_empty = [](const BVHNode_t<T>& box) {
+        return (box.min_[0] > box.max_[0]) || (box.min_[1] > box.max_[1]) || (box.min_[2] > box.max_[2]);
+    };
+
+    nodes_.reserve(2 * std::max(triangles.size(), size_t{1}));
+    nodes_.emplace_back();
+    indices_.reserve(triangles.size());
+
+    if (triangles.empty()) {
+        return;
+    }
+
+    const auto max_references = static_cast<size_t>(reference_budget * static_cast<T>(triangles.size()));
+    size_t n_references       = triangles.size();
+    T root_area               = 0;
+
+    std::vector<Reference> references(triangles.size());
+    for (size_t i = 0; i < triangles.size(); ++i) {
+        references[i].index = static_cast<uint32_t>(i);
+        for (const auto& point: triangles[i]) {
+            references[i].box.min_.min(point);
+            references[i].box.max_.max(point);
+        }
+    }
+
+    std::vector<BuildTask> tasks;
+    tasks.push_back({0, std::move(references), 0});
+
+    while (!tasks.empty()) {
+        BuildTask task = std::move(tasks.back());
+        tasks.pop_back();
+
+        BVHNode_t<T> node;
+        for (const Reference& reference: task.references) {
+            node.min_.min(reference.box.min_);
+            node.max_.max(reference.box.max_);
+        }
+        if (task.node == 0) {
+            root_area = node.surface_area();
+        }
+
+        const auto count = static_cast<uint32_t>(task.references.size());
+
+        if (count > 1) {
+            Split split  = find_object_split(task.references, node);
+            bool spatial = false;
+
+            // Children of a split have at most as many references as their parent. Splitting in the middle at every level reaches
+            // leaves of one reference after bit_width(count - 1) levels, so once the depth leaves just that many levels, nodes are
+            // split in the middle, so that no leaf is deeper than max_depth_.
+            const bool depth_limited = task.depth + static_cast<uint32_t>(std::bit_width(count - 1)) >= BVHNode_t<T>::max_depth_;
+
+            // Spatial splits are only worth it where the children of the object split overlap
+            const BVHNode_t<T> overlap(split.left.min_.getMax(split.right.min_), split.left.max_.getMin(split.right.max_), 0, 0);
+            if (!depth_limited && (n_references < max_references) && (overlap.surface_area() > min_overlap * root_area)) {
+                size_t n_duplicates       = 0;
+                const Split spatial_split = find_spatial_split(triangles, task.references, node, n_duplicates);
+                if ((spatial_split.cost < split.cost) && (n_references + n_duplicates <= max_references)) {
+                    split   = spatial_split;
+                    spatial = true;
+                }
+            }
+
+            if ((split.cost < static_cast<T>(count)) || (count > max_leaf_size)) {
+                std::vector<Reference> left;
+                std::vector<Reference> right;
+                size_t n_split = 0;
+
+                if (spatial) {
+                    for (const Reference& reference: task.references) {
+                        if (reference.box.max_[split.axis] <= split.position) {
+                            left.push_back(reference);
+                        }
+                        else if (reference.box.min_[split.axis] >= split.position) {
+                            right.push_back(reference);
+                        }
+                        else {
+                            // The reference is split in two, each side keeping the box of its part of the triangle
+                            const BVHNode_t<T> left_box  = clip(triangles[reference.index], reference.box, split.axis, reference.box.min_[split.axis], split.position);
+                            const BVHNode_t<T> right_box = clip(triangles[reference.index], reference.box, split.axis, split.position, reference.box.max_[split.axis]);
+                            if (!is_empty(left_box)) {
+                                left.push_back({reference.index, left_box});
+                            }
+                            if (!is_empty(right_box)) {
+                                right.push_back({reference.index, right_box});
+                            }
+                            if (is_empty(left_box) && is_empty(right_box)) {
+                                left.push_back(reference);
+                            }
+                            n_split += (!is_empty(left_box) && !is_empty(right_box)) ? 1 : 0;
+                        }
+                    }
+                }
+                else if ((split.cost != std::numeric_limits<T>::infinity()) && !depth_limited) {
+                    for (const Reference& reference: task.references) {
+                        if ((reference.box.min_[split.axis] + reference.box.max_[split.axis]) / T{2} < split.position) {
+                            left.push_back(reference);
+                        }
+                        else {
+                            right.push_back(reference);
+                        }
+                    }
+                }
+
+                if (left.empty() || right.empty()) {
+                    // Splits along the longest axis of the centroids, in the middle of the range
+                    Entities::Vec3<T> centroid_min(std::numeric_limits<T>::max());
+                    Entities::Vec3<T> centroid_max(std::numeric_limits<T>::lowest());
+                    for (const Reference& reference: task.references) {
+                        const Entities::Vec3<T> centroid = (reference.box.min_ + reference.box.max_) / T{2};
+                        centroid_min.min(centroid);
+                        centroid_max.max(centroid);
+                    }
+                    const Entities::Vec3<T> extent = centroid_max - centroid_min;
+                    const unsigned int axis        = (extent[0] > extent[1]) ? ((extent[0] > extent[2]) ? 0 : 2) : ((extent[1] > extent[2]) ? 1 : 2);
+                    const auto middle              = task.references.begin() + count / 2;
+
+                    std::nth_element(task.references.begin(), middle, task.references.end(), [&](const Reference& reference_a, const Reference& reference_b) {
+                        return reference_a.box.min_[axis] + reference_a.box.max_[axis] < reference_b.box.min_[axis] + reference_b.box.max_[axis];
+                    });
+                    left.assign(task.references.begin(), middle);
+                    right.assign(middle, task.references.end());
+                    n_split = 0;
+                }
+
+                n_references += n_split;
+                const auto first = static_cast<uint32_t>(nodes_.size());
+                nodes_.emplace_back();
+                nodes_.emplace_back();
+                nodes_[task.node] = BVHNode_t<T>(node.min_, node.max_, first, 0);
+
+                tasks.push_back({first + 1, std::move(right), task.depth + 1});
+                tasks.push_back({first, std::move(left), task.depth + 1});
+                continue;
+            }
+        }
+
+        nodes_[task.node] = BVHNode_t<T>(node.min_, node.max_, static_cast<uint32_t>(indices_.size()), count);
+        for (const Reference& reference: task.references) {
+            indices_.push_back(reference.index);
+        }
+    }
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::SBVHBuilder_t<T>::find_object_split(const std::vector<Reference>& references, const BVHNode_t<T>& node) const -> Split {
+    constexpr size_t n_bins    = 16;
+    constexpr T traversal_cost = 1; // Relative to the cost of intersecting a shape
+    Split split{std::numeric_limits<T>::infinity(), 0, T{0}, BVHNode_t<T>(), BVHNode_t<T>()};
+    const T parent_surface_area = node.surface_area();
+
+    Entities::Vec3<T> centroid_min(std::numeric_limits<T>::max());
+    Entities::Vec3<T> centroid_max(std::numeric_limits<T>::lowest());
+    for (const Reference& reference: references) {
+        const Entities::Vec3<T> centroid = (reference.box.min_ + reference.box.max_) / T{2};
+        centroid_min.min(centroid);
+        centroid_max.max(centroid);
+    }
+
+    if (parent_surface_area <= T{0}) {
+        return split;
+    }
+
+    for (unsigned int current_axis = 0; current_axis < 3; ++current_axis) {
+        const T extent = centroid_max[current_axis] - centroid_min[current_axis];
+        if (extent <= T{0}) {
+            continue;
+        }
+        const T scale = static_cast<T>(n_bins) / extent;
+
+        std::array<BVHNode_t<T>, n_bins> bins{};
+        std::array<uint32_t, n_bins> bin_counts{};
+        for (const Reference& reference: references) {
+            const T centroid = (reference.box.min_[current_axis] + reference.box.max_[current_axis]) / T{2};
+            const auto bin   = std::min(static_cast<size_t>((centroid - centroid_min[current_axis]) * scale), n_bins - 1);
+            ++bin_counts[bin];
+            bins[bin].min_.min(reference.box.min_);
+            bins[bin].max_.max(reference.box.max_);
+        }
+
+        // Sweeps from the right to get the cost of the right side of every split
+        std::array<T, n_bins - 1> right_costs{};
+        std::array<BVHNode_t<T>, n_bins - 1> right_boxes{};
+        BVHNode_t<T> right_box;
+        uint32_t right_count = 0;
+        for (size_t bin = n_bins - 1; bin > 0; --bin) {
+            right_box.min_.min(bins[bin].min_);
+            right_box.max_.max(bins[bin].max_);
+            right_count += bin_counts[bin];
+            right_costs[bin - 1] = right_box.surface_area() * static_cast<T>(right_count);
+            right_boxes[bin - 1] = right_box;
+        }
+
+        BVHNode_t<T> left_box;
+        uint32_t left_count = 0;
+        for (size_t bin = 0; bin < n_bins - 1; ++bin) {
+            left_box.min_.min(bins[bin].min_);
+            left_box.max_.max(bins[bin].max_);
+            left_count += bin_counts[bin];
+
+            if ((left_count == 0) || (left_count == references.size())) {
+                continue;
+            }
+
+            const T cost = traversal_cost + (left_box.surface_area() * static_cast<T>(left_count) + right_costs[bin]) / parent_surface_area;
+            if (cost < split.cost) {
+                split = {cost, current_axis, centroid_min[current_axis] + static_cast<T>(bin + 1) / scale, left_box, right_boxes[bin]};
+            }
+        }
+    }
+
+    return split;
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::SBVHBuilder_t<T>::find_spatial_split(std::span<const std::array<Entities::Vec3<T>, 3>> triangles,
+                                                                            const std::vector<Reference>& references,
+                                                                            const BVHNode_t<T>& node,
+                                                                            size_t& n_duplicates) const -> Split {
+    constexpr size_t n_bins    = 16;
+    constexpr T traversal_cost = 1; // Relative to the cost of intersecting a shape
+    Split split{std::numeric_limits<T>::infinity(), 0, T{0}, BVHNode_t<T>(), BVHNode_t<T>()};
+    const T parent_surface_area = node.surface_area();
+
+    if (parent_surface_area <= T{0}) {
+        return split;
+    }
+
+    for (unsigned int current_axis = 0; current_axis < 3; ++current_axis) {
+        const T low    = node.min_[current_axis];
+        const T extent = node.max_[current_axis] - low;
+        if (extent <= T{0}) {
+            continue;
+        }
+        const T bin_size = extent / static_cast<T>(n_bins);
+
+        // Each reference is clipped to every bin it crosses, and counted as entering its first bin and exiting its last
+        std::array<BVHNode_t<T>, n_bins> bins{};
+        std::array<uint32_t, n_bins> entries{};
+        std::array<uint32_t, n_bins> exits{};
+        for (const Reference& reference: references) {
+            const auto first_bin = std::min(static_cast<size_t>(std::max((reference.box.min_[current_axis] - low) / bin_size, T{0})), n_bins - 1);
+            const auto last_bin  = std::min(static_cast<size_t>(std::max((reference.box.max_[current_axis] - low) / bin_size, T{0})), n_bins - 1);
+
+            for (size_t bin = first_bin; bin <= last_bin; ++bin) {
+                const T bin_low         = low + static_cast<T>(bin) * bin_size;
+                const T bin_high        = (bin == n_bins - 1) ? node.max_[current_axis] : low + static_cast<T>(bin + 1) * bin_size;
+                const BVHNode_t<T> part = (first_bin == last_bin) ? reference.box : clip(triangles[reference.index], reference.box, current_axis, bin_low, bin_high);
+                bins[bin].min_.min(part.min_);
+                bins[bin].max_.max(part.max_);
+            }
+            ++entries[first_bin];
+            ++exits[last_bin];
+        }
+
+        // Sweeps from the right to get the cost of the right side of every split
+        std::array<T, n_bins - 1> right_costs{};
+        std::array<BVHNode_t<T>, n_bins - 1> right_boxes{};
+        std::array<uint32_t, n_bins - 1> right_counts{};
+        BVHNode_t<T> right_box;
+        uint32_t right_count = 0;
+        for (size_t bin = n_bins - 1; bin > 0; --bin) {
+            right_box.min_.min(bins[bin].min_);
+            right_box.max_.max(bins[bin].max_);
+            right_count += exits[bin];
+            right_costs[bin - 1]  = right_box.surface_area() * static_cast<T>(right_count);
+            right_boxes[bin - 1]  = right_box;
+            right_counts[bin - 1] = right_count;
+        }
+
+        BVHNode_t<T> left_box;
+        uint32_t left_count = 0;
+        for (size_t bin = 0; bin < n_bins - 1; ++bin) {
+            left_box.min_.min(bins[bin].min_);
+            left_box.max_.max(bins[bin].max_);
+            left_count += entries[bin];
+
+            if ((left_count == 0) || (right_counts[bin] == 0)) {
+                continue;
+            }
+
+            const T cost = traversal_cost + (left_box.surface_area() * static_cast<T>(left_count) + right_costs[bin]) / parent_surface_area;
+            if (cost < split.cost) {
+                split        = {cost, current_axis, low + static_cast<T>(bin + 1) * bin_size, left_box, right_boxes[bin]};
+                n_duplicates = left_count + right_counts[bin] - references.size();
+            }
+        }
+    }
+
+    return split;
+}
+
+template<typename T>
+auto AGPTracer::AccelerationStructures::SBVHBuilder_t<T>::clip(const std::array<Entities::Vec3<T>, 3>& triangle, const BVHNode_t<T>& box, unsigned int axis, T low, T high) -> BVHNode_t<T> {
+    BVHNode_t<T> clipped;
+
+    // The clipped polygon is made of the points inside the slab, and of the intersections of the edges with its planes
+    for (size_t i = 0; i < 3; ++i) {
+        const Entities::Vec3<T>& point_a = triangle[i];
+        const Entities::Vec3<T>& point_b = triangle[(i + 1) % 3];
+
+        if ((point_a[axis] >= low) && (point_a[axis] <= high)) {
+            clipped.min_.min(point_a);
+            clipped.max_.max(point_a);
+        }
+
+        for (const T plane: std::array<T, 2>{low, high}) {
+            if ((point_a[axis] < plane) != (point_b[axis] < plane)) {
+                Entities::Vec3<T> point = point_a + (point_b - point_a) * ((plane - point_a[axis]) / (point_b[axis] - point_a[axis]));
+                point[axis]             = plane;
+                clipped.min_.min(point);
+                clipped.max_.max(point);
+            }
+        }
+    }
+
+    clipped.min_ = clipped.min_.getMax(box.min_);
+    clipped.max_ = clipped.max_.getMin(box.max_);
+    if ((clipped.min_[0] > clipped.max_[0]) || (clipped.min_[1] > clipped.max_[1]) || (clipped.min_[2] > clipped.max_[2])) {
+        return BVHNode_t<T>();
+    }
+    return clipped;
+}
@@ -0,0 +1,72 @@
+#ifndef AGPTRACER_ACCELERATIONSTRUCTURES_WIDEBVHNODE_T_HPP
+#define AGPTRACER_ACCELERATIONSTRUCTURES_WIDEBVHNODE_T_HPP
+
+#include "entities/Vec3.hpp"
+#include <array>
+#include <cstdint>
+
+namespace AGPTracer::AccelerationStructures {
+    /**
+     * @brief The wide BVH node class represents a node of a flattened bounding volume hierarchy with up to W children.
+     *
+     * Contrary to the binary node, a wide node stores the bounding boxes of its children instead of its own. The boxes are
+     * stored as a structure of arrays, one array of W values per coordinate, so that a ray can be intersected with all the
+     * children at once, with the same operations applied to every lane. Each child is either another wide node, at index
+     * first_ in the node array, or a leaf, a range of count_ shape indices starting at first_. The children are packed at
+     * the front of the arrays, the last W - n_children_ slots are unused.
+     *
+     * @tparam T Floating point datatype to use
+     * @tparam W Maximum number of children of a node
+     */
+    template<typename T = double, size_t W = 4>
+    class WideBVHNode_t {
+        public:
+            /**
+             * @brief Construct a new WideBVHNode_t object without children, which no ray can intersect.
+             */
+            constexpr WideBVHNode_t();
+
+            std::array<std::array<T, W>, 3> min_; /**< @brief Minimum coordinates of the bounding boxes of the children, by coordinate then by child.*/
+            std::array<std::array<T, W>, 3> max_; /**< @brief Maximum coordinates of the bounding boxes of the children, by coordinate then by child.*/
+            std::array<uint32_t, W> first_; /**< @brief Index of the node of each inner child, or index of the first shape index of each leaf.*/
+            std::array<uint32_t, W> count_; /**< @brief Number of shapes in each leaf. Inner children have a count of 0.*/
+            uint32_t n_children_; /**< @brief Number of children of the node, stored in the first slots.*/
+
+            /**
+             * @brief Adds a child to the node, in the first unused slot.
+             *
+             * @param minimum Minimum coordinates of the bounding box of the child.
+             * @param maximum Maximum coordinates of the bounding box of the child.
+             * @param first Index of the node of the child if it is an inner node, or of its first shape index if it is a leaf.
+             * @param count Number of shapes in the leaf, 0 for inner nodes.
+             */
+            constexpr auto add_child(const Entities::Vec3<T>& minimum, const Entities::Vec3<T>& maximum, uint32_t first, uint32_t count) -> void;
+
+            /**
+             * @brief Returns whether a child is a leaf, containing shapes, or an inner node, containing other nodes.
+             *
+             * @param child Slot of the child.
+             * @return true The child is a leaf, first_ and count_ describe a range of shape indices.
+             * @return false The child is an inner node, stored at first_.
+             */
+            constexpr auto is_leaf(uint32_t child) const -> bool;
+
+            /**
+             * @brief Intersects a ray with the bounding boxes of all the children, using the slab method.
+             *
+             * All W slots are tested with the same branchless operations, so that the loop over the children is vectorised.
+             * Unused slots are masked out of the result.
+             *
+             * @param origin Origin of the ray.
+             * @param inverse_direction Component-wise inverse of the direction of the ray.
+             * @param t_max Distance past which intersections are ignored, usually the closest intersection found so far.
+             * @param[out] t Distance at which the ray enters the bounding box of each child. Undefined for the children not intersected.
+             * @return uint32_t Bit mask of the children intersected before t_max, with the bit i set if the child i is intersected.
+             */
+            constexpr auto intersection(const Entities::Vec3<T>& origin, const Entities::Vec3<T>& inverse_direction, T t_max, std::array<T, W>& t) const -> uint32_t;
+    };
+}
+
+#include "acceleration_structures/WideBVHNode_t.tpp"
+
+#endif
@@ -0,0 +1,51 @@
+#include <algorithm>
+#include <limits>
+
+template<typename T, size_t W>
+constexpr AGPTracer::AccelerationStructures::WideBVHNode_t<T, W>::WideBVHNode_t() : min_{}, max_{}, first_{}, count_{}, n_children_(0) {
+    for (auto& coordinate: min_) {
+        coordinate.fill(std::numeric_limits<T>::max());
+    }
+    for (auto& coordinate: max_) {
+        coordinate.fill(std::numeric_limits<T>::lowest());
+    }
+}
+
+template<typename T, size_t W>
+constexpr auto AGPTracer::AccelerationStructures::WideBVHNode_t<T, W>::add_child(const Entities::Vec3<T>& minimum, const Entities::Vec3<T>& maximum, uint32_t first, uint32_t count) -> void {
+    for (size_t j = 0; j < 3; ++j) {
+        min_[j][n_children_] = minimum[j];
+        max_[j][n_children_] = maximum[j];
+    }
+    first_[n_children_] = first;
+    count_[n_children_] = count;
+    ++n_children_;
+}
+
+template<typename T, size_t W>
+constexpr auto AGPTracer::AccelerationStructures::WideBVHNode_t<T, W>::is_leaf(uint32_t child) const -> bool {
+    return count_[child] > 0;
+}
+
+template<typename T, size_t W>
+constexpr auto
+AGPTracer::AccelerationStructures::WideBVHNode_t<T, W>::intersection(const Entities::Vec3<T>& origin, const Entities::Vec3<T>& inverse_direction, T t_max, std::array<T, W>& t) const -> uint32_t {
+    uint32_t hits = 0;
+
+    for (uint32_t i = 0; i < W; ++i) {
+        const T tx1 = (min_[0][i] - origin[0]) * inverse_direction[0];
+        const T tx2 = (max_[0][i] - origin[0]) * inverse_direction[0];
+        const T ty1 = (min_[1][i] - origin[1]) * inverse_direction[1];
+        const T ty2 = (max_[1][i] - origin[1]) * inverse_direction[1];
+        const T tz1 = (min_[2][i] - origin[2]) * inverse_direction[2];
+        const T tz2 = (max_[2][i] - origin[2]) * inverse_direction[2];
+
+        const T t_enter = std::max(std::max(std::min(tx1, tx2), std::min(ty1, ty2)), std::max(std::min(tz1, tz2), T{0}));
+        const T t_exit  = std::min(std::min(std::max(tx1, tx2), std::max(ty1, ty2)), std::min(std::max(tz1, tz2), t_max));
+
+        t[i] = t_enter;
+        hits |= (static_cast<uint32_t>(t_enter <= t_exit) & static_cast<uint32_t>(i < n_children_)) << i;
+    }
+
+    return hits;
+}
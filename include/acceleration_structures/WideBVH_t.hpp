@@ -0,0 +1,186 @@
+#ifndef AGPTRACER_ACCELERATIONSTRUCTURES_WIDEBVH_T_HPP
+#define AGPTRACER_ACCELERATIONSTRUCTURES_WIDEBVH_T_HPP
+
+#include "acceleration_structures/BVH_t.hpp"
+#include "acceleration_structures/CompressedBVHNode_t.hpp"
+#include "acceleration_structures/WideBVHNode_t.hpp"
+#include "entities/Ray_t.hpp"
+#include "entities/Shape.hpp"
+#include <array>
+#include <cstdint>
+#include <sycl/sycl.hpp>
+
+namespace AGPTracer::AccelerationStructures {
+    /**
+     * @brief The wide BVH class is a bounding volume hierarchy where each node has up to W children, used to quickly find which shapes a ray intersects.
+     *
+     * The hierarchy is obtained by collapsing a binary hierarchy: the children of a node are repeatedly replaced by their own children,
+     * largest surface area first, until the node has W children or only leaves left. The wide hierarchy is shallower, so a ray visits
+     * fewer nodes, and the bounding boxes of all the children of a node are intersected together with a single vectorised slab test.
+     * This suits wide SIMD units such as those of the CPU backends. The binary hierarchy is kept to be refitted or rebuilt on the device
+     * on update. A refit carries over to the wide nodes on the device, while a rebuild is collapsed again on the host. The leaves of both
+     * hierarchies share the same shape index buffer.
+     *
+     * @tparam T Floating point datatype to use
+     * @tparam W Maximum number of children of a node, usually 4 or 8 to match the width of the SIMD units
+     * @tparam B Node type, storing the bounding boxes of the children either at full precision or quantised
+     */
+    template<typename T = double, size_t W = 4, template<typename, size_t> typename B = WideBVHNode_t>
+    class WideBVH_t {
+        public:
+            class Accessor_t {
+                public:
+                    /**
+                     * @brief Construct a new Accessor_t object with the given buffers.
+                     *
+                     * @param cgh Device handler.
+                     * @param nodes Node buffer to access.
+                     * @param indices Shape index buffer to access.
+                     */
+                    Accessor_t(sycl::handler& cgh, sycl::buffer<B<T, W>, 1>& nodes, sycl::buffer<uint32_t, 1>& indices);
+
+                    /**
+                     * @brief Traverses the hierarchy with a ray, calling a function for each shape whose leaf is hit by the ray.
+                     *
+                     * The children of a node are intersected together, and those hit are sorted by distance. Their leaves are
+                     * intersected front to back, then their inner nodes are pushed so that the closest is visited first. Nodes
+                     * further than t are skipped. The leaf function is called with the index of a shape and a reference to t,
+                     * and should lower t when it finds a closer intersection. It returns true to stop the traversal.
+                     *
+                     * @tparam N Number of mediums in the ray's medium list
+                     * @tparam F Leaf function type, callable as bool(size_t index, T& t)
+                     * @param[in] ray Ray to traverse the hierarchy with.
+                     * @param[in, out] t Distance past which nodes are skipped. Lowered by the leaf function.
+                     * @param[in] leaf Function called for each shape of the leaves hit by the ray.
+                     */
+                    template<size_t N, class F>
+                    auto traverse(const Entities::Ray_t<T, N>& ray, T& t, F leaf) const -> void;
+
+                private:
+                    sycl::accessor<B<T, W>, 1, sycl::access::mode::read> nodes_; /**< @brief Accessor to the nodes.*/
+                    sycl::accessor<uint32_t, 1, sycl::access::mode::read> indices_; /**< @brief Accessor to the shape indices.*/
+            };
+
+            /**
+             * @brief Construct a new empty WideBVH_t object, which no ray can intersect.
+             *
+             * @param rebuild_threshold Ratio of the current cost to the cost at build past which update rebuilds the binary hierarchy instead of refitting it.
+             */
+            explicit WideBVH_t(T rebuild_threshold = 1.5);
+
+            sycl::buffer<B<T, W>, 1> nodes_; /**< @brief Flattened nodes of the hierarchy. The root is the first node.*/
+            sycl::buffer<std::array<uint32_t, W>, 1> sources_; /**< @brief Binary node of each child of each node, or BVH_t::no_reference_ past the last child.*/
+            BVH_t<T> binary_; /**< @brief Binary hierarchy collapsed into this one. Its shape indices are referenced by the leaves.*/
+            size_t collapsed_builds_; /**< @brief Value of BVH_t::n_builds_ when the binary hierarchy was last collapsed.*/
+
+            /**
+             * @brief Builds the hierarchy around the given shapes, on the host.
+             *
+             * @tparam S Shape type
+             * @param shapes Shapes to sort in the hierarchy.
+             */
+            template<template<typename> typename S>
+            requires Entities::Coordinates<S, T> auto build(sycl::buffer<S<T>, 1>& shapes) -> void;
+
+            /**
+             * @brief Builds the binary hierarchy around the given triangles on the host with spatial splits, as with BVH_t::build_spatial, and collapses it.
+             *
+             * @tparam S Shape type
+             * @param shapes Shapes to sort in the hierarchy.
+             * @param reference_budget Maximum number of references to shapes in the leaves, relative to the number of shapes.
+             * @return T Ratio of the surface area heuristic cost of the binary hierarchy built without spatial splits to the cost of this one.
+             */
+            template<template<typename> typename S>
+            requires Entities::Coordinates<S, T>&& Entities::Triangular<S, T> auto build_spatial(sycl::buffer<S<T>, 1>& shapes, T reference_budget = 1.5) -> T;
+
+            /**
+             * @brief Builds the binary hierarchy around the given shapes on the device, and collapses it.
+             *
+             * @tparam S Shape type
+             * @param queue Queue on which to submit the build.
+             * @param shapes Shapes to sort in the hierarchy.
+             */
+            template<template<typename> typename S>
+            requires Entities::Coordinates<S, T> auto build(sycl::queue& queue, sycl::buffer<S<T>, 1>& shapes) -> void;
+
+            /**
+             * @brief Updates the hierarchy after the shapes have changed.
+             *
+             * The binary hierarchy is refitted or rebuilt on the device, as with BVH_t::update. When it was only refitted, the wide
+             * nodes are refitted from it on the device too. When it was rebuilt, it is collapsed again on the host.
+             *
+             * @tparam S Shape type
+             * @param queue Queue on which to submit the update.
+             * @param shapes Shapes contained in the hierarchy.
+             */
+            template<template<typename> typename S>
+            requires Entities::Coordinates<S, T> auto update(sycl::queue& queue, sycl::buffer<S<T>, 1>& shapes) -> void;
+
+            /**
+             * @brief Renumbers the shapes after they were moved in memory, as with BVH_t::permute.
+             *
+             * The leaves reference the shape indices of the binary hierarchy, so the wide nodes are left as they are.
+             *
+             * @param queue Queue on which to submit the kernels.
+             * @param order Previous index of the shape now at each index.
+             */
+            auto permute(sycl::queue& queue, sycl::buffer<uint32_t, 1>& order) -> void;
+
+            /**
+             * @brief Get a Accessor_t object attached to this acceleration structure
+             *
+             * @param cgh Device handler.
+             * @return Accessor_t Accessor that can be used on the device to traverse the acceleration structure
+             */
+            auto getAccessor(sycl::handler& cgh) -> Accessor_t;
+
+        private:
+            /**
+             * @brief Collapses the binary hierarchy into the wide node buffer, on the host.
+             */
+            auto collapse() -> void;
+
+            /**
+             * @brief Recomputes the bounding boxes of the children of all the nodes from the binary hierarchy, on the device.
+             *
+             * @param queue Queue on which to submit the kernel.
+             */
+            auto refit(sycl::queue& queue) -> void;
+    };
+
+    /**
+     * @brief Bounding volume hierarchy with four children per node, to be used as the acceleration structure of a scene.
+     *
+     * @tparam T Floating point datatype to use
+     */
+    template<typename T>
+    using BVH4_t = WideBVH_t<T, 4>;
+
+    /**
+     * @brief Bounding volume hierarchy with eight children per node, to be used as the acceleration structure of a scene.
+     *
+     * @tparam T Floating point datatype to use
+     */
+    template<typename T>
+    using BVH8_t = WideBVH_t<T, 8>;
+
+    /**
+     * @brief Bounding volume hierarchy with four children per node, whose bounding boxes are quantised to 8 bits.
+     *
+     * @tparam T Floating point datatype to use
+     */
+    template<typename T>
+    using CompressedBVH4_t = WideBVH_t<T, 4, CompressedBVHNode_t>;
+
+    /**
+     * @brief Bounding volume hierarchy with eight children per node, whose bounding boxes are quantised to 8 bits.
+     *
+     * @tparam T Floating point datatype to use
+     */
+    template<typename T>
+    using CompressedBVH8_t = WideBVH_t<T, 8, CompressedBVHNode_t>;
+}
+
+#include "acceleration_structures/WideBVH_t.tpp"
+
+#endif
@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <array>
+#include <utility>
+#include <vector>
+
+template<typename T, size_t W, template<typename, size_t> typename B>
+AGPTracer::AccelerationStructures::WideBVH_t<T, W, B>::WideBVH_t(T rebuild_threshold) :
+        nodes_(sycl::range<1>{1}), sources_(sycl::range<1>{1}), binary_(rebuild_threshold), collapsed_builds_(binary_.n_builds_) {
+    const sycl::host_accessor<B<T, W>, 1, sycl::access_mode::write> node_accessor(nodes_, sycl::no_init);
+    node_accessor[0] = B<T, W>();
+
+    const sycl::host_accessor<std::array<uint32_t, W>, 1, sycl::access_mode::write> source_accessor(sources_, sycl::no_init);
+    source_accessor[0].fill(BVH_t<T>::no_reference_);
+}
+
+template<typename T, size_t W, template<typename, size_t> typename B>
+template<template<typename> typename S>
+requires AGPTracer::Entities::Coordinates<S, T> auto AGPTracer::AccelerationStructures::WideBVH_t<T, W, B>::build(sycl::buffer<S<T>, 1>& shapes) -> void {
+    binary_.build(shapes);
+    collapse();
+}
+
+template<typename T, size_t W, template<typename, size_t> typename B>
+template<template<typename> typename S>
+requires AGPTracer::Entities::Coordinates<S, T>&& AGPTracer::Entities::Triangular<S, T> auto AGPTracer::AccelerationStructures::WideBVH_t<T, W, B>::build_spatial(sycl::buffer<S<T>, 1>& shapes,
+                                                                                                                                                                  T reference_budget) -> T {
+    const T improvement = binary_.build_spatial(shapes, reference_budget);
+    collapse();
+    return improvement;
+}
+
+template<typename T, size_t W, template<typename, size_t> typename B>
+template<template<typename> typename S>
+requires AGPTracer::Entities::Coordinates<S, T> auto AGPTracer::AccelerationStructures::WideBVH_t<T, W, B>::build(sycl::queue& queue, sycl::buffer<S<T>, 1>& shapes) -> void {
+    binary_.build(queue, shapes);
+    collapse();
+}
+
+template<typename T, size_t W, template<typename, size_t> typename B>
+template<template<typename> typename S>
+requires AGPTracer::Entities::Coordinates<S, T> auto AGPTracer::AccelerationStructures::WideBVH_t<T, W, B>::update(sycl::queue& queue, sycl::buffer<S<T>, 1>& shapes) -> void {
+    binary_.update(queue, shapes);
+
+    // A refitted binary hierarchy keeps its layout, so the boxes of the wide nodes are refitted from it on the device
+    if (binary_.n_builds_ == collapsed_builds_) {
+        refit(queue);
+    }
+    else {
+        collapse();
+    }
+}
+
+template<typename T, size_t W, template<typename, size_t> typename B>
+auto AGPTracer::AccelerationStructures::WideBVH_t<T, W, B>::permute(sycl::queue& queue, sycl::buffer<uint32_t, 1>& order) -> void {
+    binary_.permute(queue, order);
+}
+
+template<typename T, size_t W, template<typename, size_t> typename B>
+auto AGPTracer::AccelerationStructures::WideBVH_t<T, W, B>::getAccessor(sycl::handler& cgh) -> Accessor_t {
+    return Accessor_t(cgh, nodes_, binary_.indices_);
+}
+
+template<typename T, size_t W, template<typename, size_t> typename B>
+auto AGPTracer::AccelerationStructures::WideBVH_t<T, W, B>::collapse() -> void {
+    std::array<uint32_t, W> no_sources{};
+    no_sources.fill(BVH_t<T>::no_reference_);
+    std::vector<WideBVHNode_t<T, W>> nodes(1);
+    std::vector<std::array<uint32_t, W>> sources(1, no_sources);
+
+    if (binary_.n_shapes_ > 0) {
+        const sycl::host_accessor<BVHNode_t<T>, 1, sycl::access_mode::read> binary_accessor(binary_.nodes_);
+
+        if (binary_accessor[0].is_leaf()) {
+            nodes[0].add_child(binary_accessor[0].min_, binary_accessor[0].max_, binary_accessor[0].first_, binary_accessor[0].count_);
+            sources[0][0] = 0;
+        }
+        else {
+            // Pairs of wide node to fill and binary node it replaces
+            std::vector<std::pair<uint32_t, uint32_t>> stack{{0, 0}};
+
+            while (!stack.empty()) {
+                const auto [node_index, binary_index] = stack.back();
+                stack.pop_back();
+
+                std::array<uint32_t, W> children{};
+                children[0]       = binary_accessor[binary_index].first_;
+                children[1]       = binary_accessor[binary_index].first_ + 1;
+                size_t n_children = 2;
+
+                // Opens the inner child with the largest surface area, as it is the most likely to be hit
+                while (n_children < W) {
+                    size_t largest = W;
+                    T largest_area = T{-1};
+                    for (size_t i = 0; i < n_children; ++i) {
+                        const BVHNode_t<T>& child = binary_accessor[children[i]];
+                        if (!child.is_leaf() && (child.surface_area() > largest_area)) {
+                            largest      = i;
+                            largest_area = child.surface_area();
+                        }
+                    }
+                    if (largest == W) {
+                        break;
+                    }
+
+                    const uint32_t first   = binary_accessor[children[largest]].first_;
+                    children[largest]      = first;
+                    children[n_children++] = first + 1;
+                }
+
+                for (size_t i = 0; i < n_children; ++i) {
+                    const BVHNode_t<T>& child = binary_accessor[children[i]];
+                    sources[node_index][i]    = children[i];
+                    if (child.is_leaf()) {
+                        nodes[node_index].add_child(child.min_, child.max_, child.first_, child.count_);
+                    }
+                    else {
+                        const auto child_index = static_cast<uint32_t>(nodes.size());
+                        nodes.emplace_back();
+                        sources.push_back(no_sources);
+                        nodes[node_index].add_child(child.min_, child.max_, child_index, 0);
+                        stack.emplace_back(child_index, children[i]);
+                    }
+                }
+            }
+        }
+    }
+
+    if (nodes_.get_range()[0] != nodes.size()) {
+        nodes_   = sycl::buffer<B<T, W>, 1>(sycl::range<1>{nodes.size()});
+        sources_ = sycl::buffer<std::array<uint32_t, W>, 1>(sycl::range<1>{nodes.size()});
+    }
+    collapsed_builds_ = binary_.n_builds_;
+
+    const sycl::host_accessor<B<T, W>, 1, sycl::access_mode::write> node_accessor(nodes_, sycl::no_init);
+    std::transform(nodes.begin(), nodes.end(), node_accessor.begin(), [](const WideBVHNode_t<T, W>& node) { return B<T, W>(node); });
+
+    const sycl::host_accessor<std::array<uint32_t, W>, 1, sycl::access_mode::write> source_accessor(sources_, sycl::no_init);
+    std::copy(sources.begin(), sources.end(), source_accessor.begin());
+}
+
+template<typename T, size_t W, template<typename, size_t> typename B>
+auto AGPTracer::AccelerationStructures::WideBVH_t<T, W, B>::refit(sycl::queue& queue) -> void {
+    queue.submit([&](sycl::handler& cgh) {
+        auto node_accessor   = nodes_.template get_access<sycl::access::mode::read_write>(cgh);
+        auto source_accessor = sources_.template get_access<sycl::access::mode::read>(cgh);
+        auto binary_accessor = binary_.nodes_.template get_access<sycl::access::mode::read>(cgh);
+
+        cgh.parallel_for<class FitWideBVH>(sycl::range<1>{nodes_.get_range()[0]}, [=](sycl::id<1> WIid) {
+            // The children keep their shapes or wide node, only their boxes change
+            const B<T, W> previous = node_accessor[WIid];
+            WideBVHNode_t<T, W> node;
+            for (uint32_t i = 0; i < W; ++i) {
+                const uint32_t source = source_accessor[WIid][i];
+                if (source == BVH_t<T>::no_reference_) {
+                    break;
+                }
+                const BVHNode_t<T>& child = binary_accessor[source];
+                node.add_child(child.min_, child.max_, previous.first_[i], static_cast<uint32_t>(previous.count_[i]));
+            }
+            node_accessor[WIid] = B<T, W>(node);
+        });
+    });
+}
+
+template<typename T, size_t W, template<typename, size_t> typename B>
+AGPTracer::AccelerationStructures::WideBVH_t<T, W, B>::Accessor_t::Accessor_t(sycl::handler& cgh, sycl::buffer<B<T, W>, 1>& nodes, sycl::buffer<uint32_t, 1>& indices) :
+        nodes_(nodes.template get_access<sycl::access::mode::read>(cgh)), indices_(indices.template get_access<sycl::access::mode::read>(cgh)) {}
+
+template<typename T, size_t W, template<typename, size_t> typename B>
+template<size_t N, class F>
+auto AGPTracer::AccelerationStructures::WideBVH_t<T, W, B>::Accessor_t::traverse(const Entities::Ray_t<T, N>& ray, T& t, F leaf) const -> void {
+    // Each visited node pushes at most W - 1 nodes more than it pops, and the wide hierarchy is no deeper than the binary one
+    constexpr size_t max_stack_size = BVHNode_t<T>::max_depth_ * (W - 1);
+    const Entities::Vec3<T> inverse_direction(T{1} / ray.direction_[0], T{1} / ray.direction_[1], T{1} / ray.direction_[2]);
+
+    std::array<uint32_t, max_stack_size> stack; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+    size_t stack_size   = 0;
+    uint32_t node_index = 0;
+
+    while (true) {
+        const B<T, W>& node = nodes_[node_index];
+        std::array<T, W> t_children;  // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+        std::array<uint32_t, W> order; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+        const uint32_t hits = node.intersection(ray.origin_, inverse_direction, t, t_children);
+
+        // Insertion sort of the children hit, by distance, as there are only a few of them
+        uint32_t n_hits = 0;
+        for (uint32_t i = 0; i < W; ++i) {
+            if ((hits >> i) & 1U) {
+                uint32_t j = n_hits++;
+                while ((j > 0) && (t_children[order[j - 1]] > t_children[i])) {
+                    order[j] = order[j - 1];
+                    --j;
+                }
+                order[j] = i;
+            }
+        }
+
+        for (uint32_t i = 0; i < n_hits; ++i) {
+            const uint32_t child = order[i];
+            if (node.is_leaf(child)) {
+                for (uint32_t k = node.first_[child]; k < node.first_[child] + node.count_[child]; ++k) {
+                    if (leaf(static_cast<size_t>(indices_[k]), t)) {
+                        return;
+                    }
+                }
+            }
+        }
+
+        // Pushed back to front so that the closest inner child is visited next, skipping those now behind a leaf hit
+        for (uint32_t i = n_hits; i-- > 0;) {
+            const uint32_t child = order[i];
+            if (!node.is_leaf(child) && (t_children[child] <= t) && (stack_size < max_stack_size)) {
+                stack[stack_size++] = node.first_[child];
+            }
+        }
+
+        if (stack_size == 0) {
+            return;
+        }
+        node_index = stack[--stack_size];
+    }
+}
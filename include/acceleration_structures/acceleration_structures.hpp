@@ -0,0 +1,28 @@
+#ifndef AGPTRACER_ACCELERATIONSTRUCTURES_ACCELERATIONSTRUCTURES_HPP
+#define AGPTRACER_ACCELERATIONSTRUCTURES_ACCELERATIONSTRUCTURES_HPP
+
+/**
+ * @brief Contains the different acceleration structures that can be used.
+ *
+ * Acceleration structures sort shapes spatially so that rays only have to be intersected
+ * with the few shapes close to their path, instead of every shape of the scene. They are
+ * built on the host or on the device, stored in device buffers, and traversed on the device.
+ */
+namespace AGPTracer::AccelerationStructures {
+}
+
+#include "BVHBuilder_t.hpp"
+#include "BVHCache_t.hpp"
+#include "BVHNode_t.hpp"
+#include "BVH_t.hpp"
+#include "CompressedBVHNode_t.hpp"
+#include "InstanceBVH_t.hpp"
+#include "LBVHBuilder_t.hpp"
+#include "MotionBVHNode_t.hpp"
+#include "MotionBVH_t.hpp"
+#include "MultiGrid_t.hpp"
+#include "SBVHBuilder_t.hpp"
+#include "WideBVHNode_t.hpp"
+#include "WideBVH_t.hpp"
+
+#endif
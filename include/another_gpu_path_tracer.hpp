@@ -10,6 +10,7 @@
 namespace AGPTracer {
 }
 
+#include "acceleration_structures/acceleration_structures.hpp"
 #include "cameras/cameras.hpp"
 #include "entities/entities.hpp"
 #include "images/images.hpp"
@@ -79,6 +79,7 @@ namespace AGPTracer::Cameras {
             Entities::Vec3<T> up_; /**< @brief Vector pointing up. Used to set the roll of the camera. Changed by setUp.*/
             Entities::Vec3<T> up_buffer_; /**< @brief Stores the up vector until the camera is updated.*/
             I<T> image_; /**< @brief Image buffer into which the image is stored.*/
+            unsigned int cached_levels_ = 0; /**< @brief Number of levels of the acceleration structure copied to the local memory of each work-group by raytrace. 0 disables the cache.*/
 
             /**
              * @brief Updates the camera's members.
@@ -92,17 +93,88 @@ namespace AGPTracer::Cameras {
              * @brief Sends rays through the scene, to generate an image.
              *
              * The camera will generate rays according to a spherical projection, and cast them through the provided scene.
-             * The resulting colour is written to the image buffer. This will generate one image.
+             * The resulting colour is written to the image buffer. This will generate one image. Each ray is
+             * emitted at a random time of the exposure, so that moving shapes are blurred along their path. Rays start
+             * as camera rays, so shapes hidden from the camera are only seen through bounces.
+             *
+             * This uses raytrace_packets if AGPTRACER_PACKET_TRAVERSAL is defined. Otherwise, this uses raytrace_cached if
+             * cached_levels_ is not 0, and raytrace_rays if it is.
              *
              * @tparam R Random generator type to use
              * @tparam U Random distribution type to use
              * @tparam S Shape type to use
+             * @tparam M Material type to use
+             * @tparam D Medium type to use
+             * @tparam A Acceleration structure type to use
              * @param queue Device queue to use to run computations
              * @param random_generator Random generator used to get random numbers
              * @param scene Scene that will be used to find what each ray hits.
              */
-            template<class R, template<typename> typename U, template<typename> typename S>
-            requires Entities::Shape<S, T> auto raytrace(sycl::queue& queue, Entities::RandomGenerator_t<T, R, U>& random_generator, Entities::Scene_t<T, S>& scene) -> void;
+            template<class R, template<typename> typename U, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+            requires Entities::Shape<S, T> auto raytrace(sycl::queue& queue, Entities::RandomGenerator_t<T, R, U>& random_generator, Entities::Scene_t<T, S, M, D, A>& scene) -> void;
+
+            /**
+             * @brief Sends rays through the scene one pixel per work item, to generate an image.
+             *
+             * Each work item traces the rays of its pixel from the camera to their last bounce, independently of the others.
+             *
+             * @tparam R Random generator type to use
+             * @tparam U Random distribution type to use
+             * @tparam S Shape type to use
+             * @tparam M Material type to use
+             * @tparam D Medium type to use
+             * @tparam A Acceleration structure type to use
+             * @param queue Device queue to use to run computations
+             * @param random_generator Random generator used to get random numbers
+             * @param scene Scene that will be used to find what each ray hits.
+             */
+            template<class R, template<typename> typename U, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+            requires Entities::Shape<S, T> auto raytrace_rays(sycl::queue& queue, Entities::RandomGenerator_t<T, R, U>& random_generator, Entities::Scene_t<T, S, M, D, A>& scene) -> void;
+
+            /**
+             * @brief Sends rays through the scene one pixel per work item, with the top levels of the acceleration structure cached per work-group, to generate an image.
+             *
+             * The kernel is launched over an nd_range of 8x8 pixel work-groups. Each work-group first copies the top cached_levels
+             * levels of the acceleration structure to its local memory, which all its rays start by traversing, then traces its
+             * rays as raytrace_rays does. This gives the same image as raytrace_rays for the same random generator. The cache
+             * uses 2^cached_levels - 1 nodes of local memory per work-group. If they don't fit in the local memory of the device,
+             * a warning is printed and only the levels that fit are cached.
+             *
+             * @tparam R Random generator type to use
+             * @tparam U Random distribution type to use
+             * @tparam S Shape type to use
+             * @tparam M Material type to use
+             * @tparam D Medium type to use
+             * @tparam A Acceleration structure type to use
+             * @param queue Device queue to use to run computations
+             * @param random_generator Random generator used to get random numbers
+             * @param scene Scene that will be used to find what each ray hits.
+             * @param cached_levels Number of levels of the acceleration structure to copy to local memory.
+             */
+            template<class R, template<typename> typename U, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+            requires Entities::Shape<S, T> auto
+                raytrace_cached(sycl::queue& queue, Entities::RandomGenerator_t<T, R, U>& random_generator, Entities::Scene_t<T, S, M, D, A>& scene, unsigned int cached_levels) -> void;
+
+            /**
+             * @brief Sends rays through the scene one tile of 8x8 pixels per work item, to generate an image.
+             *
+             * The camera rays of a tile are close to each other, so they are intersected as a packet sharing a single
+             * traversal, with nodes culled for the whole tile at once. The bounces that follow go in all directions, and
+             * are traced one ray at a time. This gives the same image as raytrace_rays for the same random generator, but
+             * each work item holds the rays of a whole tile, so it is meant for the CPU rather than for GPUs.
+             *
+             * @tparam R Random generator type to use
+             * @tparam U Random distribution type to use
+             * @tparam S Shape type to use
+             * @tparam M Material type to use
+             * @tparam D Medium type to use
+             * @tparam A Acceleration structure type to use
+             * @param queue Device queue to use to run computations
+             * @param random_generator Random generator used to get random numbers
+             * @param scene Scene that will be used to find what each ray hits.
+             */
+            template<class R, template<typename> typename U, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+            requires Entities::Shape<S, T> auto raytrace_packets(sycl::queue& queue, Entities::RandomGenerator_t<T, R, U>& random_generator, Entities::Scene_t<T, S, M, D, A>& scene) -> void;
 
             /**
              * @brief Raytraces the scene multiple times to get more samples per pixel.
@@ -112,13 +184,17 @@ namespace AGPTracer::Cameras {
              * @tparam R Random generator type to use
              * @tparam U Random distribution type to use
              * @tparam S Shape type to use
+             * @tparam M Material type to use
+             * @tparam D Medium type to use
+             * @tparam A Acceleration structure type to use
              * @param queue Device queue to use to run computations
              * @param random_generator Random generator used to get random numbers
              * @param scene Scene that will be used to find what each ray hits.
              * @param n_iter Number of times the scene will be raytraced.
              */
-            template<class R, template<typename> typename U, template<typename> typename S>
-            requires Entities::Shape<S, T> auto accumulate(sycl::queue& queue, Entities::RandomGenerator_t<T, R, U>& random_generator, Entities::Scene_t<T, S>& scene, unsigned int n_iter) -> void;
+            template<class R, template<typename> typename U, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+            requires Entities::Shape<S, T> auto
+            accumulate(sycl::queue& queue, Entities::RandomGenerator_t<T, R, U>& random_generator, Entities::Scene_t<T, S, M, D, A>& scene, unsigned int n_iter) -> void;
 
             /**
              * @brief Raytraces the scene indefinitely to get more samples per pixel.
@@ -128,12 +204,15 @@ namespace AGPTracer::Cameras {
              * @tparam R Random generator type to use
              * @tparam U Random distribution type to use
              * @tparam S Shape type to use
+             * @tparam M Material type to use
+             * @tparam D Medium type to use
+             * @tparam A Acceleration structure type to use
              * @param queue Device queue to use to run computations
              * @param random_generator Random generator used to get random numbers
              * @param scene Scene that will be used to find what each ray hits.
              */
-            template<class R, template<typename> typename U, template<typename> typename S>
-            requires Entities::Shape<S, T> auto accumulate(sycl::queue& queue, Entities::RandomGenerator_t<T, R, U>& random_generator, Entities::Scene_t<T, S>& scene) -> void;
+            template<class R, template<typename> typename U, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+            requires Entities::Shape<S, T> auto accumulate(sycl::queue& queue, Entities::RandomGenerator_t<T, R, U>& random_generator, Entities::Scene_t<T, S, M, D, A>& scene) -> void;
 
             /**
              * @brief Raytraces the scene multiple times to get more samples per pixel, saving the image every so often.
@@ -143,15 +222,18 @@ namespace AGPTracer::Cameras {
              * @tparam R Random generator type to use
              * @tparam U Random distribution type to use
              * @tparam S Shape type to use
+             * @tparam M Material type to use
+             * @tparam D Medium type to use
+             * @tparam A Acceleration structure type to use
              * @param queue Device queue to use to run computations
              * @param random_generator Random generator used to get random numbers
              * @param scene Scene that will be used to find what each ray hits.
              * @param n_iter Number of times the scene will be raytraced.
              * @param interval Saves the image every x frames by calling write().
              */
-            template<class R, template<typename> typename U, template<typename> typename S>
+            template<class R, template<typename> typename U, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
             requires Entities::Shape<S, T> auto
-            accumulateWrite(sycl::queue& queue, Entities::RandomGenerator_t<T, R, U>& random_generator, Entities::Scene_t<T, S>& scene, unsigned int n_iter, unsigned int interval) -> void;
+            accumulateWrite(sycl::queue& queue, Entities::RandomGenerator_t<T, R, U>& random_generator, Entities::Scene_t<T, S, M, D, A>& scene, unsigned int n_iter, unsigned int interval) -> void;
 
             /**
              * @brief Raytraces the scene indefinitely to get more samples per pixel, saving the image every so often.
@@ -161,14 +243,17 @@ namespace AGPTracer::Cameras {
              * @tparam R Random generator type to use
              * @tparam U Random distribution type to use
              * @tparam S Shape type to use
+             * @tparam M Material type to use
+             * @tparam D Medium type to use
+             * @tparam A Acceleration structure type to use
              * @param queue Device queue to use to run computations
              * @param random_generator Random generator used to get random numbers
              * @param scene Scene that will be used to find what each ray hits.
              * @param interval Saves the image every x frames by calling write().
              */
-            template<class R, template<typename> typename U, template<typename> typename S>
-            requires Entities::Shape<S, T> auto accumulateWrite(sycl::queue& queue, Entities::RandomGenerator_t<T, R, U>& random_generator, Entities::Scene_t<T, S>& scene, unsigned int interval)
-                -> void;
+            template<class R, template<typename> typename U, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+            requires Entities::Shape<S, T> auto
+            accumulateWrite(sycl::queue& queue, Entities::RandomGenerator_t<T, R, U>& random_generator, Entities::Scene_t<T, S, M, D, A>& scene, unsigned int interval) -> void;
 
             /**
              * @brief Raytraces the scene indefinitely to get more samples per pixel, saving the image frame.
@@ -178,12 +263,15 @@ namespace AGPTracer::Cameras {
              * @tparam R Random generator type to use
              * @tparam U Random distribution type to use
              * @tparam S Shape type to use
+             * @tparam M Material type to use
+             * @tparam D Medium type to use
+             * @tparam A Acceleration structure type to use
              * @param queue Device queue to use to run computations
              * @param random_generator Random generator used to get random numbers
              * @param scene Scene that will be used to find what each ray hits.
              */
-            template<class R, template<typename> typename U, template<typename> typename S>
-            requires Entities::Shape<S, T> auto accumulateWrite(sycl::queue& queue, Entities::RandomGenerator_t<T, R, U>& random_generator, Entities::Scene_t<T, S>& scene) -> void;
+            template<class R, template<typename> typename U, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+            requires Entities::Shape<S, T> auto accumulateWrite(sycl::queue& queue, Entities::RandomGenerator_t<T, R, U>& random_generator, Entities::Scene_t<T, S, M, D, A>& scene) -> void;
 
             /**
              * @brief Sets the focus distance of the camera to a specific distance.
@@ -203,12 +291,15 @@ namespace AGPTracer::Cameras {
              * such. The focal plane's shape will vary based on the projection used.
              *
              * @tparam S Shape type to use
+             * @tparam M Material type to use
+             * @tparam D Medium type to use
+             * @tparam A Acceleration structure type to use
              * @param queue Device queue to use to run computations
              * @param scene Scene that will be used to find what object the ray hits and its distance.
              * @param position Where in the frame will the ray be sent. [horizontal, vertical], both from 0 to 1, starting from bottom left.
              */
-            template<template<typename> typename S>
-            requires Entities::Shape<S, T> auto autoFocus(sycl::queue& queue, Entities::Scene_t<T, S>& scene, std::array<T, 2> position) -> void{};
+            template<template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+            requires Entities::Shape<S, T> auto autoFocus(sycl::queue& queue, Entities::Scene_t<T, S, M, D, A>& scene, std::array<T, 2> position) -> void{};
 
             /**
              * @brief Set the up vector of the camera.
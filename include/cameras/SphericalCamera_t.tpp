@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <numbers>
@@ -38,9 +39,29 @@ requires AGPTracer::Entities::Skybox<K, T>&& AGPTracer::Entities::Image<I, T> au
 }
 
 template<typename T, template<typename> typename K, template<typename> typename I, size_t N>
-requires AGPTracer::Entities::Skybox<K, T>&& AGPTracer::Entities::Image<I, T> template<class R, template<typename> typename U, template<typename> typename S>
-requires AGPTracer::Entities::Shape<S, T> auto
-AGPTracer::Cameras::SphericalCamera_t<T, K, I, N>::raytrace(sycl::queue& queue, Entities::RandomGenerator_t<T, R, U>& random_generator, Entities::Scene_t<T, S>& scene) -> void {
+requires AGPTracer::Entities::Skybox<K, T>&&
+    AGPTracer::Entities::Image<I, T> template<class R, template<typename> typename U, template<typename> typename S, template<typename> typename M, template<typename> typename D,
+                                              template<typename> typename A>
+    requires AGPTracer::Entities::Shape<S, T> auto
+    AGPTracer::Cameras::SphericalCamera_t<T, K, I, N>::raytrace(sycl::queue& queue, Entities::RandomGenerator_t<T, R, U>& random_generator, Entities::Scene_t<T, S, M, D, A>& scene) -> void {
+#ifdef AGPTRACER_PACKET_TRAVERSAL
+    raytrace_packets(queue, random_generator, scene);
+#else
+    if (cached_levels_ > 0) {
+        raytrace_cached(queue, random_generator, scene, cached_levels_);
+    }
+    else {
+        raytrace_rays(queue, random_generator, scene);
+    }
+#endif
+}
+
+template<typename T, template<typename> typename K, template<typename> typename I, size_t N>
+requires AGPTracer::Entities::Skybox<K, T>&&
+    AGPTracer::Entities::Image<I, T> template<class R, template<typename> typename U, template<typename> typename S, template<typename> typename M, template<typename> typename D,
+                                              template<typename> typename A>
+    requires AGPTracer::Entities::Shape<S, T> auto
+    AGPTracer::Cameras::SphericalCamera_t<T, K, I, N>::raytrace_rays(sycl::queue& queue, Entities::RandomGenerator_t<T, R, U>& random_generator, Entities::Scene_t<T, S, M, D, A>& scene) -> void {
     const T tot_subpix                 = subpix_[0] * subpix_[1];
     const T pixel_span_y               = fov_[0] / static_cast<T>(image_.size_y_);
     const T pixel_span_x               = fov_[1] / static_cast<T>(image_.size_x_);
@@ -83,6 +104,7 @@ AGPTracer::Cameras::SphericalCamera_t<T, K, I, N>::raytrace(sycl::queue& queue,
                 const unsigned int k  = subindex / subpix[1]; // y
                 const double jitter_y = unif(rng);
                 const double jitter_x = unif(rng);
+                const T time          = unif(rng);
 
                 const Entities::Vec3<T> subpix_vec = (pix_vec
                                                       + Entities::Vec3<T>(T{0},
@@ -90,7 +112,8 @@ AGPTracer::Cameras::SphericalCamera_t<T, K, I, N>::raytrace(sycl::queue& queue,
                                                                           (static_cast<double>(l) - static_cast<double>(subpix[1]) / T{2} + jitter_x) * subpix_span_x))
                                                          .to_xyz_offset(direction, horizontal, vertical);
 
-                Entities::Ray_t ray(origin, subpix_vec, Entities::Vec3<T>(), Entities::Vec3<T>(T{1}), medium_list);
+                Entities::Ray_t ray(origin, subpix_vec, Entities::Vec3<T>(), Entities::Vec3<T>(T{1}), medium_list, time);
+                ray.visibility_ = Entities::Visibility::camera;
                 scene_accessor.raycast(rng, unif, ray, max_bounces, skybox);
                 col += ray.colour_;
             }
@@ -101,9 +124,189 @@ AGPTracer::Cameras::SphericalCamera_t<T, K, I, N>::raytrace(sycl::queue& queue,
 }
 
 template<typename T, template<typename> typename K, template<typename> typename I, size_t N>
-requires AGPTracer::Entities::Skybox<K, T>&& AGPTracer::Entities::Image<I, T> template<class R, template<typename> typename U, template<typename> typename S>
-requires AGPTracer::Entities::Shape<S, T> auto
-AGPTracer::Cameras::SphericalCamera_t<T, K, I, N>::accumulate(sycl::queue& queue, Entities::RandomGenerator_t<T, R, U>& random_generator, Entities::Scene_t<T, S>& scene, unsigned int n_iter) -> void {
+requires AGPTracer::Entities::Skybox<K, T>&&
+    AGPTracer::Entities::Image<I, T> template<class R, template<typename> typename U, template<typename> typename S, template<typename> typename M, template<typename> typename D,
+                                              template<typename> typename A>
+    requires AGPTracer::Entities::Shape<S, T> auto AGPTracer::Cameras::SphericalCamera_t<T, K, I, N>::raytrace_cached(sycl::queue& queue,
+                                                                                                                     Entities::RandomGenerator_t<T, R, U>& random_generator,
+                                                                                                                     Entities::Scene_t<T, S, M, D, A>& scene,
+                                                                                                                     unsigned int cached_levels) -> void {
+    // Local memory is allocated per work-group when the kernel is submitted, which fails if the cache doesn't fit
+    const size_t max_levels = scene.max_cached_levels(queue.get_device());
+    if (cached_levels > max_levels) {
+        std::cerr << "Warning: " << cached_levels << " levels of the acceleration structure don't fit in the local memory of the device. Only " << max_levels << " levels are cached."
+                  << std::endl;
+        cached_levels = static_cast<unsigned int>(max_levels);
+    }
+
+    constexpr size_t group_size        = 8;
+    const T tot_subpix                 = subpix_[0] * subpix_[1];
+    const T pixel_span_y               = fov_[0] / static_cast<T>(image_.size_y_);
+    const T pixel_span_x               = fov_[1] / static_cast<T>(image_.size_x_);
+    const T subpix_span_y              = pixel_span_y / subpix_[0];
+    const T subpix_span_x              = pixel_span_x / subpix_[1];
+    const Entities::Vec3<T> horizontal = direction_.cross(up_).normalize_inplace();
+    const Entities::Vec3<T> vertical   = horizontal.cross(direction_).normalize_inplace();
+
+    // Copy of members
+    const std::array<unsigned int, 2> subpix = subpix_;
+    const Entities::Vec3<T> direction        = direction_;
+    const Entities::Vec3<T> origin           = origin_;
+    Entities::MediumList_t<N> medium_list    = medium_list_;
+    unsigned int max_bounces                 = max_bounces_;
+    K<T> skybox                              = skybox_; // This is especially bad, maybe skyboxes should be in the scene too
+    const sycl::range<2> size{image_.size_x_, image_.size_y_};
+
+    image_.update();
+
+    // Size of index space for kernel, rounded up to whole work-groups
+    const sycl::range<2> num_work_items{(size[0] + group_size - 1) / group_size * group_size, (size[1] + group_size - 1) / group_size * group_size};
+
+    // Submitting command group(work) to queue
+    queue.submit([&](sycl::handler& cgh) {
+        // Getting read write access to the buffer on a device
+        auto image_accessor  = image_.getAccessor(cgh);
+        auto scene_accessor  = scene.getAccessor(cgh, cached_levels);
+        auto random_accessor = random_generator.getAccessor(cgh);
+
+        // Executing kernel
+        cgh.parallel_for<class SphericalCameraRaytraceCached>(sycl::nd_range<2>{num_work_items, sycl::range<2>{group_size, group_size}}, [=](sycl::nd_item<2> item) {
+            // Work items past the image still take part in loading the cache
+            scene_accessor.load(item);
+
+            const sycl::id<2> WIid = item.get_global_id();
+            if ((WIid[0] >= size[0]) || (WIid[1] >= size[1])) {
+                return;
+            }
+
+            Entities::Vec3<T> col           = Entities::Vec3<T>();
+            const Entities::Vec3<T> pix_vec = Entities::Vec3<T>(T{1},
+                                                                std::numbers::pi_v<T> / T{2} + (static_cast<T>(WIid[1]) - static_cast<double>(size[1]) / T{2} + T{0.5}) * pixel_span_y,
+                                                                (static_cast<double>(WIid[0]) - static_cast<double>(size[0]) / T{2} + T{0.5}) * pixel_span_x);
+            R& rng                          = random_accessor.rng_[WIid];
+            U<T>& unif                      = random_accessor.unif_[WIid];
+
+            for (unsigned int subindex = 0; subindex < subpix[0] * subpix[1]; ++subindex) {
+                const unsigned int l  = subindex % subpix[1]; // x
+                const unsigned int k  = subindex / subpix[1]; // y
+                const double jitter_y = unif(rng);
+                const double jitter_x = unif(rng);
+                const T time          = unif(rng);
+
+                const Entities::Vec3<T> subpix_vec = (pix_vec
+                                                      + Entities::Vec3<T>(T{0},
+                                                                          (static_cast<double>(k) - static_cast<double>(subpix[0]) / T{2} + jitter_y) * subpix_span_y,
+                                                                          (static_cast<double>(l) - static_cast<double>(subpix[1]) / T{2} + jitter_x) * subpix_span_x))
+                                                         .to_xyz_offset(direction, horizontal, vertical);
+
+                Entities::Ray_t ray(origin, subpix_vec, Entities::Vec3<T>(), Entities::Vec3<T>(T{1}), medium_list, time);
+                ray.visibility_ = Entities::Visibility::camera;
+                scene_accessor.raycast(rng, unif, ray, max_bounces, skybox);
+                col += ray.colour_;
+            }
+            col = col / tot_subpix;
+            image_accessor.update(col, WIid);
+        });
+    });
+}
+
+template<typename T, template<typename> typename K, template<typename> typename I, size_t N>
+requires AGPTracer::Entities::Skybox<K, T>&&
+    AGPTracer::Entities::Image<I, T> template<class R, template<typename> typename U, template<typename> typename S, template<typename> typename M, template<typename> typename D,
+                                              template<typename> typename A>
+    requires AGPTracer::Entities::Shape<S, T> auto
+    AGPTracer::Cameras::SphericalCamera_t<T, K, I, N>::raytrace_packets(sycl::queue& queue, Entities::RandomGenerator_t<T, R, U>& random_generator, Entities::Scene_t<T, S, M, D, A>& scene) -> void {
+    constexpr size_t tile_size         = 8;
+    constexpr size_t packet_size       = tile_size * tile_size;
+    const T tot_subpix                 = subpix_[0] * subpix_[1];
+    const T pixel_span_y               = fov_[0] / static_cast<T>(image_.size_y_);
+    const T pixel_span_x               = fov_[1] / static_cast<T>(image_.size_x_);
+    const T subpix_span_y              = pixel_span_y / subpix_[0];
+    const T subpix_span_x              = pixel_span_x / subpix_[1];
+    const Entities::Vec3<T> horizontal = direction_.cross(up_).normalize_inplace();
+    const Entities::Vec3<T> vertical   = horizontal.cross(direction_).normalize_inplace();
+
+    // Copy of members
+    const std::array<unsigned int, 2> subpix = subpix_;
+    const Entities::Vec3<T> direction        = direction_;
+    const Entities::Vec3<T> origin           = origin_;
+    Entities::MediumList_t<N> medium_list    = medium_list_;
+    unsigned int max_bounces                 = max_bounces_;
+    K<T> skybox                              = skybox_; // This is especially bad, maybe skyboxes should be in the scene too
+    const std::array<size_t, 2> size         = {image_.size_x_, image_.size_y_};
+
+    image_.update();
+
+    // Size of index space for kernel, one work item per tile
+    const sycl::range<2> num_work_items{(size[0] + tile_size - 1) / tile_size, (size[1] + tile_size - 1) / tile_size};
+
+    // Submitting command group(work) to queue
+    queue.submit([&](sycl::handler& cgh) {
+        // Getting read write access to the buffer on a device
+        auto image_accessor  = image_.getAccessor(cgh);
+        auto scene_accessor  = scene.getAccessor(cgh);
+        auto random_accessor = random_generator.getAccessor(cgh);
+
+        // Executing kernel
+        cgh.parallel_for<class SphericalCameraRaytracePackets>(num_work_items, [=](sycl::id<2> WIid) {
+            const std::array<size_t, 2> tile_start = {WIid[0] * tile_size, WIid[1] * tile_size};
+            const size_t n_x                       = std::min(tile_size, size[0] - tile_start[0]);
+            const size_t n_rays                    = n_x * std::min(tile_size, size[1] - tile_start[1]);
+            std::array<Entities::Vec3<T>, packet_size> cols{};
+            std::array<Entities::Ray_t<T, N>, packet_size> rays{};
+            std::array<Entities::Hit_t<T>, packet_size> hits{};
+
+            // Each pixel draws from its own random generator in the same order as raytrace_rays
+            for (unsigned int subindex = 0; subindex < subpix[0] * subpix[1]; ++subindex) {
+                const unsigned int l = subindex % subpix[1]; // x
+                const unsigned int k = subindex / subpix[1]; // y
+
+                for (size_t i = 0; i < n_rays; ++i) {
+                    const sycl::id<2> pixel{tile_start[0] + i % n_x, tile_start[1] + i / n_x};
+                    const Entities::Vec3<T> pix_vec = Entities::Vec3<T>(T{1},
+                                                                        std::numbers::pi_v<T> / T{2} + (static_cast<T>(pixel[1]) - static_cast<double>(size[1]) / T{2} + T{0.5}) * pixel_span_y,
+                                                                        (static_cast<double>(pixel[0]) - static_cast<double>(size[0]) / T{2} + T{0.5}) * pixel_span_x);
+                    R& rng                          = random_accessor.rng_[pixel];
+                    U<T>& unif                      = random_accessor.unif_[pixel];
+                    const double jitter_y           = unif(rng);
+                    const double jitter_x           = unif(rng);
+                    const T time                    = unif(rng);
+
+                    const Entities::Vec3<T> subpix_vec = (pix_vec
+                                                          + Entities::Vec3<T>(T{0},
+                                                                              (static_cast<double>(k) - static_cast<double>(subpix[0]) / T{2} + jitter_y) * subpix_span_y,
+                                                                              (static_cast<double>(l) - static_cast<double>(subpix[1]) / T{2} + jitter_x) * subpix_span_x))
+                                                             .to_xyz_offset(direction, horizontal, vertical);
+
+                    rays[i]             = Entities::Ray_t(origin, subpix_vec, Entities::Vec3<T>(), Entities::Vec3<T>(T{1}), medium_list, time);
+                    rays[i].visibility_ = Entities::Visibility::camera;
+                }
+
+                scene_accessor.query_packet(rays, n_rays, hits);
+
+                for (size_t i = 0; i < n_rays; ++i) {
+                    const sycl::id<2> pixel{tile_start[0] + i % n_x, tile_start[1] + i / n_x};
+                    scene_accessor.raycast(random_accessor.rng_[pixel], random_accessor.unif_[pixel], rays[i], max_bounces, skybox, hits[i]);
+                    cols[i] += rays[i].colour_;
+                }
+            }
+
+            for (size_t i = 0; i < n_rays; ++i) {
+                image_accessor.update(cols[i] / tot_subpix, sycl::id<2>{tile_start[0] + i % n_x, tile_start[1] + i / n_x});
+            }
+        });
+    });
+}
+
+template<typename T, template<typename> typename K, template<typename> typename I, size_t N>
+requires AGPTracer::Entities::Skybox<K, T>&&
+    AGPTracer::Entities::Image<I, T> template<class R, template<typename> typename U, template<typename> typename S, template<typename> typename M, template<typename> typename D,
+                                              template<typename> typename A>
+    requires AGPTracer::Entities::Shape<S, T> auto
+    AGPTracer::Cameras::SphericalCamera_t<T, K, I, N>::accumulate(sycl::queue& queue,
+                                                                  Entities::RandomGenerator_t<T, R, U>& random_generator,
+                                                                  Entities::Scene_t<T, S, M, D, A>& scene,
+                                                                  unsigned int n_iter) -> void {
     const auto t_start = std::chrono::high_resolution_clock::now();
     for (unsigned int n = 0; n < n_iter; ++n){
         raytrace(queue, random_generator, scene);
@@ -115,9 +318,11 @@ AGPTracer::Cameras::SphericalCamera_t<T, K, I, N>::accumulate(sycl::queue& queue
 }
 
 template<typename T, template<typename> typename K, template<typename> typename I, size_t N>
-requires AGPTracer::Entities::Skybox<K, T>&& AGPTracer::Entities::Image<I, T> template<class R, template<typename> typename U, template<typename> typename S>
-requires AGPTracer::Entities::Shape<S, T> auto
-AGPTracer::Cameras::SphericalCamera_t<T, K, I, N>::accumulate(sycl::queue& queue, Entities::RandomGenerator_t<T, R, U>& random_generator, Entities::Scene_t<T, S>& scene) -> void {
+requires AGPTracer::Entities::Skybox<K, T>&&
+    AGPTracer::Entities::Image<I, T> template<class R, template<typename> typename U, template<typename> typename S, template<typename> typename M, template<typename> typename D,
+                                              template<typename> typename A>
+    requires AGPTracer::Entities::Shape<S, T> auto
+    AGPTracer::Cameras::SphericalCamera_t<T, K, I, N>::accumulate(sycl::queue& queue, Entities::RandomGenerator_t<T, R, U>& random_generator, Entities::Scene_t<T, S, M, D, A>& scene) -> void {
     unsigned int n = 0;
     while (true) {
         ++n;
@@ -131,9 +336,11 @@ AGPTracer::Cameras::SphericalCamera_t<T, K, I, N>::accumulate(sycl::queue& queue
 }
 
 template<typename T, template<typename> typename K, template<typename> typename I, size_t N>
-requires AGPTracer::Entities::Skybox<K, T>&& AGPTracer::Entities::Image<I, T> template<class R, template<typename> typename U, template<typename> typename S>
-requires AGPTracer::Entities::Shape<S, T> auto AGPTracer::Cameras::SphericalCamera_t<T, K, I, N>::accumulateWrite(
-    sycl::queue& queue, Entities::RandomGenerator_t<T, R, U>& random_generator, Entities::Scene_t<T, S>& scene, unsigned int n_iter, unsigned int interval) -> void {
+requires AGPTracer::Entities::Skybox<K, T>&&
+    AGPTracer::Entities::Image<I, T> template<class R, template<typename> typename U, template<typename> typename S, template<typename> typename M, template<typename> typename D,
+                                              template<typename> typename A>
+    requires AGPTracer::Entities::Shape<S, T> auto AGPTracer::Cameras::SphericalCamera_t<T, K, I, N>::accumulateWrite(
+        sycl::queue& queue, Entities::RandomGenerator_t<T, R, U>& random_generator, Entities::Scene_t<T, S, M, D, A>& scene, unsigned int n_iter, unsigned int interval) -> void {
     // std::chrono::steady_clock::time_point t_start, t_end;
     unsigned int n = 0;
     while (n < n_iter) {
@@ -157,10 +364,14 @@ requires AGPTracer::Entities::Shape<S, T> auto AGPTracer::Cameras::SphericalCame
 }
 
 template<typename T, template<typename> typename K, template<typename> typename I, size_t N>
-requires AGPTracer::Entities::Skybox<K, T>&& AGPTracer::Entities::Image<I, T> template<class R, template<typename> typename U, template<typename> typename S>
-requires AGPTracer::Entities::Shape<S, T> auto
-AGPTracer::Cameras::SphericalCamera_t<T, K, I, N>::accumulateWrite(sycl::queue& queue, Entities::RandomGenerator_t<T, R, U>& random_generator, Entities::Scene_t<T, S>& scene, unsigned int interval)
-    -> void {
+requires AGPTracer::Entities::Skybox<K, T>&&
+    AGPTracer::Entities::Image<I, T> template<class R, template<typename> typename U, template<typename> typename S, template<typename> typename M, template<typename> typename D,
+                                              template<typename> typename A>
+    requires AGPTracer::Entities::Shape<S, T> auto
+    AGPTracer::Cameras::SphericalCamera_t<T, K, I, N>::accumulateWrite(sycl::queue& queue,
+                                                                       Entities::RandomGenerator_t<T, R, U>& random_generator,
+                                                                       Entities::Scene_t<T, S, M, D, A>& scene,
+                                                                       unsigned int interval) -> void {
     unsigned int n = 0;
     while (true) {
         ++n;
@@ -183,9 +394,11 @@ AGPTracer::Cameras::SphericalCamera_t<T, K, I, N>::accumulateWrite(sycl::queue&
 }
 
 template<typename T, template<typename> typename K, template<typename> typename I, size_t N>
-requires AGPTracer::Entities::Skybox<K, T>&& AGPTracer::Entities::Image<I, T> template<class R, template<typename> typename U, template<typename> typename S>
-requires AGPTracer::Entities::Shape<S, T> auto
-AGPTracer::Cameras::SphericalCamera_t<T, K, I, N>::accumulateWrite(sycl::queue& queue, Entities::RandomGenerator_t<T, R, U>& random_generator, Entities::Scene_t<T, S>& scene) -> void {
+requires AGPTracer::Entities::Skybox<K, T>&&
+    AGPTracer::Entities::Image<I, T> template<class R, template<typename> typename U, template<typename> typename S, template<typename> typename M, template<typename> typename D,
+                                              template<typename> typename A>
+    requires AGPTracer::Entities::Shape<S, T> auto
+    AGPTracer::Cameras::SphericalCamera_t<T, K, I, N>::accumulateWrite(sycl::queue& queue, Entities::RandomGenerator_t<T, R, U>& random_generator, Entities::Scene_t<T, S, M, D, A>& scene) -> void {
     unsigned int n = 0;
     while (true) {
         ++n;
@@ -0,0 +1,108 @@
+#ifndef AGPTRACER_ENTITIES_ACCELERATIONSTRUCTURE_HPP
+#define AGPTRACER_ENTITIES_ACCELERATIONSTRUCTURE_HPP
+
+#include "entities/Ray_t.hpp"
+#include "entities/Vec3.hpp"
+#include <array>
+#include <concepts>
+#include <cstdint>
+#include <span>
+#include <sycl/sycl.hpp>
+
+namespace AGPTracer::Entities {
+    /**
+     * @brief The acceleration structure interface describes a structure sorting the shapes of a scene, used to quickly find which shapes a ray intersects.
+     *
+     * An acceleration structure gives an accessor that can traverse it on the device. The traversal calls a function for every
+     * shape that the ray may intersect, which lowers the maximum distance of the traversal when it finds a closer intersection.
+     * The structure is built from the shapes of the scene with build, and updated after they change with update.
+     *
+     * @tparam A Acceleration structure type
+     * @tparam T Floating point datatype to use
+     */
+    template<template<typename> typename A, typename T>
+    concept AccelerationStructure = requires(A<T> a, const typename A<T>::Accessor_t accessor, sycl::handler& cgh, const Ray_t<T, 16>& ray, T& t, bool (*leaf)(size_t, T&)) {
+        { a.getAccessor(cgh) } -> std::convertible_to<typename A<T>::Accessor_t>;
+        accessor.traverse(ray, t, leaf);
+    };
+
+    /**
+     * @brief The packet acceleration structure interface describes an acceleration structure that can be traversed by a packet of coherent rays at once.
+     *
+     * The packet shares a single traversal, and nodes are culled for all its rays together. The leaf function is called with the
+     * index of a ray in the packet and the index of a shape that this ray may intersect, and lowers the distance of that ray.
+     *
+     * @tparam A Acceleration structure type
+     * @tparam T Floating point datatype to use
+     */
+    template<template<typename> typename A, typename T>
+    concept PacketAccelerationStructure = AccelerationStructure<A, T> && requires(const typename A<T>::Accessor_t accessor, const std::array<Ray_t<T, 16>, 1>& rays, std::array<T, 1>& t) {
+        accessor.traverse_packet(rays, size_t{1}, t, [](size_t /*ray_index*/, size_t /*shape_index*/, T& /*distance*/) {});
+    };
+
+    /**
+     * @brief The cached acceleration structure interface describes an acceleration structure whose top levels can be copied to the local memory of each work-group.
+     *
+     * Its accessor is given the number of levels to cache, and is loaded once per work-group at the start of a kernel launched
+     * over an nd_range. Traversal then reads the cached levels from local memory. The number of levels that fit in an amount
+     * of local memory is given by max_cached_levels.
+     *
+     * @tparam A Acceleration structure type
+     * @tparam T Floating point datatype to use
+     */
+    template<template<typename> typename A, typename T>
+    concept CachedAccelerationStructure = AccelerationStructure<A, T> && requires(A<T> a, const typename A<T>::Accessor_t accessor, sycl::handler& cgh, size_t levels, const sycl::nd_item<2>& item) {
+        { a.getAccessor(cgh, levels) } -> std::convertible_to<typename A<T>::Accessor_t>;
+        { A<T>::max_cached_levels(levels) } -> std::convertible_to<size_t>;
+        accessor.load(item);
+    };
+
+    /**
+     * @brief The incremental acceleration structure interface describes an acceleration structure in which shapes can be inserted and removed without rebuilding it.
+     *
+     * Shapes are inserted from their bounding boxes, after the shapes already in the structure. When shapes are removed, the last
+     * shape takes the index of each removed shape, going through them from the last to the first, so that only a few shapes are
+     * renumbered. Both take the number of shapes the structure must already contain, and do nothing if it is out of date. They
+     * run on the given queue, which should be the one the structure is traversed and updated with, so that it stays on its device.
+     *
+     * @tparam A Acceleration structure type
+     * @tparam T Floating point datatype to use
+     */
+    template<template<typename> typename A, typename T>
+    concept IncrementalAccelerationStructure = AccelerationStructure<A, T> && requires(A<T> a, sycl::queue& queue, size_t n_shapes, std::span<const Vec3<T>> mins, std::span<const Vec3<T>> maxs) {
+        a.insert(queue, n_shapes, mins, maxs);
+    }
+    &&requires(A<T> a, sycl::queue& queue, size_t n_shapes, std::span<const uint32_t> removed) {
+        a.remove(queue, n_shapes, removed);
+    };
+
+    /**
+     * @brief The permutable acceleration structure interface describes an acceleration structure whose shapes can be renumbered without rebuilding it.
+     *
+     * This is used after the shapes are moved in memory, and keeps the structure as it was built. The order gives the previous
+     * index of the shape now at each index.
+     *
+     * @tparam A Acceleration structure type
+     * @tparam T Floating point datatype to use
+     */
+    template<template<typename> typename A, typename T>
+    concept PermutableAccelerationStructure = AccelerationStructure<A, T> && requires(A<T> a, sycl::queue& queue, sycl::buffer<uint32_t, 1>& order) {
+        a.permute(queue, order);
+    };
+
+    /**
+     * @brief The device built acceleration structure interface describes an acceleration structure that can be built on the device around shapes of type S.
+     *
+     * The shapes stay on the device during the build, which is faster than a host build but may give a lower quality structure.
+     *
+     * @tparam A Acceleration structure type
+     * @tparam T Floating point datatype to use
+     * @tparam S Shape type
+     */
+    template<template<typename> typename A, typename T, template<typename> typename S>
+    concept DeviceBuiltAccelerationStructure = AccelerationStructure<A, T> && requires(A<T> a, sycl::queue& queue, sycl::buffer<S<T>, 1>& shapes) {
+        a.build(queue, shapes);
+    };
+}
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef AGPTRACER_ENTITIES_CLIPPLANE_T_HPP
+#define AGPTRACER_ENTITIES_CLIPPLANE_T_HPP
+
+#include "entities/Vec3.hpp"
+#include <array>
+#include <limits>
+
+namespace AGPTracer::Entities {
+    /**
+     * @brief The clip plane class describes a half-space of the scene that stays visible, used to cut section views through a scene.
+     *
+     * Points in front of the plane, where the dot product of the normal with the point is greater than the distance, are
+     * clipped away. Clip planes act on the rays instead of on the shapes, by restricting the interval of each ray to the
+     * part behind all the planes of the scene, so moving a plane doesn't require changing the shapes or rebuilding the
+     * acceleration structure. As each plane keeps a half-space, several planes keep a convex region, such as a box.
+     *
+     * @tparam T Floating point datatype to use
+     */
+    template<typename T = double>
+    class ClipPlane_t {
+        public:
+            Vec3<T> normal_; /**< @brief Normal of the plane, pointing towards the clipped half-space. Doesn't have to be normalised.*/
+            T distance_; /**< @brief Dot product of the normal with any point of the plane.*/
+
+            /**
+             * @brief Restricts the interval of a ray to the part behind the plane.
+             *
+             * @param origin Origin of the ray.
+             * @param direction Direction of the ray.
+             * @param[in, out] t_near Distance from which the ray is visible. Raised if the ray enters the visible half-space after it.
+             * @param[in, out] t_far Distance up to which the ray is visible. Lowered if the ray leaves the visible half-space before it.
+             */
+            constexpr auto clip(const Vec3<T>& origin, const Vec3<T>& direction, T& t_near, T& t_far) const -> void {
+                const T height = distance_ - normal_.dot(origin);
+                const T slope  = normal_.dot(direction);
+
+                // Rays parallel to the plane are either entirely visible or entirely clipped
+                if (slope == T{0}) {
+                    if (height < T{0}) {
+                        t_far = std::numeric_limits<T>::lowest();
+                    }
+                    return;
+                }
+
+                const T t = height / slope;
+                if (slope > T{0}) {
+                    t_far = (t < t_far) ? t : t_far;
+                }
+                else {
+                    t_near = (t > t_near) ? t : t_near;
+                }
+            }
+
+            /**
+             * @brief Returns the six planes keeping the inside of an axis-aligned box.
+             *
+             * @param minimum Minimum coordinates of the box.
+             * @param maximum Maximum coordinates of the box.
+             * @return std::array<ClipPlane_t<T>, 6> Planes clipping everything outside the box.
+             */
+            constexpr static auto box(const Vec3<T>& minimum, const Vec3<T>& maximum) -> std::array<ClipPlane_t<T>, 6> {
+                return {
+                    ClipPlane_t<T>{Vec3<T>(T{-1}, T{0}, T{0}), -minimum[0]},
+                    ClipPlane_t<T>{Vec3<T>(T{0}, T{-1}, T{0}), -minimum[1]},
+                    ClipPlane_t<T>{Vec3<T>(T{0}, T{0}, T{-1}), -minimum[2]},
+                    ClipPlane_t<T>{Vec3<T>(T{1}, T{0}, T{0}),  maximum[0] },
+                    ClipPlane_t<T>{Vec3<T>(T{0}, T{1}, T{0}),  maximum[1] },
+                    ClipPlane_t<T>{Vec3<T>(T{0}, T{0}, T{1}),  maximum[2] }
+                };
+            }
+    };
+}
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef AGPTRACER_ENTITIES_HIT_T_HPP
+#define AGPTRACER_ENTITIES_HIT_T_HPP
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+namespace AGPTracer::Entities {
+    /**
+     * @brief The hit class holds the result of a ray query, the closest intersection of a ray with a scene.
+     *
+     * Hits are returned by the batched ray queries of the scene, which are used for workloads that don't produce images, such as
+     * line of sight or view factors. Shapes hit through a mesh instance are referenced by their index in the shapes of the meshes,
+     * along with the index of the instance. Indices are 32 bits to keep the records small, as many of them are written at once.
+     *
+     * @tparam T Floating point datatype to use
+     */
+    template<typename T = double>
+    class Hit_t {
+        public:
+            constexpr static uint32_t none_ = std::numeric_limits<uint32_t>::max(); /**< @brief Index stored when there is no shape, instance or material.*/
+
+            T t_ = std::numeric_limits<T>::max(); /**< @brief Distance from the ray origin to the intersection, in units of the ray direction. Maximum value if nothing is hit.*/
+            std::array<T, 2> uv_{}; /**< @brief 2D object-space coordinates of the intersection on the shape.*/
+            uint32_t shape_    = none_; /**< @brief Index of the shape hit, in the shapes of the scene or in the shapes of the meshes if an instance is hit. Indexed mesh triangles come after them.*/
+            uint32_t instance_ = none_; /**< @brief Index of the mesh instance hit, if any.*/
+            uint32_t material_ = none_; /**< @brief Material of the shape hit, replaced by the material of the instance if it has one.*/
+
+            /**
+             * @brief Returns whether the ray hit something.
+             *
+             * @return true The ray hit a shape, and the other members are valid.
+             * @return false The ray didn't hit anything.
+             */
+            constexpr auto hit() const -> bool {
+                return shape_ != none_;
+            }
+    };
+}
+
+#endif
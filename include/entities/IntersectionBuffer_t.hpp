@@ -0,0 +1,122 @@
+#ifndef AGPTRACER_ENTITIES_INTERSECTIONBUFFER_T_HPP
+#define AGPTRACER_ENTITIES_INTERSECTIONBUFFER_T_HPP
+
+#include "entities/Ray_t.hpp"
+#include "entities/Shape.hpp"
+#include "entities/Vec3.hpp"
+#include <array>
+#include <cstdint>
+#include <sycl/sycl.hpp>
+
+namespace AGPTracer::Entities {
+    /**
+     * @brief The intersection buffer class holds the part of triangles read when intersecting them, apart from the rest of their data.
+     *
+     * Shapes carry their transformation, original points, normals and texture coordinates, which are only needed to shade the closest
+     * hit, while intersecting a triangle only reads its first point and its two edges. A triangle of doubles is hundreds of bytes, so
+     * traversing the shapes themselves fetches an order of magnitude more memory than needed. This buffer stores the first points, the
+     * edges and the visibility masks of the shapes in separate arrays, so that traversal only fetches those, and the shapes are read
+     * once for the closest hit. Shapes that can't be split this way leave the buffer empty, and are intersected whole.
+     *
+     * @tparam T Floating point datatype to use
+     */
+    template<typename T = double>
+    class IntersectionBuffer_t {
+        public:
+            class Accessor_t {
+                public:
+                    /**
+                     * @brief Construct a new Accessor_t object with the given buffers.
+                     *
+                     * @param cgh Device handler.
+                     * @param points First point buffer to access.
+                     * @param v0v1 First edge buffer to access.
+                     * @param v0v2 Second edge buffer to access.
+                     * @param masks Visibility mask buffer to access.
+                     */
+                    Accessor_t(sycl::handler& cgh, sycl::buffer<Vec3<T>, 1>& points, sycl::buffer<Vec3<T>, 1>& v0v1, sycl::buffer<Vec3<T>, 1>& v0v2, sycl::buffer<uint32_t, 1>& masks);
+
+                    /**
+                     * @brief Intersects a ray with a triangle of the buffer, using the intersection of its shape type.
+                     *
+                     * @tparam S Shape type the buffer was built from
+                     * @tparam N Number of mediums in the ray's medium list
+                     * @param index Index of the triangle, the same as the index of its shape.
+                     * @param ray Ray to be tested for intersection with the triangle.
+                     * @param[out] t Distance at which the intersection ocurred, from ray origin. Undefined if not intersected.
+                     * @param[out] uv Coordinates in object space of the intersection. Undefined if not intersected.
+                     * @return true The ray intersected the triangle, t and uv are defined.
+                     * @return false The ray doesn't intersect the triangle, t and uv are undefined.
+                     */
+                    template<template<typename> typename S, size_t N>
+                    requires EdgeIntersectable<S, T> auto intersection(size_t index, const Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv) const -> bool;
+
+                    /**
+                     * @brief Returns the geometric normal of a triangle of the buffer, not normalised.
+                     *
+                     * @param index Index of the triangle, the same as the index of its shape.
+                     * @return Vec3<T> Normal of the triangle, from its points in counter-clockwise order.
+                     */
+                    auto normal_face(size_t index) const -> Vec3<T>;
+
+                    /**
+                     * @brief Returns the visibility mask of a triangle of the buffer.
+                     *
+                     * @param index Index of the triangle, the same as the index of its shape.
+                     * @return uint32_t Visibility mask of the shape.
+                     */
+                    auto mask(size_t index) const -> uint32_t;
+
+                private:
+                    sycl::accessor<Vec3<T>, 1, sycl::access::mode::read> points_; /**< @brief Accessor to the first points of the triangles.*/
+                    sycl::accessor<Vec3<T>, 1, sycl::access::mode::read> v0v1_; /**< @brief Accessor to the vectors from the first point to the second point of the triangles.*/
+                    sycl::accessor<Vec3<T>, 1, sycl::access::mode::read> v0v2_; /**< @brief Accessor to the vectors from the first point to the third point of the triangles.*/
+                    sycl::accessor<uint32_t, 1, sycl::access::mode::read> masks_; /**< @brief Accessor to the visibility masks of the triangles.*/
+            };
+
+            /**
+             * @brief Construct a new empty IntersectionBuffer_t object.
+             */
+            IntersectionBuffer_t();
+
+            sycl::buffer<Vec3<T>, 1> points_; /**< @brief First point of each triangle.*/
+            sycl::buffer<Vec3<T>, 1> v0v1_; /**< @brief Vector from the first point to the second point of each triangle.*/
+            sycl::buffer<Vec3<T>, 1> v0v2_; /**< @brief Vector from the first point to the third point of each triangle.*/
+            sycl::buffer<uint32_t, 1> masks_; /**< @brief Visibility mask of each triangle, all visible for shapes without a mask.*/
+
+            /**
+             * @brief Fills the buffer from shapes on the host, with one triangle per shape.
+             *
+             * Has to be called whenever shapes are added, removed or reordered. The buffer is emptied if the shapes can't be split.
+             *
+             * @tparam S Shape type
+             * @param shapes Shapes from which to take the triangles.
+             */
+            template<template<typename> typename S>
+            auto build(sycl::buffer<S<T>, 1>& shapes) -> void;
+
+            /**
+             * @brief Fills the buffer from shapes on the device, after they are updated.
+             *
+             * The buffer is built on the host instead if the number of shapes changed. Does nothing if the shapes can't be split.
+             *
+             * @tparam S Shape type
+             * @param queue Queue on which to submit the update.
+             * @param shapes Shapes from which to take the triangles.
+             */
+            template<template<typename> typename S>
+            auto update(sycl::queue& queue, sycl::buffer<S<T>, 1>& shapes) -> void;
+
+            /**
+             * @brief Get a Accessor_t object attached to this buffer
+             *
+             * @param cgh Device handler.
+             * @return Accessor_t Accessor that can be used on the device to intersect the triangles
+             */
+            auto getAccessor(sycl::handler& cgh) -> Accessor_t;
+    };
+}
+
+#include "entities/IntersectionBuffer_t.tpp"
+
+#endif
@@ -0,0 +1,100 @@
+#include "entities/Visibility.hpp"
+
+template<typename T>
+AGPTracer::Entities::IntersectionBuffer_t<T>::IntersectionBuffer_t() :
+        points_(sycl::range<1>{0}), v0v1_(sycl::range<1>{0}), v0v2_(sycl::range<1>{0}), masks_(sycl::range<1>{0}) {}
+
+template<typename T>
+template<template<typename> typename S>
+auto AGPTracer::Entities::IntersectionBuffer_t<T>::build(sycl::buffer<S<T>, 1>& shapes) -> void {
+    const size_t n_shapes = EdgeIntersectable<S, T> ? shapes.get_range()[0] : 0;
+    if (points_.get_range()[0] != n_shapes) {
+        points_ = sycl::buffer<Vec3<T>, 1>(sycl::range<1>{n_shapes});
+        v0v1_   = sycl::buffer<Vec3<T>, 1>(sycl::range<1>{n_shapes});
+        v0v2_   = sycl::buffer<Vec3<T>, 1>(sycl::range<1>{n_shapes});
+        masks_  = sycl::buffer<uint32_t, 1>(sycl::range<1>{n_shapes});
+    }
+
+    if constexpr (EdgeIntersectable<S, T>) {
+        const sycl::host_accessor<S<T>, 1, sycl::access_mode::read> shape_accessor(shapes);
+        const sycl::host_accessor<Vec3<T>, 1, sycl::access_mode::write> point_accessor(points_, sycl::no_init);
+        const sycl::host_accessor<Vec3<T>, 1, sycl::access_mode::write> v0v1_accessor(v0v1_, sycl::no_init);
+        const sycl::host_accessor<Vec3<T>, 1, sycl::access_mode::write> v0v2_accessor(v0v2_, sycl::no_init);
+        const sycl::host_accessor<uint32_t, 1, sycl::access_mode::write> mask_accessor(masks_, sycl::no_init);
+
+        for (size_t i = 0; i < n_shapes; ++i) {
+            point_accessor[i] = shape_accessor[i].points_[0];
+            v0v1_accessor[i]  = shape_accessor[i].v0v1_;
+            v0v2_accessor[i]  = shape_accessor[i].v0v2_;
+            if constexpr (Masked<S, T>) {
+                mask_accessor[i] = shape_accessor[i].mask_;
+            }
+            else {
+                mask_accessor[i] = Visibility::all;
+            }
+        }
+    }
+}
+
+template<typename T>
+template<template<typename> typename S>
+auto AGPTracer::Entities::IntersectionBuffer_t<T>::update(sycl::queue& queue, sycl::buffer<S<T>, 1>& shapes) -> void {
+    if constexpr (EdgeIntersectable<S, T>) {
+        if (points_.get_range()[0] != shapes.get_range()[0]) {
+            build(shapes);
+            return;
+        }
+
+        const sycl::range<1> num_work_items{shapes.get_range()};
+
+        queue.submit([&](sycl::handler& cgh) {
+            auto shape_accessor = shapes.template get_access<sycl::access::mode::read>(cgh);
+            auto point_accessor = points_.template get_access<sycl::access::mode::discard_write>(cgh);
+            auto v0v1_accessor  = v0v1_.template get_access<sycl::access::mode::discard_write>(cgh);
+            auto v0v2_accessor  = v0v2_.template get_access<sycl::access::mode::discard_write>(cgh);
+            auto mask_accessor  = masks_.template get_access<sycl::access::mode::discard_write>(cgh);
+
+            cgh.parallel_for<class UpdateIntersectionBuffer>(num_work_items, [=](sycl::id<1> WIid) {
+                point_accessor[WIid] = shape_accessor[WIid].points_[0];
+                v0v1_accessor[WIid]  = shape_accessor[WIid].v0v1_;
+                v0v2_accessor[WIid]  = shape_accessor[WIid].v0v2_;
+                if constexpr (Masked<S, T>) {
+                    mask_accessor[WIid] = shape_accessor[WIid].mask_;
+                }
+                else {
+                    mask_accessor[WIid] = Visibility::all;
+                }
+            });
+        });
+    }
+}
+
+template<typename T>
+auto AGPTracer::Entities::IntersectionBuffer_t<T>::getAccessor(sycl::handler& cgh) -> Accessor_t {
+    return Accessor_t(cgh, points_, v0v1_, v0v2_, masks_);
+}
+
+template<typename T>
+AGPTracer::Entities::IntersectionBuffer_t<T>::Accessor_t::Accessor_t(
+    sycl::handler& cgh, sycl::buffer<Vec3<T>, 1>& points, sycl::buffer<Vec3<T>, 1>& v0v1, sycl::buffer<Vec3<T>, 1>& v0v2, sycl::buffer<uint32_t, 1>& masks) :
+        points_(points.template get_access<sycl::access::mode::read>(cgh)),
+        v0v1_(v0v1.template get_access<sycl::access::mode::read>(cgh)),
+        v0v2_(v0v2.template get_access<sycl::access::mode::read>(cgh)),
+        masks_(masks.template get_access<sycl::access::mode::read>(cgh)) {}
+
+template<typename T>
+template<template<typename> typename S, size_t N>
+requires AGPTracer::Entities::EdgeIntersectable<S, T> auto AGPTracer::Entities::IntersectionBuffer_t<T>::Accessor_t::intersection(size_t index, const Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv) const
+    -> bool {
+    return S<T>::intersection(points_[index], v0v1_[index], v0v2_[index], ray, t, uv);
+}
+
+template<typename T>
+auto AGPTracer::Entities::IntersectionBuffer_t<T>::Accessor_t::normal_face(size_t index) const -> Vec3<T> {
+    return v0v1_[index].cross(v0v2_[index]);
+}
+
+template<typename T>
+auto AGPTracer::Entities::IntersectionBuffer_t<T>::Accessor_t::mask(size_t index) const -> uint32_t {
+    return masks_[index];
+}
@@ -0,0 +1,69 @@
+#ifndef AGPTRACER_ENTITIES_OCTAHEDRAL_HPP
+#define AGPTRACER_ENTITIES_OCTAHEDRAL_HPP
+
+#include "entities/Vec3.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+/**
+ * @brief Contains the octahedral encoding of unit vectors in 32 bits.
+ *
+ * A direction is projected on the octahedron |x| + |y| + |z| = 1, whose lower half is folded over the upper half, which maps
+ * it to the square [-1, 1] x [-1, 1]. Both coordinates of the square are stored as 16 bit signed normalised integers. The
+ * error on the decoded direction is below 1e-4 radians, plenty for shading normals and tangents, and six times smaller than
+ * three doubles. Decoding an encoded direction and encoding it again gives back the same bits.
+ */
+namespace AGPTracer::Entities::Octahedral {
+    constexpr int32_t max_value = 32767; /**< @brief Value of the integers storing a coordinate of 1 on the square.*/
+
+    /**
+     * @brief Encodes a direction in 32 bits. The direction doesn't have to be normalised. Zero is encoded as the z axis.
+     *
+     * @tparam T Floating point datatype of the direction
+     * @param direction Direction to encode.
+     * @return uint32_t Encoded direction, with the first coordinate on the square in the high 16 bits and the second one in the low 16 bits.
+     */
+    template<typename T>
+    auto encode(const Vec3<T>& direction) -> uint32_t {
+        const T norm = std::abs(direction[0]) + std::abs(direction[1]) + std::abs(direction[2]);
+        if (!(norm > T{0})) {
+            return 0;
+        }
+        T x = direction[0] / norm;
+        T y = direction[1] / norm;
+        if (direction[2] < T{0}) {
+            const T folded_x = (T{1} - std::abs(y)) * std::copysign(T{1}, x);
+            const T folded_y = (T{1} - std::abs(x)) * std::copysign(T{1}, y);
+            x                = folded_x;
+            y                = folded_y;
+        }
+
+        const auto quantised_x = static_cast<int16_t>(std::round(std::min(std::max(x, T{-1}), T{1}) * max_value));
+        const auto quantised_y = static_cast<int16_t>(std::round(std::min(std::max(y, T{-1}), T{1}) * max_value));
+        return (static_cast<uint32_t>(static_cast<uint16_t>(quantised_x)) << 16U) | static_cast<uint32_t>(static_cast<uint16_t>(quantised_y));
+    }
+
+    /**
+     * @brief Decodes a direction encoded in 32 bits.
+     *
+     * @tparam T Floating point datatype of the direction
+     * @param encoded Encoded direction, as returned by encode.
+     * @return Vec3<T> Decoded direction, normalised.
+     */
+    template<typename T>
+    auto decode(uint32_t encoded) -> Vec3<T> {
+        T x       = static_cast<T>(static_cast<int16_t>(static_cast<uint16_t>(encoded >> 16U))) / max_value;
+        T y       = static_cast<T>(static_cast<int16_t>(static_cast<uint16_t>(encoded & 0xFFFFU))) / max_value;
+        const T z = T{1} - std::abs(x) - std::abs(y);
+        if (z < T{0}) {
+            const T unfolded_x = (T{1} - std::abs(y)) * std::copysign(T{1}, x);
+            const T unfolded_y = (T{1} - std::abs(x)) * std::copysign(T{1}, y);
+            x                  = unfolded_x;
+            y                  = unfolded_y;
+        }
+        return Vec3<T>(x, y, z).normalize_inplace();
+    }
+}
+
+#endif
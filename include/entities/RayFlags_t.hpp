@@ -0,0 +1,43 @@
+#ifndef AGPTRACER_ENTITIES_RAYFLAGS_T_HPP
+#define AGPTRACER_ENTITIES_RAYFLAGS_T_HPP
+
+#include <cstdint>
+
+namespace AGPTracer::Entities {
+    /**
+     * @brief The ray flags change how a ray query intersects the scene. They can be combined with the | operator.
+     *
+     * Camera rays usually use none, to find the closest hit. Shadow rays and other visibility tests don't need the closest hit,
+     * and can stop at the first one they find with terminate_on_first_hit, or with an occlusion query, which always does.
+     */
+    enum class RayFlags_t : uint32_t {
+        none                   = 0, /**< @brief Finds the closest hit with every shape.*/
+        cull_back_faces        = 1U, /**< @brief Ignores hits where the ray comes from behind the geometric normal of the shape.*/
+        terminate_on_first_hit = 1U << 1U /**< @brief Stops at the first hit found, which may not be the closest one.*/
+    };
+
+    /**
+     * @brief Combines two sets of ray flags.
+     *
+     * @param lhs First set of flags.
+     * @param rhs Second set of flags.
+     * @return RayFlags_t Flags set in either set.
+     */
+    constexpr auto operator|(RayFlags_t lhs, RayFlags_t rhs) -> RayFlags_t {
+        return static_cast<RayFlags_t>(static_cast<uint32_t>(lhs) | static_cast<uint32_t>(rhs));
+    }
+
+    /**
+     * @brief Returns whether a flag is part of a set of ray flags.
+     *
+     * @param flags Set of flags to check.
+     * @param flag Flag to look for.
+     * @return true The flag is set.
+     * @return false The flag isn't set.
+     */
+    constexpr auto has_flag(RayFlags_t flags, RayFlags_t flag) -> bool {
+        return (static_cast<uint32_t>(flags) & static_cast<uint32_t>(flag)) != 0;
+    }
+}
+
+#endif
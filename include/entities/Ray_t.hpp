@@ -3,6 +3,8 @@
 
 #include "entities/MediumList_t.hpp"
 #include "entities/Vec3.hpp"
+#include "entities/Visibility.hpp"
+#include <cstdint>
 
 namespace AGPTracer::Entities {
     /**
@@ -17,6 +19,11 @@ namespace AGPTracer::Entities {
     template<typename T = double, size_t N = 16>
     class Ray_t {
         public:
+            /**
+             * @brief Construct a new Ray_t object at the origin, without a direction. Used to make arrays of rays, such as packets, before filling them.
+             */
+            constexpr Ray_t() : origin_(), direction_(), colour_(), mask_(T{1}), dist_(0), medium_list_(), time_(1), visibility_(Visibility::all){};
+
             /**
              * @brief Construct a new Ray_t object.
              *
@@ -28,7 +35,7 @@ namespace AGPTracer::Entities {
              * @param[in] medium_list Initial list of materials through which the ray is travelling. Should have at least two copies of an "outside" medium not assigned to any object (issue #25).
              */
             constexpr Ray_t(const Vec3<T>& origin, const Vec3<T>& direction, const Vec3<T>& colour, const Vec3<T>& mask, MediumList_t<N> medium_list) :
-                    origin_(origin), direction_(direction), colour_(colour), mask_(mask), dist_(0), medium_list_(std::move(medium_list)), time_(1){};
+                    origin_(origin), direction_(direction), colour_(colour), mask_(mask), dist_(0), medium_list_(std::move(medium_list)), time_(1), visibility_(Visibility::all){};
 
             /**
              * @brief Construct a new Ray_t object with a  time.
@@ -42,7 +49,7 @@ namespace AGPTracer::Entities {
              * @param[in] time Time at which the ray is emitted. From 0 for exposure start to 1 for exposure end.
              */
             constexpr Ray_t(const Vec3<T>& origin, const Vec3<T>& direction, const Vec3<T>& colour, const Vec3<T>& mask, MediumList_t<N> medium_list, T time) :
-                    origin_(origin), direction_(direction), colour_(colour), mask_(mask), dist_(0), medium_list_(std::move(medium_list)), time_(time){};
+                    origin_(origin), direction_(direction), colour_(colour), mask_(mask), dist_(0), medium_list_(std::move(medium_list)), time_(time), visibility_(Visibility::all){};
 
             Vec3<T> origin_; /**< @brief Origin of the ray. Changed by materials on bounce.*/
             Vec3<T> direction_; /**< @brief Direction of the ray. Changed by materials on bounce.*/
@@ -52,6 +59,7 @@ namespace AGPTracer::Entities {
             T dist_; /**< @brief Distance traveled by the ray since last bounce.*/
             MediumList_t<N> medium_list_; /**< @brief List of materials in which the ray travels. The first one is the current one.*/
             T time_; /**< @brief Time of emission of the ray, relative to exposure time. 0 for start of exposure to 1 for end.*/
+            uint32_t visibility_; /**< @brief Visibility mask of the ray. Only shapes and instances whose mask has a bit in common with it are intersected. Starts with every bit set.*/
     };
 }
 
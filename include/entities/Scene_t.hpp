@@ -1,21 +1,34 @@
 #ifndef AGPTRACER_ENTITIES_SCENE_T_HPP
 #define AGPTRACER_ENTITIES_SCENE_T_HPP
 
-// #include "entities/AccelerationStructure_t.hpp"
+#include "acceleration_structures/BVHCache_t.hpp"
+#include "acceleration_structures/BVH_t.hpp"
+#include "acceleration_structures/InstanceBVH_t.hpp"
+#include "acceleration_structures/LBVHBuilder_t.hpp"
+#include "entities/AccelerationStructure.hpp"
+#include "entities/ClipPlane_t.hpp"
+#include "entities/Hit_t.hpp"
+#include "entities/IntersectionBuffer_t.hpp"
 #include "entities/Material.hpp"
+#include "entities/MeshGeometry_t.hpp"
 #include "entities/Medium.hpp"
+#include "entities/RayFlags_t.hpp"
 #include "entities/Ray_t.hpp"
 #include "entities/Shape.hpp"
 #include "entities/Skybox.hpp"
 #include "materials/Diffuse_t.hpp"
 #include "mediums/NonAbsorber_t.hpp"
+#include "shapes/IndexedMesh_t.hpp"
+#include "shapes/MeshTop_t.hpp"
 #include "shapes/Triangle_t.hpp"
 #include <array>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <random>
 #include <span>
 #include <sycl/sycl.hpp>
+#include <vector>
 
 namespace AGPTracer::Entities {
 
@@ -25,14 +38,38 @@ namespace AGPTracer::Entities {
      * Holds an array of shapes to be intersected by rays. Those shapes are sorted in an acceleration structure owned by the scene for
      * faster intersection. The acceleration has to be built using build_acc before intersecting the scene. It can also be intersected
      * without the acceleration structure with intersect_brute, at a much slower pace when there are many shapes. Shapes can be added and
-     * removed from the scene, but these operations are costly so should be batched.
+     * removed from the scene, but these operations copy the shapes so should be batched. Acceleration structures that support it, like
+     * BVH_t, are updated in place when shapes are added or removed, otherwise they have to be built again.
+     *
+     * Meshes can also be added to the scene once, and then instanced many times. The shapes of a mesh are stored in object space in a
+     * separate buffer, and each instance only holds the index of its mesh, its transformation matrix and an optional material. Instances
+     * are sorted in a two-level acceleration structure, so that memory grows with the number of unique shapes instead of instances.
+     * Meshes can also be added from a mesh geometry, and are then stored as indexed meshes, with vertices shared between triangles and
+     * read through a 32 bit index buffer. Both kinds of meshes share the same numbering, and are instanced the same way.
+     *
+     * Triangles are traversed from intersection buffers holding only their first point and edges, kept in sync with the shapes. The
+     * shapes themselves are much larger and are only read for the closest hit, to get its material and shade it.
+     *
+     * Shapes like Triangle_t don't own their transformation matrix, but reference a matrix in a palette owned by the scene, which
+     * starts with the identity at index 0. All the triangles of an object share its matrix, so moving the object only writes one
+     * matrix in transformations_ before updating the scene.
+     *
+     * Shapes can be sorted along the Morton curve of their centroids with sort_shapes before building the acceleration structure, so
+     * that shapes close in space are close in memory. shape_indices_ maps the position of each shape to the index it was added at.
+     *
+     * Up to max_clip_planes_ clip planes cut away parts of the scene, for section views. Rays are restricted to the region behind all
+     * the planes before traversing the acceleration structures, so planes can be added and moved between frames without any rebuild.
      *
      * @tparam T Floating point datatype to use
      * @tparam S Shape making up the scene
+     * @tparam A Acceleration structure containing the shapes, such as a binary or a wide bounding volume hierarchy
      */
-    template<typename T = double, template<typename> typename S = Shapes::Triangle_t, template<typename> typename M = Materials::Diffuse_t, template<typename> typename D = Mediums::NonAbsorber_t>
-    requires Entities::Shape<S, T>&& Entities::Material<M, T>&& Entities::Medium<D, T> class Scene_t {
+    template<typename T = double, template<typename> typename S = Shapes::Triangle_t, template<typename> typename M = Materials::Diffuse_t, template<typename> typename D = Mediums::NonAbsorber_t,
+             template<typename> typename A = AccelerationStructures::BVH_t>
+    requires Entities::Shape<S, T>&& Entities::Material<M, T>&& Entities::Medium<D, T>&& Entities::AccelerationStructure<A, T> class Scene_t {
         public:
+            constexpr static size_t max_clip_planes_ = 8; /**< @brief Maximum number of clip planes of a scene, which are copied to each accessor.*/
+
             class Accessor_t {
                 public:
                     /**
@@ -42,8 +79,41 @@ namespace AGPTracer::Entities {
                      * @param shapes Shape buffer to access.
                      * @param materials Shape buffer to access.
                      * @param mediums Shape buffer to access.
+                     * @param mesh_shapes Mesh shape buffer to access.
+                     * @param instances Mesh instance buffer to access.
+                     * @param shape_intersections Intersection buffer of the shapes to access.
+                     * @param mesh_shape_intersections Intersection buffer of the mesh shapes to access.
+                     * @param indexed_meshes Indexed meshes to access.
+                     * @param acc Acceleration structure to access.
+                     * @param instance_acc Instance acceleration structure to access.
+                     * @param clip_planes Clip planes restricting the rays, at most max_clip_planes_.
+                     * @param cached_levels Number of levels of the acceleration structure to copy to local memory, if it supports it. 0 disables the cache.
+                     */
+                    Accessor_t(sycl::handler& cgh,
+                               sycl::buffer<S<T>, 1>& shapes,
+                               sycl::buffer<M<T>, 1>& materials,
+                               sycl::buffer<D<T>, 1>& mediums,
+                               sycl::buffer<S<T>, 1>& mesh_shapes,
+                               sycl::buffer<Shapes::MeshTop_t<T>, 1>& instances,
+                               IntersectionBuffer_t<T>& shape_intersections,
+                               IntersectionBuffer_t<T>& mesh_shape_intersections,
+                               Shapes::IndexedMesh_t<T>& indexed_meshes,
+                               A<T>& acc,
+                               AccelerationStructures::InstanceBVH_t<T>& instance_acc,
+                               std::span<const ClipPlane_t<T>> clip_planes,
+                               size_t cached_levels = 0);
+
+                    /**
+                     * @brief Copies the top levels of the acceleration structure to the local memory of the work-group.
+                     *
+                     * All the work items of the group have to call this before querying the scene, if the accessor was created with
+                     * cached levels. Does nothing otherwise, or if the acceleration structure can't be cached.
+                     *
+                     * @tparam Dims Number of dimensions of the kernel
+                     * @param item Work item calling the function.
                      */
-                    Accessor_t(sycl::handler& cgh, sycl::buffer<S<T>, 1>& shapes, sycl::buffer<M<T>, 1>& materials, sycl::buffer<D<T>, 1>& mediums);
+                    template<int Dims>
+                    auto load(const sycl::nd_item<Dims>& item) const -> void;
 
                     /**
                      * @brief Intersects the ray with objects in the scene and bounces it on their material.
@@ -54,7 +124,8 @@ namespace AGPTracer::Entities {
                      * up to max_bounces times, or until no object is it, at which point the skybox is intersected.
                      * The ray is also modified by its first medium using the scatter function. If it is scattered,
                      * it won't be bounced on the hit object's material, as it intersects the medium instead of
-                     * the object.
+                     * the object. After the first iteration, the visibility of the ray is set to secondary, so that
+                     * shapes and instances can be hidden from either camera rays or bounced rays.
                      *
                      * @tparam R Random generator type
                      * @tparam U Random distribution type to use
@@ -69,6 +140,27 @@ namespace AGPTracer::Entities {
                     template<class R, template<typename> typename U, template<typename> typename K, size_t N>
                     requires Entities::Skybox<K, T> auto raycast(R& rng, U<T>& unif, Ray_t<T, N>& ray, unsigned int max_bounces, const K<T>& skybox) const -> void;
 
+                    /**
+                     * @brief Bounces the ray on objects in the scene, starting from a first hit that is already known.
+                     *
+                     * This is the same as raycast, except that the first intersection of the ray is given instead of being
+                     * computed, for example when it was found by a packet of rays. The following bounces are intersected one
+                     * ray at a time.
+                     *
+                     * @tparam R Random generator type
+                     * @tparam U Random distribution type to use
+                     * @tparam K Skybox type to intersect
+                     * @tparam N Number of mediums in the ray's medium list
+                     * @param[in] rng Random generator used to get random numbers.
+                     * @param[in] unif Uniform distribution used to get random numbers.
+                     * @param[in] ray Ray to intersect with the scene.
+                     * @param[in] max_bounces Upper bound of number of bounces. Number of bounces may be less if no object is hit or ray can't be illuminated anymore.
+                     * @param[in] skybox Skybox that will be intersected if no object is hit.
+                     * @param[in] hit Closest hit of the ray with the scene, from its current origin and direction.
+                     */
+                    template<class R, template<typename> typename U, template<typename> typename K, size_t N>
+                    requires Entities::Skybox<K, T> auto raycast(R& rng, U<T>& unif, Ray_t<T, N>& ray, unsigned int max_bounces, const K<T>& skybox, Hit_t<T> hit) const -> void;
+
                     /**
                      * @brief Intersects the scene shapes directly one by one. Not to be used for general operation.
                      *
@@ -76,27 +168,219 @@ namespace AGPTracer::Entities {
                      * @param[in] ray Ray to be intersected with the scene, using its current origin and direction.
                      * @param[out] t Distance to intersection. It is stored in t if there is an intersection.
                      * @param[out] uv 2D object-space coordinates of the intersection.
+                     * @param[in] flags Flags changing how the shapes are intersected.
                      * @return std::optional<size_t> Index of the intersected shape. Returns none if there is no intersection.
                      */
                     template<size_t N>
-                    auto intersect_brute(const Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv) const -> std::optional<size_t>;
+                    auto intersect_brute(const Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv, RayFlags_t flags = RayFlags_t::none) const -> std::optional<size_t>;
 
                     /**
                      * @brief Intersects the scene using the acceleration structure. Main way to intersect shapes.
                      *
+                     * Only the shapes of the scene are intersected, not the mesh instances. Hits clipped away by the clip planes
+                     * are ignored, as in all the other queries except intersect_brute.
+                     *
                      * @tparam N Number of mediums in the ray's medium list
                      * @param[in] ray Ray to be intersected with the scene, using its current origin and direction.
                      * @param[out] t Distance to intersection. It is stored in t if there is an intersection.
                      * @param[out] uv 2D object-space coordinates of the intersection.
-                     * @return std::optional<std::reference_wrapper<S<T>>> Reference to the intersected shape. Returns none if there is no intersection.
+                     * @param[in] flags Flags changing how the shapes are intersected.
+                     * @return std::optional<size_t> Index of the intersected shape. Returns none if there is no intersection.
                      */
-                    // template<size_t N>
-                    // auto intersect(const Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv) const -> std::optional<std::reference_wrapper<S<T>>>;
+                    template<size_t N>
+                    auto intersect(const Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv, RayFlags_t flags = RayFlags_t::none) const -> std::optional<size_t>;
+
+                    /**
+                     * @brief Intersects the shapes and the mesh instances of the scene using the acceleration structures.
+                     *
+                     * @tparam N Number of mediums in the ray's medium list
+                     * @param[in] ray Ray to be intersected with the scene, using its current origin and direction.
+                     * @param[out] t Distance to intersection. It is stored in t if there is an intersection.
+                     * @param[out] uv 2D object-space coordinates of the intersection.
+                     * @param[out] instance Index of the intersected mesh instance. None if a shape of the scene is intersected, or if there is no intersection.
+                     * @param[in] flags Flags changing how the shapes and instances are intersected.
+                     * @return std::optional<size_t> Index of the intersected shape, in mesh_shapes_ if an instance is intersected and in shapes_ otherwise. Returns none if there is no intersection.
+                     */
+                    template<size_t N>
+                    auto intersect(const Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv, std::optional<size_t>& instance, RayFlags_t flags = RayFlags_t::none) const -> std::optional<size_t>;
+
+                    /**
+                     * @brief Returns whether anything in the scene, shapes or mesh instances, is hit by the ray closer than a distance.
+                     *
+                     * The traversal stops at the first hit found, instead of looking for the closest one, which makes this much
+                     * cheaper than intersect for shadow rays, ambient occlusion and other visibility tests.
+                     *
+                     * @tparam N Number of mediums in the ray's medium list
+                     * @param[in] ray Ray to be intersected with the scene, using its current origin and direction.
+                     * @param[in] t_max Distance past which hits are ignored, for example the distance to a light.
+                     * @param[in] flags Flags changing how the shapes and instances are intersected. The traversal always terminates on the first hit.
+                     * @return true Something is hit closer than t_max.
+                     * @return false Nothing is hit closer than t_max.
+                     */
+                    template<size_t N>
+                    auto occluded(const Ray_t<T, N>& ray, T t_max, RayFlags_t flags = RayFlags_t::none) const -> bool;
+
+                    /**
+                     * @brief Intersects the shapes and the mesh instances of the scene, and returns the closest hit as a hit record.
+                     *
+                     * @tparam N Number of mediums in the ray's medium list
+                     * @param[in] ray Ray to be intersected with the scene, using its current origin and direction.
+                     * @param[in] flags Flags changing how the shapes and instances are intersected.
+                     * @return Hit_t<T> Closest hit of the ray, with the shape, instance and material hit. Its shape is Hit_t<T>::none_ if there is no intersection.
+                     */
+                    template<size_t N>
+                    auto query(const Ray_t<T, N>& ray, RayFlags_t flags = RayFlags_t::none) const -> Hit_t<T>;
+
+                    /**
+                     * @brief Intersects a packet of coherent rays with the shapes and the mesh instances of the scene, and writes the closest hit of each ray.
+                     *
+                     * The shapes of the scene are intersected with a single traversal for the whole packet if the acceleration
+                     * structure supports it, and one ray at a time otherwise. Mesh instances are always intersected one ray at a time.
+                     * The closest hit is always found, terminate_on_first_hit is ignored. When the scene has clip planes, the rays
+                     * start at different distances, and are all intersected one at a time.
+                     *
+                     * @tparam N Number of mediums in the rays' medium list
+                     * @tparam P Maximum number of rays in the packet
+                     * @param[in] rays Rays of the packet, using their current origin and direction.
+                     * @param[in] n_rays Number of rays used in the packet, at most P.
+                     * @param[out] hits Closest hit of each ray, with the shape, instance and material hit.
+                     * @param[in] flags Flags changing how the shapes and instances are intersected.
+                     */
+                    template<size_t N, size_t P>
+                    auto query_packet(const std::array<Ray_t<T, N>, P>& rays, size_t n_rays, std::array<Hit_t<T>, P>& hits, RayFlags_t flags = RayFlags_t::none) const -> void;
 
                 private:
                     sycl::accessor<S<T>, 1, sycl::access::mode::read> shapes_; /**< @brief Accessor to the shapes.*/
                     sycl::accessor<M<T>, 1, sycl::access::mode::read> materials_; /**< @brief Accessor to the materials.*/
                     sycl::accessor<D<T>, 1, sycl::access::mode::read> mediums_; /**< @brief Accessor to the mediums.*/
+                    sycl::accessor<S<T>, 1, sycl::access::mode::read> mesh_shapes_; /**< @brief Accessor to the shapes of the meshes.*/
+                    sycl::accessor<Shapes::MeshTop_t<T>, 1, sycl::access::mode::read> instances_; /**< @brief Accessor to the mesh instances.*/
+                    typename IntersectionBuffer_t<T>::Accessor_t shape_intersections_; /**< @brief Accessor to the points and edges of the shapes, read during traversal.*/
+                    typename IntersectionBuffer_t<T>::Accessor_t mesh_shape_intersections_; /**< @brief Accessor to the points and edges of the shapes of the meshes, read during traversal.*/
+                    typename Shapes::IndexedMesh_t<T>::Accessor_t indexed_meshes_; /**< @brief Accessor to the vertices and triangles of the indexed meshes.*/
+                    typename A<T>::Accessor_t acc_; /**< @brief Accessor to the acceleration structure.*/
+                    typename AccelerationStructures::InstanceBVH_t<T>::Accessor_t instance_acc_; /**< @brief Accessor to the instance acceleration structure.*/
+                    std::array<ClipPlane_t<T>, max_clip_planes_> clip_planes_; /**< @brief Clip planes restricting the rays, copied from the scene.*/
+                    size_t n_clip_planes_; /**< @brief Number of clip planes used in clip_planes_.*/
+
+                    /**
+                     * @brief Restricts a ray to the region kept by the clip planes.
+                     *
+                     * The region behind all the planes is convex, so the visible part of a ray is a single interval. Rays are moved
+                     * to the start of their interval before traversing, so that the acceleration structures cull the nodes before
+                     * it as they cull the nodes past t.
+                     *
+                     * @tparam N Number of mediums in the ray's medium list
+                     * @param[in] ray Ray to clip.
+                     * @param[out] t_near Distance at which the ray enters the kept region, 0 if it starts inside it.
+                     * @param[in, out] t_far Distance up to which hits are looked for. Lowered to the distance at which the ray leaves the kept region.
+                     * @return true Part of the ray before t_far is kept.
+                     * @return false The whole ray before t_far is clipped away.
+                     */
+                    template<size_t N>
+                    auto clip(const Ray_t<T, N>& ray, T& t_near, T& t_far) const -> bool;
+
+                    /**
+                     * @brief Intersects the shapes of the scene using the acceleration structure, without clipping the ray.
+                     *
+                     * @tparam N Number of mediums in the ray's medium list
+                     * @param[in] ray Ray to be intersected with the scene, using its current origin and direction.
+                     * @param[in, out] t Distance past which hits are ignored. Lowered to the distance to the intersection if there is one.
+                     * @param[out] uv 2D object-space coordinates of the intersection.
+                     * @param[in] flags Flags changing how the shapes are intersected.
+                     * @return std::optional<size_t> Index of the intersected shape. Returns none if there is no intersection.
+                     */
+                    template<size_t N>
+                    auto intersect_shapes(const Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv, RayFlags_t flags) const -> std::optional<size_t>;
+
+                    /**
+                     * @brief Intersects the shapes and the mesh instances of the scene using the acceleration structures, without clipping the ray.
+                     *
+                     * @tparam N Number of mediums in the ray's medium list
+                     * @param[in] ray Ray to be intersected with the scene, using its current origin and direction.
+                     * @param[in, out] t Distance past which hits are ignored. Lowered to the distance to the intersection if there is one.
+                     * @param[out] uv 2D object-space coordinates of the intersection.
+                     * @param[out] instance Index of the intersected mesh instance. None if a shape of the scene is intersected, or if there is no intersection.
+                     * @param[in] flags Flags changing how the shapes and instances are intersected.
+                     * @return std::optional<size_t> Index of the intersected shape, in mesh_shapes_ if an instance is intersected and in shapes_ otherwise. Returns none if there is no intersection.
+                     */
+                    template<size_t N>
+                    auto intersect_all(const Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv, std::optional<size_t>& instance, RayFlags_t flags) const -> std::optional<size_t>;
+
+                    /**
+                     * @brief Returns whether anything in the scene is hit by the ray closer than a distance, without clipping the ray.
+                     *
+                     * @tparam N Number of mediums in the ray's medium list
+                     * @param[in] ray Ray to be intersected with the scene, using its current origin and direction.
+                     * @param[in] t_max Distance past which hits are ignored.
+                     * @param[in] flags Flags changing how the shapes and instances are intersected.
+                     * @return true Something is hit closer than t_max.
+                     * @return false Nothing is hit closer than t_max.
+                     */
+                    template<size_t N>
+                    auto occluded_all(const Ray_t<T, N>& ray, T t_max, RayFlags_t flags) const -> bool;
+
+                    /**
+                     * @brief Sets the material of a hit, from its shape or from its instance if it replaces the material of its mesh.
+                     *
+                     * @param[in, out] hit Hit whose shape and instance are set, and whose material is set.
+                     */
+                    auto resolve_material(Hit_t<T>& hit) const -> void;
+
+                    /**
+                     * @brief Intersects a shape of the meshes, from the mesh shapes or from the indexed meshes depending on its index.
+                     *
+                     * Indices past the mesh shapes are triangles of the indexed meshes, offset by the number of mesh shapes.
+                     *
+                     * @tparam N Number of mediums in the ray's medium list
+                     * @param[in] index Index of the shape to intersect, in the shapes of all the meshes.
+                     * @param[in] ray Ray to be intersected with the shape, in object space.
+                     * @param[out] t Distance to intersection. Undefined if not intersected.
+                     * @param[out] uv 2D object-space coordinates of the intersection. Undefined if not intersected.
+                     * @param[in] flags Flags changing how the shape is intersected.
+                     * @return true The ray intersected the shape, and the hit isn't culled.
+                     * @return false The ray doesn't intersect the shape, or the hit is culled.
+                     */
+                    template<size_t N>
+                    auto intersect_mesh_shape(size_t index, const Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv, RayFlags_t flags) const -> bool;
+
+                    /**
+                     * @brief Intersects a single shape, ignoring the hit if it is culled by the flags.
+                     *
+                     * @tparam N Number of mediums in the ray's medium list
+                     * @param[in] shape Shape to intersect, in the same space as the ray.
+                     * @param[in] ray Ray to be intersected with the shape.
+                     * @param[out] t Distance to intersection. Undefined if not intersected.
+                     * @param[out] uv 2D object-space coordinates of the intersection. Undefined if not intersected.
+                     * @param[in] flags Flags changing how the shape is intersected.
+                     * @return true The ray intersected the shape, and the hit isn't culled.
+                     * @return false The ray doesn't intersect the shape, or the hit is culled.
+                     */
+                    template<size_t N>
+                    static auto intersect_shape(const S<T>& shape, const Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv, RayFlags_t flags) -> bool;
+
+                    /**
+                     * @brief Intersects a shape by index, from its intersection buffer if the shapes can be split and from the shape otherwise.
+                     *
+                     * @tparam N Number of mediums in the ray's medium list
+                     * @param[in] shapes Shapes from which the shape is read if it can't be intersected from the intersection buffer.
+                     * @param[in] intersections Intersection buffer built from the shapes.
+                     * @param[in] index Index of the shape to intersect, in the same space as the ray.
+                     * @param[in] ray Ray to be intersected with the shape.
+                     * @param[out] t Distance to intersection. Undefined if not intersected.
+                     * @param[out] uv 2D object-space coordinates of the intersection. Undefined if not intersected.
+                     * @param[in] flags Flags changing how the shape is intersected.
+                     * @return true The ray intersected the shape, and the hit isn't culled.
+                     * @return false The ray doesn't intersect the shape, or the hit is culled.
+                     */
+                    template<size_t N>
+                    static auto intersect_shape(const sycl::accessor<S<T>, 1, sycl::access::mode::read>& shapes,
+                                                const typename IntersectionBuffer_t<T>::Accessor_t& intersections,
+                                                size_t index,
+                                                const Ray_t<T, N>& ray,
+                                                T& t,
+                                                std::array<T, 2>& uv,
+                                                RayFlags_t flags) -> bool;
             };
 
             /**
@@ -113,39 +397,61 @@ namespace AGPTracer::Entities {
              */
             Scene_t(std::span<S<T>> shapes, std::span<M<T>> materials, std::span<D<T>> mediums);
 
-            /**
-             * @brief Construct a new Scene_t object containing a single mesh.
-             *
-             * @param mesh Mesh to add to the scene.
-             */
-            // explicit Scene_t(Shapes::MeshTop_t* mesh);
-
-            /**
-             * @brief Construct a new Scene_t object from multiple meshes.
-             *
-             * @param meshes Meshes to be added to the scene.
-             */
-            // explicit Scene_t(const std::vector<Shapes::MeshTop_t*>& meshes);
-
             sycl::buffer<S<T>, 1> shapes_; /**< @brief Vector of shapes to be drawn.*/
             sycl::buffer<M<T>, 1> materials_; /**< @brief Vector of materials for the shapes.*/
             sycl::buffer<D<T>, 1> mediums_; /**< @brief Vector of mediums for the materials.*/
-            // std::unique_ptr<AccelerationStructure_t> acc_; /**< @brief Acceleration structure containing the shapes, used to accelerate intersection.*/
+            sycl::buffer<S<T>, 1> mesh_shapes_; /**< @brief Vector of the shapes of all the meshes, in object space. Each mesh is stored once, however many times it is instanced.*/
+            sycl::buffer<Shapes::MeshTop_t<T>, 1> instances_; /**< @brief Vector of mesh instances to be drawn.*/
+            sycl::buffer<TransformMatrix_t<T>, 1> transformations_; /**< @brief Palette of transformation matrices shared by shapes, which reference them by index. Starts with the identity.*/
+            IntersectionBuffer_t<T> shape_intersections_; /**< @brief Points and edges of the shapes, the only part of them read during traversal. Rebuilt when the shapes change.*/
+            IntersectionBuffer_t<T> mesh_shape_intersections_; /**< @brief Points and edges of the shapes of the meshes, the only part of them read during traversal.*/
+            std::vector<uint32_t> shape_indices_; /**< @brief Index of each shape in the order shapes were added to the scene, at its current position in shapes_.*/
+            uint32_t next_shape_index_; /**< @brief Index given to the next shape added to the scene. Indices of removed shapes are not reused.*/
+            std::vector<size_t> mesh_offsets_; /**< @brief Index of the first shape of each mesh in mesh_shapes_, followed by the total number of mesh shapes.*/
+            Shapes::IndexedMesh_t<T> indexed_meshes_; /**< @brief Vertices and triangles of the meshes added from mesh geometries, in object space.*/
+            std::vector<std::optional<size_t>> indexed_mesh_indices_; /**< @brief Index of each mesh in indexed_meshes_, or none if its shapes are in mesh_shapes_.*/
+            A<T> acc_; /**< @brief Acceleration structure containing the shapes, used to accelerate intersection.*/
+            AccelerationStructures::InstanceBVH_t<T> instance_acc_; /**< @brief Two-level acceleration structure containing the meshes and their instances.*/
+            std::array<ClipPlane_t<T>, max_clip_planes_> clip_planes_{}; /**< @brief Clip planes cutting away parts of the scene. Planes can be moved by changing them directly.*/
+            size_t n_clip_planes_ = 0; /**< @brief Number of clip planes used in clip_planes_.*/
 
             /**
              * @brief Adds a single shape to the scene.
              *
+             * An incremental acceleration structure is updated on a new queue, see the overload taking a queue.
+             *
              * @param shape Shape to be added to the scene.
              */
             auto add(S<T> shape) -> void;
 
+            /**
+             * @brief Adds a single shape to the scene, updating an incremental acceleration structure on the given queue.
+             *
+             * @param queue Queue on which to insert the shape in the acceleration structure, usually the one used to update and render the scene.
+             * @param shape Shape to be added to the scene.
+             */
+            auto add(sycl::queue& queue, S<T> shape) -> void;
+
             /**
              * @brief Adds several shapes to the scene.
              *
+             * An incremental acceleration structure is updated on a new queue, see the overload taking a queue.
+             *
              * @param shapes Array of shapes to be added to the scene.
              */
             auto add(std::span<S<T>> shapes) -> void;
 
+            /**
+             * @brief Adds several shapes to the scene, updating an incremental acceleration structure on the given queue.
+             *
+             * Using the queue that updates and renders the scene keeps the acceleration structure on its device, so only the
+             * nodes on the way of the new shapes are touched.
+             *
+             * @param queue Queue on which to insert the shapes in the acceleration structure.
+             * @param shapes Array of shapes to be added to the scene.
+             */
+            auto add(sycl::queue& queue, std::span<S<T>> shapes) -> void;
+
             /**
              * @brief Adds a single material to the scene.
              *
@@ -175,18 +481,77 @@ namespace AGPTracer::Entities {
             auto add(std::span<D<T>> mediums) -> void;
 
             /**
-             * @brief Adds a single mesh to the scene.
+             * @brief Adds a mesh to the scene, which can then be instanced.
+             *
+             * The shapes are stored once in object space, and are only drawn through instances of the mesh.
              *
-             * @param mesh Mesh to be added to the scene.
+             * @param shapes Shapes making up the mesh, in object space.
+             * @return size_t Index of the mesh, used by its instances.
              */
-            // auto add(Shapes::MeshTop_t* mesh) -> void;
+            auto add_mesh(std::span<S<T>> shapes) -> size_t;
 
             /**
-             * @brief Adds multiple meshes to the scene.
+             * @brief Adds an indexed mesh to the scene from a mesh geometry, which can then be instanced.
              *
-             * @param meshes Array of meshes to be added to the scene.
+             * The faces of the geometry are stored as triangles indexing shared vertices, instead of as shapes. Hits on them
+             * have a shape index past the mesh shapes, the number of mesh shapes plus the index of the triangle in indexed_meshes_.
+             *
+             * @param geometry Geometry of the mesh, in object space.
+             * @param material Material of all the triangles of the mesh.
+             * @return size_t Index of the mesh, used by its instances.
              */
-            // auto add(const std::vector<Shapes::MeshTop_t*>& meshes) -> void;
+            auto add_mesh(const MeshGeometry_t<T>& geometry, size_t material) -> size_t;
+
+            /**
+             * @brief Adds a single mesh instance to the scene.
+             *
+             * @param instance Mesh instance to be added to the scene.
+             */
+            auto add(Shapes::MeshTop_t<T> instance) -> void;
+
+            /**
+             * @brief Adds multiple mesh instances to the scene.
+             *
+             * @param instances Array of mesh instances to be added to the scene.
+             */
+            auto add(std::span<Shapes::MeshTop_t<T>> instances) -> void;
+
+            /**
+             * @brief Adds a single clip plane to the scene.
+             *
+             * Nothing is rebuilt, the plane is used from the next accessor. If the scene already has max_clip_planes_ planes,
+             * the plane is ignored.
+             *
+             * @param plane Clip plane to be added to the scene.
+             * @return bool Whether the plane was added.
+             */
+            auto add(ClipPlane_t<T> plane) -> bool;
+
+            /**
+             * @brief Adds several clip planes to the scene, for example the six planes of a box.
+             *
+             * If they don't all fit within max_clip_planes_, none of them is added.
+             *
+             * @param planes Array of clip planes to be added to the scene.
+             * @return bool Whether the planes were added.
+             */
+            auto add(std::span<const ClipPlane_t<T>> planes) -> bool;
+
+            /**
+             * @brief Adds a transformation matrix to the palette, to be referenced by shapes.
+             *
+             * @param transformation Transformation matrix to be added to the palette.
+             * @return size_t Index of the matrix in the palette, used by the shapes it transforms.
+             */
+            auto add_transformation(TransformMatrix_t<T> transformation) -> size_t;
+
+            /**
+             * @brief Adds several transformation matrices to the palette, to be referenced by shapes.
+             *
+             * @param transformations Array of transformation matrices to be added to the palette.
+             * @return size_t Index of the first matrix in the palette, the others follow it.
+             */
+            auto add_transformations(std::span<const TransformMatrix_t<T>> transformations) -> size_t;
 
             /**
              * @brief Removes a single shape from the scene.
@@ -202,6 +567,26 @@ namespace AGPTracer::Entities {
              */
             auto remove(std::span<S<T>> shapes) -> void;
 
+            /**
+             * @brief Removes shapes from the scene by index.
+             *
+             * The last shape takes the index of each removed shape, going through them from the last to the first, so that
+             * only a few shapes change index. An incremental acceleration structure is updated to match, without a rebuild.
+             *
+             * An incremental acceleration structure is updated on a new queue, see the overload taking a queue.
+             *
+             * @param indices Indices of the shapes to be removed from the scene.
+             */
+            auto remove_shapes(std::span<const size_t> indices) -> void;
+
+            /**
+             * @brief Removes shapes from the scene by index, updating an incremental acceleration structure on the given queue.
+             *
+             * @param queue Queue on which to remove the shapes from the acceleration structure, usually the one used to update and render the scene.
+             * @param indices Indices of the shapes to be removed from the scene.
+             */
+            auto remove_shapes(sycl::queue& queue, std::span<const size_t> indices) -> void;
+
             /**
              * @brief Removes a single material from the scene.
              *
@@ -231,44 +616,71 @@ namespace AGPTracer::Entities {
             auto remove(std::span<D<T>> mediums) -> void;
 
             /**
-             * @brief Removes a mesh from the scene.
+             * @brief Removes all the clip planes of the scene, so that the whole scene is visible again.
+             */
+            auto clear_clip_planes() -> void;
+
+            /**
+             * @brief Updates all the shapes in the scene.
              *
-             * This works by finding the first shape pointer of the mesh and deleting it and the n_tris next shapes.
-             * This works fine if the mesh is added with add and if the triangles of the mesh are not added individually
-             * out of order.
+             * Called to update all the shapes in the structure if their transformation matrix
+             * has changed. Shapes referencing a matrix in the palette read it from transformations_,
+             * which must hold the index of every shape. The acceleration structure is then refitted to the updated shapes in
+             * the same queue, or rebuilt on the device if shapes were added or removed, or if
+             * refitting degraded it too much. The bounding boxes of the mesh instances are then
+             * updated from their transformation matrices, and the top level of the instance
+             * acceleration structure is refitted or rebuilt.
              *
-             * @param mesh Mesh to be removed from the scene.
+             * @param queue Queue on which to submit the update.
              */
-            // auto remove(Shapes::MeshTop_t* mesh) -> void;
+            auto update(sycl::queue& queue) -> void;
 
             /**
-             * @brief Removes multiple meshes from the scene.
+             * @brief Builds an acceleration structure with the scene's shapes.
              *
-             * This works by finding the first shape pointer of the meshes and deleting it and the n_tris next shapes.
-             * This works fine if the meshes are added with add and if the triangles of the meshes are not added individually
-             * out of order.
+             * The acceleration structure is a bounding volume hierarchy built with the binned surface area heuristic.
+             * It has to be rebuilt when shapes are added or removed, or when they are moved by update.
+             * The hierarchies of the meshes and of their instances are also built. They have to be rebuilt
+             * when meshes are added.
+             */
+            auto build_acc() -> void;
+
+            /**
+             * @brief Builds an acceleration structure with the scene's shapes, or loads it from a cache if the same shapes were built before.
              *
-             * @param meshes Array of meshes to be removed from the scene.
+             * This is only available with acceleration structures that can be cached, like BVH_t. The hierarchies of the meshes
+             * and of their instances are built as with build_acc.
+             *
+             * @param cache Cache in which to look for the acceleration structure, and to write it if it isn't found.
+             * @return true The acceleration structure was loaded from the cache.
+             * @return false The acceleration structure was built.
              */
-            // auto remove(const std::vector<Shapes::MeshTop_t*>& meshes) -> void;
+            auto build_acc(const AccelerationStructures::BVHCache_t<T>& cache) -> bool;
 
             /**
-             * @brief Updates all the shapes in the scene.
+             * @brief Reorders the nodes of the acceleration structure in treelets, and the shapes in the order of the leaves.
              *
-             * Called to update all the shapes in the structure if their transformation matrix
-             * has changed.
+             * This is only available with acceleration structures that can be reordered, like BVH_t, after they are built.
+             * Shapes hit by the same rays end up close to each other in memory. The indices of the shapes change, so indices
+             * kept from before are no longer valid.
              *
-             * @param queue Queue on which to submit the update.
+             * @param treelet_size Size of a treelet of nodes in bytes, for example the size of a page or of a few cache lines.
              */
-            auto update(sycl::queue& queue) -> void;
+            auto reorder(size_t treelet_size = 4096) -> void;
 
             /**
-             * @brief Builds an acceleration structure with the scene's shapes.
+             * @brief Sorts the shapes on the device along the Morton curve of their centroids, so that shapes close in space are close in memory.
              *
-             * The type of the acceleration structure will be AccelerationMultiGridVector_t, the highest performing
-             * one for most (static) scenes.
+             * Shapes are often given in an order unrelated to their position, like the order of the faces of a file. Sorting them makes
+             * the shapes read by a ray, or by neighbouring rays, share cache lines, during traversal and shading. The acceleration
+             * structure keeps the way it was built: a hierarchy only has its shape indices renumbered, on the device, and other
+             * structures are built again. The positions of the shapes change, but shape_indices_ keeps the index of each shape in
+             * the order it was added, so that hits can be mapped back to the shapes given by the caller.
+             *
+             * @param queue Queue on which to submit the sort.
+             * @return T Mean distance between the centroids of consecutive shapes in memory before sorting, divided by the same distance after. Above 1 when locality improved.
              */
-            // auto build_acc() -> void;
+            auto sort_shapes(sycl::queue& queue) -> T;
 
             /**
              * @brief Intersects the scene shapes directly one by one. Not to be used for general operation.
@@ -291,10 +703,48 @@ namespace AGPTracer::Entities {
              * @param[in] ray Ray to be intersected with the scene, using its current origin and direction.
              * @param[out] t Distance to intersection. It is stored in t if there is an intersection.
              * @param[out] uv 2D object-space coordinates of the intersection.
-             * @return std::optional<std::reference_wrapper<S<T>>> Reference to the intersected shape. Returns none if there is no intersection.
+             * @return std::optional<size_t> Index of the intersected shape. Returns none if there is no intersection.
+             */
+            template<size_t N>
+            auto intersect(sycl::handler& cgh, const Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv) -> std::optional<size_t>;
+
+            /**
+             * @brief Intersects a batch of rays with the scene, and writes the closest hit of each ray.
+             *
+             * This is the entry point for ray queries that don't render an image, such as line of sight or view factors. Rays
+             * are only given by their origin and direction, so no image or random generator is needed. All the rays are
+             * intersected by a single kernel submitted to the queue. The acceleration structures have to be built first.
+             * Nothing is submitted if there are fewer directions or hits than origins.
+             *
+             * @param queue Queue on which to submit the queries.
+             * @param origins Origins of the rays.
+             * @param directions Directions of the rays, one per origin. Distances to the hits are in units of their length.
+             * @param hits Buffer in which the closest hit of each ray is written, with at least one element per origin.
+             * @param flags Flags changing how the shapes and instances are intersected.
+             * @param visibility Visibility mask of the rays, compared with the masks of the shapes and instances.
+             */
+            auto intersect(sycl::queue& queue,
+                           sycl::buffer<Vec3<T>, 1>& origins,
+                           sycl::buffer<Vec3<T>, 1>& directions,
+                           sycl::buffer<Hit_t<T>, 1>& hits,
+                           RayFlags_t flags    = RayFlags_t::none,
+                           uint32_t visibility = Visibility::all) -> void;
+
+            /**
+             * @brief Intersects a batch of rays stored on the host with the scene, and returns the closest hit of each ray.
+             *
+             * The rays are copied to buffers and intersected as with the buffer version, and the hits are copied back. If
+             * there isn't one direction per origin, no ray is intersected and no hit is returned.
+             *
+             * @param queue Queue on which to submit the queries.
+             * @param origins Origins of the rays.
+             * @param directions Directions of the rays, one per origin. Distances to the hits are in units of their length.
+             * @param flags Flags changing how the shapes and instances are intersected.
+             * @param visibility Visibility mask of the rays, compared with the masks of the shapes and instances.
+             * @return std::vector<Hit_t<T>> Closest hit of each ray.
              */
-            // template<size_t N>
-            // auto intersect(sycl::handler& cgh, const Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv) const -> std::optional<std::reference_wrapper<S<T>>>;
+            auto intersect(sycl::queue& queue, std::span<const Vec3<T>> origins, std::span<const Vec3<T>> directions, RayFlags_t flags = RayFlags_t::none, uint32_t visibility = Visibility::all)
+                -> std::vector<Hit_t<T>>;
 
             /**
              * @brief Intersects the ray with objects in the scene and bounces it on their material.
@@ -326,6 +776,39 @@ namespace AGPTracer::Entities {
              * @return Accessor_t Accessor that can be used on the device to query the scene
              */
             auto getAccessor(sycl::handler& cgh) -> Accessor_t;
+
+            /**
+             * @brief Get a Accessor_t object attached to this scene, which caches the top levels of the acceleration structure in local memory
+             *
+             * The accessor can only be used in kernels launched over an nd_range, and has to be loaded by each work-group before
+             * querying the scene. Acceleration structures that can't be cached are accessed as usual.
+             *
+             * @param cgh Device handler.
+             * @param cached_levels Number of levels of the acceleration structure to copy to local memory.
+             * @return Accessor_t Accessor that can be used on the device to query the scene
+             */
+            auto getAccessor(sycl::handler& cgh, size_t cached_levels) -> Accessor_t;
+
+            /**
+             * @brief Gives the number of levels of the acceleration structure that can be cached in the local memory of a device.
+             *
+             * @param device Device on which the accessor caching the levels is to be used.
+             * @return size_t Largest number of levels to give to getAccessor for this device. 0 if the acceleration structure can't be cached.
+             */
+            auto max_cached_levels(const sycl::device& device) const -> size_t;
+
+        private:
+            /**
+             * @brief Builds the hierarchies of the meshes, from the mesh shapes or from the indexed meshes, and of their instances.
+             */
+            auto build_instance_acc() -> void;
+
+            /**
+             * @brief Computes the mean distance between the centroids of consecutive shapes in memory, a measure of their locality.
+             *
+             * @return T Mean distance between the centroids of consecutive shapes.
+             */
+            auto neighbour_distance() -> T;
     };
 }
 
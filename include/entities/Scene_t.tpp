@@ -1,12 +1,32 @@
 #include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iostream>
 #include <limits>
-
-template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
-requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>
-AGPTracer::Entities::Scene_t<T, S, M, D>::Scene_t(std::span<S<T>> shapes, std::span<M<T>> materials, std::span<D<T>> mediums) :
-        shapes_(shapes.size()), materials_(materials.size()), mediums_(mediums.size()) {
-    const sycl::host_accessor<S<T>, 1, sycl::access_mode::write> shape_accessor(shapes_, sycl::no_init);
-    std::copy(shapes.begin(), shapes.end(), shape_accessor.begin());
+#include <numeric>
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&& AGPTracer::Entities::AccelerationStructure<A, T>
+AGPTracer::Entities::Scene_t<T, S, M, D, A>::Scene_t(std::span<S<T>> shapes, std::span<M<T>> materials, std::span<D<T>> mediums) :
+        shapes_(shapes.size()),
+        materials_(materials.size()),
+        mediums_(mediums.size()),
+        mesh_shapes_(sycl::range<1>{0}),
+        instances_(sycl::range<1>{0}),
+        transformations_(sycl::range<1>{1}),
+        next_shape_index_(static_cast<uint32_t>(shapes.size())),
+        mesh_offsets_{0} {
+    {
+        const sycl::host_accessor<TransformMatrix_t<T>, 1, sycl::access_mode::write> transformation_accessor(transformations_, sycl::no_init);
+        transformation_accessor[0] = TransformMatrix_t<T>();
+    }
+    shape_indices_.resize(shapes.size());
+    std::iota(shape_indices_.begin(), shape_indices_.end(), uint32_t{0});
+    {
+        const sycl::host_accessor<S<T>, 1, sycl::access_mode::write> shape_accessor(shapes_, sycl::no_init);
+        std::copy(shapes.begin(), shapes.end(), shape_accessor.begin());
+    }
+    shape_intersections_.build(shapes_);
 
     const sycl::host_accessor<M<T>, 1, sycl::access_mode::write> material_accessor(materials_, sycl::no_init);
     std::copy(materials.begin(), materials.end(), material_accessor.begin());
@@ -15,61 +35,75 @@ AGPTracer::Entities::Scene_t<T, S, M, D>::Scene_t(std::span<S<T>> shapes, std::s
     std::copy(mediums.begin(), mediums.end(), medium_accessor.begin());
 }
 
-/*template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
-requires AGPTracer::Entities::Shape<S, T> && AGPTracer::Entities::Medium<D, T>
-AGPTracer::Entities::Scene_t<T, S, M, D>::Scene_t(MeshTop_t* mesh) : shapes_(mesh->triangles_.size()) {
-    for (size_t i = 0; i < mesh->triangles_.size(); ++i) {
-        shapes_[i] = mesh->triangles_[i].get();
-    }
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::add(S<T> shape) -> void {
+    sycl::queue queue(sycl::default_selector_v);
+    add(queue, shape);
 }
 
-template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
-requires AGPTracer::Entities::Shape<S, T> && AGPTracer::Entities::Medium<D, T>
-AGPTracer::Entities::Scene_t<T, S, M, D>::Scene_t(const std::vector<MeshTop_t*>& meshes) {
-    size_t additional_size = 0;
-    for (const auto& mesh: meshes) {
-        additional_size += mesh->triangles_.size();
-    }
-
-    shapes_ = std::vector<Shape_t*>(additional_size);
-
-    size_t index = 0;
-    for (const auto& mesh: meshes) {
-        for (size_t i = 0; i < mesh->triangles_.size(); ++i) {
-            shapes_[index + i] = mesh->triangles_[i].get();
-        }
-        index += mesh->triangles_.size();
-    }
-}*/
-
-template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
-requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T> auto AGPTracer::Entities::Scene_t<T, S, M, D>::add(S<T> shape) -> void {
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::add(sycl::queue& queue, S<T> shape) -> void {
     sycl::buffer<S<T>, 1> new_shapes(sycl::range<1>{shapes_.get_range()[0] + 1});
+    {
+        const sycl::host_accessor<S<T>, 1, sycl::access_mode::write> new_host_accessor(new_shapes, sycl::no_init);
+        const sycl::host_accessor<S<T>, 1, sycl::access_mode::read> old_host_accessor(shapes_);
 
-    const sycl::host_accessor<S<T>, 1, sycl::access_mode::write> new_host_accessor(new_shapes, sycl::no_init);
-    const sycl::host_accessor<S<T>, 1, sycl::access_mode::read> old_host_accessor(shapes_);
+        std::copy(old_host_accessor.begin(), old_host_accessor.end(), new_host_accessor.begin());
+        new_host_accessor[shapes_.get_range()[0]] = shape;
+    }
+    shape_indices_.push_back(next_shape_index_++);
 
-    std::copy(old_host_accessor.begin(), old_host_accessor.end(), new_host_accessor.begin());
-    new_host_accessor[shapes_.get_range()[0]] = shape;
+    if constexpr (IncrementalAccelerationStructure<A, T>) {
+        const std::array<Vec3<T>, 1> mins{shape.mincoord()};
+        const std::array<Vec3<T>, 1> maxs{shape.maxcoord()};
+        acc_.insert(queue, shapes_.get_range()[0], mins, maxs);
+    }
 
     shapes_ = std::move(new_shapes);
+    shape_intersections_.build(shapes_);
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::add(std::span<S<T>> shapes) -> void {
+    sycl::queue queue(sycl::default_selector_v);
+    add(queue, shapes);
 }
 
-template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
-requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T> auto AGPTracer::Entities::Scene_t<T, S, M, D>::add(std::span<S<T>> shapes) -> void {
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::add(sycl::queue& queue, std::span<S<T>> shapes) -> void {
     sycl::buffer<S<T>, 1> new_shapes(sycl::range<1>{shapes_.get_range()[0] + shapes.size()});
+    {
+        const sycl::host_accessor<S<T>, 1, sycl::access_mode::write> new_host_accessor(new_shapes, sycl::no_init);
+        const sycl::host_accessor<S<T>, 1, sycl::access_mode::read> old_host_accessor(shapes_);
 
-    const sycl::host_accessor<S<T>, 1, sycl::access_mode::write> new_host_accessor(new_shapes, sycl::no_init);
-    const sycl::host_accessor<S<T>, 1, sycl::access_mode::read> old_host_accessor(shapes_);
+        std::copy(old_host_accessor.begin(), old_host_accessor.end(), new_host_accessor.begin());
+        std::copy(shapes.begin(), shapes.end(), new_host_accessor.begin() + shapes_.get_range()[0]);
+    }
+    for (size_t i = 0; i < shapes.size(); ++i) {
+        shape_indices_.push_back(next_shape_index_++);
+    }
 
-    std::copy(old_host_accessor.begin(), old_host_accessor.end(), new_host_accessor.begin());
-    std::copy(shapes.begin(), shapes.end(), new_host_accessor.begin() + shapes_.get_range()[0]);
+    if constexpr (IncrementalAccelerationStructure<A, T>) {
+        std::vector<Vec3<T>> mins(shapes.size());
+        std::vector<Vec3<T>> maxs(shapes.size());
+        for (size_t i = 0; i < shapes.size(); ++i) {
+            mins[i] = shapes[i].mincoord();
+            maxs[i] = shapes[i].maxcoord();
+        }
+        acc_.insert(queue, shapes_.get_range()[0], mins, maxs);
+    }
 
     shapes_ = std::move(new_shapes);
+    shape_intersections_.build(shapes_);
 }
 
-template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
-requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T> auto AGPTracer::Entities::Scene_t<T, S, M, D>::add(M<T> material) -> void {
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::add(M<T> material) -> void {
     sycl::buffer<M<T>, 1> new_materials(sycl::range<1>{materials_.get_range()[0] + 1});
 
     const sycl::host_accessor<M<T>, 1, sycl::access_mode::write> new_host_accessor(new_materials, sycl::no_init);
@@ -81,9 +115,9 @@ requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&
     materials_ = std::move(new_materials);
 }
 
-template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
-requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T> auto AGPTracer::Entities::Scene_t<T, S, M, D>::add(std::span<M<T>> materials)
-    -> void {
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::add(std::span<M<T>> materials) -> void {
     sycl::buffer<M<T>, 1> new_materials(sycl::range<1>{materials_.get_range()[0] + materials.size()});
 
     const sycl::host_accessor<M<T>, 1, sycl::access_mode::write> new_host_accessor(new_materials, sycl::no_init);
@@ -95,8 +129,9 @@ requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&
     materials_ = std::move(new_materials);
 }
 
-template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
-requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T> auto AGPTracer::Entities::Scene_t<T, S, M, D>::add(D<T> medium) -> void {
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::add(D<T> medium) -> void {
     sycl::buffer<D<T>, 1> new_mediums(sycl::range<1>{mediums_.get_range()[0] + 1});
 
     const sycl::host_accessor<D<T>, 1, sycl::access_mode::write> new_host_accessor(new_mediums, sycl::no_init);
@@ -108,9 +143,9 @@ requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&
     mediums_ = std::move(new_mediums);
 }
 
-template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
-requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T> auto AGPTracer::Entities::Scene_t<T, S, M, D>::add(std::span<D<T>> mediums)
-    -> void {
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::add(std::span<D<T>> mediums) -> void {
     sycl::buffer<D<T>, 1> new_mediums(sycl::range<1>{mediums_.get_range()[0] + mediums.size()});
 
     const sycl::host_accessor<D<T>, 1, sycl::access_mode::write> new_host_accessor(new_mediums, sycl::no_init);
@@ -122,67 +157,190 @@ requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&
     mediums_ = std::move(new_mediums);
 }
 
-/*template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
-requires AGPTracer::Entities::Shape<S, T> && AGPTracer::Entities::Medium<D, T>
-auto AGPTracer::Entities::Scene_t<T, S, M, D>::add(MeshTop_t* mesh) -> void {
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::add_mesh(std::span<S<T>> shapes) -> size_t {
+    sycl::buffer<S<T>, 1> new_shapes(sycl::range<1>{mesh_shapes_.get_range()[0] + shapes.size()});
+    {
+        const sycl::host_accessor<S<T>, 1, sycl::access_mode::write> new_host_accessor(new_shapes, sycl::no_init);
+        const sycl::host_accessor<S<T>, 1, sycl::access_mode::read> old_host_accessor(mesh_shapes_);
+
+        std::copy(old_host_accessor.begin(), old_host_accessor.end(), new_host_accessor.begin());
+        std::copy(shapes.begin(), shapes.end(), new_host_accessor.begin() + mesh_shapes_.get_range()[0]);
+    }
+
+    mesh_shapes_ = std::move(new_shapes);
+    mesh_shape_intersections_.build(mesh_shapes_);
+    mesh_offsets_.push_back(mesh_offsets_.back() + shapes.size());
+    indexed_mesh_indices_.push_back(std::nullopt);
+    return mesh_offsets_.size() - 2;
+}
 
-    const size_t index = shapes_.size();
-    shapes_.resize(shapes_.size() + mesh->triangles_.size());
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::add_mesh(const MeshGeometry_t<T>& geometry, size_t material) -> size_t {
+    // Indexed meshes have no mesh shapes, so that meshes of both kinds are numbered together
+    indexed_mesh_indices_.push_back(indexed_meshes_.add(geometry, material));
+    mesh_offsets_.push_back(mesh_offsets_.back());
+    return mesh_offsets_.size() - 2;
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::add(Shapes::MeshTop_t<T> instance) -> void {
+    sycl::buffer<Shapes::MeshTop_t<T>, 1> new_instances(sycl::range<1>{instances_.get_range()[0] + 1});
+
+    const sycl::host_accessor<Shapes::MeshTop_t<T>, 1, sycl::access_mode::write> new_host_accessor(new_instances, sycl::no_init);
+    const sycl::host_accessor<Shapes::MeshTop_t<T>, 1, sycl::access_mode::read> old_host_accessor(instances_);
+
+    std::copy(old_host_accessor.begin(), old_host_accessor.end(), new_host_accessor.begin());
+    new_host_accessor[instances_.get_range()[0]] = instance;
+
+    instances_ = std::move(new_instances);
+}
 
-    for (size_t i = 0; i < mesh->triangles_.size(); ++i) {
-        shapes_[index + i] = mesh->triangles_[i].get();
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::add(std::span<Shapes::MeshTop_t<T>> instances) -> void {
+    sycl::buffer<Shapes::MeshTop_t<T>, 1> new_instances(sycl::range<1>{instances_.get_range()[0] + instances.size()});
+
+    const sycl::host_accessor<Shapes::MeshTop_t<T>, 1, sycl::access_mode::write> new_host_accessor(new_instances, sycl::no_init);
+    const sycl::host_accessor<Shapes::MeshTop_t<T>, 1, sycl::access_mode::read> old_host_accessor(instances_);
+
+    std::copy(old_host_accessor.begin(), old_host_accessor.end(), new_host_accessor.begin());
+    std::copy(instances.begin(), instances.end(), new_host_accessor.begin() + instances_.get_range()[0]);
+
+    instances_ = std::move(new_instances);
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::add(ClipPlane_t<T> plane) -> bool {
+    const std::array<ClipPlane_t<T>, 1> planes{plane};
+    return add(planes);
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::add(std::span<const ClipPlane_t<T>> planes) -> bool {
+    // A partial set of planes would clip a different region than asked, so the planes are added together or not at all
+    if (planes.size() > max_clip_planes_ - n_clip_planes_) {
+        std::cerr << "Warning: the scene has " << n_clip_planes_ << " of its maximum of " << max_clip_planes_ << " clip planes, " << planes.size()
+                  << " more can't be added. The clip planes are ignored." << std::endl;
+        return false;
     }
+    std::copy(planes.begin(), planes.end(), clip_planes_.begin() + static_cast<std::ptrdiff_t>(n_clip_planes_));
+    n_clip_planes_ += planes.size();
+    return true;
 }
 
-template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
-requires AGPTracer::Entities::Shape<S, T> && AGPTracer::Entities::Medium<D, T>
-auto AGPTracer::Entities::Scene_t<T, S, M, D>::add(const std::vector<MeshTop_t*>& meshes) -> void {
-    size_t additional_size = 0;
-    for (const auto& mesh: meshes) {
-        additional_size += mesh->triangles_.size();
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::add_transformation(TransformMatrix_t<T> transformation) -> size_t {
+    const std::array<TransformMatrix_t<T>, 1> transformations{transformation};
+    return add_transformations(transformations);
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::add_transformations(std::span<const TransformMatrix_t<T>> transformations) -> size_t {
+    const size_t first = transformations_.get_range()[0];
+    sycl::buffer<TransformMatrix_t<T>, 1> new_transformations(sycl::range<1>{first + transformations.size()});
+    {
+        const sycl::host_accessor<TransformMatrix_t<T>, 1, sycl::access_mode::write> new_host_accessor(new_transformations, sycl::no_init);
+        const sycl::host_accessor<TransformMatrix_t<T>, 1, sycl::access_mode::read> old_host_accessor(transformations_);
+
+        std::copy(old_host_accessor.begin(), old_host_accessor.end(), new_host_accessor.begin());
+        std::copy(transformations.begin(), transformations.end(), new_host_accessor.begin() + first);
+    }
+
+    transformations_ = std::move(new_transformations);
+    return first;
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::remove(S<T> shape) -> void {
+    std::vector<size_t> removed;
+    {
+        const sycl::host_accessor<S<T>, 1, sycl::access_mode::read> host_accessor(shapes_);
+        for (size_t i = 0; i < shapes_.get_range()[0]; ++i) {
+            if (host_accessor[i] == shape) {
+                removed.push_back(i);
+            }
+        }
     }
 
-    size_t index = shapes_.size();
-    shapes_.resize(shapes_.size() + additional_size);
+    remove_shapes(removed);
+}
 
-    for (const auto& mesh: meshes) {
-        for (size_t i = 0; i < mesh->triangles_.size(); ++i) {
-            shapes_[index + i] = mesh->triangles_[i].get();
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::remove(std::span<S<T>> shapes) -> void {
+    std::vector<size_t> removed;
+    {
+        const sycl::host_accessor<S<T>, 1, sycl::access_mode::read> host_accessor(shapes_);
+        for (size_t i = 0; i < shapes_.get_range()[0]; ++i) {
+            if (std::find(shapes.begin(), shapes.end(), host_accessor[i]) != shapes.end()) {
+                removed.push_back(i);
+            }
         }
-        index += mesh->triangles_.size();
     }
-}*/
 
-template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
-requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T> auto AGPTracer::Entities::Scene_t<T, S, M, D>::remove(S<T> shape) -> void {
-    const sycl::host_accessor<S<T>, 1, sycl::access_mode::read_write> host_accessor(shapes_);
+    remove_shapes(removed);
+}
 
-    host_accessor.erase(std::remove(host_accessor.begin(), host_accessor.end(), shape), host_accessor.end());
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::remove_shapes(std::span<const size_t> indices) -> void {
+    sycl::queue queue(sycl::default_selector_v);
+    remove_shapes(queue, indices);
 }
 
-template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
-requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T> auto AGPTracer::Entities::Scene_t<T, S, M, D>::remove(std::span<S<T>> shapes)
-    -> void {
-    const sycl::host_accessor<S<T>, 1, sycl::access_mode::read_write> host_accessor(shapes_);
-    auto end = host_accessor.end();
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::remove_shapes(sycl::queue& queue, std::span<const size_t> indices) -> void {
+    std::vector<uint32_t> removed(indices.size());
+    std::transform(indices.begin(), indices.end(), removed.begin(), [](size_t index) { return static_cast<uint32_t>(index); });
+    std::sort(removed.begin(), removed.end(), std::greater<>());
+    removed.erase(std::unique(removed.begin(), removed.end()), removed.end());
+
+    const size_t n_shapes = shapes_.get_range()[0];
+    sycl::buffer<S<T>, 1> new_shapes(sycl::range<1>{n_shapes - removed.size()});
+    {
+        const sycl::host_accessor<S<T>, 1, sycl::access_mode::read_write> old_host_accessor(shapes_);
+        const sycl::host_accessor<S<T>, 1, sycl::access_mode::write> new_host_accessor(new_shapes, sycl::no_init);
+
+        // The last shape takes the place of each removed shape, from the last to the first
+        size_t n_remaining = n_shapes;
+        for (const uint32_t index: removed) {
+            --n_remaining;
+            old_host_accessor[index] = old_host_accessor[n_remaining];
+            shape_indices_[index]    = shape_indices_[n_remaining];
+        }
+        shape_indices_.resize(n_remaining);
+        std::copy(old_host_accessor.begin(), old_host_accessor.begin() + static_cast<std::ptrdiff_t>(n_remaining), new_host_accessor.begin());
+    }
 
-    for (const auto& shape: shapes) {
-        end = std::remove(host_accessor.begin(), end, shape);
+    if constexpr (IncrementalAccelerationStructure<A, T>) {
+        acc_.remove(queue, n_shapes, removed);
     }
 
-    host_accessor.erase(end, host_accessor.end());
+    shapes_ = std::move(new_shapes);
+    shape_intersections_.build(shapes_);
 }
 
-template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
-requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T> auto AGPTracer::Entities::Scene_t<T, S, M, D>::remove(M<T> material) -> void {
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::remove(M<T> material) -> void {
     const sycl::host_accessor<M<T>, 1, sycl::access_mode::read_write> host_accessor(materials_);
 
     host_accessor.erase(std::remove(host_accessor.begin(), host_accessor.end(), material), host_accessor.end());
 }
 
-template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
-requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T> auto AGPTracer::Entities::Scene_t<T, S, M, D>::remove(std::span<M<T>> materials)
-    -> void {
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::remove(std::span<M<T>> materials) -> void {
     const sycl::host_accessor<M<T>, 1, sycl::access_mode::read_write> host_accessor(materials_);
     auto end = host_accessor.end();
 
@@ -193,16 +351,17 @@ requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&
     host_accessor.erase(end, host_accessor.end());
 }
 
-template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
-requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T> auto AGPTracer::Entities::Scene_t<T, S, M, D>::remove(D<T> medium) -> void {
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::remove(D<T> medium) -> void {
     const sycl::host_accessor<D<T>, 1, sycl::access_mode::read_write> host_accessor(mediums_);
 
     host_accessor.erase(std::remove(host_accessor.begin(), host_accessor.end(), medium), host_accessor.end());
 }
 
-template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
-requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T> auto AGPTracer::Entities::Scene_t<T, S, M, D>::remove(std::span<D<T>> mediums)
-    -> void {
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::remove(std::span<D<T>> mediums) -> void {
     const sycl::host_accessor<D<T>, 1, sycl::access_mode::read_write> host_accessor(mediums_);
     auto end = host_accessor.end();
 
@@ -213,56 +372,170 @@ requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&
     host_accessor.erase(end, host_accessor.end());
 }
 
-/*template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
-requires AGPTracer::Entities::Shape<S, T> && AGPTracer::Entities::Medium<D, T>
-auto AGPTracer::Entities::Scene_t<T, S, M, D>::remove(MeshTop_t* mesh) -> void {
-    if (!mesh->triangles_.empty()) {
-        const auto triangle = std::find(shapes_.begin(), shapes_.end(), mesh->triangles_[0].get());
-        if (triangle != shapes_.end()) {
-            shapes_.erase(triangle, triangle + static_cast<long long>(mesh->triangles_.size()));
-        }
-    }
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::clear_clip_planes() -> void {
+    n_clip_planes_ = 0;
 }
 
-template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
-requires AGPTracer::Entities::Shape<S, T> && AGPTracer::Entities::Medium<D, T>
-auto AGPTracer::Entities::Scene_t<T, S, M, D>::remove(const std::vector<MeshTop_t*>& meshes) -> void {
-    for (const auto& mesh: meshes) {
-        if (!mesh->triangles_.empty()) {
-            const auto triangle = std::find(shapes_.begin(), shapes_.end(), mesh->triangles_[0].get());
-            if (triangle != shapes_.end()) {
-                shapes_.erase(triangle, triangle + static_cast<long long>(mesh->triangles_.size()));
-            }
-        }
-    }
-}*/
-
-template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
-requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T> auto AGPTracer::Entities::Scene_t<T, S, M, D>::update(sycl::queue& queue) -> void {
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::update(sycl::queue& queue) -> void {
     // Size of index space for kernel
     const sycl::range<1> num_work_items{shapes_.get_range()};
 
     // Submitting command group(work) to queue
     queue.submit([&](sycl::handler& cgh) {
         // Getting read write access to the buffer on a device
-        auto accessor = shapes_.get_access<sycl::access::mode::read_write>(cgh);
+        auto accessor = shapes_.template get_access<sycl::access::mode::read_write>(cgh);
 
         // Executing kernel
-        cgh.parallel_for<class UpdateScene>(num_work_items, [=](sycl::id<1> WIid) { accessor[WIid].update(); });
+        if constexpr (PaletteTransformable<S, T>) {
+            auto transformation_accessor = transformations_.template get_access<sycl::access::mode::read>(cgh);
+            cgh.parallel_for<class UpdateScene>(num_work_items, [=](sycl::id<1> WIid) { accessor[WIid].update(transformation_accessor[accessor[WIid].transformation_]); });
+        }
+        else {
+            cgh.parallel_for<class UpdateScene>(num_work_items, [=](sycl::id<1> WIid) { accessor[WIid].update(); });
+        }
     });
+
+    shape_intersections_.update(queue, shapes_);
+    acc_.update(queue, shapes_);
+    instance_acc_.update(queue, instances_);
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::build_acc() -> void {
+    acc_.build(shapes_);
+    build_instance_acc();
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::build_acc(const AccelerationStructures::BVHCache_t<T>& cache) -> bool {
+    const bool cached = acc_.build(shapes_, cache);
+    build_instance_acc();
+    return cached;
 }
 
-/*template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
-requires AGPTracer::Entities::Shape<S, T> && AGPTracer::Entities::Medium<D, T>
-auto AGPTracer::Entities::Scene_t<T, S, M, D>::build_acc() -> void {
-    constexpr size_t grid_max_res          = 128;
-    constexpr size_t grid_max_cell_content = 32;
-    acc_                                   = std::make_unique<AccelerationMultiGridVector_t>(shapes_, 1, grid_max_res, grid_max_cell_content, 1);
-}*/
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::build_instance_acc() -> void {
+    // The triangles of the indexed meshes are numbered after the mesh shapes
+    const size_t n_mesh_shapes = mesh_shapes_.get_range()[0];
+    std::vector<Vec3<T>> mins(n_mesh_shapes + indexed_meshes_.size());
+    std::vector<Vec3<T>> maxs(n_mesh_shapes + indexed_meshes_.size());
+    std::vector<uint32_t> masks(n_mesh_shapes + indexed_meshes_.size(), Visibility::all);
+    {
+        const sycl::host_accessor<S<T>, 1, sycl::access_mode::read> shape_accessor(mesh_shapes_);
+        for (size_t i = 0; i < n_mesh_shapes; ++i) {
+            mins[i] = shape_accessor[i].mincoord();
+            maxs[i] = shape_accessor[i].maxcoord();
+            if constexpr (Masked<S, T>) {
+                masks[i] = shape_accessor[i].mask_;
+            }
+        }
+    }
+    indexed_meshes_.bounds(std::span<Vec3<T>>(mins).subspan(n_mesh_shapes), std::span<Vec3<T>>(maxs).subspan(n_mesh_shapes));
+
+    std::vector<std::array<size_t, 2>> meshes(indexed_mesh_indices_.size());
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        if (indexed_mesh_indices_[i]) {
+            const size_t index = indexed_mesh_indices_[i].value();
+            meshes[i]          = {n_mesh_shapes + indexed_meshes_.offsets_[index], indexed_meshes_.offsets_[index + 1] - indexed_meshes_.offsets_[index]};
+        }
+        else {
+            meshes[i] = {mesh_offsets_[i], mesh_offsets_[i + 1] - mesh_offsets_[i]};
+        }
+    }
+
+    instance_acc_.build(mins, maxs, masks, meshes, instances_);
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::reorder(size_t treelet_size) -> void {
+    const std::vector<uint32_t> order = acc_.reorder(treelet_size);
+
+    {
+        const sycl::host_accessor<S<T>, 1, sycl::access_mode::read_write> shape_accessor(shapes_);
+        const std::vector<S<T>> shapes(shape_accessor.begin(), shape_accessor.end());
+        const std::vector<uint32_t> indices(shape_indices_);
+        for (size_t i = 0; i < order.size(); ++i) {
+            shape_accessor[i] = shapes[order[i]];
+            shape_indices_[i] = indices[order[i]];
+        }
+    }
+    shape_intersections_.build(shapes_);
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::sort_shapes(sycl::queue& queue) -> T {
+    const size_t n_shapes = shapes_.get_range()[0];
+    if (n_shapes < 2) {
+        return T{1};
+    }
+    const T distance_before = neighbour_distance();
+
+    sycl::buffer<uint32_t, 1> order(sycl::range<1>{n_shapes});
+    AccelerationStructures::LBVHBuilder_t<T> builder;
+    builder.order(queue, shapes_, order);
+
+    sycl::buffer<S<T>, 1> sorted_shapes(sycl::range<1>{n_shapes});
+    queue.submit([&](sycl::handler& cgh) {
+        auto order_accessor        = order.template get_access<sycl::access::mode::read>(cgh);
+        auto shape_accessor        = shapes_.template get_access<sycl::access::mode::read>(cgh);
+        auto sorted_shape_accessor = sorted_shapes.template get_access<sycl::access::mode::discard_write>(cgh);
+
+        cgh.parallel_for<class SortShapes>(sycl::range<1>{n_shapes}, [=](sycl::id<1> WIid) { sorted_shape_accessor[WIid] = shape_accessor[order_accessor[WIid]]; });
+    });
+    shapes_ = std::move(sorted_shapes);
+    shape_intersections_.build(shapes_);
+
+    // The acceleration structure still references the shapes by their index before sorting. Structures that can't be
+    // renumbered have a single way to be built, so building them again gives the same kind of structure.
+    if constexpr (PermutableAccelerationStructure<A, T>) {
+        acc_.permute(queue, order);
+    }
+    else if constexpr (DeviceBuiltAccelerationStructure<A, T, S>) {
+        acc_.build(queue, shapes_);
+    }
+    else {
+        acc_.build(shapes_);
+    }
 
-template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
-requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T> template<size_t N>
-auto AGPTracer::Entities::Scene_t<T, S, M, D>::intersect_brute(sycl::handler& cgh, const Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv) const -> std::optional<size_t> {
+    {
+        const sycl::host_accessor<uint32_t, 1, sycl::access_mode::read> order_accessor(order);
+        const std::vector<uint32_t> indices(shape_indices_);
+        for (size_t i = 0; i < n_shapes; ++i) {
+            shape_indices_[i] = indices[order_accessor[i]];
+        }
+    }
+
+    const T distance_after = neighbour_distance();
+    return (distance_after > T{0}) ? distance_before / distance_after : T{1};
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::neighbour_distance() -> T {
+    const sycl::host_accessor<S<T>, 1, sycl::access_mode::read> shape_accessor(shapes_);
+    const size_t n_shapes = shapes_.get_range()[0];
+
+    T distance = 0;
+    for (size_t i = 1; i < n_shapes; ++i) {
+        const Vec3<T> centroid      = (shape_accessor[i].mincoord() + shape_accessor[i].maxcoord()) / T{2};
+        const Vec3<T> last_centroid = (shape_accessor[i - 1].mincoord() + shape_accessor[i - 1].maxcoord()) / T{2};
+        distance += (centroid - last_centroid).magnitude();
+    }
+    return distance / static_cast<T>(n_shapes - 1);
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&& AGPTracer::Entities::AccelerationStructure<A, T> template<size_t N>
+auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::intersect_brute(sycl::handler& cgh, const Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv) const -> std::optional<size_t> {
     T t_temp = std::numeric_limits<T>::max();
     std::array<T, 2> uv_temp{};
 
@@ -281,17 +554,65 @@ auto AGPTracer::Entities::Scene_t<T, S, M, D>::intersect_brute(sycl::handler& cg
     return hit_obj;
 }
 
-/*template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
-requires AGPTracer::Entities::Shape<S, T> && AGPTracer::Entities::Medium<D, T>
-auto AGPTracer::Entities::Scene_t<T, S, M, D>::intersect(const Ray_t& ray, double& t, std::array<double, 2>& uv) const -> Shape_t* {
-    return acc_->intersect(ray, t, uv);
-}*/
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&& AGPTracer::Entities::AccelerationStructure<A, T> template<size_t N>
+auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::intersect(sycl::handler& cgh, const Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv) -> std::optional<size_t> {
+    return getAccessor(cgh).intersect(ray, t, uv);
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&& AGPTracer::Entities::AccelerationStructure<A, T>
+auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::intersect(
+    sycl::queue& queue, sycl::buffer<Vec3<T>, 1>& origins, sycl::buffer<Vec3<T>, 1>& directions, sycl::buffer<Hit_t<T>, 1>& hits, RayFlags_t flags, uint32_t visibility) -> void {
+    if ((directions.get_range()[0] < origins.get_range()[0]) || (hits.get_range()[0] < origins.get_range()[0])) {
+        std::cerr << "Error: " << origins.get_range()[0] << " ray origins were given with " << directions.get_range()[0] << " directions and room for " << hits.get_range()[0]
+                  << " hits. No ray is intersected." << std::endl;
+        return;
+    }
+
+    queue.submit([&](sycl::handler& cgh) {
+        auto scene_accessor     = getAccessor(cgh);
+        auto origin_accessor    = origins.template get_access<sycl::access::mode::read>(cgh);
+        auto direction_accessor = directions.template get_access<sycl::access::mode::read>(cgh);
+        auto hit_accessor       = hits.template get_access<sycl::access::mode::discard_write>(cgh);
+
+        // The rays don't go through any medium, so they carry the smallest medium list
+        cgh.parallel_for<class SceneRayQuery>(origin_accessor.get_range(), [=](sycl::id<1> WIid) {
+            Ray_t<T, 1> ray(origin_accessor[WIid], direction_accessor[WIid], Vec3<T>(), Vec3<T>(T{1}), MediumList_t<1>());
+            ray.visibility_    = visibility;
+            hit_accessor[WIid] = scene_accessor.query(ray, flags);
+        });
+    });
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&& AGPTracer::Entities::AccelerationStructure<A, T>
+auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::intersect(sycl::queue& queue, std::span<const Vec3<T>> origins, std::span<const Vec3<T>> directions, RayFlags_t flags, uint32_t visibility)
+    -> std::vector<Hit_t<T>> {
+    if (origins.size() != directions.size()) {
+        std::cerr << "Error: " << origins.size() << " ray origins were given with " << directions.size() << " directions. No ray is intersected." << std::endl;
+        return {};
+    }
+    if (origins.empty()) {
+        return {};
+    }
+
+    sycl::buffer<Vec3<T>, 1> origin_buffer(origins.data(), sycl::range<1>{origins.size()});
+    sycl::buffer<Vec3<T>, 1> direction_buffer(directions.data(), sycl::range<1>{origins.size()});
+    sycl::buffer<Hit_t<T>, 1> hit_buffer(sycl::range<1>{origins.size()});
+    intersect(queue, origin_buffer, direction_buffer, hit_buffer, flags, visibility);
 
-template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
+    std::vector<Hit_t<T>> hits(origins.size());
+    const sycl::host_accessor<Hit_t<T>, 1, sycl::access_mode::read> hit_accessor(hit_buffer);
+    std::copy(hit_accessor.begin(), hit_accessor.end(), hits.begin());
+    return hits;
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
 requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&&
-    AGPTracer::Entities::Medium<D, T> template<class R, template<typename> typename U, template<typename> typename K, size_t N>
+    AGPTracer::Entities::Medium<D, T>&& AGPTracer::Entities::AccelerationStructure<A, T> template<class R, template<typename> typename U, template<typename> typename K, size_t N>
     requires AGPTracer::Entities::Skybox<K, T> auto
-    AGPTracer::Entities::Scene_t<T, S, M, D>::raycast(R& rng, U<T>& unif, sycl::handler& cgh, Ray_t<T, N>& ray, unsigned int max_bounces, const K<T>& skybox) const -> void {
+    AGPTracer::Entities::Scene_t<T, S, M, D, A>::raycast(R& rng, U<T>& unif, sycl::handler& cgh, Ray_t<T, N>& ray, unsigned int max_bounces, const K<T>& skybox) const -> void {
     unsigned int bounces = 0;
 
     constexpr T minimum_mask = 0.01;
@@ -318,50 +639,148 @@ requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&
     }
 }
 
-template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
-requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T> auto AGPTracer::Entities::Scene_t<T, S, M, D>::getAccessor(sycl::handler& cgh)
-    -> Accessor_t {
-    return Accessor_t(cgh, shapes_, materials_, mediums_);
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::getAccessor(sycl::handler& cgh) -> Accessor_t {
+    return Accessor_t(cgh,
+                      shapes_,
+                      materials_,
+                      mediums_,
+                      mesh_shapes_,
+                      instances_,
+                      shape_intersections_,
+                      mesh_shape_intersections_,
+                      indexed_meshes_,
+                      acc_,
+                      instance_acc_,
+                      std::span<const ClipPlane_t<T>>(clip_planes_.data(), n_clip_planes_));
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::getAccessor(sycl::handler& cgh, size_t cached_levels) -> Accessor_t {
+    return Accessor_t(cgh,
+                      shapes_,
+                      materials_,
+                      mediums_,
+                      mesh_shapes_,
+                      instances_,
+                      shape_intersections_,
+                      mesh_shape_intersections_,
+                      indexed_meshes_,
+                      acc_,
+                      instance_acc_,
+                      std::span<const ClipPlane_t<T>>(clip_planes_.data(), n_clip_planes_),
+                      cached_levels);
 }
 
-template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
-requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>
-AGPTracer::Entities::Scene_t<T, S, M, D>::Accessor_t::Accessor_t(sycl::handler& cgh, sycl::buffer<S<T>, 1>& shapes, sycl::buffer<M<T>, 1>& materials, sycl::buffer<D<T>, 1>& mediums) :
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::max_cached_levels(const sycl::device& device) const -> size_t {
+    if constexpr (CachedAccelerationStructure<A, T>) {
+        return A<T>::max_cached_levels(device.get_info<sycl::info::device::local_mem_size>());
+    }
+    else {
+        return 0;
+    }
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&& AGPTracer::Entities::AccelerationStructure<A, T>
+AGPTracer::Entities::Scene_t<T, S, M, D, A>::Accessor_t::Accessor_t(sycl::handler& cgh,
+                                                                    sycl::buffer<S<T>, 1>& shapes,
+                                                                    sycl::buffer<M<T>, 1>& materials,
+                                                                    sycl::buffer<D<T>, 1>& mediums,
+                                                                    sycl::buffer<S<T>, 1>& mesh_shapes,
+                                                                    sycl::buffer<Shapes::MeshTop_t<T>, 1>& instances,
+                                                                    IntersectionBuffer_t<T>& shape_intersections,
+                                                                    IntersectionBuffer_t<T>& mesh_shape_intersections,
+                                                                    Shapes::IndexedMesh_t<T>& indexed_meshes,
+                                                                    A<T>& acc,
+                                                                    AccelerationStructures::InstanceBVH_t<T>& instance_acc,
+                                                                    std::span<const ClipPlane_t<T>> clip_planes,
+                                                                    size_t cached_levels) :
         shapes_(shapes.template get_access<sycl::access::mode::read>(cgh)),
         materials_(materials.template get_access<sycl::access::mode::read>(cgh)),
-        mediums_(mediums.template get_access<sycl::access::mode::read>(cgh)) {}
+        mediums_(mediums.template get_access<sycl::access::mode::read>(cgh)),
+        mesh_shapes_(mesh_shapes.template get_access<sycl::access::mode::read>(cgh)),
+        instances_(instances.template get_access<sycl::access::mode::read>(cgh)),
+        shape_intersections_(shape_intersections.getAccessor(cgh)),
+        mesh_shape_intersections_(mesh_shape_intersections.getAccessor(cgh)),
+        indexed_meshes_(indexed_meshes.getAccessor(cgh)),
+        acc_([&]() {
+            if constexpr (CachedAccelerationStructure<A, T>) {
+                if (cached_levels > 0) {
+                    return acc.getAccessor(cgh, cached_levels);
+                }
+            }
+            return acc.getAccessor(cgh);
+        }()),
+        instance_acc_(instance_acc.getAccessor(cgh, instances)),
+        clip_planes_(),
+        n_clip_planes_(std::min(clip_planes.size(), max_clip_planes_)) {
+    std::copy(clip_planes.begin(), clip_planes.begin() + static_cast<std::ptrdiff_t>(n_clip_planes_), clip_planes_.begin());
+}
 
-template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&&
+    AGPTracer::Entities::AccelerationStructure<A, T> template<int Dims>
+    auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::Accessor_t::load(const sycl::nd_item<Dims>& item) const -> void {
+    if constexpr (CachedAccelerationStructure<A, T>) {
+        acc_.load(item);
+    }
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&&
+    AGPTracer::Entities::Medium<D, T>&& AGPTracer::Entities::AccelerationStructure<A, T> template<class R, template<typename> typename U, template<typename> typename K, size_t N>
+    requires AGPTracer::Entities::Skybox<K, T> auto
+    AGPTracer::Entities::Scene_t<T, S, M, D, A>::Accessor_t::raycast(R& rng, U<T>& unif, Ray_t<T, N>& ray, unsigned int max_bounces, const K<T>& skybox) const -> void {
+    raycast(rng, unif, ray, max_bounces, skybox, query(ray));
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
 requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&&
-    AGPTracer::Entities::Medium<D, T> template<class R, template<typename> typename U, template<typename> typename K, size_t N>
+    AGPTracer::Entities::Medium<D, T>&& AGPTracer::Entities::AccelerationStructure<A, T> template<class R, template<typename> typename U, template<typename> typename K, size_t N>
     requires AGPTracer::Entities::Skybox<K, T> auto
-    AGPTracer::Entities::Scene_t<T, S, M, D>::Accessor_t::raycast(R& rng, U<T>& unif, Ray_t<T, N>& ray, unsigned int max_bounces, const K<T>& skybox) const -> void {
+    AGPTracer::Entities::Scene_t<T, S, M, D, A>::Accessor_t::raycast(R& rng, U<T>& unif, Ray_t<T, N>& ray, unsigned int max_bounces, const K<T>& skybox, Hit_t<T> hit) const -> void {
     unsigned int bounces = 0;
 
     constexpr T minimum_mask = 0.01;
     while ((bounces < max_bounces) && (ray.mask_.magnitudeSquared() > minimum_mask)) { // Should maybe make magnitudeSquared min value lower
-        T t{};
-        std::array<T, 2> uv{};
-
-        // const std::optional<std::reference_wrapper<S<T>>> hit_obj = acc_->intersect(ray, t, uv);
-        const std::optional<size_t> hit_obj = intersect_brute(ray, t, uv);
+        if (bounces > 0) {
+            hit = query(ray);
+        }
 
-        if (!hit_obj) {
+        if (!hit.hit()) {
             ray.colour_ += ray.mask_ * skybox.get(ray.direction_);
             return;
         }
-        ray.dist_ = t;
+        ray.dist_ = hit.t_;
         ++bounces;
 
         if (!mediums_[ray.medium_list_.mediums_[0]].scatter(rng, unif, ray)) {
-            materials_[shapes_[*hit_obj].material_].bounce(rng, unif, uv, shapes_[*hit_obj], ray);
+            if ((hit.instance_ != Hit_t<T>::none_) && (hit.shape_ >= mesh_shapes_.get_range()[0])) {
+                // Triangles of indexed meshes are gathered from their vertices, then moved to world space like mesh shapes
+                const Shapes::Triangle_t<T> triangle = instances_[hit.instance_].to_world(indexed_meshes_.triangle(hit.shape_ - mesh_shapes_.get_range()[0]));
+                materials_[hit.material_].bounce(rng, unif, hit.uv_, triangle, ray);
+            }
+            else if (hit.instance_ != Hit_t<T>::none_) {
+                // Mesh shapes are in object space, so the hit shape is moved to world space to be shaded
+                const S<T> shape = instances_[hit.instance_].to_world(mesh_shapes_[hit.shape_]);
+                materials_[hit.material_].bounce(rng, unif, hit.uv_, shape, ray);
+            }
+            else {
+                materials_[hit.material_].bounce(rng, unif, hit.uv_, shapes_[hit.shape_], ray);
+            }
         }
+        ray.visibility_ = Visibility::secondary;
     }
 }
 
-template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
-requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T> template<size_t N>
-auto AGPTracer::Entities::Scene_t<T, S, M, D>::Accessor_t::intersect_brute(const Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv) const -> std::optional<size_t> {
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&& AGPTracer::Entities::AccelerationStructure<A, T> template<size_t N>
+auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::Accessor_t::intersect_brute(const Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv, RayFlags_t flags) const -> std::optional<size_t> {
     T t_temp = std::numeric_limits<T>::max();
     std::array<T, 2> uv_temp{};
 
@@ -369,18 +788,318 @@ auto AGPTracer::Entities::Scene_t<T, S, M, D>::Accessor_t::intersect_brute(const
     std::optional<size_t> hit_obj{};
 
     for (size_t i = 0; i < shapes_.get_range()[0]; ++i) {
-        if (shapes_[i].intersection(ray, t_temp, uv_temp) && (t_temp < t)) {
+        if (intersect_shape(shapes_, shape_intersections_, i, ray, t_temp, uv_temp, flags) && (t_temp < t)) {
             hit_obj = i;
             uv      = uv_temp;
             t       = t_temp;
+            if (has_flag(flags, RayFlags_t::terminate_on_first_hit)) {
+                break;
+            }
         }
     }
 
     return hit_obj;
 }
 
-/*template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D>
-requires AGPTracer::Entities::Shape<S, T> && AGPTracer::Entities::Medium<D, T>
-auto AGPTracer::Entities::Scene_t<T, S, M, D>::Accessor_t::intersect(double& t, std::array<double, 2>& uv) const -> Shape_t* {
-    return acc_->intersect(ray, t, uv);
-}*/
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&& AGPTracer::Entities::AccelerationStructure<A, T> template<size_t N>
+auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::Accessor_t::intersect(const Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv, RayFlags_t flags) const -> std::optional<size_t> {
+    T t_near{};
+    t = std::numeric_limits<T>::max();
+    if (!clip(ray, t_near, t)) {
+        return std::nullopt;
+    }
+    if (t_near == T{0}) {
+        return intersect_shapes(ray, t, uv, flags);
+    }
+
+    // The ray starts where it enters the kept region, so that the nodes before it are culled by the traversal
+    Ray_t<T, N> clipped_ray = ray;
+    clipped_ray.origin_     = ray.origin_ + ray.direction_ * t_near;
+
+    T t_clipped                         = t - t_near;
+    const std::optional<size_t> hit_obj = intersect_shapes(clipped_ray, t_clipped, uv, flags);
+    t                                   = t_clipped + t_near;
+    return hit_obj;
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&& AGPTracer::Entities::AccelerationStructure<A, T> template<size_t N>
+auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::Accessor_t::intersect(const Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv, std::optional<size_t>& instance, RayFlags_t flags) const
+    -> std::optional<size_t> {
+    T t_near{};
+    t        = std::numeric_limits<T>::max();
+    instance = std::nullopt;
+    if (!clip(ray, t_near, t)) {
+        return std::nullopt;
+    }
+    if (t_near == T{0}) {
+        return intersect_all(ray, t, uv, instance, flags);
+    }
+
+    Ray_t<T, N> clipped_ray = ray;
+    clipped_ray.origin_     = ray.origin_ + ray.direction_ * t_near;
+
+    T t_clipped                         = t - t_near;
+    const std::optional<size_t> hit_obj = intersect_all(clipped_ray, t_clipped, uv, instance, flags);
+    t                                   = t_clipped + t_near;
+    return hit_obj;
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&& AGPTracer::Entities::AccelerationStructure<A, T> template<size_t N>
+auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::Accessor_t::occluded(const Ray_t<T, N>& ray, T t_max, RayFlags_t flags) const -> bool {
+    T t_near{};
+    T t_far = t_max;
+    if (!clip(ray, t_near, t_far)) {
+        return false;
+    }
+    if (t_near == T{0}) {
+        return occluded_all(ray, t_far, flags);
+    }
+
+    Ray_t<T, N> clipped_ray = ray;
+    clipped_ray.origin_     = ray.origin_ + ray.direction_ * t_near;
+    return occluded_all(clipped_ray, t_far - t_near, flags);
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&& AGPTracer::Entities::AccelerationStructure<A, T> template<size_t N>
+auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::Accessor_t::query(const Ray_t<T, N>& ray, RayFlags_t flags) const -> Hit_t<T> {
+    Hit_t<T> hit{};
+    std::optional<size_t> instance;
+    const std::optional<size_t> hit_obj = intersect(ray, hit.t_, hit.uv_, instance, flags);
+
+    if (!hit_obj) {
+        return Hit_t<T>{};
+    }
+    hit.shape_ = static_cast<uint32_t>(*hit_obj);
+    if (instance) {
+        hit.instance_ = static_cast<uint32_t>(*instance);
+    }
+    resolve_material(hit);
+    return hit;
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&& AGPTracer::Entities::AccelerationStructure<A, T> template<size_t N, size_t P>
+auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::Accessor_t::query_packet(const std::array<Ray_t<T, N>, P>& rays, size_t n_rays, std::array<Hit_t<T>, P>& hits, RayFlags_t flags) const -> void {
+    if (n_clip_planes_ > 0) {
+        const RayFlags_t closest_flags = has_flag(flags, RayFlags_t::cull_back_faces) ? RayFlags_t::cull_back_faces : RayFlags_t::none;
+        for (size_t i = 0; i < n_rays; ++i) {
+            hits[i] = query(rays[i], closest_flags);
+        }
+        return;
+    }
+
+    std::array<T, P> t; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+    T t_temp = std::numeric_limits<T>::max();
+    std::array<T, 2> uv_temp{};
+
+    for (size_t i = 0; i < n_rays; ++i) {
+        hits[i] = Hit_t<T>{};
+        t[i]    = std::numeric_limits<T>::max();
+    }
+
+    const auto leaf = [&](size_t ray_index, size_t index, T& t_max) {
+        if (intersect_shape(shapes_, shape_intersections_, index, rays[ray_index], t_temp, uv_temp, flags) && (t_temp < t_max)) {
+            hits[ray_index].shape_ = static_cast<uint32_t>(index);
+            hits[ray_index].uv_    = uv_temp;
+            t_max                  = t_temp;
+        }
+    };
+
+    if constexpr (PacketAccelerationStructure<A, T>) {
+        acc_.traverse_packet(rays, n_rays, t, leaf);
+    }
+    else {
+        for (size_t i = 0; i < n_rays; ++i) {
+            acc_.traverse(rays[i], t[i], [&](size_t index, T& t_max) {
+                leaf(i, index, t_max);
+                return false;
+            });
+        }
+    }
+
+    for (size_t i = 0; i < n_rays; ++i) {
+        instance_acc_.traverse(rays[i], t[i], [&](size_t instance_index, size_t index, const Ray_t<T, N>& object_ray, T& t_max) {
+            if (intersect_mesh_shape(index, object_ray, t_temp, uv_temp, flags) && (t_temp < t_max)) {
+                hits[i].shape_    = static_cast<uint32_t>(index);
+                hits[i].instance_ = static_cast<uint32_t>(instance_index);
+                hits[i].uv_       = uv_temp;
+                t_max             = t_temp;
+            }
+            return false;
+        });
+
+        if (hits[i].hit()) {
+            hits[i].t_ = t[i];
+            resolve_material(hits[i]);
+        }
+    }
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&& AGPTracer::Entities::AccelerationStructure<A, T> template<size_t N>
+auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::Accessor_t::clip(const Ray_t<T, N>& ray, T& t_near, T& t_far) const -> bool {
+    t_near = T{0};
+    for (size_t i = 0; i < n_clip_planes_; ++i) {
+        clip_planes_[i].clip(ray.origin_, ray.direction_, t_near, t_far);
+    }
+    return t_near < t_far;
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&& AGPTracer::Entities::AccelerationStructure<A, T> template<size_t N>
+auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::Accessor_t::intersect_shapes(const Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv, RayFlags_t flags) const -> std::optional<size_t> {
+    T t_temp = std::numeric_limits<T>::max();
+    std::array<T, 2> uv_temp{};
+
+    std::optional<size_t> hit_obj{};
+    const bool terminate = has_flag(flags, RayFlags_t::terminate_on_first_hit);
+
+    acc_.traverse(ray, t, [&](size_t index, T& t_max) {
+        if (intersect_shape(shapes_, shape_intersections_, index, ray, t_temp, uv_temp, flags) && (t_temp < t_max)) {
+            hit_obj = index;
+            uv      = uv_temp;
+            t_max   = t_temp;
+            return terminate;
+        }
+        return false;
+    });
+
+    return hit_obj;
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&& AGPTracer::Entities::AccelerationStructure<A, T> template<size_t N>
+auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::Accessor_t::intersect_all(const Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv, std::optional<size_t>& instance, RayFlags_t flags) const
+    -> std::optional<size_t> {
+    T t_temp = std::numeric_limits<T>::max();
+    std::array<T, 2> uv_temp{};
+
+    std::optional<size_t> hit_obj = intersect_shapes(ray, t, uv, flags);
+    instance                      = std::nullopt;
+    const bool terminate          = has_flag(flags, RayFlags_t::terminate_on_first_hit);
+    if (hit_obj && terminate) {
+        return hit_obj;
+    }
+
+    instance_acc_.traverse(ray, t, [&](size_t instance_index, size_t index, const Ray_t<T, N>& object_ray, T& t_max) {
+        if (intersect_mesh_shape(index, object_ray, t_temp, uv_temp, flags) && (t_temp < t_max)) {
+            hit_obj  = index;
+            instance = instance_index;
+            uv       = uv_temp;
+            t_max    = t_temp;
+            return terminate;
+        }
+        return false;
+    });
+
+    return hit_obj;
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&& AGPTracer::Entities::AccelerationStructure<A, T> template<size_t N>
+auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::Accessor_t::occluded_all(const Ray_t<T, N>& ray, T t_max, RayFlags_t flags) const -> bool {
+    T t_temp{};
+    std::array<T, 2> uv_temp{};
+    bool hit = false;
+
+    // Any hit closer than t_max is enough, so the traversal stops at the first one and t is never lowered
+    T t = t_max;
+    acc_.traverse(ray, t, [&](size_t index, T& t_leaf) {
+        hit = intersect_shape(shapes_, shape_intersections_, index, ray, t_temp, uv_temp, flags) && (t_temp < t_leaf);
+        return hit;
+    });
+    if (hit) {
+        return true;
+    }
+
+    t = t_max;
+    instance_acc_.traverse(ray, t, [&](size_t /*instance_index*/, size_t index, const Ray_t<T, N>& object_ray, T& t_leaf) {
+        hit = intersect_mesh_shape(index, object_ray, t_temp, uv_temp, flags) && (t_temp < t_leaf);
+        return hit;
+    });
+
+    return hit;
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&& AGPTracer::Entities::AccelerationStructure<A, T>
+auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::Accessor_t::resolve_material(Hit_t<T>& hit) const -> void {
+    if ((hit.instance_ != Hit_t<T>::none_) && (hit.shape_ >= mesh_shapes_.get_range()[0])) {
+        hit.material_ = static_cast<uint32_t>(instances_[hit.instance_].material_.value_or(indexed_meshes_.material(hit.shape_ - mesh_shapes_.get_range()[0])));
+    }
+    else if (hit.instance_ != Hit_t<T>::none_) {
+        hit.material_ = static_cast<uint32_t>(instances_[hit.instance_].material_.value_or(mesh_shapes_[hit.shape_].material_));
+    }
+    else {
+        hit.material_ = static_cast<uint32_t>(shapes_[hit.shape_].material_);
+    }
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&& AGPTracer::Entities::AccelerationStructure<A, T> template<size_t N>
+auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::Accessor_t::intersect_mesh_shape(size_t index, const Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv, RayFlags_t flags) const -> bool {
+    const size_t n_mesh_shapes = mesh_shapes_.get_range()[0];
+    if (index < n_mesh_shapes) {
+        return intersect_shape(mesh_shapes_, mesh_shape_intersections_, index, ray, t, uv, flags);
+    }
+
+    // Indexed triangles have no mask of their own, their instance is already culled by its mask
+    const size_t triangle = index - n_mesh_shapes;
+    if (!indexed_meshes_.intersection(triangle, ray, t, uv)) {
+        return false;
+    }
+    return !has_flag(flags, RayFlags_t::cull_back_faces) || (indexed_meshes_.normal_face(triangle).dot(ray.direction_) < T{0});
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&& AGPTracer::Entities::AccelerationStructure<A, T> template<size_t N>
+auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::Accessor_t::intersect_shape(const S<T>& shape, const Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv, RayFlags_t flags) -> bool {
+    // Leaves hold the union of the masks of their shapes, so the shapes themselves still have to be checked
+    if constexpr (Masked<S, T>) {
+        if ((shape.mask_ & ray.visibility_) == 0) {
+            return false;
+        }
+    }
+    if (!shape.intersection(ray, t, uv)) {
+        return false;
+    }
+    if (!has_flag(flags, RayFlags_t::cull_back_faces)) {
+        return true;
+    }
+
+    // Triangles use their geometric normal, other shapes can only give their shading normal
+    if constexpr (Triangular<S, T>) {
+        return (shape.points_[1] - shape.points_[0]).cross(shape.points_[2] - shape.points_[0]).dot(ray.direction_) < T{0};
+    }
+    else {
+        return shape.normal(ray.time_, uv).dot(ray.direction_) < T{0};
+    }
+}
+
+template<typename T, template<typename> typename S, template<typename> typename M, template<typename> typename D, template<typename> typename A>
+requires AGPTracer::Entities::Shape<S, T>&& AGPTracer::Entities::Material<M, T>&& AGPTracer::Entities::Medium<D, T>&& AGPTracer::Entities::AccelerationStructure<A, T> template<size_t N>
+auto AGPTracer::Entities::Scene_t<T, S, M, D, A>::Accessor_t::intersect_shape(const sycl::accessor<S<T>, 1, sycl::access::mode::read>& shapes,
+                                                                              const typename IntersectionBuffer_t<T>::Accessor_t& intersections,
+                                                                              size_t index,
+                                                                              const Ray_t<T, N>& ray,
+                                                                              T& t,
+                                                                              std::array<T, 2>& uv,
+                                                                              RayFlags_t flags) -> bool {
+    // Only the point and edges of the triangle are fetched, the shape is read once the closest hit is known
+    if constexpr (EdgeIntersectable<S, T>) {
+        if ((intersections.mask(index) & ray.visibility_) == 0) {
+            return false;
+        }
+        if (!intersections.template intersection<S>(index, ray, t, uv)) {
+            return false;
+        }
+        return !has_flag(flags, RayFlags_t::cull_back_faces) || (intersections.normal_face(index).dot(ray.direction_) < T{0});
+    }
+    else {
+        return intersect_shape(shapes[index], ray, t, uv, flags);
+    }
+}
@@ -7,6 +7,7 @@
 #include "entities/Vec3.hpp"
 #include <array>
 #include <concepts>
+#include <cstdint>
 
 namespace AGPTracer::Entities {
     /**
@@ -52,6 +53,57 @@ namespace AGPTracer::Entities {
         { a.maxcoord() } -> std::convertible_to<Vec3<T>>;
     };
 
+    /**
+     * @brief The Moving interface describes an object that can be queried for minimum and maximum coordinates in space at a given time of the exposure.
+     *
+     * @tparam S Moving type
+     * @tparam T Floating point datatype
+     */
+    template<template<typename> typename S, typename T>
+    concept Moving = requires(const S<T> a, T time) {
+        { a.mincoord(time) } -> std::convertible_to<Vec3<T>>;
+    }
+    &&requires(const S<T> a, T time) {
+        { a.maxcoord(time) } -> std::convertible_to<Vec3<T>>;
+    };
+
+    /**
+     * @brief The Triangular interface describes an object made of a single triangle, which can be clipped by planes.
+     *
+     * @tparam S Triangular type
+     * @tparam T Floating point datatype
+     */
+    template<template<typename> typename S, typename T>
+    concept Triangular = requires(const S<T> a) {
+        { a.points_ } -> std::convertible_to<std::array<Vec3<T>, 3>>;
+    };
+
+    /**
+     * @brief The EdgeIntersectable interface describes a triangle whose intersection only depends on its first point and its two edges from that point.
+     *
+     * The point and edges of such shapes can be stored apart from the rest of their data, and intersected without the shape.
+     *
+     * @tparam S EdgeIntersectable type
+     * @tparam T Floating point datatype
+     */
+    template<template<typename> typename S, typename T>
+    concept EdgeIntersectable = Triangular<S, T> && requires(const S<T> a, const Vec3<T>& point, const Entities::Ray_t<T, 16>& ray, T& t, std::array<T, 2>& uv) {
+        { a.v0v1_ } -> std::convertible_to<Vec3<T>>;
+        { a.v0v2_ } -> std::convertible_to<Vec3<T>>;
+        { S<T>::intersection(point, a.v0v1_, a.v0v2_, ray, t, uv) } -> std::convertible_to<bool>;
+    };
+
+    /**
+     * @brief The Masked interface describes an object with a visibility mask, which is only intersected by rays whose visibility has a bit in common with it.
+     *
+     * @tparam S Masked type
+     * @tparam T Floating point datatype
+     */
+    template<template<typename> typename S, typename T>
+    concept Masked = requires(const S<T> a) {
+        { a.mask_ } -> std::convertible_to<uint32_t>;
+    };
+
     /**
      * @brief The Transformable interface describes an object that can be transformed via a transformation matrix.
      *
@@ -62,6 +114,20 @@ namespace AGPTracer::Entities {
         { a.transformation_ } -> std::convertible_to<TransformMatrix_t<T>>;
     };
 
+    /**
+     * @brief The PaletteTransformable interface describes an object whose transformation matrix is stored in a palette shared with other objects.
+     *
+     * The object holds the index of its matrix in the palette, and is given the matrix on update.
+     *
+     * @tparam S PaletteTransformable type
+     * @tparam T Floating point datatype
+     */
+    template<template<typename> typename S, typename T>
+    concept PaletteTransformable = requires(S<T> a, const TransformMatrix_t<T>& transformation) {
+        { a.transformation_ } -> std::convertible_to<uint32_t>;
+        { a.update(transformation) } -> std::convertible_to<void>;
+    };
+
     /**
      * @brief The HasMaterial interface describes an object that has a material.
      *
@@ -78,13 +144,14 @@ namespace AGPTracer::Entities {
      * Shapes are surfaces that can be intersected by rays and shaded. Rays bounce on them according to their material, and they can provide
      * information about an intersection, like the hit point, object coordinates hit point, surface normal, etc. Shapes are stored in a scene and
      * in an acceleration structure, and as such must provide the mincoord and maxcoord functions to be spatially sorted. The shapes can be modified
-     * by applying transformations to their transformation matrix. These changes are propagated on update.
+     * by applying transformations to their transformation matrix. These changes are propagated on update. Shapes either own their
+     * transformation matrix, or reference a matrix shared with other shapes in a palette.
      *
      * @tparam S Shape type
      * @tparam T Floating point datatype to use
      */
     template<template<typename> typename S, typename T>
-    concept Shape = Updatable<S<T>> && Intersectable<S, T> && Geometric<S, T, T> && Coordinates<S, T> && Transformable<S, T> && HasMaterial<S<T>>;
+    concept Shape = Intersectable<S, T> && Geometric<S, T, T> && Coordinates<S, T> && ((Updatable<S<T>> && Transformable<S, T>) || PaletteTransformable<S, T>) && HasMaterial<S<T>>;
 }
 
 #endif
@@ -267,6 +267,16 @@ namespace AGPTracer::Entities {
              */
             constexpr auto neg() -> TransformMatrix_t<T>&;
 
+            /**
+             * @brief Applies another transformation matrix after this one.
+             *
+             * Objects transformed by the resulting matrix are first transformed by this matrix, then by the other one.
+             *
+             * @param other Transformation to apply after this one.
+             * @return TransformMatrix_t<T>& Reference to this matrix, used to chain operations.
+             */
+            constexpr auto transform(const TransformMatrix_t<T>& other) -> TransformMatrix_t<T>&;
+
             /**
              * @brief Transforms a point with the matrix, moving it around according to the operations made on the matrix.
              *
@@ -287,6 +297,29 @@ namespace AGPTracer::Entities {
             template<class T2>
             auto multDir(const Vec3<T2>& vec) const -> Vec3<T2>; // In c++26 sqrt is constexpr
 
+            /**
+             * @brief Transforms a point with the inverse of the matrix, bringing a transformed point back to where it was.
+             *
+             * @tparam T2 Other type
+             * @param vec Point to transform.
+             * @return Vec3<T2> Point transformed by the inverse matrix.
+             */
+            template<class T2>
+            constexpr auto multVecInverse(const Vec3<T2>& vec) const -> Vec3<T2>;
+
+            /**
+             * @brief Transforms a vector with the inverse of the matrix, ignoring the translation.
+             *
+             * Unlike multDir, the result is not normalised, so that distances along a ray transformed by the inverse
+             * matrix are the same as along the original ray.
+             *
+             * @tparam T2 Other type
+             * @param vec Vector to transform.
+             * @return Vec3<T2> Vector transformed by the inverse matrix.
+             */
+            template<class T2>
+            constexpr auto multDirInverse(const Vec3<T2>& vec) const -> Vec3<T2>;
+
             /**
              * @brief Get the maximum scale of all three axis.
              *
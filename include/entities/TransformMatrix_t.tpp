@@ -463,6 +463,20 @@ constexpr auto AGPTracer::Entities::TransformMatrix_t<T>::neg() -> TransformMatr
     return *this;
 }
 
+template<typename T>
+constexpr auto AGPTracer::Entities::TransformMatrix_t<T>::transform(const TransformMatrix_t<T>& other) -> TransformMatrix_t<T>& {
+    const std::array<T, 16> matrix{matrix_};
+
+    for (unsigned int j = 0; j < 4; j++) {
+        for (unsigned int i = 0; i < 4; ++i) {
+            matrix_[4 * j + i] = matrix[4 * j] * other.matrix_[i] + matrix[4 * j + 1] * other.matrix_[4 + i] + matrix[4 * j + 2] * other.matrix_[8 + i] + matrix[4 * j + 3] * other.matrix_[12 + i];
+        }
+    }
+
+    buildInverse();
+    return *this;
+}
+
 template<typename T>
 template<class T2>
 constexpr auto AGPTracer::Entities::TransformMatrix_t<T>::multVec(const AGPTracer::Entities::Vec3<T2>& vec) const -> AGPTracer::Entities::Vec3<T2> {
@@ -489,6 +503,27 @@ auto AGPTracer::Entities::TransformMatrix_t<T>::multDir(const AGPTracer::Entitie
     // Will maybe have to normalise this. (was not normalised)
 }
 
+template<typename T>
+template<class T2>
+constexpr auto AGPTracer::Entities::TransformMatrix_t<T>::multVecInverse(const AGPTracer::Entities::Vec3<T2>& vec) const -> AGPTracer::Entities::Vec3<T2> {
+    // The inverse is stored transposed, so its columns are read as rows
+    std::array<decltype(std::declval<T2>() * std::declval<T>()), 4> vec2;
+    for (unsigned int i = 0; i < 4; ++i) {
+        vec2[i] = vec[0] * matrix_inverse_[4 * i] + vec[1] * matrix_inverse_[4 * i + 1] + vec[2] * matrix_inverse_[4 * i + 2] + matrix_inverse_[4 * i + 3];
+    }
+    return AGPTracer::Entities::Vec3<T2>(vec2[0], vec2[1], vec2[2]) / vec2[3];
+}
+
+template<typename T>
+template<class T2>
+constexpr auto AGPTracer::Entities::TransformMatrix_t<T>::multDirInverse(const AGPTracer::Entities::Vec3<T2>& vec) const -> AGPTracer::Entities::Vec3<T2> {
+    std::array<decltype(std::declval<T2>() * std::declval<T>()), 3> vec2;
+    for (unsigned int i = 0; i < 3; ++i) {
+        vec2[i] = vec[0] * matrix_inverse_[4 * i] + vec[1] * matrix_inverse_[4 * i + 1] + vec[2] * matrix_inverse_[4 * i + 2];
+    }
+    return AGPTracer::Entities::Vec3<T2>(vec2[0], vec2[1], vec2[2]);
+}
+
 template<typename T>
 auto AGPTracer::Entities::TransformMatrix_t<T>::getScale() const -> T { // In c++26 sqrt is constexpr
     const T norm0 = AGPTracer::Entities::Vec3<T>(matrix_[0], matrix_[1], matrix_[2]).magnitude();
@@ -0,0 +1,20 @@
+#ifndef AGPTRACER_ENTITIES_VISIBILITY_HPP
+#define AGPTRACER_ENTITIES_VISIBILITY_HPP
+
+#include <cstdint>
+#include <limits>
+
+/**
+ * @brief Contains the visibility masks of the different kinds of rays.
+ *
+ * Rays carry a visibility mask, and shapes and mesh instances a mask of the rays that can see them. A ray only intersects
+ * shapes whose mask has a bit in common with its own, so an object with a mask of secondary is invisible to the camera but
+ * still casts shadows and emits light, and an object with a mask of camera is only seen directly. Other bits are free to use.
+ */
+namespace AGPTracer::Entities::Visibility {
+    constexpr uint32_t camera    = 1U; /**< @brief Rays leaving the camera, up to their first hit.*/
+    constexpr uint32_t secondary = 1U << 1U; /**< @brief Rays after their first bounce.*/
+    constexpr uint32_t all       = std::numeric_limits<uint32_t>::max(); /**< @brief Every kind of ray. Default mask of rays, shapes and instances.*/
+}
+
+#endif
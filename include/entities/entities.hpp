@@ -10,13 +10,19 @@
 namespace APTracer::Entities {
 }
 
+#include "AccelerationStructure.hpp"
 #include "Camera.hpp"
+#include "ClipPlane_t.hpp"
+#include "Hit_t.hpp"
+#include "IntersectionBuffer_t.hpp"
 #include "Material.hpp"
 #include "Medium.hpp"
 #include "MediumList_t.hpp"
 #include "MeshGeometry_t.hpp"
+#include "Octahedral.hpp"
 #include "RandomGenerator_t.hpp"
 #include "RandomNumberGenerator_t.hpp"
+#include "RayFlags_t.hpp"
 #include "Ray_t.hpp"
 #include "Scene_t.hpp"
 #include "Shape.hpp"
@@ -26,5 +32,6 @@ namespace APTracer::Entities {
 #include "Translucent.hpp"
 #include "UniformDistribution_t.hpp"
 #include "Vec3.hpp"
+#include "Visibility.hpp"
 
 #endif
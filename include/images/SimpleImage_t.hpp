@@ -121,6 +121,15 @@ namespace AGPTracer::Images {
              */
             auto set(const Entities::Vec3<T>& colour, size_t pos_x, size_t pos_y) -> void;
 
+            /**
+             * @brief Returns the value of a single pixel of the image, the sum of all its samples.
+             *
+             * @param pos_x Horizontal coordinate of the pixel.
+             * @param pos_y Vertical coordinate of the pixel.
+             * @return Entities::Vec3<T> Colour of the pixel, not divided by the number of updates.
+             */
+            auto get(size_t pos_x, size_t pos_y) -> Entities::Vec3<T>;
+
             /**
              * @brief Writes the image to disk using the provided filename.
              *
@@ -59,6 +59,12 @@ auto AGPTracer::Images::SimpleImage_t<T>::set(const Entities::Vec3<T>& colour, s
     accessor[sycl::id<2>{pos_x, pos_y}] = colour;
 }
 
+template<typename T>
+auto AGPTracer::Images::SimpleImage_t<T>::get(size_t pos_x, size_t pos_y) -> Entities::Vec3<T> {
+    const sycl::host_accessor<Entities::Vec3<T>, 2, sycl::access_mode::read> accessor(img_);
+    return accessor[sycl::id<2>{pos_x, pos_y}];
+}
+
 template<typename T>
 auto AGPTracer::Images::SimpleImage_t<T>::write(const std::filesystem::path& filename) -> void {
     const T update_mult = T{1} / static_cast<T>(updates_);
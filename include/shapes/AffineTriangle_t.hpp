@@ -0,0 +1,55 @@
+#ifndef AGPTRACER_SHAPES_AFFINETRIANGLE_T_HPP
+#define AGPTRACER_SHAPES_AFFINETRIANGLE_T_HPP
+
+#include "entities/Ray_t.hpp"
+#include "entities/Vec3.hpp"
+#include <array>
+
+namespace AGPTracer::Shapes {
+    /**
+     * @brief The affine triangle class is a precomputed intersection record of a triangle, as an affine transformation to the unit triangle.
+     *
+     * The transformation maps the first point of the triangle to the origin, its two edges from that point to the x and y axes, and its
+     * normal to the z axis, so that the triangle becomes the triangle with corners (0, 0, 0), (1, 0, 0) and (0, 1, 0). Its three rows
+     * of four scalars are computed once when the triangle moves. A ray is intersected by moving it to that space, where the intersection
+     * with the plane z = 0 only takes dot products and a division, and where the x and y coordinates of the hit are the same barycentric
+     * coordinates as the ones given by Triangle_t::intersection. The Möller–Trumbore intersection of Triangle_t stays the reference.
+     *
+     * @tparam T Floating point datatype to use
+     */
+    template<typename T = double>
+    class AffineTriangle_t {
+        public:
+            /**
+             * @brief Construct a new AffineTriangle_t object that doesn't intersect any ray.
+             */
+            constexpr AffineTriangle_t();
+
+            /**
+             * @brief Construct a new AffineTriangle_t object from the three points of a triangle. Degenerate triangles don't intersect any ray.
+             *
+             * @param points Array of three points, in counter-clockwise order, defining the triangle.
+             */
+            constexpr explicit AffineTriangle_t(const std::array<Entities::Vec3<T>, 3>& points);
+
+            std::array<Entities::Vec3<T>, 3> rows_; /**< @brief Linear part of the transformation to unit triangle space, one row per axis.*/
+            Entities::Vec3<T> offsets_; /**< @brief Translation part of the transformation to unit triangle space, one component per axis.*/
+
+            /**
+             * @brief Intersects a ray with the triangle, and stores information about the intersection.
+             *
+             * @tparam N Number of mediums in the ray's medium list
+             * @param ray Ray to be tested for intersection with the triangle.
+             * @param[out] t Distance at which the intersection ocurred, from ray origin. Undefined if not intersected.
+             * @param[out] uv Coordinates in object space of the intersection. Undefined if not intersected. The coordinates are in barycentric coordinates, minus w [u, v].
+             * @return true The ray intersected the triangle, t and uv are defined.
+             * @return false The ray doesn't intersect the triangle, t and uv are undefined.
+             */
+            template<size_t N>
+            constexpr auto intersection(const Entities::Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv) const -> bool;
+    };
+}
+
+#include "shapes/AffineTriangle_t.tpp"
+
+#endif
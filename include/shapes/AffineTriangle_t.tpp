@@ -0,0 +1,52 @@
+#include <cmath>
+#include <limits>
+
+template<typename T>
+constexpr AGPTracer::Shapes::AffineTriangle_t<T>::AffineTriangle_t() : rows_{}, offsets_{} {}
+
+template<typename T>
+constexpr AGPTracer::Shapes::AffineTriangle_t<T>::AffineTriangle_t(const std::array<Entities::Vec3<T>, 3>& points) : rows_{}, offsets_{} {
+    const Entities::Vec3<T> v0v1   = points[1] - points[0];
+    const Entities::Vec3<T> v0v2   = points[2] - points[0];
+    const Entities::Vec3<T> normal = v0v1.cross(v0v2);
+    const T det                    = normal.magnitudeSquared();
+
+    // A null matrix gives a null direction along z, which is rejected by the intersection
+    if (det < std::numeric_limits<T>::min()) {
+        return;
+    }
+
+    // The inverse of the matrix with the two edges and the normal as columns has their pairwise cross products as rows
+    const T invdet = 1.0 / det;
+    rows_          = {v0v2.cross(normal) * invdet, normal.cross(v0v1) * invdet, normal * invdet};
+    offsets_       = Entities::Vec3<T>(-rows_[0].dot(points[0]), -rows_[1].dot(points[0]), -rows_[2].dot(points[0]));
+}
+
+template<typename T>
+template<size_t N>
+constexpr auto AGPTracer::Shapes::AffineTriangle_t<T>::intersection(const Entities::Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv) const -> bool {
+    const T origin_z    = rows_[2].dot(ray.origin_) + offsets_[2];
+    const T direction_z = rows_[2].dot(ray.direction_);
+
+    if (std::abs(direction_z) < std::numeric_limits<T>::min()) {
+        return false;
+    }
+
+    t = -origin_z / direction_z;
+
+    if (t < 0.0) {
+        return false;
+    }
+
+    const T u = rows_[0].dot(ray.origin_) + offsets_[0] + t * rows_[0].dot(ray.direction_);
+    uv[0]     = u;
+
+    if ((u < 0.0) || (u > 1.0)) {
+        return false;
+    }
+
+    const T v = rows_[1].dot(ray.origin_) + offsets_[1] + t * rows_[1].dot(ray.direction_);
+    uv[1]     = v;
+
+    return (v >= 0.0) && ((u + v) <= 1.0);
+}
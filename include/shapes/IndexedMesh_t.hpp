@@ -0,0 +1,158 @@
+#ifndef AGPTRACER_SHAPES_INDEXEDMESH_T_HPP
+#define AGPTRACER_SHAPES_INDEXEDMESH_T_HPP
+
+#include "entities/MeshGeometry_t.hpp"
+#include "entities/Octahedral.hpp"
+#include "entities/Ray_t.hpp"
+#include "entities/Vec3.hpp"
+#include "shapes/Triangle_t.hpp"
+#include <array>
+#include <cstdint>
+#include <span>
+#include <sycl/sycl.hpp>
+#include <vector>
+
+namespace AGPTracer::Shapes {
+    /**
+     * @brief The indexed mesh class holds the triangles of meshes as shared vertices and indices, instead of as standalone triangles.
+     *
+     * Mesh geometries reference the nodes, normals and texture coordinates of their faces by index. Expanding them into triangles copies
+     * those for every face, twice as triangles keep their original and transformed points, while a closed mesh shares each node between
+     * about six faces. Here, each unique combination of node, normal and texture coordinates of a geometry is stored once as a vertex,
+     * and each triangle is three 32 bit indices into the vertices along with its material. Triangles are intersected and shaded by
+     * reading their vertices through their indices. The vertices and triangles of all the meshes are stored in the same buffers, which
+     * are uploaded once when a mesh is added. Meshes are in object space, and are placed in the scene by mesh instances. As in triangles,
+     * vertex normals are octahedral encoded and texture coordinates are half precision floats.
+     *
+     * @tparam T Floating point datatype to use
+     */
+    template<typename T = double>
+    class IndexedMesh_t {
+        public:
+            class Accessor_t {
+                public:
+                    /**
+                     * @brief Construct a new Accessor_t object with the given buffers.
+                     *
+                     * @param cgh Device handler.
+                     * @param vertices Vertex position buffer to access.
+                     * @param normals Vertex normal buffer to access.
+                     * @param texture_coordinates Vertex texture coordinate buffer to access.
+                     * @param indices Triangle index buffer to access.
+                     * @param materials Triangle material buffer to access.
+                     */
+                    Accessor_t(sycl::handler& cgh,
+                               sycl::buffer<Entities::Vec3<T>, 1>& vertices,
+                               sycl::buffer<uint32_t, 1>& normals,
+                               sycl::buffer<std::array<sycl::half, 2>, 1>& texture_coordinates,
+                               sycl::buffer<uint32_t, 1>& indices,
+                               sycl::buffer<uint32_t, 1>& materials);
+
+                    /**
+                     * @brief Intersects a ray with a triangle, reading its three vertex positions through its indices.
+                     *
+                     * @tparam N Number of mediums in the ray's medium list
+                     * @param triangle Index of the triangle, in the triangles of all the meshes.
+                     * @param ray Ray to be tested for intersection with the triangle, in object space.
+                     * @param[out] t Distance at which the intersection ocurred, from ray origin. Undefined if not intersected.
+                     * @param[out] uv Coordinates in object space of the intersection. Undefined if not intersected. The coordinates are in barycentric coordinates, minus w [u, v].
+                     * @return true The ray intersected the triangle, t and uv are defined.
+                     * @return false The ray doesn't intersect the triangle, t and uv are undefined.
+                     */
+                    template<size_t N>
+                    auto intersection(size_t triangle, const Entities::Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv) const -> bool;
+
+                    /**
+                     * @brief Returns the geometric normal of a triangle, not normalised.
+                     *
+                     * @param triangle Index of the triangle, in the triangles of all the meshes.
+                     * @return Entities::Vec3<T> Normal of the triangle, from its vertices in counter-clockwise order.
+                     */
+                    auto normal_face(size_t triangle) const -> Entities::Vec3<T>;
+
+                    /**
+                     * @brief Returns the material of a triangle.
+                     *
+                     * @param triangle Index of the triangle, in the triangles of all the meshes.
+                     * @return size_t Material of the triangle.
+                     */
+                    auto material(size_t triangle) const -> size_t;
+
+                    /**
+                     * @brief Gathers the vertices of a triangle into a standalone triangle, in object space, to shade a hit on it.
+                     *
+                     * @param triangle Index of the triangle, in the triangles of all the meshes.
+                     * @return Triangle_t<T> Triangle with the positions, normals, texture coordinates and material of the triangle.
+                     */
+                    auto triangle(size_t triangle) const -> Triangle_t<T>;
+
+                private:
+                    sycl::accessor<Entities::Vec3<T>, 1, sycl::access::mode::read> vertices_; /**< @brief Accessor to the vertex positions.*/
+                    sycl::accessor<uint32_t, 1, sycl::access::mode::read> normals_; /**< @brief Accessor to the vertex normals.*/
+                    sycl::accessor<std::array<sycl::half, 2>, 1, sycl::access::mode::read> texture_coordinates_; /**< @brief Accessor to the vertex texture coordinates.*/
+                    sycl::accessor<uint32_t, 1, sycl::access::mode::read> indices_; /**< @brief Accessor to the vertex indices of the triangles.*/
+                    sycl::accessor<uint32_t, 1, sycl::access::mode::read> materials_; /**< @brief Accessor to the materials of the triangles.*/
+            };
+
+            /**
+             * @brief Construct a new IndexedMesh_t object without any mesh.
+             */
+            IndexedMesh_t();
+
+            sycl::buffer<Entities::Vec3<T>, 1> vertices_; /**< @brief Position of the vertices of all the meshes, in object space.*/
+            sycl::buffer<uint32_t, 1> normals_; /**< @brief Normal of the vertices of all the meshes, in object space, octahedral encoded.*/
+            sycl::buffer<std::array<sycl::half, 2>, 1> texture_coordinates_; /**< @brief Texture coordinates of the vertices of all the meshes, in half precision.*/
+            sycl::buffer<uint32_t, 1> indices_; /**< @brief Indices of the three vertices of each triangle, in counter-clockwise order.*/
+            sycl::buffer<uint32_t, 1> materials_; /**< @brief Material of each triangle.*/
+            std::vector<size_t> offsets_; /**< @brief Index of the first triangle of each mesh, followed by the total number of triangles.*/
+
+            /**
+             * @brief Adds a mesh made of the faces of a geometry, and uploads its vertices and triangles.
+             *
+             * Faces using the same node, normal and texture coordinates at a corner share the vertex.
+             *
+             * @param geometry Geometry of the mesh, in object space.
+             * @param material Material of all the triangles of the mesh.
+             * @return size_t Index of the mesh, in the meshes of this object.
+             */
+            auto add(const Entities::MeshGeometry_t<T>& geometry, size_t material) -> size_t;
+
+            /**
+             * @brief Returns the number of triangles of all the meshes.
+             *
+             * @return size_t Number of triangles.
+             */
+            auto size() const -> size_t;
+
+            /**
+             * @brief Computes the bounding box of each triangle on the host, to build acceleration structures around them.
+             *
+             * @param[out] mins Minimum coordinates of the bounding box of each triangle, with one element per triangle.
+             * @param[out] maxs Maximum coordinates of the bounding box of each triangle, with one element per triangle.
+             */
+            auto bounds(std::span<Entities::Vec3<T>> mins, std::span<Entities::Vec3<T>> maxs) -> void;
+
+            /**
+             * @brief Get a Accessor_t object attached to these meshes
+             *
+             * @param cgh Device handler.
+             * @return Accessor_t Accessor that can be used on the device to intersect and shade the triangles
+             */
+            auto getAccessor(sycl::handler& cgh) -> Accessor_t;
+
+        private:
+            /**
+             * @brief Appends values to a buffer, which is replaced by a larger buffer.
+             *
+             * @tparam U Type of the values
+             * @param buffer Buffer to which to append the values.
+             * @param values Values to append.
+             */
+            template<typename U>
+            static auto append(sycl::buffer<U, 1>& buffer, std::span<const U> values) -> void;
+    };
+}
+
+#include "shapes/IndexedMesh_t.tpp"
+
+#endif
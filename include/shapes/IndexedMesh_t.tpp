@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <map>
+
+template<typename T>
+AGPTracer::Shapes::IndexedMesh_t<T>::IndexedMesh_t() :
+        vertices_(sycl::range<1>{0}), normals_(sycl::range<1>{0}), texture_coordinates_(sycl::range<1>{0}), indices_(sycl::range<1>{0}), materials_(sycl::range<1>{0}), offsets_{0} {}
+
+template<typename T>
+auto AGPTracer::Shapes::IndexedMesh_t<T>::add(const Entities::MeshGeometry_t<T>& geometry, size_t material) -> size_t {
+    const size_t n_triangles = geometry.face_nodes_.size();
+    const auto first_vertex  = static_cast<uint32_t>(vertices_.get_range()[0]);
+
+    // Each unique node, normal and texture coordinates triplet becomes a vertex
+    std::map<std::array<size_t, 3>, uint32_t> vertex_indices;
+    std::vector<Entities::Vec3<T>> vertices;
+    std::vector<uint32_t> normals;
+    std::vector<std::array<sycl::half, 2>> texture_coordinates;
+    std::vector<uint32_t> indices(3 * n_triangles);
+    for (size_t i = 0; i < n_triangles; ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+            const std::array<size_t, 3> key{geometry.face_nodes_[i][j], geometry.face_normals_[i][j], geometry.face_texture_coordinates_[i][j]};
+            const auto [vertex, inserted] = vertex_indices.try_emplace(key, first_vertex + static_cast<uint32_t>(vertices.size()));
+            if (inserted) {
+                vertices.push_back(geometry.nodes_[key[0]]);
+                normals.push_back(Entities::Octahedral::encode(geometry.normals_[key[1]]));
+                texture_coordinates.push_back({static_cast<sycl::half>(static_cast<float>(geometry.texture_coordinates_[key[2]][0])),
+                                               static_cast<sycl::half>(static_cast<float>(geometry.texture_coordinates_[key[2]][1]))});
+            }
+            indices[3 * i + j] = vertex->second;
+        }
+    }
+    const std::vector<uint32_t> materials(n_triangles, static_cast<uint32_t>(material));
+
+    append(vertices_, std::span<const Entities::Vec3<T>>(vertices));
+    append(normals_, std::span<const uint32_t>(normals));
+    append(texture_coordinates_, std::span<const std::array<sycl::half, 2>>(texture_coordinates));
+    append(indices_, std::span<const uint32_t>(indices));
+    append(materials_, std::span<const uint32_t>(materials));
+
+    offsets_.push_back(offsets_.back() + n_triangles);
+    return offsets_.size() - 2;
+}
+
+template<typename T>
+auto AGPTracer::Shapes::IndexedMesh_t<T>::size() const -> size_t {
+    return offsets_.back();
+}
+
+template<typename T>
+auto AGPTracer::Shapes::IndexedMesh_t<T>::bounds(std::span<Entities::Vec3<T>> mins, std::span<Entities::Vec3<T>> maxs) -> void {
+    const sycl::host_accessor<Entities::Vec3<T>, 1, sycl::access_mode::read> vertex_accessor(vertices_);
+    const sycl::host_accessor<uint32_t, 1, sycl::access_mode::read> index_accessor(indices_);
+
+    for (size_t i = 0; i < size(); ++i) {
+        const Entities::Vec3<T>& point0 = vertex_accessor[index_accessor[3 * i]];
+        const Entities::Vec3<T>& point1 = vertex_accessor[index_accessor[3 * i + 1]];
+        const Entities::Vec3<T>& point2 = vertex_accessor[index_accessor[3 * i + 2]];
+        mins[i]                         = point0.getMin(point1).min(point2);
+        maxs[i]                         = point0.getMax(point1).max(point2);
+    }
+}
+
+template<typename T>
+auto AGPTracer::Shapes::IndexedMesh_t<T>::getAccessor(sycl::handler& cgh) -> Accessor_t {
+    return Accessor_t(cgh, vertices_, normals_, texture_coordinates_, indices_, materials_);
+}
+
+template<typename T>
+template<typename U>
+auto AGPTracer::Shapes::IndexedMesh_t<T>::append(sycl::buffer<U, 1>& buffer, std::span<const U> values) -> void {
+    sycl::buffer<U, 1> new_buffer(sycl::range<1>{buffer.get_range()[0] + values.size()});
+    {
+        const sycl::host_accessor<U, 1, sycl::access_mode::write> new_host_accessor(new_buffer, sycl::no_init);
+        const sycl::host_accessor<U, 1, sycl::access_mode::read> old_host_accessor(buffer);
+
+        std::copy(old_host_accessor.begin(), old_host_accessor.end(), new_host_accessor.begin());
+        std::copy(values.begin(), values.end(), new_host_accessor.begin() + buffer.get_range()[0]);
+    }
+
+    buffer = std::move(new_buffer);
+}
+
+template<typename T>
+AGPTracer::Shapes::IndexedMesh_t<T>::Accessor_t::Accessor_t(sycl::handler& cgh,
+                                                            sycl::buffer<Entities::Vec3<T>, 1>& vertices,
+                                                            sycl::buffer<uint32_t, 1>& normals,
+                                                            sycl::buffer<std::array<sycl::half, 2>, 1>& texture_coordinates,
+                                                            sycl::buffer<uint32_t, 1>& indices,
+                                                            sycl::buffer<uint32_t, 1>& materials) :
+        vertices_(vertices.template get_access<sycl::access::mode::read>(cgh)),
+        normals_(normals.template get_access<sycl::access::mode::read>(cgh)),
+        texture_coordinates_(texture_coordinates.template get_access<sycl::access::mode::read>(cgh)),
+        indices_(indices.template get_access<sycl::access::mode::read>(cgh)),
+        materials_(materials.template get_access<sycl::access::mode::read>(cgh)) {}
+
+template<typename T>
+template<size_t N>
+auto AGPTracer::Shapes::IndexedMesh_t<T>::Accessor_t::intersection(size_t triangle, const Entities::Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv) const -> bool {
+    const Entities::Vec3<T>& point0 = vertices_[indices_[3 * triangle]];
+    const Entities::Vec3<T>& point1 = vertices_[indices_[3 * triangle + 1]];
+    const Entities::Vec3<T>& point2 = vertices_[indices_[3 * triangle + 2]];
+    return Triangle_t<T>::intersection(point0, point1 - point0, point2 - point0, ray, t, uv);
+}
+
+template<typename T>
+auto AGPTracer::Shapes::IndexedMesh_t<T>::Accessor_t::normal_face(size_t triangle) const -> Entities::Vec3<T> {
+    const Entities::Vec3<T>& point0 = vertices_[indices_[3 * triangle]];
+    const Entities::Vec3<T>& point1 = vertices_[indices_[3 * triangle + 1]];
+    const Entities::Vec3<T>& point2 = vertices_[indices_[3 * triangle + 2]];
+    return (point1 - point0).cross(point2 - point0);
+}
+
+template<typename T>
+auto AGPTracer::Shapes::IndexedMesh_t<T>::Accessor_t::material(size_t triangle) const -> size_t {
+    return materials_[triangle];
+}
+
+template<typename T>
+auto AGPTracer::Shapes::IndexedMesh_t<T>::Accessor_t::triangle(size_t triangle) const -> Triangle_t<T> {
+    // Decoded normals and texture coordinates are encoded again to the same bits by the triangle
+    const std::array<uint32_t, 3> indices{indices_[3 * triangle], indices_[3 * triangle + 1], indices_[3 * triangle + 2]};
+    std::array<Entities::Vec3<T>, 3> normals;
+    std::array<std::array<T, 2>, 3> texture_coordinates;
+    for (unsigned int i = 0; i < 3; ++i) {
+        normals[i]             = Entities::Octahedral::decode<T>(normals_[indices[i]]);
+        texture_coordinates[i] = {static_cast<T>(texture_coordinates_[indices[i]][0]), static_cast<T>(texture_coordinates_[indices[i]][1])};
+    }
+    return Triangle_t<T>(materials_[triangle],
+                         0,
+                         std::array<Entities::Vec3<T>, 3>{vertices_[indices[0]], vertices_[indices[1]], vertices_[indices[2]]},
+                         normals,
+                         texture_coordinates);
+}
@@ -0,0 +1,102 @@
+#ifndef AGPTRACER_SHAPES_MESHTOP_T_HPP
+#define AGPTRACER_SHAPES_MESHTOP_T_HPP
+
+#include "entities/Ray_t.hpp"
+#include "entities/Shape.hpp"
+#include "entities/TransformMatrix_t.hpp"
+#include "entities/Vec3.hpp"
+#include "entities/Visibility.hpp"
+#include <cstdint>
+#include <optional>
+#include <sycl/sycl.hpp>
+
+namespace AGPTracer::Shapes {
+    /**
+     * @brief The mesh top class represents an instance of a mesh, placing the mesh's shapes in the scene with its own transformation matrix.
+     *
+     * The shapes of a mesh are stored once in the scene, in object space, with their own bounding volume hierarchy. A mesh top only holds
+     * the index of the mesh, a transformation matrix and an optional material replacing the material of the mesh's shapes, so a mesh
+     * can be instanced many times at the cost of a few matrices. Rays are moved to object space with the inverse of the transformation
+     * matrix to be intersected with the mesh's shapes, and the hit shape is moved to world space only to be shaded.
+     *
+     * @tparam T Floating point datatype to use
+     */
+    template<typename T = double>
+    class MeshTop_t {
+        public:
+            /**
+             * @brief Construct a new MeshTop_t object instancing a mesh with a transformation matrix and an optional material.
+             *
+             * @param mesh Index of the mesh in the scene, as returned when the mesh is added.
+             * @param transform_matrix Transformation used to place the mesh's shapes in the scene.
+             * @param material Material replacing the material of all the mesh's shapes. The shapes keep their own material if none.
+             * @param mask Visibility mask of the instance. Only rays whose visibility has a bit in common with it intersect the instance. Visible to all rays by default.
+             */
+            MeshTop_t(size_t mesh, Entities::TransformMatrix_t<T> transform_matrix, std::optional<size_t> material = std::nullopt, uint32_t mask = Entities::Visibility::all);
+
+            size_t mesh_; /**< @brief Index of the instanced mesh in the scene.*/
+            std::optional<size_t> material_; /**< @brief Material replacing the material of the mesh's shapes, if any.*/
+            Entities::TransformMatrix_t<T> transformation_; /**< @brief Transformation matrix used to move the mesh's shapes from object space to world space.*/
+            Entities::Vec3<T> min_; /**< @brief Minimum coordinates of the bounding box of the instance in world space. Computed on update.*/
+            Entities::Vec3<T> max_; /**< @brief Maximum coordinates of the bounding box of the instance in world space. Computed on update.*/
+            uint32_t mask_; /**< @brief Visibility mask of the instance. Rays whose visibility has no bit in common with it skip the instance, whatever the masks of its shapes.*/
+
+            /**
+             * @brief Updates the bounding box of the instance from the bounding box of its mesh in object space.
+             *
+             * The eight corners of the mesh's bounding box are transformed, and the instance's bounding box is fitted around them.
+             *
+             * @param minimum Minimum coordinates of the bounding box of the mesh in object space.
+             * @param maximum Maximum coordinates of the bounding box of the mesh in object space.
+             */
+            constexpr auto update(const Entities::Vec3<T>& minimum, const Entities::Vec3<T>& maximum) -> void;
+
+            /**
+             * @brief Moves a ray to the object space of the instance, to be intersected with the mesh's shapes.
+             *
+             * The direction is not normalised, so that intersection distances along the object space ray are the same as along the
+             * world space ray.
+             *
+             * @tparam N Number of mediums in the ray's medium list
+             * @param ray Ray in world space.
+             * @return Entities::Ray_t<T, N> Ray in object space.
+             */
+            template<size_t N>
+            constexpr auto to_object(const Entities::Ray_t<T, N>& ray) const -> Entities::Ray_t<T, N>;
+
+            /**
+             * @brief Moves a shape of the mesh to world space, and applies the material of the instance.
+             *
+             * This is used on the shape hit by a ray, so that materials can bounce the ray on the shape as it is seen in the scene.
+             * Intersection coordinates are kept by the transformation, so the uv coordinates found in object space can be used.
+             *
+             * @tparam S Shape type
+             * @param shape Shape of the mesh, in object space.
+             * @return S<T> Copy of the shape, in world space.
+             */
+            template<template<typename> typename S>
+            requires Entities::Shape<S, T> auto to_world(S<T> shape) const -> S<T>;
+
+            /**
+             * @brief Minimum coordinates of an axis-aligned bounding box around the instance.
+             *
+             * This is used by the top-level acceleration structure to spatially sort instances.
+             *
+             * @return Entities::Vec3<T> Minimum coordinates of an axis-aligned bounding box around the instance.
+             */
+            constexpr auto mincoord() const -> Entities::Vec3<T>;
+
+            /**
+             * @brief Maximum coordinates of an axis-aligned bounding box around the instance.
+             *
+             * This is used by the top-level acceleration structure to spatially sort instances.
+             *
+             * @return Entities::Vec3<T> Maximum coordinates of an axis-aligned bounding box around the instance.
+             */
+            constexpr auto maxcoord() const -> Entities::Vec3<T>;
+    };
+}
+
+#include "shapes/MeshTop_t.tpp"
+
+#endif
@@ -0,0 +1,60 @@
+#include <limits>
+#include <utility>
+
+template<typename T>
+AGPTracer::Shapes::MeshTop_t<T>::MeshTop_t(size_t mesh, Entities::TransformMatrix_t<T> transform_matrix, std::optional<size_t> material, uint32_t mask) :
+        mesh_(mesh),
+        material_(material),
+        transformation_(std::move(transform_matrix)),
+        min_(std::numeric_limits<T>::max()),
+        max_(std::numeric_limits<T>::lowest()),
+        mask_(mask) {}
+
+template<typename T>
+constexpr auto AGPTracer::Shapes::MeshTop_t<T>::update(const Entities::Vec3<T>& minimum, const Entities::Vec3<T>& maximum) -> void {
+    min_ = Entities::Vec3<T>(std::numeric_limits<T>::max());
+    max_ = Entities::Vec3<T>(std::numeric_limits<T>::lowest());
+
+    for (unsigned int i = 0; i < 8; ++i) {
+        const Entities::Vec3<T> corner((i & 1U) ? maximum[0] : minimum[0], (i & 2U) ? maximum[1] : minimum[1], (i & 4U) ? maximum[2] : minimum[2]);
+        const Entities::Vec3<T> point = transformation_.multVec(corner);
+        min_.min(point);
+        max_.max(point);
+    }
+}
+
+template<typename T>
+template<size_t N>
+constexpr auto AGPTracer::Shapes::MeshTop_t<T>::to_object(const Entities::Ray_t<T, N>& ray) const -> Entities::Ray_t<T, N> {
+    Entities::Ray_t<T, N> object_ray(ray);
+    object_ray.origin_    = transformation_.multVecInverse(ray.origin_);
+    object_ray.direction_ = transformation_.multDirInverse(ray.direction_);
+    return object_ray;
+}
+
+template<typename T>
+template<template<typename> typename S>
+requires AGPTracer::Entities::Shape<S, T> auto AGPTracer::Shapes::MeshTop_t<T>::to_world(S<T> shape) const -> S<T> {
+    // Shapes sharing a palette matrix are stored untransformed in object space
+    if constexpr (Entities::PaletteTransformable<S, T>) {
+        shape.update(transformation_);
+    }
+    else {
+        shape.transformation_.transform(transformation_);
+        shape.update();
+    }
+    if (material_) {
+        shape.material_ = *material_;
+    }
+    return shape;
+}
+
+template<typename T>
+constexpr auto AGPTracer::Shapes::MeshTop_t<T>::mincoord() const -> Entities::Vec3<T> {
+    return min_;
+}
+
+template<typename T>
+constexpr auto AGPTracer::Shapes::MeshTop_t<T>::maxcoord() const -> Entities::Vec3<T> {
+    return max_;
+}
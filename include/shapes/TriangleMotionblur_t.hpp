@@ -0,0 +1,200 @@
+#ifndef AGPTRACER_SHAPES_TRIANGLEMOTIONBLUR_T_HPP
+#define AGPTRACER_SHAPES_TRIANGLEMOTIONBLUR_T_HPP
+
+#include "entities/Ray_t.hpp"
+#include "entities/TransformMatrix_t.hpp"
+#include "entities/Vec3.hpp"
+#include "entities/Visibility.hpp"
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <sycl/sycl.hpp>
+
+namespace AGPTracer::Shapes {
+    /**
+     * @brief The motion blur triangle class defines a triangle shape that can be intersected by rays, and that moves during the exposure.
+     *
+     * A triangle is defined by three points, in counter-clockwise order. Its transformation matrix is used
+     * to modify those points. The triangle keeps its points from before its last update, which are its points
+     * at the start of the exposure, at time 0. Its current points are its points at the end of the exposure, at
+     * time 1. Rays intersect the triangle linearly interpolated between the two at their time.
+     *
+     * @tparam T Floating point datatype to use
+     */
+    template<typename T = double>
+    class TriangleMotionblur_t {
+        public:
+            /**
+             * @brief Construct a new TriangleMotionblur_t object with a transformation matrix and material from three points.
+             *
+             * The triangle doesn't move until it is updated with a different transformation matrix.
+             *
+             * @param material Material of the triangle. Material that will be bounced on at intersection.
+             * @param transform_matrix Transformation used by the triangle to modify its points.
+             * @param points Array of three points, in counter-clockwise order, defining the triangle.
+             * @param normals Array of three normals, in counter-clockwise order, at the three points of the triangle.
+             * @param texcoord Array of three texture coordinates with two components, in counter-clockwise order, at the three points of the triangle. [x0, y0, x1, y1, x2, y2]
+             * @param mask Visibility mask of the triangle. Only rays whose visibility has a bit in common with it intersect the triangle. Visible to all rays by default.
+             */
+            TriangleMotionblur_t(size_t material,
+                                 Entities::TransformMatrix_t<T> transform_matrix,
+                                 std::array<AGPTracer::Entities::Vec3<T>, 3> points,
+                                 std::optional<std::array<AGPTracer::Entities::Vec3<T>, 3>> normals,
+                                 std::optional<std::array<std::array<T, 2>, 3>> texcoord,
+                                 uint32_t mask = Entities::Visibility::all); // In c++26 sqrt is constexpr
+
+            size_t material_; /**< @brief Material of which the shape is made of.*/
+            uint32_t mask_; /**< @brief Visibility mask of the shape. Rays whose visibility has no bit in common with it don't intersect the shape.*/
+            AGPTracer::Entities::TransformMatrix_t<T> transformation_; /**< @brief Transformation matrix used to modify the position and other transformations of the shape.*/
+            std::array<AGPTracer::Entities::Vec3<T>, 3>
+                points_orig_; /**< @brief Array of the three un-transformed points of the triangle, in counter-clockwise order. Transformed by the transform matrix on update to give points.*/
+            std::array<AGPTracer::Entities::Vec3<T>, 3>
+                normals_orig_; /**< @brief Array of the three un-transformed normals of the triangle, in counter-clockwise order. Transformed by the transform matrix on update to give normals.*/
+            std::array<std::array<T, 2>, 3> texture_coordinates_; /**< @brief Array of the three texture coordinates with two components of the triangle, in counter-clockwise order. Transformed by the
+                                                           transform matrix on update to give texture coordinates. [[x0, y0], [x1, y1], [x2, y2]]*/
+            std::array<AGPTracer::Entities::Vec3<T>, 3> points_; /**< @brief Array of the three points of the triangle at the end of the exposure, in counter-clockwise order.*/
+            std::array<AGPTracer::Entities::Vec3<T>, 3> normals_; /**< @brief Array of the three normals of the triangle at the end of the exposure, in counter-clockwise order.*/
+            AGPTracer::Entities::Vec3<T> v0v1_; /**< @brief Cached vector from point 0 to point 1 at the end of the exposure. Used for intersection.*/
+            AGPTracer::Entities::Vec3<T> v0v2_; /**< @brief Cached vector from point 0 to point 2 at the end of the exposure. Used for intersection.*/
+            std::array<T, 2> tuv_to_world_; /**< @brief Matrix to change referential from texture coordinate space to world space. Used to compute tangent vector.*/
+            AGPTracer::Entities::Vec3<T> tangent_vec_; /**< @brief Tangent vector of the triangle at the end of the exposure. Points to positive u in texture coordinates. Used for normal mapping.*/
+            std::array<AGPTracer::Entities::Vec3<T>, 3> points_last_; /**< @brief Array of the three points of the triangle at the start of the exposure, before the last update.*/
+            std::array<AGPTracer::Entities::Vec3<T>, 3> normals_last_; /**< @brief Array of the three normals of the triangle at the start of the exposure, before the last update.*/
+            AGPTracer::Entities::Vec3<T> v0v1_last_; /**< @brief Cached vector from point 0 to point 1 at the start of the exposure. Used for intersection.*/
+            AGPTracer::Entities::Vec3<T> v0v2_last_; /**< @brief Cached vector from point 0 to point 2 at the start of the exposure. Used for intersection.*/
+            AGPTracer::Entities::Vec3<T> tangent_vec_last_; /**< @brief Tangent vector of the triangle in world space at the start of the exposure.*/
+
+            /**
+             * @brief Updates the triangle's points from its transformation matrix.
+             *
+             * The current points become the points at the start of the exposure, and the new points are created from
+             * the transformation matrix and the original points, stored in points_orig_.
+             */
+            auto update() -> void; // In c++26 sqrt is constexpr
+
+            /**
+             * @brief Intersects a ray with the triangle at the ray's time, and stores information about the intersection.
+             *
+             * This function returns wether a ray intersected the triangle or not, according to its direction, origin and
+             * time. The triangle is interpolated between its points at the start and at the end of the exposure. The
+             * intersection point, in object coordinates, is stored in uv, and the distance from the ray origin is stored
+             * in t. uv is in barycentric coordinates, minus w [u, v].
+             *
+             * @tparam N Number of mediums in the ray's medium list
+             * @param ray Ray to be tested for intersection with the triangle.
+             * @param[out] t Distance at which the intersection ocurred, from ray origin. Undefined if not intersected.
+             * @param[out] uv Coordinates in object space of the intersection. Undefined if not intersected. The coordinates are in barycentric coordinates, minus w [u, v].
+             * @return true The ray intersected the triangle, t and uv are defined.
+             * @return false The ray doesn't intersect the triangle, t and uv are undefined.
+             */
+            template<size_t N>
+            constexpr auto intersection(const AGPTracer::Entities::Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv) const -> bool;
+
+            /**
+             * @brief Returns the surface normal at a point in object coordinates.
+             *
+             * This is used to find the surface normal on ray bounce. Used by materials to determine ray colour.
+             * The normals are interpolated between the start and the end of the exposure at the given time.
+             * The object coordinates are in barycentric coordinates (minus w) [u, v].
+             *
+             * @param[in] time Time at which we want the normal, from 0 for the start of the exposure to 1 for the end.
+             * @param[in] uv Object coordinates at which we want to find the normal. The coordinates are in barycentric coordinates, minus w [u, v].
+             * @return AGPTracer::Entities::Vec3<T> Normal vector at the specified coordinates.
+             */
+            template<class T2>
+            constexpr auto normal(T2 time, std::array<T, 2> uv) const -> AGPTracer::Entities::Vec3<T>;
+
+            /**
+             * @brief Returns the surface normal and texture coordinates at a point in object coordinates.
+             *
+             * This is used to find the surface normal on ray bounce. Used by materials to determine ray colour.
+             * The texture coordinates is also returned, used by materials to fetch a colour in a texture.
+             * The normals are interpolated between the start and the end of the exposure at the given time.
+             * The object coordinates are in barycentric coordinates (minus w) [u, v].
+             *
+             * @param[in] time Time at which we want the normal and texture coordinates, from 0 for the start of the exposure to 1 for the end.
+             * @param[in] uv Object coordinates at which we want to find the normal and texture coordinates. The coordinates are in barycentric coordinates, minus w [u, v].
+             * @param[out] tuv Texture coordinates at the specified coordinates.
+             * @return AGPTracer::Entities::Vec3<T> Normal vector at the specified coordinates.
+             */
+            template<class T2>
+            constexpr auto normal_uv(T2 time, std::array<T, 2> uv, std::array<T, 2>& tuv) const -> AGPTracer::Entities::Vec3<T>;
+
+            /**
+             * @brief Returns the surface normal, texture coordinates and tangent vector at a point in object coordinates.
+             *
+             * This is used to find the surface normal on ray bounce. Used by materials to determine ray colour.
+             * The texture coordinates is also returned, used by materials to fetch a colour in a texture. The tangent
+             * vector is used by materials for normal mapping, as the normals returned by those textures are in object
+             * coordinates. The normals and tangent vector are interpolated between the start and the end of the exposure
+             * at the given time. The object coordinates are in barycentric coordinates (minus w) [u, v].
+             *
+             * @param[in] time Time at which we want the normal, tangent and texture coordinates, from 0 for the start of the exposure to 1 for the end.
+             * @param[in] uv Object coordinates at which we want to find the normal, texture coordinates and tangent vector. The coordinates are in barycentric coordinates, minus w [u, v].
+             * @param[out] tuv Texture coordinates at the specified coordinates.
+             * @param[out] tangentvec Tangent vector at the specified coordinates.
+             * @return AGPTracer::Entities::Vec3<T> Normal vector at the specified coordinates.
+             */
+            template<class T2>
+            auto normal_uv_tangent(T2 time, std::array<T, 2> uv, std::array<T, 2>& tuv, AGPTracer::Entities::Vec3<T>& tangentvec) const -> AGPTracer::Entities::Vec3<T>; // In c++26 sqrt is constexpr
+
+            /**
+             * @brief Returns the geometric surface normal of the triangle, not the interpolated one from vertex normals.
+             *
+             * Not used anywhere usually, used to debug normal interpolation.
+             *
+             * @param time Time at which we want the normal, from 0 for the start of the exposure to 1 for the end.
+             * @return AGPTracer::Entities::Vec3<T> Normal vector of the triangle.
+             */
+            template<class T2>
+            auto normal_face(T2 time) const -> AGPTracer::Entities::Vec3<T>; // In c++26 sqrt is constexpr
+
+            /**
+             * @brief Minimum coordinates of an axis-aligned bounding box around the triangle, during the whole exposure.
+             *
+             * This is used by acceleration structures to spatially sort shapes. Returns the minimum of all
+             * three points at the start and at the end of the exposure for all axes.
+             *
+             * @return AGPTracer::Entities::Vec3<T> Minimum coordinates of an axis-aligned bounding box around the triangle.
+             */
+            constexpr auto mincoord() const -> AGPTracer::Entities::Vec3<T>;
+
+            /**
+             * @brief Maximum coordinates of an axis-aligned bounding box around the triangle, during the whole exposure.
+             *
+             * This is used by acceleration structures to spatially sort shapes. Returns the maximum of all
+             * three points at the start and at the end of the exposure for all axes.
+             *
+             * @return AGPTracer::Entities::Vec3<T> Maximum coordinates of an axis-aligned bounding box around the triangle.
+             */
+            constexpr auto maxcoord() const -> AGPTracer::Entities::Vec3<T>;
+
+            /**
+             * @brief Minimum coordinates of an axis-aligned bounding box around the triangle at a given time.
+             *
+             * This is used by motion blur acceleration structures, which interpolate the bounding boxes of their nodes
+             * between the start and the end of the exposure.
+             *
+             * @param time Time at which we want the bounding box, from 0 for the start of the exposure to 1 for the end.
+             * @return AGPTracer::Entities::Vec3<T> Minimum coordinates of an axis-aligned bounding box around the triangle at that time.
+             */
+            template<class T2>
+            constexpr auto mincoord(T2 time) const -> AGPTracer::Entities::Vec3<T>;
+
+            /**
+             * @brief Maximum coordinates of an axis-aligned bounding box around the triangle at a given time.
+             *
+             * This is used by motion blur acceleration structures, which interpolate the bounding boxes of their nodes
+             * between the start and the end of the exposure.
+             *
+             * @param time Time at which we want the bounding box, from 0 for the start of the exposure to 1 for the end.
+             * @return AGPTracer::Entities::Vec3<T> Maximum coordinates of an axis-aligned bounding box around the triangle at that time.
+             */
+            template<class T2>
+            constexpr auto maxcoord(T2 time) const -> AGPTracer::Entities::Vec3<T>;
+    };
+}
+
+#include "shapes/TriangleMotionblur_t.tpp"
+
+#endif
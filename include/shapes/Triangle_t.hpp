@@ -1,10 +1,13 @@
 #ifndef AGPTRACER_SHAPES_TRIANGLE_T_HPP
 #define AGPTRACER_SHAPES_TRIANGLE_T_HPP
 
+#include "entities/Octahedral.hpp"
 #include "entities/Ray_t.hpp"
 #include "entities/TransformMatrix_t.hpp"
 #include "entities/Vec3.hpp"
+#include "entities/Visibility.hpp"
 #include <array>
+#include <cstdint>
 #include <optional>
 #include <sycl/sycl.hpp>
 
@@ -13,7 +16,11 @@ namespace AGPTracer::Shapes {
      * @brief The triangle class defines a triangle shape that can be intersected by rays.
      *
      * A triangle is defined by three points, in counter-clockwise order. Its transformation matrix is used
-     * to modify those points.
+     * to modify those points. Triangles don't store their matrix, which they share with the other triangles of
+     * the same object, but its index in the palette of transformation matrices of their scene. The matrix is
+     * given to the triangle when it is updated. The normals and tangent of the triangle are stored with the octahedral encoding
+     * and its texture coordinates as half precision floats, and are decoded when queried, so that shading a hit
+     * fetches much less memory than the points.
      *
      * @tparam T Floating point datatype to use
      */
@@ -23,39 +30,45 @@ namespace AGPTracer::Shapes {
             /**
              * @brief Construct a new Triangle_t object with a transformation matrix and material from three points.
              *
+             * The triangle is not transformed until it is updated.
+             *
              * @param material Material of the triangle. Material that will be bounced on at intersection.
-             * @param transform_matrix Transformation used by the triangle to modify its points.
+             * @param transformation Index of the transformation matrix used by the triangle to modify its points, in the palette of its scene.
              * @param points Array of three points, in counter-clockwise order, defining the triangle.
              * @param normals Array of three normals, in counter-clockwise order, at the three points of the triangle.
              * @param texcoord Array of three texture coordinates with two components, in counter-clockwise order, at the three points of the triangle. [x0, y0, x1, y1, x2, y2]
+             * @param mask Visibility mask of the triangle. Only rays whose visibility has a bit in common with it intersect the triangle. Visible to all rays by default.
              */
             Triangle_t(size_t material,
-                       Entities::TransformMatrix_t<T> transform_matrix,
+                       uint32_t transformation,
                        std::array<AGPTracer::Entities::Vec3<T>, 3> points,
                        std::optional<std::array<AGPTracer::Entities::Vec3<T>, 3>> normals,
-                       std::optional<std::array<std::array<T, 2>, 3>> texcoord); // In c++26 sqrt is constexpr
+                       std::optional<std::array<std::array<T, 2>, 3>> texcoord,
+                       uint32_t mask = Entities::Visibility::all); // In c++26 sqrt is constexpr
 
-            size_t material_; /**< @brief Material of which the shape is made of.*/
-            AGPTracer::Entities::TransformMatrix_t<T> transformation_; /**< @brief Transformation matrix used to modify the position and other transformations of the shape.*/
+            uint32_t material_; /**< @brief Material of which the shape is made of.*/
+            uint32_t mask_; /**< @brief Visibility mask of the shape. Rays whose visibility has no bit in common with it don't intersect the shape.*/
+            uint32_t transformation_; /**< @brief Index of the transformation matrix used to modify the position and other transformations of the shape, in the palette of its scene.*/
             std::array<AGPTracer::Entities::Vec3<T>, 3>
                 points_orig_; /**< @brief Array of the three un-transformed points of the triangle, in counter-clockwise order. Transformed by the transform matrix on update to give points.*/
-            std::array<AGPTracer::Entities::Vec3<T>, 3>
-                normals_orig_; /**< @brief Array of the three un-transformed normals of the triangle, in counter-clockwise order. Transformed by the transform matrix on update to give normals.*/
-            std::array<std::array<T, 2>, 3> texture_coordinates_; /**< @brief Array of the three texture coordinates with two components of the triangle, in counter-clockwise order. Transformed by the
-                                                           transform matrix on update to give texture coordinates. [[x0, y0], [x1, y1], [x2, y2]]*/
+            std::array<uint32_t, 3> normals_orig_; /**< @brief Array of the three un-transformed normals of the triangle, octahedral encoded, in counter-clockwise order. Transformed on update.*/
+            std::array<std::array<sycl::half, 2>, 3>
+                texture_coordinates_; /**< @brief Array of the three half precision texture coordinates of the triangle, in counter-clockwise order. [[x0, y0], [x1, y1], [x2, y2]]*/
             std::array<AGPTracer::Entities::Vec3<T>, 3> points_; /**< @brief Array of the three points of the triangle, in counter-clockwise order.*/
-            std::array<AGPTracer::Entities::Vec3<T>, 3> normals_; /**< @brief Array of the three  normals of the triangle, in counter-clockwise order.*/
+            std::array<uint32_t, 3> normals_; /**< @brief Array of the three normals of the triangle, in counter-clockwise order, octahedral encoded.*/
             AGPTracer::Entities::Vec3<T> v0v1_; /**< @brief Cached vector from point 0 to point 1. Used for intersection.*/
             AGPTracer::Entities::Vec3<T> v0v2_; /**< @brief Cached vector from point 0 to point 2. Used for intersection.*/
             std::array<T, 2> tuv_to_world_; /**< @brief Matrix to change referential from texture coordinate space to world space. Used to compute tangent vector.*/
-            AGPTracer::Entities::Vec3<T> tangent_vec_; /**< @brief Tangent vector of the triangle in world space. Points to positive u in texture coordinates. Used for normal mapping.*/
+            uint32_t tangent_vec_; /**< @brief Tangent vector of the triangle in world space, octahedral encoded. Points to positive u in texture coordinates. Used for normal mapping.*/
 
             /**
              * @brief Updates the triangle's points from its transformation matrix.
              *
-             * The points are created from the transformation matrix and the original points, stored in normals_orig_.
+             * The points are created from the transformation matrix and the original points, stored in points_orig_.
+             *
+             * @param transformation Transformation matrix of the triangle, at index transformation_ of the palette of its scene.
              */
-            auto update() -> void; // In c++26 sqrt is constexpr
+            auto update(const Entities::TransformMatrix_t<T>& transformation) -> void; // In c++26 sqrt is constexpr
 
             /**
              * @brief Intersects a ray with the triangle, and stores information about the intersection.
@@ -74,6 +87,30 @@ namespace AGPTracer::Shapes {
             template<size_t N>
             constexpr auto intersection(const AGPTracer::Entities::Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv) const -> bool;
 
+            /**
+             * @brief Intersects a ray with a triangle given by its first point and its two edges from that point.
+             *
+             * This is the intersection used by the triangle, for callers that store the points and edges of triangles apart from
+             * the rest of their data, so that only what the intersection reads is fetched.
+             *
+             * @tparam N Number of mediums in the ray's medium list
+             * @param point First point of the triangle.
+             * @param v0v1 Vector from the first point of the triangle to the second.
+             * @param v0v2 Vector from the first point of the triangle to the third.
+             * @param ray Ray to be tested for intersection with the triangle.
+             * @param[out] t Distance at which the intersection ocurred, from ray origin. Undefined if not intersected.
+             * @param[out] uv Coordinates in object space of the intersection. Undefined if not intersected. The coordinates are in barycentric coordinates, minus w [u, v].
+             * @return true The ray intersected the triangle, t and uv are defined.
+             * @return false The ray doesn't intersect the triangle, t and uv are undefined.
+             */
+            template<size_t N>
+            constexpr static auto intersection(const AGPTracer::Entities::Vec3<T>& point,
+                                               const AGPTracer::Entities::Vec3<T>& v0v1,
+                                               const AGPTracer::Entities::Vec3<T>& v0v2,
+                                               const AGPTracer::Entities::Ray_t<T, N>& ray,
+                                               T& t,
+                                               std::array<T, 2>& uv) -> bool;
+
             /**
              * @brief Returns the surface normal at a point in object coordinates.
              *
@@ -86,7 +123,7 @@ namespace AGPTracer::Shapes {
              * @return AGPTracer::Entities::Vec3<T> Normal vector at the specified coordinates.
              */
             template<class T2>
-            constexpr auto normal(T2 time, std::array<T, 2> uv) const -> AGPTracer::Entities::Vec3<T>;
+            auto normal(T2 time, std::array<T, 2> uv) const -> AGPTracer::Entities::Vec3<T>; // In c++26 sqrt is constexpr
 
             /**
              * @brief Returns the surface normal and texture coordinates at a point in object coordinates.
@@ -102,7 +139,7 @@ namespace AGPTracer::Shapes {
              * @return AGPTracer::Entities::Vec3<T> Normal vector at the specified coordinates.
              */
             template<class T2>
-            constexpr auto normal_uv(T2 time, std::array<T, 2> uv, std::array<T, 2>& tuv) const -> AGPTracer::Entities::Vec3<T>;
+            auto normal_uv(T2 time, std::array<T, 2> uv, std::array<T, 2>& tuv) const -> AGPTracer::Entities::Vec3<T>; // In c++26 sqrt is constexpr
 
             /**
              * @brief Returns the surface normal, texture coordinates and tangent vector at a point in object coordinates.
@@ -152,6 +189,24 @@ namespace AGPTracer::Shapes {
              * @return AGPTracer::Entities::Vec3<T> Maximum coordinates of an axis-aligned bounding box around the triangle.
              */
             constexpr auto maxcoord() const -> AGPTracer::Entities::Vec3<T>;
+
+        private:
+            /**
+             * @brief Transforms an encoded normal by a transformation matrix.
+             *
+             * @param transformation Transformation matrix of the triangle.
+             * @param normal Un-transformed normal, octahedral encoded.
+             * @return uint32_t Transformed normal, octahedral encoded.
+             */
+            static auto transform_normal(const Entities::TransformMatrix_t<T>& transformation, uint32_t normal) -> uint32_t; // In c++26 sqrt is constexpr
+
+            /**
+             * @brief Interpolates the texture coordinates of the three points of the triangle.
+             *
+             * @param distance Barycentric coordinates at which to interpolate the texture coordinates [w, u, v].
+             * @return std::array<T, 2> Texture coordinates at the specified coordinates.
+             */
+            auto texture_coordinates(const AGPTracer::Entities::Vec3<T>& distance) const -> std::array<T, 2>;
     };
 }
 
@@ -5,30 +5,37 @@
 
 template<typename T>
 AGPTracer::Shapes::Triangle_t<T>::Triangle_t(size_t material,
-                                             Entities::TransformMatrix_t<T> transform_matrix,
+                                             uint32_t transformation,
                                              std::array<AGPTracer::Entities::Vec3<T>, 3> points, // In c++26 sqrt is constexpr
                                              const std::optional<std::array<AGPTracer::Entities::Vec3<T>, 3>> normals,
-                                             const std::optional<std::array<std::array<T, 2>, 3>> texcoord) :
-        material_(material), transformation_(std::move(transform_matrix)), points_orig_{points} {
+                                             const std::optional<std::array<std::array<T, 2>, 3>> texcoord,
+                                             uint32_t mask) :
+        material_(static_cast<uint32_t>(material)), mask_(mask), transformation_(transformation), points_orig_{points} {
 
-    const AGPTracer::Entities::Vec3<T> nor = (points_orig_[1] - points_orig_[0]).cross(points_orig_[2] - points_orig_[0]).normalize_inplace();
-    normals_orig_                          = normals.value_or(std::array<AGPTracer::Entities::Vec3<T>, 3>{nor, nor, nor});
+    const AGPTracer::Entities::Vec3<T> nor                     = (points_orig_[1] - points_orig_[0]).cross(points_orig_[2] - points_orig_[0]).normalize_inplace();
+    const std::array<AGPTracer::Entities::Vec3<T>, 3> normals3 = normals.value_or(std::array<AGPTracer::Entities::Vec3<T>, 3>{nor, nor, nor});
+    normals_orig_ = {AGPTracer::Entities::Octahedral::encode(normals3[0]), AGPTracer::Entities::Octahedral::encode(normals3[1]), AGPTracer::Entities::Octahedral::encode(normals3[2])};
 
-    texture_coordinates_ = texcoord.value_or(std::array<std::array<T, 2>, 3>{
+    const std::array<std::array<T, 2>, 3> texcoord3 = texcoord.value_or(std::array<std::array<T, 2>, 3>{
         std::array<T, 2>{0, 1},
          std::array<T, 2>{0, 0},
          std::array<T, 2>{1, 0}
     });
+    for (unsigned int i = 0; i < 3; ++i) {
+        texture_coordinates_[i] = {static_cast<sycl::half>(static_cast<float>(texcoord3[i][0])), static_cast<sycl::half>(static_cast<float>(texcoord3[i][1]))};
+    }
 
-    points_ = {transformation_.multVec(points_orig_[0]), transformation_.multVec(points_orig_[1]), transformation_.multVec(points_orig_[2])};
-
-    normals_ = {transformation_.multDir(normals_orig_[0]), transformation_.multDir(normals_orig_[1]), transformation_.multDir(normals_orig_[2])}; // was transformation_ before
+    points_  = points_orig_;
+    normals_ = normals_orig_;
 
     v0v1_ = points_[1] - points_[0];
     v0v2_ = points_[2] - points_[0];
 
-    const std::array<T, 2> tuv0v1 = {texture_coordinates_[1][0] - texture_coordinates_[0][0], texture_coordinates_[1][1] - texture_coordinates_[0][1]};
-    const std::array<T, 2> tuv0v2 = {texture_coordinates_[2][0] - texture_coordinates_[0][0], texture_coordinates_[2][1] - texture_coordinates_[0][1]};
+    // The tangent is computed from the stored texture coordinates, so that it doesn't depend on the precision they were given in
+    const std::array<T, 2> tuv0v1 = {static_cast<T>(texture_coordinates_[1][0]) - static_cast<T>(texture_coordinates_[0][0]),
+                                     static_cast<T>(texture_coordinates_[1][1]) - static_cast<T>(texture_coordinates_[0][1])};
+    const std::array<T, 2> tuv0v2 = {static_cast<T>(texture_coordinates_[2][0]) - static_cast<T>(texture_coordinates_[0][0]),
+                                     static_cast<T>(texture_coordinates_[2][1]) - static_cast<T>(texture_coordinates_[0][1])};
 
     if (std::abs(tuv0v1[0] * tuv0v2[1] - tuv0v1[1] * tuv0v2[0]) >= std::numeric_limits<T>::min()) {
         const T invdet = 1.0 / (tuv0v1[0] * tuv0v2[1] - tuv0v1[1] * tuv0v2[0]);
@@ -37,32 +44,48 @@ AGPTracer::Shapes::Triangle_t<T>::Triangle_t(size_t material,
     else {
         tuv_to_world_ = {1.0, 0.0};
     }
-    tangent_vec_ = v0v1_ * tuv_to_world_[0] + v0v2_ * tuv_to_world_[1];
+    tangent_vec_ = AGPTracer::Entities::Octahedral::encode(v0v1_ * tuv_to_world_[0] + v0v2_ * tuv_to_world_[1]);
 }
 
 template<typename T>
-auto AGPTracer::Shapes::Triangle_t<T>::update() -> void { // In c++26 sqrt is constexpr
-    points_  = {transformation_.multVec(points_orig_[0]), transformation_.multVec(points_orig_[1]), transformation_.multVec(points_orig_[2])};
-    normals_ = {transformation_.multDir(normals_orig_[0]), transformation_.multDir(normals_orig_[1]), transformation_.multDir(normals_orig_[2])};
+auto AGPTracer::Shapes::Triangle_t<T>::update(const Entities::TransformMatrix_t<T>& transformation) -> void { // In c++26 sqrt is constexpr
+    points_  = {transformation.multVec(points_orig_[0]), transformation.multVec(points_orig_[1]), transformation.multVec(points_orig_[2])};
+    normals_ = {transform_normal(transformation, normals_orig_[0]), transform_normal(transformation, normals_orig_[1]), transform_normal(transformation, normals_orig_[2])};
 
     v0v1_ = points_[1] - points_[0];
     v0v2_ = points_[2] - points_[0];
 
-    tangent_vec_ = v0v1_ * tuv_to_world_[0] + v0v2_ * tuv_to_world_[1];
+    tangent_vec_ = AGPTracer::Entities::Octahedral::encode(v0v1_ * tuv_to_world_[0] + v0v2_ * tuv_to_world_[1]);
+}
+
+template<typename T>
+auto AGPTracer::Shapes::Triangle_t<T>::transform_normal(const Entities::TransformMatrix_t<T>& transformation, uint32_t normal) -> uint32_t {
+    return AGPTracer::Entities::Octahedral::encode(transformation.multDir(AGPTracer::Entities::Octahedral::decode<T>(normal)));
 }
 
 template<typename T>
 template<size_t N>
 constexpr auto AGPTracer::Shapes::Triangle_t<T>::intersection(const AGPTracer::Entities::Ray_t<T, N>& ray, T& t, std::array<T, 2>& uv) const -> bool {
-    const AGPTracer::Entities::Vec3<T> pvec = ray.direction_.cross(v0v2_);
-    const T det                             = v0v1_.dot(pvec);
+    return intersection(points_[0], v0v1_, v0v2_, ray, t, uv);
+}
+
+template<typename T>
+template<size_t N>
+constexpr auto AGPTracer::Shapes::Triangle_t<T>::intersection(const AGPTracer::Entities::Vec3<T>& point,
+                                                              const AGPTracer::Entities::Vec3<T>& v0v1,
+                                                              const AGPTracer::Entities::Vec3<T>& v0v2,
+                                                              const AGPTracer::Entities::Ray_t<T, N>& ray,
+                                                              T& t,
+                                                              std::array<T, 2>& uv) -> bool {
+    const AGPTracer::Entities::Vec3<T> pvec = ray.direction_.cross(v0v2);
+    const T det                             = v0v1.dot(pvec);
 
     if (std::abs(det) < std::numeric_limits<T>::min()) {
         return false;
     }
 
     const T invdet                          = 1.0 / det;
-    const AGPTracer::Entities::Vec3<T> tvec = ray.origin_ - points_[0];
+    const AGPTracer::Entities::Vec3<T> tvec = ray.origin_ - point;
     const T u                               = tvec.dot(pvec) * invdet;
     uv[0]                                   = u;
 
@@ -70,7 +93,7 @@ constexpr auto AGPTracer::Shapes::Triangle_t<T>::intersection(const AGPTracer::E
         return false;
     }
 
-    const AGPTracer::Entities::Vec3<T> qvec = tvec.cross(v0v1_);
+    const AGPTracer::Entities::Vec3<T> qvec = tvec.cross(v0v1);
     const T v                               = ray.direction_.dot(qvec) * invdet;
     uv[1]                                   = v;
 
@@ -78,7 +101,7 @@ constexpr auto AGPTracer::Shapes::Triangle_t<T>::intersection(const AGPTracer::E
         return false;
     }
 
-    t = v0v2_.dot(qvec) * invdet;
+    t = v0v2.dot(qvec) * invdet;
 
     if (t < 0.0) {
         return false;
@@ -89,24 +112,19 @@ constexpr auto AGPTracer::Shapes::Triangle_t<T>::intersection(const AGPTracer::E
 
 template<typename T>
 template<class T2>
-constexpr auto AGPTracer::Shapes::Triangle_t<T>::normal(T2 time, std::array<T, 2> uv) const -> AGPTracer::Entities::Vec3<T> {
+auto AGPTracer::Shapes::Triangle_t<T>::normal(T2 time, std::array<T, 2> uv) const -> AGPTracer::Entities::Vec3<T> { // In c++26 sqrt is constexpr
     const AGPTracer::Entities::Vec3<T> distance = AGPTracer::Entities::Vec3<T>(1.0 - uv[0] - uv[1], uv[0], uv[1]);
-    return {distance[0] * normals_[0][0] + distance[1] * normals_[1][0] + distance[2] * normals_[2][0],
-            distance[0] * normals_[0][1] + distance[1] * normals_[1][1] + distance[2] * normals_[2][1],
-            distance[0] * normals_[0][2] + distance[1] * normals_[1][2] + distance[2] * normals_[2][2]};
-    // Matrix multiplication, optimise.
+    return AGPTracer::Entities::Octahedral::decode<T>(normals_[0]) * distance[0] + AGPTracer::Entities::Octahedral::decode<T>(normals_[1]) * distance[1]
+         + AGPTracer::Entities::Octahedral::decode<T>(normals_[2]) * distance[2];
 }
 
 template<typename T>
 template<class T2>
-constexpr auto AGPTracer::Shapes::Triangle_t<T>::normal_uv(T2 time, std::array<T, 2> uv, std::array<T, 2>& tuv) const -> AGPTracer::Entities::Vec3<T> {
+auto AGPTracer::Shapes::Triangle_t<T>::normal_uv(T2 time, std::array<T, 2> uv, std::array<T, 2>& tuv) const -> AGPTracer::Entities::Vec3<T> { // In c++26 sqrt is constexpr
     const AGPTracer::Entities::Vec3<T> distance = AGPTracer::Entities::Vec3<T>(1.0 - uv[0] - uv[1], uv[0], uv[1]);
-    // Matrix multiplication, optimise.
-    tuv = {distance[0] * texture_coordinates_[0][0] + distance[1] * texture_coordinates_[1][0] + distance[2] * texture_coordinates_[2][0],
-           distance[0] * texture_coordinates_[0][1] + distance[1] * texture_coordinates_[1][1] + distance[2] * texture_coordinates_[2][1]};
-    return {distance[0] * normals_[0][0] + distance[1] * normals_[1][0] + distance[2] * normals_[2][0],
-            distance[0] * normals_[0][1] + distance[1] * normals_[1][1] + distance[2] * normals_[2][1],
-            distance[0] * normals_[0][2] + distance[1] * normals_[1][2] + distance[2] * normals_[2][2]};
+    tuv                                         = texture_coordinates(distance);
+    return AGPTracer::Entities::Octahedral::decode<T>(normals_[0]) * distance[0] + AGPTracer::Entities::Octahedral::decode<T>(normals_[1]) * distance[1]
+         + AGPTracer::Entities::Octahedral::decode<T>(normals_[2]) * distance[2];
 }
 
 template<typename T>
@@ -114,18 +132,21 @@ template<class T2>
 auto AGPTracer::Shapes::Triangle_t<T>::normal_uv_tangent(T2 time, std::array<T, 2> uv, std::array<T, 2>& tuv, AGPTracer::Entities::Vec3<T>& tangentvec) const // In c++26 sqrt is constexpr
     -> AGPTracer::Entities::Vec3<T> {
     const AGPTracer::Entities::Vec3<T> distance = AGPTracer::Entities::Vec3<T>(1.0 - uv[0] - uv[1], uv[0], uv[1]);
-    // Matrix multiplication, optimise.
-    tuv = {distance[0] * texture_coordinates_[0][0] + distance[1] * texture_coordinates_[1][0] + distance[2] * texture_coordinates_[2][0],
-           distance[0] * texture_coordinates_[0][1] + distance[1] * texture_coordinates_[1][1] + distance[2] * texture_coordinates_[2][1]};
+    tuv                                         = texture_coordinates(distance);
 
-    const AGPTracer::Entities::Vec3<T> normalvec = AGPTracer::Entities::Vec3<T>(distance[0] * normals_[0][0] + distance[1] * normals_[1][0] + distance[2] * normals_[2][0],
-                                                                                distance[0] * normals_[0][1] + distance[1] * normals_[1][1] + distance[2] * normals_[2][1],
-                                                                                distance[0] * normals_[0][2] + distance[1] * normals_[1][2] + distance[2] * normals_[2][2]);
+    const AGPTracer::Entities::Vec3<T> normalvec = AGPTracer::Entities::Octahedral::decode<T>(normals_[0]) * distance[0] + AGPTracer::Entities::Octahedral::decode<T>(normals_[1]) * distance[1]
+                                                 + AGPTracer::Entities::Octahedral::decode<T>(normals_[2]) * distance[2];
 
-    tangentvec = tangent_vec_.cross(normalvec).normalize_inplace();
+    tangentvec = AGPTracer::Entities::Octahedral::decode<T>(tangent_vec_).cross(normalvec).normalize_inplace();
     return normalvec;
 }
 
+template<typename T>
+auto AGPTracer::Shapes::Triangle_t<T>::texture_coordinates(const AGPTracer::Entities::Vec3<T>& distance) const -> std::array<T, 2> {
+    return {distance[0] * static_cast<T>(texture_coordinates_[0][0]) + distance[1] * static_cast<T>(texture_coordinates_[1][0]) + distance[2] * static_cast<T>(texture_coordinates_[2][0]),
+            distance[0] * static_cast<T>(texture_coordinates_[0][1]) + distance[1] * static_cast<T>(texture_coordinates_[1][1]) + distance[2] * static_cast<T>(texture_coordinates_[2][1])};
+}
+
 template<typename T>
 template<class T2>
 auto AGPTracer::Shapes::Triangle_t<T>::normal_face(T2 time) const -> AGPTracer::Entities::Vec3<T> { // In c++26 sqrt is constexpr
@@ -13,6 +13,10 @@
 namespace AGPTracer::Shapes {
 }
 
+#include "AffineTriangle_t.hpp"
+#include "IndexedMesh_t.hpp"
+#include "MeshTop_t.hpp"
+#include "TriangleMotionblur_t.hpp"
 #include "Triangle_t.hpp"
 
 #endif
@@ -1,3 +1,4 @@
+#include "acceleration_structures/BVHCache_t.hpp"
 #include "cameras/SphericalCamera_t.hpp"
 #include "entities/MediumList_t.hpp"
 #include "entities/MeshGeometry_t.hpp"
@@ -12,6 +13,7 @@
 #include "mediums/NonAbsorber_t.hpp"
 #include "shapes/Triangle_t.hpp"
 #include "skyboxes/SkyboxFlat_t.hpp"
+#include <filesystem>
 #include <numbers>
 #include <random>
 #include <span>
@@ -26,18 +28,18 @@ using AGPTracer::Shapes::Triangle_t;
 constexpr size_t TRIANGLE_BUFFER_SIZE = 12;
 auto get_triangles() -> std::array<Triangle_t<double>, TRIANGLE_BUFFER_SIZE> {
     return {
-        Triangle_t<double>{0, TransformMatrix_t{}, std::array<Vec3<double>, 3>{Vec3<double>{-2, 4, 2}, Vec3<double>{-2, 4, 0}, Vec3<double>{0, 4, 0}},    {}, {}},
-        Triangle_t<double>{1, TransformMatrix_t{}, std::array<Vec3<double>, 3>{Vec3<double>{-3, 3, -1}, Vec3<double>{-3, 3, -3}, Vec3<double>{0, 3, -1}}, {}, {}},
-        Triangle_t<double>{2, TransformMatrix_t{}, std::array<Vec3<double>, 3>{Vec3<double>{-3, 4, -3}, Vec3<double>{0, 4, -3}, Vec3<double>{0, 4, -1}},  {}, {}},
-        Triangle_t<double>{3, TransformMatrix_t{}, std::array<Vec3<double>, 3>{Vec3<double>{0, 5, 0}, Vec3<double>{0, 5, -4}, Vec3<double>{4, 5, -4}},    {}, {}},
-        Triangle_t<double>{4, TransformMatrix_t{}, std::array<Vec3<double>, 3>{Vec3<double>{1, 2, 0}, Vec3<double>{0, 2, 0}, Vec3<double>{0, 3, 0}},      {}, {}},
-        Triangle_t<double>{0, TransformMatrix_t{}, std::array<Vec3<double>, 3>{Vec3<double>{0, 3, 0}, Vec3<double>{1, 3, 0}, Vec3<double>{1, 2, 0}},      {}, {}},
-        Triangle_t<double>{1, TransformMatrix_t{}, std::array<Vec3<double>, 3>{Vec3<double>{0, 3, 1}, Vec3<double>{0, 2, 1}, Vec3<double>{1, 2, 1}},      {}, {}},
-        Triangle_t<double>{2, TransformMatrix_t{}, std::array<Vec3<double>, 3>{Vec3<double>{1, 2, 1}, Vec3<double>{1, 3, 1}, Vec3<double>{0, 3, 1}},      {}, {}},
-        Triangle_t<double>{3, TransformMatrix_t{}, std::array<Vec3<double>, 3>{Vec3<double>{1, 3, 1}, Vec3<double>{1, 2, 1}, Vec3<double>{1, 2, 0}},      {}, {}},
-        Triangle_t<double>{4, TransformMatrix_t{}, std::array<Vec3<double>, 3>{Vec3<double>{1, 2, 0}, Vec3<double>{1, 3, 0}, Vec3<double>{1, 3, 1}},      {}, {}},
-        Triangle_t<double>{0, TransformMatrix_t{}, std::array<Vec3<double>, 3>{Vec3<double>{0, 2, 0}, Vec3<double>{0, 2, 1}, Vec3<double>{0, 3, 1}},      {}, {}},
-        Triangle_t<double>{1, TransformMatrix_t{}, std::array<Vec3<double>, 3>{Vec3<double>{0, 3, 1}, Vec3<double>{0, 3, 0}, Vec3<double>{0, 2, 0}},      {}, {}}
+        Triangle_t<double>{0, 0, std::array<Vec3<double>, 3>{Vec3<double>{-2, 4, 2}, Vec3<double>{-2, 4, 0}, Vec3<double>{0, 4, 0}},    {}, {}},
+        Triangle_t<double>{1, 0, std::array<Vec3<double>, 3>{Vec3<double>{-3, 3, -1}, Vec3<double>{-3, 3, -3}, Vec3<double>{0, 3, -1}}, {}, {}},
+        Triangle_t<double>{2, 0, std::array<Vec3<double>, 3>{Vec3<double>{-3, 4, -3}, Vec3<double>{0, 4, -3}, Vec3<double>{0, 4, -1}},  {}, {}},
+        Triangle_t<double>{3, 0, std::array<Vec3<double>, 3>{Vec3<double>{0, 5, 0}, Vec3<double>{0, 5, -4}, Vec3<double>{4, 5, -4}},    {}, {}},
+        Triangle_t<double>{4, 0, std::array<Vec3<double>, 3>{Vec3<double>{1, 2, 0}, Vec3<double>{0, 2, 0}, Vec3<double>{0, 3, 0}},      {}, {}},
+        Triangle_t<double>{0, 0, std::array<Vec3<double>, 3>{Vec3<double>{0, 3, 0}, Vec3<double>{1, 3, 0}, Vec3<double>{1, 2, 0}},      {}, {}},
+        Triangle_t<double>{1, 0, std::array<Vec3<double>, 3>{Vec3<double>{0, 3, 1}, Vec3<double>{0, 2, 1}, Vec3<double>{1, 2, 1}},      {}, {}},
+        Triangle_t<double>{2, 0, std::array<Vec3<double>, 3>{Vec3<double>{1, 2, 1}, Vec3<double>{1, 3, 1}, Vec3<double>{0, 3, 1}},      {}, {}},
+        Triangle_t<double>{3, 0, std::array<Vec3<double>, 3>{Vec3<double>{1, 3, 1}, Vec3<double>{1, 2, 1}, Vec3<double>{1, 2, 0}},      {}, {}},
+        Triangle_t<double>{4, 0, std::array<Vec3<double>, 3>{Vec3<double>{1, 2, 0}, Vec3<double>{1, 3, 0}, Vec3<double>{1, 3, 1}},      {}, {}},
+        Triangle_t<double>{0, 0, std::array<Vec3<double>, 3>{Vec3<double>{0, 2, 0}, Vec3<double>{0, 2, 1}, Vec3<double>{0, 3, 1}},      {}, {}},
+        Triangle_t<double>{1, 0, std::array<Vec3<double>, 3>{Vec3<double>{0, 3, 1}, Vec3<double>{0, 3, 0}, Vec3<double>{0, 2, 0}},      {}, {}}
     };
 }
 
@@ -74,7 +76,7 @@ auto main() -> int {
         constexpr size_t size_x = 600;
         constexpr size_t size_y = 400;
         const AGPTracer::Shapes::Triangle_t<double> triangle{
-            0, TransformMatrix_t{},
+            0, 0,
              std::array<Vec3<double>, 3>{Vec3<double>{0, 2, 0}, Vec3<double>{1, 2, 0}, Vec3<double>{0, 2, 1}},
              {},
              {}
@@ -85,6 +87,7 @@ auto main() -> int {
         auto materials = get_materials();
         auto mediums   = get_mediums();
         AGPTracer::Entities::Scene_t<double, Triangle_t, Diffuse_t, NonAbsorber_t> scene(triangles, materials, mediums);
+        scene.build_acc(AGPTracer::AccelerationStructures::BVHCache_t<double>(std::filesystem::temp_directory_path() / "another_gpu_path_tracer"));
         AGPTracer::Entities::RandomGenerator_t<double, std::mt19937, AGPTracer::Entities::UniformDistribution_t> random_generator(queue,
                                                                                                                                   size_x,
                                                                                                                                   size_y); // std::uniform_real_distribution doesn't compile on cuda :(
@@ -0,0 +1,1996 @@
+#include "acceleration_structures/BVHCache_t.hpp"
+#include "acceleration_structures/MotionBVH_t.hpp"
+#include "acceleration_structures/MultiGrid_t.hpp"
+#include "acceleration_structures/WideBVH_t.hpp"
+#include "cameras/SphericalCamera_t.hpp"
+#include "entities/MediumList_t.hpp"
+#include "entities/MeshGeometry_t.hpp"
+#include "entities/RandomGenerator_t.hpp"
+#include "entities/Ray_t.hpp"
+#include "entities/Scene_t.hpp"
+#include "images/SimpleImage_t.hpp"
+#include "materials/Diffuse_t.hpp"
+#include "mediums/NonAbsorber_t.hpp"
+#include "shapes/AffineTriangle_t.hpp"
+#include "shapes/TriangleMotionblur_t.hpp"
+#include "shapes/Triangle_t.hpp"
+#include "skyboxes/SkyboxFlat_t.hpp"
+#include <algorithm>
+#include <array>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+using AGPTracer::AccelerationStructures::BVH4_t;
+using AGPTracer::AccelerationStructures::BVH8_t;
+using AGPTracer::AccelerationStructures::BVHCache_t;
+using AGPTracer::AccelerationStructures::BVHNode_t;
+using AGPTracer::AccelerationStructures::BVH_t;
+using AGPTracer::AccelerationStructures::CompressedBVH4_t;
+using AGPTracer::AccelerationStructures::CompressedBVH8_t;
+using AGPTracer::AccelerationStructures::CompressedBVHNode_t;
+using AGPTracer::AccelerationStructures::MotionBVH_t;
+using AGPTracer::AccelerationStructures::MultiGrid_t;
+using AGPTracer::AccelerationStructures::WideBVHNode_t;
+using AGPTracer::Cameras::SphericalCamera_t;
+using AGPTracer::Entities::ClipPlane_t;
+using AGPTracer::Entities::Hit_t;
+using AGPTracer::Entities::MediumList_t;
+using AGPTracer::Entities::MeshGeometry_t;
+using AGPTracer::Entities::RandomGenerator_t;
+using AGPTracer::Entities::RayFlags_t;
+using AGPTracer::Entities::Ray_t;
+using AGPTracer::Entities::Scene_t;
+using AGPTracer::Entities::TransformMatrix_t;
+using AGPTracer::Entities::Vec3;
+using AGPTracer::Images::SimpleImage_t;
+using AGPTracer::Materials::Diffuse_t;
+using AGPTracer::Mediums::NonAbsorber_t;
+using AGPTracer::Shapes::AffineTriangle_t;
+using AGPTracer::Shapes::MeshTop_t;
+using AGPTracer::Shapes::Triangle_t;
+using AGPTracer::Shapes::TriangleMotionblur_t;
+using AGPTracer::Skyboxes::SkyboxFlat_t;
+namespace Visibility = AGPTracer::Entities::Visibility;
+
+constexpr size_t N_RANDOM_TRIANGLES      = 500;
+constexpr size_t N_RANDOM_TRIANGLES_LBVH = 3000;
+constexpr size_t N_RANDOM_RAYS           = 256;
+constexpr size_t N_RANDOM_INSTANCES      = 40;
+constexpr size_t N_BENCHMARK_RAYS        = 65536;
+constexpr size_t PACKET_SIZE             = 64;
+
+auto get_random_triangles(std::mt19937& rng, size_t n_triangles) -> std::vector<Triangle_t<double>> {
+    std::uniform_real_distribution<double> position(-10, 10);
+    std::uniform_real_distribution<double> offset(-1, 1);
+    std::vector<Triangle_t<double>> triangles;
+    triangles.reserve(n_triangles);
+
+    for (size_t i = 0; i < n_triangles; ++i) {
+        const Vec3<double> centre(position(rng), position(rng), position(rng));
+        triangles.emplace_back(0,
+                               0,
+                               std::array<Vec3<double>, 3>{centre + Vec3<double>(offset(rng), offset(rng), offset(rng)),
+                                                           centre + Vec3<double>(offset(rng), offset(rng), offset(rng)),
+                                                           centre + Vec3<double>(offset(rng), offset(rng), offset(rng))},
+                               std::nullopt,
+                               std::nullopt);
+    }
+
+    return triangles;
+}
+
+auto get_random_slivers(std::mt19937& rng, size_t n_triangles) -> std::vector<Triangle_t<double>> {
+    std::uniform_real_distribution<double> position(-10, 10);
+    std::uniform_real_distribution<double> offset(-0.05, 0.05);
+    std::uniform_real_distribution<double> unif(-1, 1);
+    std::vector<Triangle_t<double>> triangles;
+    triangles.reserve(n_triangles);
+
+    for (size_t i = 0; i < n_triangles; ++i) {
+        const Vec3<double> centre(position(rng), position(rng), position(rng));
+        const Vec3<double> length = Vec3<double>(unif(rng), unif(rng), unif(rng)).normalize_inplace() * 8;
+        triangles.emplace_back(0,
+                               0,
+                               std::array<Vec3<double>, 3>{centre - length + Vec3<double>(offset(rng), offset(rng), offset(rng)),
+                                                           centre + length + Vec3<double>(offset(rng), offset(rng), offset(rng)),
+                                                           centre + Vec3<double>(offset(rng), offset(rng), offset(rng))},
+                               std::nullopt,
+                               std::nullopt);
+    }
+
+    return triangles;
+}
+
+auto get_line_triangles(size_t n_triangles, double spacing) -> std::vector<Triangle_t<double>> {
+    std::vector<Triangle_t<double>> triangles;
+    triangles.reserve(n_triangles);
+
+    // Triangles cross the x axis, each one spacing times further from the origin than the last
+    for (size_t i = 0; i < n_triangles; ++i) {
+        const double x = std::pow(spacing, static_cast<double>(i));
+        triangles.emplace_back(0, 0, std::array<Vec3<double>, 3>{Vec3<double>(x, -1, -1), Vec3<double>(x, 2, -1), Vec3<double>(x, -1, 2)}, std::nullopt, std::nullopt);
+    }
+
+    return triangles;
+}
+
+auto get_line_rays(std::mt19937& rng, size_t n_triangles, double spacing) -> std::vector<Ray_t<double, 16>> {
+    std::uniform_real_distribution<double> position(0, static_cast<double>(n_triangles));
+    std::uniform_real_distribution<double> offset(-0.5, 0.5);
+    std::vector<Ray_t<double, 16>> rays;
+    rays.reserve(N_RANDOM_RAYS);
+
+    // Rays go along the x axis from anywhere on the line of triangles, so that they reach the deepest leaves
+    for (size_t i = 0; i < N_RANDOM_RAYS; ++i) {
+        const Vec3<double> origin(std::pow(spacing, position(rng)), offset(rng), offset(rng));
+        rays.emplace_back(origin, Vec3<double>(1, 0, 0), Vec3<double>(), Vec3<double>(1), MediumList_t<16>());
+    }
+
+    return rays;
+}
+
+auto get_random_rays(std::mt19937& rng, size_t n_rays = N_RANDOM_RAYS) -> std::vector<Ray_t<double, 16>> {
+    std::uniform_real_distribution<double> unif(-1, 1);
+    std::vector<Ray_t<double, 16>> rays;
+    rays.reserve(n_rays);
+
+    for (size_t i = 0; i < n_rays; ++i) {
+        const Vec3<double> origin(unif(rng) * 12, unif(rng) * 12, unif(rng) * 12);
+        const Vec3<double> direction = Vec3<double>(unif(rng), unif(rng), unif(rng)).normalize_inplace();
+        rays.emplace_back(origin, direction, Vec3<double>(), Vec3<double>(1), MediumList_t<16>());
+    }
+
+    return rays;
+}
+
+auto get_materials() -> std::array<Diffuse_t<double>, 1> {
+    return {Diffuse_t<double>(Vec3<double>(0, 0, 0), Vec3<double>(0.5, 0.5, 0.5), 1)};
+}
+
+auto get_mediums() -> std::array<NonAbsorber_t<double>, 1> {
+    return {NonAbsorber_t<double>(1, 0)};
+}
+
+template<template<typename> typename A = BVH_t, template<typename> typename S = Triangle_t>
+auto make_scene(std::span<std::type_identity_t<S<double>>> shapes, std::span<Diffuse_t<double>> materials) -> Scene_t<double, S, Diffuse_t, NonAbsorber_t, A> {
+    std::array<NonAbsorber_t<double>, 1> mediums = get_mediums();
+    return Scene_t<double, S, Diffuse_t, NonAbsorber_t, A>(shapes, materials, mediums);
+}
+
+template<template<typename> typename A = BVH_t, template<typename> typename S = Triangle_t>
+auto make_scene(std::span<std::type_identity_t<S<double>>> shapes) -> Scene_t<double, S, Diffuse_t, NonAbsorber_t, A> {
+    std::array<Diffuse_t<double>, 1> materials = get_materials();
+    return make_scene<A, S>(shapes, materials);
+}
+
+template<template<typename> typename S, template<typename> typename A>
+auto compare_intersections(sycl::queue& queue, Scene_t<double, S, Diffuse_t, NonAbsorber_t, A>& scene, std::vector<Ray_t<double, 16>>& rays) -> void {
+    const size_t no_hit_index = scene.shapes_.get_range()[0];
+    sycl::buffer<Ray_t<double, 16>, 1> ray_buffer(rays.data(), sycl::range<1>{rays.size()});
+    sycl::buffer<size_t, 1> bvh_hits(sycl::range<1>{rays.size()});
+    sycl::buffer<size_t, 1> brute_hits(sycl::range<1>{rays.size()});
+    sycl::buffer<double, 1> bvh_distances(sycl::range<1>{rays.size()});
+    sycl::buffer<double, 1> brute_distances(sycl::range<1>{rays.size()});
+
+    queue.submit([&](sycl::handler& cgh) {
+        auto scene_accessor          = scene.getAccessor(cgh);
+        auto ray_accessor            = ray_buffer.get_access<sycl::access::mode::read>(cgh);
+        auto bvh_hit_accessor        = bvh_hits.get_access<sycl::access::mode::discard_write>(cgh);
+        auto brute_hit_accessor      = brute_hits.get_access<sycl::access::mode::discard_write>(cgh);
+        auto bvh_distance_accessor   = bvh_distances.get_access<sycl::access::mode::discard_write>(cgh);
+        auto brute_distance_accessor = brute_distances.get_access<sycl::access::mode::discard_write>(cgh);
+
+        cgh.parallel_for<class IntersectBVH>(ray_accessor.get_range(), [=](sycl::id<1> WIid) {
+            std::array<double, 2> uv{};
+            double t = 0;
+
+            const std::optional<size_t> bvh_hit = scene_accessor.intersect(ray_accessor[WIid], t, uv);
+            bvh_hit_accessor[WIid]              = bvh_hit ? *bvh_hit : no_hit_index;
+            bvh_distance_accessor[WIid]         = t;
+
+            const std::optional<size_t> brute_hit = scene_accessor.intersect_brute(ray_accessor[WIid], t, uv);
+            brute_hit_accessor[WIid]              = brute_hit ? *brute_hit : no_hit_index;
+            brute_distance_accessor[WIid]         = t;
+        });
+    });
+
+    const sycl::host_accessor<size_t, 1, sycl::access_mode::read> bvh_hit_accessor(bvh_hits);
+    const sycl::host_accessor<size_t, 1, sycl::access_mode::read> brute_hit_accessor(brute_hits);
+    const sycl::host_accessor<double, 1, sycl::access_mode::read> bvh_distance_accessor(bvh_distances);
+    const sycl::host_accessor<double, 1, sycl::access_mode::read> brute_distance_accessor(brute_distances);
+
+    size_t n_hits = 0;
+    for (size_t i = 0; i < rays.size(); ++i) {
+        REQUIRE(bvh_hit_accessor[i] == brute_hit_accessor[i]);
+        REQUIRE(bvh_distance_accessor[i] == brute_distance_accessor[i]);
+        n_hits += (brute_hit_accessor[i] < no_hit_index) ? 1 : 0;
+    }
+    REQUIRE(n_hits > 0);
+}
+
+template<bool Stackless>
+class TraceBVH;
+
+template<bool Stackless>
+auto trace_bvh(sycl::queue& queue, Scene_t<double, Triangle_t, Diffuse_t, NonAbsorber_t>& scene, sycl::buffer<Ray_t<double, 16>, 1>& ray_buffer, sycl::buffer<double, 1>& distances) -> void {
+    queue.submit([&](sycl::handler& cgh) {
+        auto bvh_accessor      = scene.acc_.getAccessor(cgh);
+        auto shape_accessor    = scene.shapes_.get_access<sycl::access::mode::read>(cgh);
+        auto ray_accessor      = ray_buffer.get_access<sycl::access::mode::read>(cgh);
+        auto distance_accessor = distances.get_access<sycl::access::mode::discard_write>(cgh);
+
+        cgh.parallel_for<TraceBVH<Stackless>>(ray_accessor.get_range(), [=](sycl::id<1> WIid) {
+            const Ray_t<double, 16>& ray = ray_accessor[WIid];
+            double t                     = std::numeric_limits<double>::max();
+            double t_temp                = 0;
+            std::array<double, 2> uv{};
+
+            const auto leaf = [&](size_t index, double& t_max) {
+                if (shape_accessor[index].intersection(ray, t_temp, uv) && (t_temp < t_max)) {
+                    t_max = t_temp;
+                }
+                return false;
+            };
+            if constexpr (Stackless) {
+                bvh_accessor.traverse_stackless(ray, t, leaf);
+            }
+            else {
+                bvh_accessor.traverse_stack(ray, t, leaf);
+            }
+            distance_accessor[WIid] = t;
+        });
+    });
+    queue.wait();
+}
+
+template<bool Occlusion>
+class TraceScene;
+
+template<bool Occlusion>
+auto trace_scene(sycl::queue& queue, Scene_t<double, Triangle_t, Diffuse_t, NonAbsorber_t>& scene, sycl::buffer<Ray_t<double, 16>, 1>& ray_buffer, sycl::buffer<double, 1>& distances) -> void {
+    queue.submit([&](sycl::handler& cgh) {
+        auto scene_accessor    = scene.getAccessor(cgh);
+        auto ray_accessor      = ray_buffer.get_access<sycl::access::mode::read>(cgh);
+        auto distance_accessor = distances.get_access<sycl::access::mode::discard_write>(cgh);
+
+        cgh.parallel_for<TraceScene<Occlusion>>(ray_accessor.get_range(), [=](sycl::id<1> WIid) {
+            if constexpr (Occlusion) {
+                distance_accessor[WIid] = scene_accessor.occluded(ray_accessor[WIid], std::numeric_limits<double>::max()) ? 0 : std::numeric_limits<double>::max();
+            }
+            else {
+                std::array<double, 2> uv{};
+                double t = 0;
+                std::optional<size_t> instance{};
+                scene_accessor.intersect(ray_accessor[WIid], t, uv, instance);
+                distance_accessor[WIid] = t;
+            }
+        });
+    });
+    queue.wait();
+}
+
+auto count_touched_blocks(Scene_t<double, Triangle_t, Diffuse_t, NonAbsorber_t>& scene, const std::vector<Ray_t<double, 16>>& rays, size_t block_size) -> double {
+    constexpr size_t max_stack_size = 64;
+    const sycl::host_accessor<BVHNode_t<double>, 1, sycl::access_mode::read> node_accessor(scene.acc_.nodes_);
+    const sycl::host_accessor<uint32_t, 1, sycl::access_mode::read> index_accessor(scene.acc_.indices_);
+    const sycl::host_accessor<Triangle_t<double>, 1, sycl::access_mode::read> shape_accessor(scene.shapes_);
+
+    // Replicates the stack traversal on the host, recording the memory blocks of every node, index and shape read
+    std::unordered_set<std::uintptr_t> blocks;
+    const auto touch = [&blocks, block_size](const auto& element) {
+        const auto address = reinterpret_cast<std::uintptr_t>(&element); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+        for (std::uintptr_t block = address / block_size; block <= (address + sizeof(element) - 1) / block_size; ++block) {
+            blocks.insert(block);
+        }
+    };
+
+    size_t n_blocks = 0;
+    for (const auto& ray: rays) {
+        const Vec3<double> inverse_direction(1.0 / ray.direction_[0], 1.0 / ray.direction_[1], 1.0 / ray.direction_[2]);
+        std::array<uint32_t, max_stack_size> stack{};
+        size_t stack_size   = 0;
+        uint32_t node_index = 0;
+        double t            = std::numeric_limits<double>::max();
+        double t_node       = 0;
+        blocks.clear();
+
+        touch(node_accessor[0]);
+        bool hit = node_accessor[0].intersection(ray.origin_, inverse_direction, t, t_node);
+        while (hit) {
+            const BVHNode_t<double>& node = node_accessor[node_index];
+
+            if (node.is_leaf()) {
+                for (uint32_t i = node.first_; i < node.first_ + node.count_; ++i) {
+                    touch(index_accessor[i]);
+                    touch(shape_accessor[index_accessor[i]]);
+                    std::array<double, 2> uv{};
+                    double t_shape = 0;
+                    if (shape_accessor[index_accessor[i]].intersection(ray, t_shape, uv) && t_shape < t) {
+                        t = t_shape;
+                    }
+                }
+            }
+            else {
+                double t_left  = 0;
+                double t_right = 0;
+                touch(node_accessor[node.first_]);
+                touch(node_accessor[node.first_ + 1]);
+                const bool hit_left  = node_accessor[node.first_].intersection(ray.origin_, inverse_direction, t, t_left);
+                const bool hit_right = node_accessor[node.first_ + 1].intersection(ray.origin_, inverse_direction, t, t_right);
+
+                if (hit_left && hit_right) {
+                    const bool left_first = t_left <= t_right;
+                    stack[stack_size++]   = left_first ? node.first_ + 1 : node.first_;
+                    node_index            = left_first ? node.first_ : node.first_ + 1;
+                    continue;
+                }
+                if (hit_left || hit_right) {
+                    node_index = hit_left ? node.first_ : node.first_ + 1;
+                    continue;
+                }
+            }
+
+            hit = stack_size > 0;
+            if (hit) {
+                node_index = stack[--stack_size];
+            }
+        }
+        n_blocks += blocks.size();
+    }
+    return static_cast<double>(n_blocks) / static_cast<double>(rays.size());
+}
+
+auto get_depth(sycl::buffer<BVHNode_t<double>, 1>& nodes) -> uint32_t {
+    const sycl::host_accessor<BVHNode_t<double>, 1, sycl::access_mode::read> node_accessor(nodes);
+    std::vector<std::pair<uint32_t, uint32_t>> stack{
+        {0, 0}
+    };
+    uint32_t depth = 0;
+    while (!stack.empty()) {
+        const auto [node_index, node_depth] = stack.back();
+        stack.pop_back();
+        depth = std::max(depth, node_depth);
+        if (!node_accessor[node_index].is_leaf()) {
+            stack.emplace_back(node_accessor[node_index].first_, node_depth + 1);
+            stack.emplace_back(node_accessor[node_index].first_ + 1, node_depth + 1);
+        }
+    }
+    return depth;
+}
+
+auto get_camera_rays(const Vec3<double>& origin, size_t size, double fov) -> std::vector<Ray_t<double, 16>> {
+    std::vector<Ray_t<double, 16>> rays;
+    rays.reserve(size * size);
+
+    // Rays are stored tile by tile, so that each packet of consecutive rays covers a tile of 8x8 pixels
+    for (size_t tile = 0; tile < size * size / PACKET_SIZE; ++tile) {
+        for (size_t i = 0; i < PACKET_SIZE; ++i) {
+            const size_t x               = (tile % (size / 8)) * 8 + i % 8;
+            const size_t y               = (tile / (size / 8)) * 8 + i / 8;
+            const Vec3<double> direction = Vec3<double>((static_cast<double>(x) / static_cast<double>(size) - 0.5) * fov, 1, (static_cast<double>(y) / static_cast<double>(size) - 0.5) * fov)
+                                               .normalize_inplace();
+            rays.emplace_back(origin, direction, Vec3<double>(), Vec3<double>(1), MediumList_t<16>());
+        }
+    }
+
+    return rays;
+}
+
+template<bool Packets>
+class TracePackets;
+
+template<bool Packets>
+auto trace_packets(sycl::queue& queue, Scene_t<double, Triangle_t, Diffuse_t, NonAbsorber_t>& scene, sycl::buffer<Ray_t<double, 16>, 1>& ray_buffer, sycl::buffer<Hit_t<double>, 1>& hits) -> void {
+    queue.submit([&](sycl::handler& cgh) {
+        auto scene_accessor = scene.getAccessor(cgh);
+        auto ray_accessor   = ray_buffer.get_access<sycl::access::mode::read>(cgh);
+        auto hit_accessor   = hits.get_access<sycl::access::mode::discard_write>(cgh);
+
+        cgh.parallel_for<TracePackets<Packets>>(sycl::range<1>{ray_accessor.get_range()[0] / PACKET_SIZE}, [=](sycl::id<1> WIid) {
+            std::array<Ray_t<double, 16>, PACKET_SIZE> rays{};
+            std::array<Hit_t<double>, PACKET_SIZE> packet_hits{};
+            for (size_t i = 0; i < PACKET_SIZE; ++i) {
+                rays[i] = ray_accessor[WIid[0] * PACKET_SIZE + i];
+            }
+
+            if constexpr (Packets) {
+                scene_accessor.query_packet(rays, PACKET_SIZE, packet_hits);
+            }
+            else {
+                for (size_t i = 0; i < PACKET_SIZE; ++i) {
+                    packet_hits[i] = scene_accessor.query(rays[i]);
+                }
+            }
+
+            for (size_t i = 0; i < PACKET_SIZE; ++i) {
+                hit_accessor[WIid[0] * PACKET_SIZE + i] = packet_hits[i];
+            }
+        });
+    });
+    queue.wait();
+}
+
+template<typename T, bool Affine>
+class TestTriangles;
+
+template<typename T, bool Affine>
+auto test_triangles(sycl::queue& queue,
+                    sycl::buffer<Triangle_t<T>, 1>& triangles,
+                    sycl::buffer<AffineTriangle_t<T>, 1>& affine_triangles,
+                    sycl::buffer<Ray_t<T, 16>, 1>& ray_buffer,
+                    sycl::buffer<T, 1>& distances) -> void {
+    queue.submit([&](sycl::handler& cgh) {
+        auto triangle_accessor        = triangles.template get_access<sycl::access::mode::read>(cgh);
+        auto affine_triangle_accessor = affine_triangles.template get_access<sycl::access::mode::read>(cgh);
+        auto ray_accessor             = ray_buffer.template get_access<sycl::access::mode::read>(cgh);
+        auto distance_accessor        = distances.template get_access<sycl::access::mode::discard_write>(cgh);
+
+        cgh.parallel_for<TestTriangles<T, Affine>>(ray_accessor.get_range(), [=](sycl::id<1> WIid) {
+            const Ray_t<T, 16>& ray = ray_accessor[WIid];
+            T t                     = std::numeric_limits<T>::max();
+            T t_temp                = 0;
+            std::array<T, 2> uv{};
+
+            for (size_t i = 0; i < triangle_accessor.get_range()[0]; ++i) {
+                bool hit = false;
+                if constexpr (Affine) {
+                    hit = affine_triangle_accessor[i].intersection(ray, t_temp, uv);
+                }
+                else {
+                    hit = triangle_accessor[i].intersection(ray, t_temp, uv);
+                }
+                if (hit && (t_temp < t)) {
+                    t = t_temp;
+                }
+            }
+            distance_accessor[WIid] = t;
+        });
+    });
+    queue.wait();
+}
+
+template<typename T>
+auto benchmark_triangle_intersection(const std::vector<Triangle_t<double>>& triangles, const std::vector<Ray_t<double, 16>>& rays) -> void {
+    const auto convert = [](const Vec3<double>& vector) {
+        return Vec3<T>(static_cast<T>(vector[0]), static_cast<T>(vector[1]), static_cast<T>(vector[2]));
+    };
+
+    std::vector<Triangle_t<T>> converted_triangles;
+    std::vector<AffineTriangle_t<T>> affine_triangles;
+    std::vector<Ray_t<T, 16>> converted_rays;
+    converted_triangles.reserve(triangles.size());
+    affine_triangles.reserve(triangles.size());
+    converted_rays.reserve(rays.size());
+    for (const auto& triangle: triangles) {
+        const std::array<Vec3<T>, 3> points{convert(triangle.points_[0]), convert(triangle.points_[1]), convert(triangle.points_[2])};
+        converted_triangles.emplace_back(0, 0, points, std::nullopt, std::nullopt);
+        affine_triangles.emplace_back(points);
+    }
+    for (const auto& ray: rays) {
+        converted_rays.emplace_back(convert(ray.origin_), convert(ray.direction_), Vec3<T>(), Vec3<T>(1), MediumList_t<16>());
+    }
+
+    sycl::queue queue(sycl::cpu_selector_v);
+    sycl::buffer<Triangle_t<T>, 1> triangle_buffer(converted_triangles.data(), sycl::range<1>{converted_triangles.size()});
+    sycl::buffer<AffineTriangle_t<T>, 1> affine_triangle_buffer(affine_triangles.data(), sycl::range<1>{affine_triangles.size()});
+    sycl::buffer<Ray_t<T, 16>, 1> ray_buffer(converted_rays.data(), sycl::range<1>{converted_rays.size()});
+    sycl::buffer<T, 1> distances(sycl::range<1>{converted_rays.size()});
+
+    // Each run does one test per ray and triangle, the number of tests per second is their product divided by the mean time
+    BENCHMARK("Möller–Trumbore intersection, " + std::to_string(rays.size() * triangles.size()) + " tests, " + std::to_string(sizeof(T)) + " byte floats") {
+        test_triangles<T, false>(queue, triangle_buffer, affine_triangle_buffer, ray_buffer, distances);
+    };
+    BENCHMARK("Affine intersection, " + std::to_string(rays.size() * triangles.size()) + " tests, " + std::to_string(sizeof(T)) + " byte floats") {
+        test_triangles<T, true>(queue, triangle_buffer, affine_triangle_buffer, ray_buffer, distances);
+    };
+}
+
+TEST_CASE("BVH_t intersection", "Compares the closest hit found with the BVH to the brute force intersection") {
+    std::mt19937 rng(42);
+    auto triangles = get_random_triangles(rng, N_RANDOM_TRIANGLES);
+    auto rays      = get_random_rays(rng);
+    auto scene     = make_scene(triangles);
+    scene.build_acc();
+
+    sycl::queue queue(sycl::default_selector_v);
+    compare_intersections(queue, scene, rays);
+}
+
+TEST_CASE("LBVH intersection", "Compares the closest hit found with the BVH built on the device to the brute force intersection") {
+    std::mt19937 rng(43);
+    auto triangles = get_random_triangles(rng, N_RANDOM_TRIANGLES_LBVH);
+    auto rays      = get_random_rays(rng);
+    auto scene     = make_scene(triangles);
+
+    sycl::queue queue(sycl::default_selector_v);
+    scene.update(queue);
+    compare_intersections(queue, scene, rays);
+}
+
+TEST_CASE("BVH_t refit", "Compares the closest hit found with a refitted BVH to the brute force intersection") {
+    std::mt19937 rng(44);
+    std::uniform_real_distribution<double> offset(-4, 4);
+    auto triangles = get_random_triangles(rng, N_RANDOM_TRIANGLES);
+    auto rays      = get_random_rays(rng);
+    auto scene     = make_scene(triangles);
+    scene.build_acc();
+
+    // Moves the shapes without changing the hierarchy
+    {
+        const sycl::host_accessor<Triangle_t<double>, 1, sycl::access_mode::read_write> shape_accessor(scene.shapes_);
+        for (size_t i = 0; i < shape_accessor.get_range()[0]; i += 2) {
+            TransformMatrix_t<double> transformation;
+            transformation.translate(Vec3<double>(offset(rng), offset(rng), offset(rng)));
+            shape_accessor[i].transformation_ = static_cast<uint32_t>(scene.add_transformation(transformation));
+        }
+    }
+    scene.acc_.rebuild_threshold_ = std::numeric_limits<double>::infinity();
+
+    sycl::queue queue(sycl::default_selector_v);
+    scene.update(queue);
+    compare_intersections(queue, scene, rays);
+    REQUIRE(scene.acc_.cost(queue) > 0);
+
+    // The cost of the refit is only read by the next update, which rebuilds the hierarchy, and the cost at build by the one after
+    scene.acc_.rebuild_threshold_ = 0;
+    scene.update(queue);
+    compare_intersections(queue, scene, rays);
+    scene.update(queue);
+    REQUIRE(scene.acc_.build_cost_ == scene.acc_.cost(queue));
+}
+
+TEST_CASE("WideBVH_t intersection", "Compares the closest hit found with the 4 and 8 wide BVHs to the brute force intersection") {
+    std::mt19937 rng(45);
+    auto triangles = get_random_triangles(rng, N_RANDOM_TRIANGLES_LBVH);
+    auto rays      = get_random_rays(rng);
+    auto scene4    = make_scene<BVH4_t>(triangles);
+    auto scene8    = make_scene<BVH8_t>(triangles);
+    scene4.build_acc();
+
+    sycl::queue queue(sycl::default_selector_v);
+    scene8.update(queue);
+    compare_intersections(queue, scene4, rays);
+    compare_intersections(queue, scene8, rays);
+}
+
+TEST_CASE("CompressedBVH intersection", "Compares the closest hit found with the quantised 4 and 8 wide BVHs to the brute force intersection") {
+    std::mt19937 rng(46);
+    auto triangles = get_random_triangles(rng, N_RANDOM_TRIANGLES_LBVH);
+    auto rays      = get_random_rays(rng);
+    auto scene4    = make_scene<CompressedBVH4_t>(triangles);
+    auto scene8    = make_scene<CompressedBVH8_t>(triangles);
+    scene4.build_acc();
+
+    sycl::queue queue(sycl::default_selector_v);
+    scene8.update(queue);
+    compare_intersections(queue, scene4, rays);
+    compare_intersections(queue, scene8, rays);
+    REQUIRE(sizeof(CompressedBVHNode_t<double, 8>) * 3 < sizeof(WideBVHNode_t<double, 8>));
+}
+
+TEST_CASE("WideBVH_t refit", "Compares the closest hit found with refitted wide BVHs to the brute force intersection") {
+    std::mt19937 rng(53);
+    std::uniform_real_distribution<double> offset(-4, 4);
+    auto triangles = get_random_triangles(rng, N_RANDOM_TRIANGLES);
+    auto rays      = get_random_rays(rng);
+    auto scene4    = make_scene<BVH4_t>(triangles);
+    auto scene8    = make_scene<CompressedBVH8_t>(triangles);
+    scene4.build_acc();
+    scene8.build_acc();
+
+    std::vector<TransformMatrix_t<double>> transformations(triangles.size());
+    for (size_t i = 0; i < transformations.size(); i += 2) {
+        transformations[i].translate(Vec3<double>(offset(rng), offset(rng), offset(rng)));
+    }
+
+    // Moves the same shapes in both scenes, and refits the hierarchies instead of rebuilding them
+    sycl::queue queue(sycl::default_selector_v);
+    auto refit = [&](auto& scene) {
+        {
+            const sycl::host_accessor<Triangle_t<double>, 1, sycl::access_mode::read_write> shape_accessor(scene.shapes_);
+            for (size_t i = 0; i < shape_accessor.get_range()[0]; i += 2) {
+                shape_accessor[i].transformation_ = static_cast<uint32_t>(scene.add_transformation(transformations[i]));
+            }
+        }
+        scene.acc_.binary_.rebuild_threshold_ = std::numeric_limits<double>::infinity();
+        const size_t n_builds                 = scene.acc_.binary_.n_builds_;
+
+        scene.update(queue);
+        REQUIRE(scene.acc_.binary_.n_builds_ == n_builds);
+        compare_intersections(queue, scene, rays);
+    };
+    refit(scene4);
+    refit(scene8);
+}
+
+TEST_CASE("SBVH intersection", "Compares the closest hit found with the BVH built with spatial splits to the brute force intersection") {
+    constexpr double reference_budget = 1.5;
+    std::mt19937 rng(47);
+    auto triangles            = get_random_slivers(rng, N_RANDOM_TRIANGLES);
+    auto rays                 = get_random_rays(rng);
+    auto scene                = make_scene(triangles);
+    auto scene8               = make_scene<BVH8_t>(triangles);
+    const double improvement  = scene.acc_.build_spatial(scene.shapes_, reference_budget);
+    const double improvement8 = scene8.acc_.build_spatial(scene8.shapes_, reference_budget);
+
+    sycl::queue queue(sycl::default_selector_v);
+    compare_intersections(queue, scene, rays);
+    compare_intersections(queue, scene8, rays);
+    REQUIRE(improvement > 1);
+    REQUIRE(improvement8 == improvement);
+    REQUIRE(scene.acc_.indices_.get_range()[0] > N_RANDOM_TRIANGLES);
+    REQUIRE(scene.acc_.indices_.get_range()[0] <= static_cast<size_t>(reference_budget * N_RANDOM_TRIANGLES));
+}
+
+TEST_CASE("BVH_t depth limit", "Compares the closest hit found with BVHs built around triangles further and further apart to the brute force intersection, and checks their depth") {
+    constexpr size_t n_triangles = 100000;
+    constexpr size_t n_added     = 1000;
+    constexpr double spacing     = 1.005;
+    std::mt19937 rng(76);
+    auto triangles = get_line_triangles(n_triangles + n_added, spacing);
+    auto rays      = get_line_rays(rng, n_triangles + n_added, spacing);
+    auto scene     = make_scene(std::span<Triangle_t<double>>(triangles.data(), n_triangles));
+
+    // The surface area heuristic splits off a few triangles at a time, which would give a hierarchy deeper than the traversal stack
+    sycl::queue queue(sycl::default_selector_v);
+    scene.acc_.build(scene.shapes_);
+    REQUIRE(get_depth(scene.acc_.nodes_) <= BVHNode_t<double>::max_depth_);
+    compare_intersections(queue, scene, rays);
+
+    // Triangles inserted further along the line can't go above the full depth hierarchy
+    scene.add(queue, std::span<Triangle_t<double>>(triangles.data() + n_triangles, n_added));
+    REQUIRE(get_depth(scene.acc_.nodes_) <= BVHNode_t<double>::max_depth_);
+    compare_intersections(queue, scene, rays);
+
+    scene.acc_.build_spatial(scene.shapes_);
+    REQUIRE(get_depth(scene.acc_.nodes_) <= BVHNode_t<double>::max_depth_);
+    compare_intersections(queue, scene, rays);
+}
+
+TEST_CASE("InstanceBVH_t intersection", "Compares the closest hit found with mesh instances to the brute force intersection of the transformed meshes") {
+    std::mt19937 rng(48);
+    std::uniform_real_distribution<double> position(-10, 10);
+    std::uniform_real_distribution<double> angle(0, 6.28);
+    std::uniform_real_distribution<double> scale(0.1, 0.4);
+    auto triangles = get_random_triangles(rng, N_RANDOM_TRIANGLES);
+    auto rays      = get_random_rays(rng);
+    std::vector<MeshTop_t<double>> instances;
+    std::vector<Triangle_t<double>> transformed_triangles;
+
+    // Each instance of the mesh is also added to a flat scene as transformed copies of the triangles
+    for (size_t i = 0; i < N_RANDOM_INSTANCES; ++i) {
+        TransformMatrix_t<double> transformation;
+        transformation.scale(scale(rng)).rotateX(angle(rng)).rotateZ(angle(rng)).translate(Vec3<double>(position(rng), position(rng), position(rng)));
+        instances.emplace_back(0, transformation);
+        for (auto triangle: triangles) {
+            triangle.update(transformation);
+            transformed_triangles.push_back(triangle);
+        }
+    }
+
+    auto scene             = make_scene(std::span<Triangle_t<double>>());
+    auto transformed_scene = make_scene(transformed_triangles);
+    REQUIRE(scene.add_mesh(triangles) == 0);
+    scene.add(instances);
+    scene.build_acc();
+    REQUIRE(scene.mesh_shapes_.get_range()[0] == N_RANDOM_TRIANGLES);
+
+    const size_t no_hit_index = transformed_triangles.size();
+    sycl::buffer<Ray_t<double, 16>, 1> ray_buffer(rays.data(), sycl::range<1>{rays.size()});
+    sycl::buffer<size_t, 1> instance_hits(sycl::range<1>{rays.size()});
+    sycl::buffer<size_t, 1> brute_hits(sycl::range<1>{rays.size()});
+    sycl::buffer<double, 1> instance_distances(sycl::range<1>{rays.size()});
+    sycl::buffer<double, 1> brute_distances(sycl::range<1>{rays.size()});
+
+    sycl::queue queue(sycl::default_selector_v);
+    queue.submit([&](sycl::handler& cgh) {
+        auto scene_accessor             = scene.getAccessor(cgh);
+        auto transformed_scene_accessor = transformed_scene.getAccessor(cgh);
+        auto ray_accessor               = ray_buffer.get_access<sycl::access::mode::read>(cgh);
+        auto instance_hit_accessor      = instance_hits.get_access<sycl::access::mode::discard_write>(cgh);
+        auto brute_hit_accessor         = brute_hits.get_access<sycl::access::mode::discard_write>(cgh);
+        auto instance_distance_accessor = instance_distances.get_access<sycl::access::mode::discard_write>(cgh);
+        auto brute_distance_accessor    = brute_distances.get_access<sycl::access::mode::discard_write>(cgh);
+
+        cgh.parallel_for<class IntersectInstances>(ray_accessor.get_range(), [=](sycl::id<1> WIid) {
+            std::array<double, 2> uv{};
+            double t = 0;
+            std::optional<size_t> instance{};
+
+            const std::optional<size_t> instance_hit = scene_accessor.intersect(ray_accessor[WIid], t, uv, instance);
+            instance_hit_accessor[WIid]              = (instance_hit && instance) ? *instance * N_RANDOM_TRIANGLES + *instance_hit : no_hit_index;
+            instance_distance_accessor[WIid]         = t;
+
+            const std::optional<size_t> brute_hit = transformed_scene_accessor.intersect_brute(ray_accessor[WIid], t, uv);
+            brute_hit_accessor[WIid]              = brute_hit ? *brute_hit : no_hit_index;
+            brute_distance_accessor[WIid]         = t;
+        });
+    });
+
+    const sycl::host_accessor<size_t, 1, sycl::access_mode::read> instance_hit_accessor(instance_hits);
+    const sycl::host_accessor<size_t, 1, sycl::access_mode::read> brute_hit_accessor(brute_hits);
+    const sycl::host_accessor<double, 1, sycl::access_mode::read> instance_distance_accessor(instance_distances);
+    const sycl::host_accessor<double, 1, sycl::access_mode::read> brute_distance_accessor(brute_distances);
+
+    size_t n_hits = 0;
+    for (size_t i = 0; i < rays.size(); ++i) {
+        REQUIRE(instance_hit_accessor[i] == brute_hit_accessor[i]);
+        if (brute_hit_accessor[i] < no_hit_index) {
+            REQUIRE(std::abs(instance_distance_accessor[i] - brute_distance_accessor[i]) < 1e-9 * brute_distance_accessor[i]);
+            ++n_hits;
+        }
+    }
+    REQUIRE(n_hits > 0);
+}
+
+TEST_CASE("MultiGrid_t intersection", "Compares the closest hit found with the two-level grid to the brute force intersection") {
+    constexpr uint32_t max_cell_content = 4;
+    std::mt19937 rng(49);
+    auto triangles                          = get_random_triangles(rng, N_RANDOM_TRIANGLES_LBVH);
+    auto rays                               = get_random_rays(rng);
+    auto scene                              = make_scene<MultiGrid_t>(triangles);
+    auto subdivided_scene                   = make_scene<MultiGrid_t>(triangles);
+    subdivided_scene.acc_.max_cell_content_ = max_cell_content;
+    scene.build_acc();
+
+    sycl::queue queue(sycl::default_selector_v);
+    subdivided_scene.update(queue);
+    compare_intersections(queue, scene, rays);
+    compare_intersections(queue, subdivided_scene, rays);
+    REQUIRE(subdivided_scene.acc_.sub_references_.get_range()[0] > 1);
+}
+
+TEST_CASE("BVHCache_t", "Compares the closest hit found with a BVH loaded from the cache to the brute force intersection") {
+    std::mt19937 rng(50);
+    auto triangles                        = get_random_triangles(rng, N_RANDOM_TRIANGLES);
+    auto rays                             = get_random_rays(rng);
+    auto scene                            = make_scene(triangles);
+    auto cached_scene                     = make_scene(triangles);
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "agptracer_bvh_cache_test";
+    std::filesystem::remove_all(directory);
+    const BVHCache_t<double> cache(directory);
+
+    REQUIRE(!scene.build_acc(cache));
+    REQUIRE(cached_scene.build_acc(cache));
+    std::filesystem::remove_all(directory);
+
+    sycl::queue queue(sycl::default_selector_v);
+    compare_intersections(queue, cached_scene, rays);
+    REQUIRE(cached_scene.acc_.build_cost_ == scene.acc_.build_cost_);
+    REQUIRE(cached_scene.acc_.nodes_.get_range()[0] == scene.acc_.nodes_.get_range()[0]);
+}
+
+TEST_CASE("BVH_t incremental updates", "Compares the closest hit found with a BVH updated as shapes are added and removed to the brute force intersection") {
+    std::mt19937 rng(55);
+    auto triangles       = get_random_triangles(rng, N_RANDOM_TRIANGLES);
+    auto added_triangles = get_random_triangles(rng, N_RANDOM_TRIANGLES / 4);
+    auto rays            = get_random_rays(rng);
+    auto scene           = make_scene(triangles);
+    sycl::queue queue(sycl::default_selector_v);
+    scene.build_acc();
+
+    scene.add(queue, added_triangles);
+    REQUIRE(scene.acc_.n_shapes_ == triangles.size() + added_triangles.size());
+    compare_intersections(queue, scene, rays);
+
+    // Removes shapes from the start, which are replaced by the last ones, and from the end
+    std::vector<size_t> removed;
+    for (size_t i = 0; i < triangles.size() + added_triangles.size(); i += 3) {
+        removed.push_back(i);
+    }
+    scene.remove_shapes(queue, removed);
+    REQUIRE(scene.acc_.n_shapes_ == scene.shapes_.get_range()[0]);
+    compare_intersections(queue, scene, rays);
+
+    // A scene emptied of all its shapes, then filled one shape at a time, is built only from insertions
+    std::vector<size_t> all(scene.shapes_.get_range()[0]);
+    std::iota(all.begin(), all.end(), size_t{0});
+    scene.remove_shapes(all);
+    REQUIRE(scene.acc_.n_shapes_ == 0);
+    for (const auto& triangle: triangles) {
+        scene.add(queue, triangle);
+    }
+    REQUIRE(scene.acc_.n_shapes_ == triangles.size());
+    compare_intersections(queue, scene, rays);
+}
+
+TEST_CASE("BVH_t sorted insertions", "Compares the closest hit found with a BVH made of shapes inserted in order along a line to the brute force intersection, and checks its depth") {
+    constexpr size_t n_triangles = 20000;
+    constexpr double spacing     = 1.001;
+    std::mt19937 rng(77);
+    auto triangles = get_line_triangles(n_triangles, spacing);
+    auto rays      = get_line_rays(rng, n_triangles, spacing);
+    auto scene     = make_scene(std::span<Triangle_t<double>>());
+    sycl::queue queue(sycl::default_selector_v);
+    scene.build_acc();
+
+    // Each triangle is further than all the others, so without balancing every insertion would add a level above them
+    scene.add(queue, triangles);
+    REQUIRE(scene.acc_.n_shapes_ == n_triangles);
+    REQUIRE(get_depth(scene.acc_.nodes_) <= BVHNode_t<double>::max_depth_);
+    compare_intersections(queue, scene, rays);
+}
+
+TEST_CASE("BVH_t stackless traversal", "Compares the closest hit found with the stackless traversal to the one found with the stack traversal") {
+    std::mt19937 rng(51);
+    auto triangles = get_random_triangles(rng, N_RANDOM_TRIANGLES_LBVH);
+    auto rays      = get_random_rays(rng);
+    auto scene     = make_scene(triangles);
+    scene.build_acc();
+
+    sycl::queue queue(sycl::default_selector_v);
+    sycl::buffer<Ray_t<double, 16>, 1> ray_buffer(rays.data(), sycl::range<1>{rays.size()});
+    sycl::buffer<double, 1> stack_distances(sycl::range<1>{rays.size()});
+    sycl::buffer<double, 1> stackless_distances(sycl::range<1>{rays.size()});
+    trace_bvh<false>(queue, scene, ray_buffer, stack_distances);
+    trace_bvh<true>(queue, scene, ray_buffer, stackless_distances);
+
+    const sycl::host_accessor<double, 1, sycl::access_mode::read> stack_distance_accessor(stack_distances);
+    const sycl::host_accessor<double, 1, sycl::access_mode::read> stackless_distance_accessor(stackless_distances);
+
+    size_t n_hits = 0;
+    for (size_t i = 0; i < rays.size(); ++i) {
+        REQUIRE(stackless_distance_accessor[i] == stack_distance_accessor[i]);
+        if (stack_distance_accessor[i] < std::numeric_limits<double>::max()) {
+            ++n_hits;
+        }
+    }
+    REQUIRE(n_hits > 0);
+}
+
+TEST_CASE("BVH_t traversal benchmark", "[.][benchmark]") {
+    std::mt19937 rng(52);
+    auto triangles = get_random_triangles(rng, N_RANDOM_TRIANGLES_LBVH);
+    auto rays      = get_random_rays(rng, N_BENCHMARK_RAYS);
+    auto scene     = make_scene(triangles);
+    scene.build_acc();
+
+    sycl::queue queue(sycl::default_selector_v);
+    sycl::buffer<Ray_t<double, 16>, 1> ray_buffer(rays.data(), sycl::range<1>{rays.size()});
+    sycl::buffer<double, 1> distances(sycl::range<1>{rays.size()});
+
+    BENCHMARK("Stack traversal") {
+        trace_bvh<false>(queue, scene, ray_buffer, distances);
+    };
+    BENCHMARK("Stackless traversal") {
+        trace_bvh<true>(queue, scene, ray_buffer, distances);
+    };
+}
+
+TEST_CASE("BVH_t treelet layout", "Compares the closest hit found with a reordered BVH and shapes to the brute force intersection, and to the hits before reordering") {
+    std::mt19937 rng(53);
+    auto triangles = get_random_triangles(rng, N_RANDOM_TRIANGLES_LBVH);
+    auto rays      = get_random_rays(rng);
+    auto scene     = make_scene(triangles);
+    scene.build_acc();
+
+    sycl::queue queue(sycl::default_selector_v);
+    sycl::buffer<Ray_t<double, 16>, 1> ray_buffer(rays.data(), sycl::range<1>{rays.size()});
+    sycl::buffer<double, 1> distances(sycl::range<1>{rays.size()});
+    sycl::buffer<double, 1> reordered_distances(sycl::range<1>{rays.size()});
+    trace_bvh<false>(queue, scene, ray_buffer, distances);
+
+    // A small treelet size makes sure the hierarchy is cut in several treelets
+    scene.reorder(256);
+    trace_bvh<false>(queue, scene, ray_buffer, reordered_distances);
+    compare_intersections(queue, scene, rays);
+
+    const sycl::host_accessor<double, 1, sycl::access_mode::read> distance_accessor(distances);
+    const sycl::host_accessor<double, 1, sycl::access_mode::read> reordered_distance_accessor(reordered_distances);
+    for (size_t i = 0; i < rays.size(); ++i) {
+        REQUIRE(reordered_distance_accessor[i] == distance_accessor[i]);
+    }
+}
+
+TEST_CASE("BVH_t treelet layout benchmark", "[.][benchmark]") {
+    std::mt19937 rng(54);
+    auto triangles = get_random_triangles(rng, N_RANDOM_TRIANGLES_LBVH);
+    auto rays      = get_random_rays(rng, N_BENCHMARK_RAYS);
+    auto scene     = make_scene(triangles);
+    scene.build_acc();
+
+    constexpr size_t cache_line_size = 64;
+    constexpr size_t page_size       = 4096;
+    const double lines_before        = count_touched_blocks(scene, rays, cache_line_size);
+    const double pages_before        = count_touched_blocks(scene, rays, page_size);
+    scene.reorder(page_size);
+    const double lines_after = count_touched_blocks(scene, rays, cache_line_size);
+    const double pages_after = count_touched_blocks(scene, rays, page_size);
+
+    WARN("Cache lines touched per ray, builder layout: " << lines_before << ", treelet layout: " << lines_after);
+    WARN("Pages touched per ray, builder layout: " << pages_before << ", treelet layout: " << pages_after);
+}
+
+TEST_CASE("MotionBVH_t intersection", "Compares the closest hit found with the motion BVH to the brute force intersection, for rays at random times") {
+    std::mt19937 rng(56);
+    std::uniform_real_distribution<double> offset(-4, 4);
+    std::uniform_real_distribution<double> time(0, 1);
+    const auto triangles = get_random_triangles(rng, N_RANDOM_TRIANGLES);
+    auto rays            = get_random_rays(rng);
+    std::vector<TriangleMotionblur_t<double>> moving_triangles;
+    moving_triangles.reserve(triangles.size());
+    for (const auto& triangle: triangles) {
+        moving_triangles.emplace_back(0, TransformMatrix_t<double>{}, triangle.points_orig_, std::nullopt, std::nullopt);
+    }
+    for (auto& ray: rays) {
+        ray.time_ = time(rng);
+    }
+    auto scene = make_scene<MotionBVH_t, TriangleMotionblur_t>(moving_triangles);
+    scene.build_acc();
+
+    // Half of the shapes move during the exposure, from where they were built to a new position
+    {
+        const sycl::host_accessor<TriangleMotionblur_t<double>, 1, sycl::access_mode::read_write> shape_accessor(scene.shapes_);
+        for (size_t i = 0; i < shape_accessor.get_range()[0]; i += 2) {
+            shape_accessor[i].transformation_.translate(Vec3<double>(offset(rng), offset(rng), offset(rng)));
+        }
+    }
+
+    sycl::queue queue(sycl::default_selector_v);
+    scene.update(queue);
+    compare_intersections(queue, scene, rays);
+}
+
+TEST_CASE("Scene_t occlusion and ray flags", "Compares the occlusion query and the queries with ray flags to the closest hit") {
+    std::mt19937 rng(57);
+    std::uniform_real_distribution<double> position(-10, 10);
+    std::uniform_real_distribution<double> angle(0, 6.28);
+    std::uniform_real_distribution<double> scale(0.1, 0.4);
+    auto triangles = get_random_triangles(rng, N_RANDOM_TRIANGLES);
+    auto mesh      = get_random_triangles(rng, N_RANDOM_TRIANGLES);
+    auto rays      = get_random_rays(rng);
+    std::vector<MeshTop_t<double>> instances;
+
+    for (size_t i = 0; i < N_RANDOM_INSTANCES; ++i) {
+        TransformMatrix_t<double> transformation;
+        transformation.scale(scale(rng)).rotateX(angle(rng)).rotateZ(angle(rng)).translate(Vec3<double>(position(rng), position(rng), position(rng)));
+        instances.emplace_back(0, transformation, std::nullopt);
+    }
+
+    auto scene = make_scene(triangles);
+    scene.add_mesh(mesh);
+    scene.add(instances);
+    scene.build_acc();
+
+    struct Queries_t {
+            bool hit;
+            double t;
+            bool occluded;
+            bool occluded_before_hit;
+            bool first_hit;
+            double t_first;
+            std::optional<size_t> culled_hit;
+            double t_culled;
+            std::optional<size_t> brute_culled_hit;
+            double t_brute_culled;
+            std::optional<size_t> shapes_hit;
+    };
+
+    sycl::queue queue(sycl::default_selector_v);
+    sycl::buffer<Ray_t<double, 16>, 1> ray_buffer(rays.data(), sycl::range<1>{rays.size()});
+    sycl::buffer<Queries_t, 1> queries(sycl::range<1>{rays.size()});
+    queue.submit([&](sycl::handler& cgh) {
+        auto scene_accessor = scene.getAccessor(cgh);
+        auto ray_accessor   = ray_buffer.get_access<sycl::access::mode::read>(cgh);
+        auto query_accessor = queries.get_access<sycl::access::mode::discard_write>(cgh);
+
+        cgh.parallel_for<class QueryScene>(ray_accessor.get_range(), [=](sycl::id<1> WIid) {
+            const Ray_t<double, 16>& ray = ray_accessor[WIid];
+            std::array<double, 2> uv{};
+            std::optional<size_t> instance{};
+            double t = 0;
+            Queries_t result{};
+
+            result.hit                 = scene_accessor.intersect(ray, result.t, uv, instance).has_value();
+            result.occluded            = scene_accessor.occluded(ray, std::numeric_limits<double>::max());
+            result.occluded_before_hit = scene_accessor.occluded(ray, result.t);
+            result.first_hit           = scene_accessor.intersect(ray, result.t_first, uv, instance, RayFlags_t::terminate_on_first_hit).has_value();
+            result.culled_hit          = scene_accessor.intersect(ray, result.t_culled, uv, RayFlags_t::cull_back_faces);
+            result.brute_culled_hit    = scene_accessor.intersect_brute(ray, result.t_brute_culled, uv, RayFlags_t::cull_back_faces);
+            result.shapes_hit          = scene_accessor.intersect(ray, t, uv);
+            query_accessor[WIid]       = result;
+        });
+    });
+
+    const sycl::host_accessor<Queries_t, 1, sycl::access_mode::read> query_accessor(queries);
+    const sycl::host_accessor<Triangle_t<double>, 1, sycl::access_mode::read> shape_accessor(scene.shapes_);
+
+    size_t n_hits   = 0;
+    size_t n_culled = 0;
+    for (size_t i = 0; i < rays.size(); ++i) {
+        const Queries_t& result = query_accessor[i];
+        REQUIRE(result.occluded == result.hit);
+        REQUIRE(!result.occluded_before_hit);
+        REQUIRE(result.first_hit == result.hit);
+        if (result.hit) {
+            REQUIRE(result.t_first >= result.t);
+            ++n_hits;
+        }
+
+        REQUIRE(result.culled_hit == result.brute_culled_hit);
+        if (result.culled_hit) {
+            REQUIRE(result.t_culled == result.t_brute_culled);
+            REQUIRE(shape_accessor[*result.culled_hit].normal_face(0.0).dot(rays[i].direction_) < 0);
+        }
+        n_culled += (result.shapes_hit && !result.culled_hit) ? 1 : 0;
+    }
+    REQUIRE(n_hits > 0);
+    REQUIRE(n_culled > 0);
+}
+
+TEST_CASE("Scene_t occlusion benchmark", "[.][benchmark]") {
+    std::mt19937 rng(58);
+    auto triangles = get_random_triangles(rng, N_RANDOM_TRIANGLES_LBVH);
+    auto rays      = get_random_rays(rng, N_BENCHMARK_RAYS);
+    auto scene     = make_scene(triangles);
+    scene.build_acc();
+
+    sycl::queue queue(sycl::default_selector_v);
+    sycl::buffer<Ray_t<double, 16>, 1> ray_buffer(rays.data(), sycl::range<1>{rays.size()});
+    sycl::buffer<double, 1> distances(sycl::range<1>{rays.size()});
+
+    BENCHMARK("Closest hit") {
+        trace_scene<false>(queue, scene, ray_buffer, distances);
+    };
+    BENCHMARK("Occlusion") {
+        trace_scene<true>(queue, scene, ray_buffer, distances);
+    };
+}
+
+TEST_CASE("Visibility masks", "Compares the closest hit of camera and secondary rays to the brute force intersection, with shapes and instances visible to either kind of ray") {
+    std::mt19937 rng(59);
+    std::uniform_real_distribution<double> position(-10, 10);
+    std::uniform_real_distribution<double> angle(0, 6.28);
+    std::uniform_real_distribution<double> scale(0.1, 0.4);
+    auto triangles = get_random_triangles(rng, N_RANDOM_TRIANGLES);
+    auto mesh      = get_random_triangles(rng, N_RANDOM_TRIANGLES);
+    auto rays      = get_random_rays(rng);
+    std::vector<MeshTop_t<double>> instances;
+
+    // Shapes in the first half of the scene are only seen by camera rays, and shapes in the second half by secondary rays
+    for (auto& triangle: triangles) {
+        triangle.mask_ = (triangle.mincoord()[0] < 0) ? Visibility::camera : Visibility::secondary;
+    }
+    for (size_t i = 0; i < N_RANDOM_INSTANCES; ++i) {
+        TransformMatrix_t<double> transformation;
+        transformation.scale(scale(rng)).rotateX(angle(rng)).rotateZ(angle(rng)).translate(Vec3<double>(position(rng), position(rng), position(rng)));
+        instances.emplace_back(0, transformation, std::nullopt, (i % 2 == 0) ? Visibility::camera : Visibility::secondary);
+    }
+
+    auto scene = make_scene(triangles);
+    scene.add_mesh(mesh);
+    scene.add(instances);
+    scene.build_acc();
+
+    // The root holds the union of the masks of all the shapes
+    {
+        const sycl::host_accessor<BVHNode_t<double>, 1, sycl::access_mode::read> node_accessor(scene.acc_.nodes_);
+        REQUIRE(node_accessor[0].mask_ == (Visibility::camera | Visibility::secondary));
+    }
+
+    struct Queries_t {
+            std::array<std::optional<size_t>, 3> hit;
+            std::array<std::optional<size_t>, 3> brute_hit;
+            std::array<std::optional<size_t>, 3> instance;
+            std::array<double, 3> t;
+            std::array<double, 3> t_brute;
+    };
+
+    sycl::queue queue(sycl::default_selector_v);
+    sycl::buffer<Ray_t<double, 16>, 1> ray_buffer(rays.data(), sycl::range<1>{rays.size()});
+    sycl::buffer<Queries_t, 1> queries(sycl::range<1>{rays.size()});
+    queue.submit([&](sycl::handler& cgh) {
+        auto scene_accessor = scene.getAccessor(cgh);
+        auto ray_accessor   = ray_buffer.get_access<sycl::access::mode::read>(cgh);
+        auto query_accessor = queries.get_access<sycl::access::mode::discard_write>(cgh);
+
+        cgh.parallel_for<class QueryVisibility>(ray_accessor.get_range(), [=](sycl::id<1> WIid) {
+            constexpr std::array<uint32_t, 3> visibilities = {Visibility::camera, Visibility::secondary, Visibility::all};
+            Ray_t<double, 16> ray                          = ray_accessor[WIid];
+            std::array<double, 2> uv{};
+            Queries_t result{};
+
+            for (size_t j = 0; j < visibilities.size(); ++j) {
+                ray.visibility_     = visibilities[j];
+                result.hit[j]       = scene_accessor.intersect(ray, result.t[j], uv, result.instance[j]);
+                result.brute_hit[j] = scene_accessor.intersect_brute(ray, result.t_brute[j], uv);
+            }
+            query_accessor[WIid] = result;
+        });
+    });
+
+    const sycl::host_accessor<Queries_t, 1, sycl::access_mode::read> query_accessor(queries);
+    const sycl::host_accessor<Triangle_t<double>, 1, sycl::access_mode::read> shape_accessor(scene.shapes_);
+    const sycl::host_accessor<MeshTop_t<double>, 1, sycl::access_mode::read> instance_accessor(scene.instances_);
+
+    constexpr std::array<uint32_t, 3> visibilities = {Visibility::camera, Visibility::secondary, Visibility::all};
+    std::array<size_t, 3> n_shape_hits{};
+    std::array<size_t, 3> n_instance_hits{};
+    for (size_t i = 0; i < rays.size(); ++i) {
+        const Queries_t& result = query_accessor[i];
+        for (size_t j = 0; j < visibilities.size(); ++j) {
+            if (result.instance[j]) {
+                REQUIRE((instance_accessor[*result.instance[j]].mask_ & visibilities[j]) != 0);
+                REQUIRE(result.t[j] <= result.t_brute[j]);
+                ++n_instance_hits[j];
+            }
+            else {
+                REQUIRE(result.hit[j] == result.brute_hit[j]);
+                if (result.hit[j]) {
+                    REQUIRE(result.t[j] == result.t_brute[j]);
+                    REQUIRE((shape_accessor[*result.hit[j]].mask_ & visibilities[j]) != 0);
+                    ++n_shape_hits[j];
+                }
+            }
+        }
+    }
+    for (size_t j = 0; j < visibilities.size(); ++j) {
+        REQUIRE(n_shape_hits[j] > 0);
+        REQUIRE(n_instance_hits[j] > 0);
+    }
+}
+
+TEST_CASE("Scene_t batched ray queries", "Compares the hit records of a batch of rays to the closest hit of each ray") {
+    std::mt19937 rng(60);
+    std::uniform_real_distribution<double> position(-10, 10);
+    std::uniform_real_distribution<double> angle(0, 6.28);
+    std::uniform_real_distribution<double> scale(0.1, 0.4);
+    auto triangles                             = get_random_triangles(rng, N_RANDOM_TRIANGLES);
+    auto mesh                                  = get_random_triangles(rng, N_RANDOM_TRIANGLES);
+    auto rays                                  = get_random_rays(rng);
+    std::array<Diffuse_t<double>, 3> materials = {Diffuse_t<double>(Vec3<double>(0, 0, 0), Vec3<double>(0.5, 0.5, 0.5), 1),
+                                                    Diffuse_t<double>(Vec3<double>(0, 0, 0), Vec3<double>(0.25, 0.5, 0.75), 1),
+                                                    Diffuse_t<double>(Vec3<double>(1, 1, 1), Vec3<double>(0.5, 0.5, 0.5), 1)};
+    std::vector<MeshTop_t<double>> instances;
+
+    // Odd shapes use the second material, mesh shapes the first one, and even instances replace it with the third one
+    for (size_t i = 0; i < triangles.size(); ++i) {
+        triangles[i].material_ = i % 2;
+    }
+    for (size_t i = 0; i < N_RANDOM_INSTANCES; ++i) {
+        TransformMatrix_t<double> transformation;
+        transformation.scale(scale(rng)).rotateX(angle(rng)).rotateZ(angle(rng)).translate(Vec3<double>(position(rng), position(rng), position(rng)));
+        instances.emplace_back(0, transformation, (i % 2 == 0) ? std::optional<size_t>(2) : std::nullopt);
+    }
+
+    auto scene = make_scene(triangles, materials);
+    scene.add_mesh(mesh);
+    scene.add(instances);
+    scene.build_acc();
+
+    std::vector<Vec3<double>> origins;
+    std::vector<Vec3<double>> directions;
+    origins.reserve(rays.size());
+    directions.reserve(rays.size());
+    for (const auto& ray: rays) {
+        origins.push_back(ray.origin_);
+        directions.push_back(ray.direction_);
+    }
+
+    sycl::queue queue(sycl::default_selector_v);
+    const std::vector<Hit_t<double>> hits = scene.intersect(queue, origins, directions);
+    REQUIRE(hits.size() == rays.size());
+    REQUIRE(scene.intersect(queue, origins, std::span<const Vec3<double>>(directions).first(directions.size() - 1)).empty());
+
+    struct Intersection_t {
+            std::optional<size_t> hit;
+            std::optional<size_t> instance;
+            double t;
+            std::array<double, 2> uv;
+    };
+
+    sycl::buffer<Ray_t<double, 16>, 1> ray_buffer(rays.data(), sycl::range<1>{rays.size()});
+    sycl::buffer<Intersection_t, 1> intersections(sycl::range<1>{rays.size()});
+    queue.submit([&](sycl::handler& cgh) {
+        auto scene_accessor        = scene.getAccessor(cgh);
+        auto ray_accessor          = ray_buffer.get_access<sycl::access::mode::read>(cgh);
+        auto intersection_accessor = intersections.get_access<sycl::access::mode::discard_write>(cgh);
+
+        cgh.parallel_for<class IntersectRays>(ray_accessor.get_range(), [=](sycl::id<1> WIid) {
+            Intersection_t result{};
+            result.hit                  = scene_accessor.intersect(ray_accessor[WIid], result.t, result.uv, result.instance);
+            intersection_accessor[WIid] = result;
+        });
+    });
+
+    const sycl::host_accessor<Intersection_t, 1, sycl::access_mode::read> intersection_accessor(intersections);
+    const sycl::host_accessor<Triangle_t<double>, 1, sycl::access_mode::read> shape_accessor(scene.shapes_);
+
+    size_t n_shape_hits    = 0;
+    size_t n_instance_hits = 0;
+    for (size_t i = 0; i < rays.size(); ++i) {
+        const Intersection_t& result = intersection_accessor[i];
+        REQUIRE(hits[i].hit() == result.hit.has_value());
+        if (!result.hit) {
+            REQUIRE(hits[i].instance_ == Hit_t<double>::none_);
+            REQUIRE(hits[i].material_ == Hit_t<double>::none_);
+            continue;
+        }
+
+        REQUIRE(hits[i].shape_ == *result.hit);
+        REQUIRE(hits[i].t_ == result.t);
+        REQUIRE(hits[i].uv_ == result.uv);
+        if (result.instance) {
+            REQUIRE(hits[i].instance_ == *result.instance);
+            REQUIRE(hits[i].material_ == ((*result.instance % 2 == 0) ? 2 : 0));
+            ++n_instance_hits;
+        }
+        else {
+            REQUIRE(hits[i].instance_ == Hit_t<double>::none_);
+            REQUIRE(hits[i].material_ == shape_accessor[*result.hit].material_);
+            ++n_shape_hits;
+        }
+    }
+    REQUIRE(n_shape_hits > 0);
+    REQUIRE(n_instance_hits > 0);
+}
+
+TEST_CASE("Scene_t batched ray queries benchmark", "[.][benchmark]") {
+    std::mt19937 rng(61);
+    auto triangles = get_random_triangles(rng, N_RANDOM_TRIANGLES_LBVH);
+    auto rays      = get_random_rays(rng, N_BENCHMARK_RAYS);
+    auto scene     = make_scene(triangles);
+    scene.build_acc();
+
+    std::vector<Vec3<double>> origins;
+    std::vector<Vec3<double>> directions;
+    origins.reserve(rays.size());
+    directions.reserve(rays.size());
+    for (const auto& ray: rays) {
+        origins.push_back(ray.origin_);
+        directions.push_back(ray.direction_);
+    }
+
+    sycl::queue queue(sycl::default_selector_v);
+    sycl::buffer<Vec3<double>, 1> origin_buffer(origins.data(), sycl::range<1>{origins.size()});
+    sycl::buffer<Vec3<double>, 1> direction_buffer(directions.data(), sycl::range<1>{directions.size()});
+    sycl::buffer<Hit_t<double>, 1> hit_buffer(sycl::range<1>{rays.size()});
+    sycl::buffer<Ray_t<double, 16>, 1> ray_buffer(rays.data(), sycl::range<1>{rays.size()});
+    sycl::buffer<double, 1> distances(sycl::range<1>{rays.size()});
+
+    BENCHMARK("Camera rays") {
+        trace_scene<false>(queue, scene, ray_buffer, distances);
+    };
+    BENCHMARK("Batched queries") {
+        scene.intersect(queue, origin_buffer, direction_buffer, hit_buffer);
+        queue.wait();
+    };
+}
+
+TEST_CASE("Scene_t packet queries", "Compares the hits of packets of coherent rays to the hits of the same rays traced one at a time") {
+    std::mt19937 rng(62);
+    std::uniform_real_distribution<double> position(-10, 10);
+    std::uniform_real_distribution<double> angle(0, 6.28);
+    std::uniform_real_distribution<double> scale(0.1, 0.4);
+    auto triangles = get_random_triangles(rng, N_RANDOM_TRIANGLES_LBVH);
+    auto mesh      = get_random_triangles(rng, N_RANDOM_TRIANGLES);
+    std::vector<MeshTop_t<double>> instances;
+
+    // Some shapes are hidden from camera rays, so that leaves are culled for only part of the packets
+    for (size_t i = 0; i < triangles.size(); i += 4) {
+        triangles[i].mask_ = Visibility::secondary;
+    }
+    for (size_t i = 0; i < N_RANDOM_INSTANCES; ++i) {
+        TransformMatrix_t<double> transformation;
+        transformation.scale(scale(rng)).rotateX(angle(rng)).rotateZ(angle(rng)).translate(Vec3<double>(position(rng), position(rng), position(rng)));
+        instances.emplace_back(0, transformation);
+    }
+
+    auto scene = make_scene(triangles);
+    scene.add_mesh(mesh);
+    scene.add(instances);
+    scene.build_acc();
+
+    // Rays from outside the shapes have packets with directions of constant sign, rays from inside have packets crossing the axes
+    auto rays              = get_camera_rays(Vec3<double>(0, -15, 0), 32, 1.2);
+    const auto rays_inside = get_camera_rays(Vec3<double>(1, 2, 3), 32, 1.5);
+    rays.insert(rays.end(), rays_inside.begin(), rays_inside.end());
+    for (size_t i = 0; i < rays.size(); i += 3) {
+        rays[i].visibility_ = Visibility::camera;
+    }
+
+    sycl::queue queue(sycl::default_selector_v);
+    sycl::buffer<Ray_t<double, 16>, 1> ray_buffer(rays.data(), sycl::range<1>{rays.size()});
+    sycl::buffer<Hit_t<double>, 1> hits(sycl::range<1>{rays.size()});
+    sycl::buffer<Hit_t<double>, 1> packet_hits(sycl::range<1>{rays.size()});
+    trace_packets<false>(queue, scene, ray_buffer, hits);
+    trace_packets<true>(queue, scene, ray_buffer, packet_hits);
+
+    const sycl::host_accessor<Hit_t<double>, 1, sycl::access_mode::read> hit_accessor(hits);
+    const sycl::host_accessor<Hit_t<double>, 1, sycl::access_mode::read> packet_hit_accessor(packet_hits);
+    size_t n_hits          = 0;
+    size_t n_instance_hits = 0;
+    for (size_t i = 0; i < rays.size(); ++i) {
+        REQUIRE(packet_hit_accessor[i].shape_ == hit_accessor[i].shape_);
+        REQUIRE(packet_hit_accessor[i].instance_ == hit_accessor[i].instance_);
+        REQUIRE(packet_hit_accessor[i].material_ == hit_accessor[i].material_);
+        REQUIRE(packet_hit_accessor[i].t_ == hit_accessor[i].t_);
+        REQUIRE(packet_hit_accessor[i].uv_ == hit_accessor[i].uv_);
+        n_hits += hit_accessor[i].hit() ? 1 : 0;
+        n_instance_hits += (hit_accessor[i].instance_ != Hit_t<double>::none_) ? 1 : 0;
+    }
+    REQUIRE(n_hits > 0);
+    REQUIRE(n_instance_hits > 0);
+}
+
+TEST_CASE("SphericalCamera_t packet traversal", "Compares the image rendered with packets of camera rays to the image rendered one ray at a time") {
+    constexpr size_t size_x = 20;
+    constexpr size_t size_y = 13;
+    std::mt19937 rng(63);
+    auto triangles                             = get_random_triangles(rng, N_RANDOM_TRIANGLES);
+    std::array<Diffuse_t<double>, 2> materials = {Diffuse_t<double>(Vec3<double>(0, 0, 0), Vec3<double>(0.5, 0.5, 0.5), 1),
+                                                    Diffuse_t<double>(Vec3<double>(1, 0.5, 0.25), Vec3<double>(0.5, 0.5, 0.5), 1)};
+    for (size_t i = 0; i < triangles.size(); i += 2) {
+        triangles[i].material_ = 1;
+    }
+    auto scene = make_scene(triangles, materials);
+    scene.build_acc();
+
+    // Both random generators start from the same state, so that each pixel draws the same numbers
+    RandomGenerator_t<double> random_generator(size_x, size_y);
+    RandomGenerator_t<double> packet_random_generator(size_x, size_y);
+    {
+        const sycl::host_accessor<std::mt19937, 2, sycl::access_mode::read> rng_accessor(random_generator.rng_);
+        const sycl::host_accessor<std::mt19937, 2, sycl::access_mode::write> packet_rng_accessor(packet_random_generator.rng_);
+        std::copy(rng_accessor.begin(), rng_accessor.end(), packet_rng_accessor.begin());
+    }
+
+    const MediumList_t<16> medium_list{
+        2, std::array<size_t, 16>{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+    };
+    const auto make_camera = [&]() {
+        SphericalCamera_t<double, SkyboxFlat_t, SimpleImage_t> camera(TransformMatrix_t<double>{},
+                                                                      "packets.png",
+                                                                      Vec3<double>(0, 0, 1),
+                                                                      std::array<double, 2>{0.9, 1.4},
+                                                                      std::array<unsigned int, 2>{2, 1},
+                                                                      medium_list,
+                                                                      SkyboxFlat_t<double>(Vec3<double>(0.75, 0.75, 0.99)),
+                                                                      4,
+                                                                      1,
+                                                                      SimpleImage_t<double>(size_x, size_y));
+        camera.transformation_.translate(Vec3<double>(0, -15, 0));
+        camera.update();
+        return camera;
+    };
+    auto camera        = make_camera();
+    auto packet_camera = make_camera();
+
+    sycl::queue queue(sycl::default_selector_v);
+    camera.raytrace_rays(queue, random_generator, scene);
+    packet_camera.raytrace_packets(queue, packet_random_generator, scene);
+
+    for (size_t i = 0; i < size_x; ++i) {
+        for (size_t j = 0; j < size_y; ++j) {
+            const Vec3<double> colour        = camera.image_.get(i, j);
+            const Vec3<double> packet_colour = packet_camera.image_.get(i, j);
+            REQUIRE(packet_colour == colour);
+        }
+    }
+}
+
+TEST_CASE("SphericalCamera_t cached traversal", "Compares the images rendered with the top levels of the BVH in local memory to the image rendered without the cache") {
+    constexpr size_t size_x = 20;
+    constexpr size_t size_y = 13;
+    std::mt19937 rng(65);
+    auto triangles                             = get_random_triangles(rng, N_RANDOM_TRIANGLES);
+    std::array<Diffuse_t<double>, 2> materials = {Diffuse_t<double>(Vec3<double>(0, 0, 0), Vec3<double>(0.5, 0.5, 0.5), 1),
+                                                    Diffuse_t<double>(Vec3<double>(1, 0.5, 0.25), Vec3<double>(0.5, 0.5, 0.5), 1)};
+    for (size_t i = 0; i < triangles.size(); i += 2) {
+        triangles[i].material_ = 1;
+    }
+    for (size_t i = 0; i < triangles.size(); i += 5) {
+        triangles[i].mask_ = Visibility::secondary;
+    }
+    auto scene = make_scene(triangles, materials);
+    scene.build_acc();
+
+    const MediumList_t<16> medium_list{
+        2, std::array<size_t, 16>{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+    };
+    const auto make_camera = [&](unsigned int cached_levels) {
+        SphericalCamera_t<double, SkyboxFlat_t, SimpleImage_t> camera(TransformMatrix_t<double>{},
+                                                                      "cached.png",
+                                                                      Vec3<double>(0, 0, 1),
+                                                                      std::array<double, 2>{0.9, 1.4},
+                                                                      std::array<unsigned int, 2>{2, 1},
+                                                                      medium_list,
+                                                                      SkyboxFlat_t<double>(Vec3<double>(0.75, 0.75, 0.99)),
+                                                                      4,
+                                                                      1,
+                                                                      SimpleImage_t<double>(size_x, size_y));
+        camera.transformation_.translate(Vec3<double>(0, -15, 0));
+        camera.cached_levels_ = cached_levels;
+        camera.update();
+        return camera;
+    };
+
+    // All the random generators start from the same state, so that each pixel draws the same numbers
+    sycl::queue queue(sycl::default_selector_v);
+    RandomGenerator_t<double> random_generator(size_x, size_y);
+    const std::vector<std::mt19937> initial_state = [&]() {
+        const sycl::host_accessor<std::mt19937, 2, sycl::access_mode::read> rng_accessor(random_generator.rng_);
+        return std::vector<std::mt19937>(rng_accessor.begin(), rng_accessor.end());
+    }();
+    auto camera = make_camera(0);
+    camera.raytrace(queue, random_generator, scene);
+
+    // The cache is limited to the local memory of the device, and to levels whose slots fit in 32 bits
+    REQUIRE(BVH_t<double>::max_cached_levels(0) == 0);
+    REQUIRE(BVH_t<double>::max_cached_levels(sizeof(BVHNode_t<double>)) == 1);
+    REQUIRE(BVH_t<double>::max_cached_levels(3 * sizeof(BVHNode_t<double>) - 1) == 1);
+    REQUIRE(BVH_t<double>::max_cached_levels(std::numeric_limits<size_t>::max() / 2) == BVH_t<double>::max_cached_levels_);
+    const size_t max_levels = scene.max_cached_levels(queue.get_device());
+    REQUIRE((size_t{1} << max_levels) - 1 <= queue.get_device().get_info<sycl::info::device::local_mem_size>() / sizeof(BVHNode_t<double>));
+
+    // A single level caches only the root, more levels than the hierarchy has leave slots empty, and more than fit are cut down
+    for (const unsigned int cached_levels: {1U, 3U, 12U, 40U}) {
+        RandomGenerator_t<double> cached_random_generator(size_x, size_y);
+        {
+            const sycl::host_accessor<std::mt19937, 2, sycl::access_mode::write> rng_accessor(cached_random_generator.rng_);
+            std::copy(initial_state.begin(), initial_state.end(), rng_accessor.begin());
+        }
+        auto cached_camera = make_camera(cached_levels);
+        cached_camera.raytrace(queue, cached_random_generator, scene);
+
+        for (size_t i = 0; i < size_x; ++i) {
+            for (size_t j = 0; j < size_y; ++j) {
+                const Vec3<double> colour        = camera.image_.get(i, j);
+                const Vec3<double> cached_colour = cached_camera.image_.get(i, j);
+                REQUIRE(cached_colour == colour);
+            }
+        }
+    }
+}
+
+TEST_CASE("Scene_t packet queries benchmark", "[.][benchmark]") {
+    std::mt19937 rng(64);
+    auto triangles = get_random_triangles(rng, N_RANDOM_TRIANGLES_LBVH);
+    auto rays      = get_camera_rays(Vec3<double>(0, -15, 0), 256, 1.2);
+    auto scene     = make_scene(triangles);
+    scene.build_acc();
+
+    sycl::queue queue(sycl::default_selector_v);
+    sycl::buffer<Ray_t<double, 16>, 1> ray_buffer(rays.data(), sycl::range<1>{rays.size()});
+    sycl::buffer<Hit_t<double>, 1> hits(sycl::range<1>{rays.size()});
+
+    BENCHMARK("Single rays") {
+        trace_packets<false>(queue, scene, ray_buffer, hits);
+    };
+    BENCHMARK("Packets") {
+        trace_packets<true>(queue, scene, ray_buffer, hits);
+    };
+}
+
+TEST_CASE("SphericalCamera_t cached traversal benchmark", "[.][benchmark]") {
+    constexpr size_t size = 64;
+    std::mt19937 rng(66);
+    auto triangles = get_random_triangles(rng, N_RANDOM_TRIANGLES_LBVH);
+    auto scene     = make_scene(triangles);
+    scene.build_acc();
+
+    const MediumList_t<16> medium_list{
+        2, std::array<size_t, 16>{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+    };
+    SphericalCamera_t<double, SkyboxFlat_t, SimpleImage_t> camera(TransformMatrix_t<double>{},
+                                                                  "cached.png",
+                                                                  Vec3<double>(0, 0, 1),
+                                                                  std::array<double, 2>{1.2, 1.2},
+                                                                  std::array<unsigned int, 2>{1, 1},
+                                                                  medium_list,
+                                                                  SkyboxFlat_t<double>(Vec3<double>(0.75, 0.75, 0.99)),
+                                                                  2,
+                                                                  1,
+                                                                  SimpleImage_t<double>(size, size));
+    camera.transformation_.translate(Vec3<double>(0, -15, 0));
+    camera.update();
+
+    sycl::queue queue(sycl::default_selector_v);
+    RandomGenerator_t<double> random_generator(size, size);
+
+    BENCHMARK("No cache") {
+        camera.raytrace_rays(queue, random_generator, scene);
+        queue.wait();
+    };
+    for (const unsigned int cached_levels: {2U, 4U, 6U, 8U}) {
+        BENCHMARK("Cached levels: " + std::to_string(cached_levels)) {
+            camera.raytrace_cached(queue, random_generator, scene, cached_levels);
+            queue.wait();
+        };
+    }
+}
+
+TEST_CASE("Scene_t clip planes", "Compares the closest hits of a scene with clip planes to the closest hits kept by the planes, found by brute force") {
+    std::mt19937 rng(67);
+    auto triangles = get_random_triangles(rng, N_RANDOM_TRIANGLES);
+    auto rays      = get_random_rays(rng);
+    auto scene     = make_scene(triangles);
+    scene.build_acc();
+
+    std::vector<Vec3<double>> origins;
+    std::vector<Vec3<double>> directions;
+    origins.reserve(rays.size());
+    directions.reserve(rays.size());
+    for (const auto& ray: rays) {
+        origins.push_back(ray.origin_);
+        directions.push_back(ray.direction_);
+    }
+
+    // Hits are kept if their point is behind all the planes
+    sycl::queue queue(sycl::default_selector_v);
+    const auto compare_hits = [&]() {
+        const std::vector<Hit_t<double>> hits = scene.intersect(queue, origins, directions);
+        size_t n_hits                         = 0;
+        for (size_t i = 0; i < rays.size(); ++i) {
+            double t_closest = std::numeric_limits<double>::max();
+            uint32_t closest = Hit_t<double>::none_;
+            for (size_t j = 0; j < triangles.size(); ++j) {
+                double t{};
+                std::array<double, 2> uv{};
+                if (!triangles[j].intersection(rays[i], t, uv) || (t >= t_closest)) {
+                    continue;
+                }
+                const Vec3<double> point = rays[i].origin_ + rays[i].direction_ * t;
+                bool kept                = true;
+                for (size_t k = 0; k < scene.n_clip_planes_; ++k) {
+                    kept = kept && (scene.clip_planes_[k].normal_.dot(point) <= scene.clip_planes_[k].distance_);
+                }
+                if (kept) {
+                    t_closest = t;
+                    closest   = static_cast<uint32_t>(j);
+                }
+            }
+
+            REQUIRE(hits[i].shape_ == closest);
+            if (hits[i].hit()) {
+                REQUIRE(std::abs(hits[i].t_ - t_closest) <= 1e-9 * t_closest);
+                ++n_hits;
+            }
+        }
+        return n_hits;
+    };
+
+    const size_t n_hits = compare_hits();
+
+    REQUIRE(scene.add(ClipPlane_t<double>{Vec3<double>(1, 0.25, 0), 2}));
+    const size_t n_hits_plane = compare_hits();
+    REQUIRE(n_hits_plane < n_hits);
+
+    // Moving the plane only changes the plane, the acceleration structure is left as is
+    scene.clip_planes_[0].distance_ = -3;
+    const size_t n_hits_moved       = compare_hits();
+    REQUIRE(n_hits_moved != n_hits_plane);
+
+    scene.clear_clip_planes();
+    const auto box = ClipPlane_t<double>::box(Vec3<double>(-4, -4, -4), Vec3<double>(5, 3, 5));
+    REQUIRE(scene.add(box));
+    REQUIRE(scene.n_clip_planes_ == 6);
+    REQUIRE(compare_hits() < n_hits);
+
+    // A second box doesn't fit, and none of its planes is added
+    REQUIRE(!scene.add(box));
+    REQUIRE(scene.n_clip_planes_ == 6);
+    REQUIRE(scene.add(box[0]));
+    REQUIRE(scene.add(box[1]));
+    REQUIRE(!scene.add(box[2]));
+    REQUIRE(scene.n_clip_planes_ == 8);
+
+    scene.clear_clip_planes();
+    REQUIRE(compare_hits() == n_hits);
+}
+
+TEST_CASE("Scene_t intersection buffer", "Compares the closest hits found from the points and edges of the shapes to the brute force intersection of the shapes, as shapes are moved, added and removed") {
+    std::mt19937 rng(68);
+    std::uniform_real_distribution<double> offset(-1, 1);
+    auto triangles       = get_random_triangles(rng, N_RANDOM_TRIANGLES);
+    auto added_triangles = get_random_triangles(rng, N_RANDOM_TRIANGLES / 4);
+    auto rays            = get_random_rays(rng);
+    auto scene           = make_scene(triangles);
+    scene.build_acc();
+
+    // Traversal reads three vectors and a mask per triangle instead of the whole shape, about three times less memory
+    REQUIRE(sizeof(Triangle_t<double>) > 3 * (3 * sizeof(Vec3<double>) + sizeof(uint32_t)));
+
+    std::vector<Vec3<double>> origins;
+    std::vector<Vec3<double>> directions;
+    origins.reserve(rays.size());
+    directions.reserve(rays.size());
+    for (const auto& ray: rays) {
+        origins.push_back(ray.origin_);
+        directions.push_back(ray.direction_);
+    }
+
+    sycl::queue queue(sycl::default_selector_v);
+    const auto compare_hits = [&]() {
+        REQUIRE(scene.shape_intersections_.points_.get_range()[0] == scene.shapes_.get_range()[0]);
+        const std::vector<Hit_t<double>> hits = scene.intersect(queue, origins, directions);
+        const sycl::host_accessor<Triangle_t<double>, 1, sycl::access_mode::read> shape_accessor(scene.shapes_);
+
+        size_t n_hits = 0;
+        for (size_t i = 0; i < rays.size(); ++i) {
+            double t_closest = std::numeric_limits<double>::max();
+            uint32_t closest = Hit_t<double>::none_;
+            for (size_t j = 0; j < shape_accessor.get_range()[0]; ++j) {
+                double t{};
+                std::array<double, 2> uv{};
+                if (shape_accessor[j].intersection(rays[i], t, uv) && (t < t_closest)) {
+                    t_closest = t;
+                    closest   = static_cast<uint32_t>(j);
+                }
+            }
+
+            REQUIRE(hits[i].shape_ == closest);
+            if (hits[i].hit()) {
+                REQUIRE(hits[i].t_ == t_closest);
+                ++n_hits;
+            }
+        }
+        REQUIRE(n_hits > 0);
+    };
+
+    compare_hits();
+
+    // Moved shapes are copied to the intersection buffer on the device by update
+    {
+        const sycl::host_accessor<Triangle_t<double>, 1, sycl::access_mode::read_write> shape_accessor(scene.shapes_);
+        for (size_t i = 0; i < shape_accessor.get_range()[0]; i += 2) {
+            TransformMatrix_t<double> transformation;
+            transformation.translate(Vec3<double>(offset(rng), offset(rng), offset(rng)));
+            shape_accessor[i].transformation_ = static_cast<uint32_t>(scene.add_transformation(transformation));
+        }
+    }
+    scene.update(queue);
+    compare_hits();
+
+    scene.add(queue, added_triangles);
+    compare_hits();
+
+    std::vector<size_t> removed;
+    for (size_t i = 0; i < triangles.size() + added_triangles.size(); i += 3) {
+        removed.push_back(i);
+    }
+    scene.remove_shapes(queue, removed);
+    compare_hits();
+}
+
+TEST_CASE("Scene_t indexed meshes", "Compares the hits and the image of instances of an indexed mesh to the hits and the image of instances of the same mesh stored as triangles") {
+    constexpr size_t size_x     = 20;
+    constexpr size_t size_y     = 13;
+    constexpr size_t n_around   = 48;
+    constexpr size_t n_section  = 24;
+    constexpr double pi         = 3.141592653589793;
+    constexpr double big_radius = 1;
+    constexpr double radius     = 0.35;
+    std::mt19937 rng(69);
+    std::uniform_real_distribution<double> position(-10, 10);
+    std::uniform_real_distribution<double> angle(0, 6.28);
+    std::uniform_real_distribution<double> scale(1, 2.5);
+    auto rays                                  = get_random_rays(rng);
+    std::array<Diffuse_t<double>, 3> materials = {Diffuse_t<double>(Vec3<double>(0, 0, 0), Vec3<double>(0.5, 0.5, 0.5), 1),
+                                                    Diffuse_t<double>(Vec3<double>(1, 0.5, 0.25), Vec3<double>(0.5, 0.5, 0.5), 1),
+                                                    Diffuse_t<double>(Vec3<double>(0, 0, 0), Vec3<double>(0.25, 0.5, 0.75), 1)};
+
+    // Torus whose vertices are shared by the four quads around them, with the same index for their position, texture coordinates and normal
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "agptracer_indexed_mesh_test";
+    std::filesystem::create_directories(directory);
+    {
+        std::ofstream file(directory / "torus.obj");
+        file.precision(17);
+        for (size_t i = 0; i < n_around; ++i) {
+            for (size_t j = 0; j < n_section; ++j) {
+                const double phi   = 2 * pi * static_cast<double>(i) / n_around;
+                const double theta = 2 * pi * static_cast<double>(j) / n_section;
+                const Vec3<double> normal(std::cos(phi) * std::cos(theta), std::sin(phi) * std::cos(theta), std::sin(theta));
+                const Vec3<double> point = Vec3<double>(std::cos(phi), std::sin(phi), 0) * big_radius + normal * radius;
+                file << "v " << point[0] << " " << point[1] << " " << point[2] << "\n";
+                file << "vt " << static_cast<double>(i) / n_around << " " << static_cast<double>(j) / n_section << "\n";
+                file << "vn " << normal[0] << " " << normal[1] << " " << normal[2] << "\n";
+            }
+        }
+        for (size_t i = 0; i < n_around; ++i) {
+            for (size_t j = 0; j < n_section; ++j) {
+                const std::array<size_t, 4> corners{i * n_section + j + 1,
+                                                    ((i + 1) % n_around) * n_section + j + 1,
+                                                    ((i + 1) % n_around) * n_section + (j + 1) % n_section + 1,
+                                                    i * n_section + (j + 1) % n_section + 1};
+                file << "f";
+                for (const size_t corner: corners) {
+                    file << " " << corner << "/" << corner << "/" << corner;
+                }
+                file << "\n";
+            }
+        }
+    }
+    const MeshGeometry_t<double> geometry(directory / "torus.obj");
+    std::filesystem::remove_all(directory);
+    REQUIRE(geometry.face_nodes_.size() == 2 * n_around * n_section);
+
+    std::vector<Triangle_t<double>> triangles;
+    triangles.reserve(geometry.face_nodes_.size());
+    for (size_t i = 0; i < geometry.face_nodes_.size(); ++i) {
+        triangles.emplace_back(1,
+                               0,
+                               std::array<Vec3<double>, 3>{geometry.nodes_[geometry.face_nodes_[i][0]], geometry.nodes_[geometry.face_nodes_[i][1]], geometry.nodes_[geometry.face_nodes_[i][2]]},
+                               std::array<Vec3<double>, 3>{geometry.normals_[geometry.face_normals_[i][0]],
+                                                           geometry.normals_[geometry.face_normals_[i][1]],
+                                                           geometry.normals_[geometry.face_normals_[i][2]]},
+                               std::array<std::array<double, 2>, 3>{geometry.texture_coordinates_[geometry.face_texture_coordinates_[i][0]],
+                                                                    geometry.texture_coordinates_[geometry.face_texture_coordinates_[i][1]],
+                                                                    geometry.texture_coordinates_[geometry.face_texture_coordinates_[i][2]]});
+    }
+
+    // Odd instances replace the material of the mesh
+    std::vector<MeshTop_t<double>> instances;
+    for (size_t i = 0; i < N_RANDOM_INSTANCES; ++i) {
+        TransformMatrix_t<double> transformation;
+        transformation.scale(scale(rng)).rotateX(angle(rng)).rotateZ(angle(rng)).translate(Vec3<double>(position(rng), position(rng), position(rng)));
+        instances.emplace_back(0, transformation, (i % 2 == 1) ? std::optional<size_t>(2) : std::nullopt);
+    }
+
+    auto indexed_scene = make_scene(std::span<Triangle_t<double>>(), materials);
+    auto scene         = make_scene(std::span<Triangle_t<double>>(), materials);
+    REQUIRE(indexed_scene.add_mesh(geometry, 1) == 0);
+    REQUIRE(scene.add_mesh(triangles) == 0);
+    indexed_scene.add(instances);
+    scene.add(instances);
+    indexed_scene.build_acc();
+    scene.build_acc();
+
+    // Each vertex holds a position, a normal and texture coordinates, and each triangle three indices and a material
+    REQUIRE(indexed_scene.indexed_meshes_.vertices_.get_range()[0] == n_around * n_section);
+    REQUIRE(indexed_scene.indexed_meshes_.size() == triangles.size());
+    const size_t indexed_bytes = indexed_scene.indexed_meshes_.vertices_.get_range()[0] * (sizeof(Vec3<double>) + sizeof(uint32_t) + sizeof(std::array<sycl::half, 2>))
+                               + indexed_scene.indexed_meshes_.size() * 4 * sizeof(uint32_t);
+    REQUIRE(triangles.size() * sizeof(Triangle_t<double>) > 8 * indexed_bytes);
+
+    std::vector<Vec3<double>> origins;
+    std::vector<Vec3<double>> directions;
+    origins.reserve(rays.size());
+    directions.reserve(rays.size());
+    for (const auto& ray: rays) {
+        origins.push_back(ray.origin_);
+        directions.push_back(ray.direction_);
+    }
+
+    sycl::queue queue(sycl::default_selector_v);
+    const std::vector<Hit_t<double>> indexed_hits = indexed_scene.intersect(queue, origins, directions);
+    const std::vector<Hit_t<double>> hits         = scene.intersect(queue, origins, directions);
+
+    size_t n_hits = 0;
+    for (size_t i = 0; i < rays.size(); ++i) {
+        REQUIRE(indexed_hits[i].shape_ == hits[i].shape_);
+        REQUIRE(indexed_hits[i].instance_ == hits[i].instance_);
+        REQUIRE(indexed_hits[i].material_ == hits[i].material_);
+        if (hits[i].hit()) {
+            REQUIRE(indexed_hits[i].t_ == hits[i].t_);
+            REQUIRE(indexed_hits[i].uv_ == hits[i].uv_);
+            ++n_hits;
+        }
+    }
+    REQUIRE(n_hits > 0);
+
+    // Both random generators start from the same state, so that each pixel draws the same numbers
+    RandomGenerator_t<double> random_generator(size_x, size_y);
+    RandomGenerator_t<double> indexed_random_generator(size_x, size_y);
+    {
+        const sycl::host_accessor<std::mt19937, 2, sycl::access_mode::read> rng_accessor(random_generator.rng_);
+        const sycl::host_accessor<std::mt19937, 2, sycl::access_mode::write> indexed_rng_accessor(indexed_random_generator.rng_);
+        std::copy(rng_accessor.begin(), rng_accessor.end(), indexed_rng_accessor.begin());
+    }
+
+    const MediumList_t<16> medium_list{
+        2, std::array<size_t, 16>{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+    };
+    const auto make_camera = [&]() {
+        SphericalCamera_t<double, SkyboxFlat_t, SimpleImage_t> camera(TransformMatrix_t<double>{},
+                                                                      "indexed.png",
+                                                                      Vec3<double>(0, 0, 1),
+                                                                      std::array<double, 2>{0.9, 1.4},
+                                                                      std::array<unsigned int, 2>{2, 1},
+                                                                      medium_list,
+                                                                      SkyboxFlat_t<double>(Vec3<double>(0.75, 0.75, 0.99)),
+                                                                      4,
+                                                                      1,
+                                                                      SimpleImage_t<double>(size_x, size_y));
+        camera.transformation_.translate(Vec3<double>(0, -15, 0));
+        camera.update();
+        return camera;
+    };
+    auto camera         = make_camera();
+    auto indexed_camera = make_camera();
+
+    camera.raytrace_rays(queue, random_generator, scene);
+    indexed_camera.raytrace_rays(queue, indexed_random_generator, indexed_scene);
+
+    for (size_t i = 0; i < size_x; ++i) {
+        for (size_t j = 0; j < size_y; ++j) {
+            REQUIRE(indexed_camera.image_.get(i, j) == camera.image_.get(i, j));
+        }
+    }
+}
+
+TEST_CASE("AffineTriangle_t intersection", "Compares the hits of the precomputed affine triangles to the hits of the triangles they were computed from") {
+    std::mt19937 rng(71);
+    auto triangles = get_random_triangles(rng, N_RANDOM_TRIANGLES);
+    auto rays      = get_random_rays(rng);
+
+    // A degenerate triangle doesn't intersect any ray
+    const AffineTriangle_t<double> degenerate(std::array<Vec3<double>, 3>{Vec3<double>(0, 0, 0), Vec3<double>(1, 1, 1), Vec3<double>(2, 2, 2)});
+    double t_degenerate = 0;
+    std::array<double, 2> uv_degenerate{};
+    REQUIRE(!degenerate.intersection(Ray_t<double, 16>(Vec3<double>(1, 0, 0), Vec3<double>(-1, 1, 0).normalize_inplace(), Vec3<double>(), Vec3<double>(1), MediumList_t<16>()),
+                                     t_degenerate,
+                                     uv_degenerate));
+
+    size_t n_hits = 0;
+    for (const auto& triangle: triangles) {
+        const AffineTriangle_t<double> affine_triangle(triangle.points_);
+        for (const auto& ray: rays) {
+            double t        = 0;
+            double t_affine = 0;
+            std::array<double, 2> uv{};
+            std::array<double, 2> uv_affine{};
+            const bool hit        = triangle.intersection(ray, t, uv);
+            const bool hit_affine = affine_triangle.intersection(ray, t_affine, uv_affine);
+
+            REQUIRE(hit_affine == hit);
+            if (hit) {
+                REQUIRE(std::abs(t_affine - t) < 1e-9 * (1 + t));
+                REQUIRE(std::abs(uv_affine[0] - uv[0]) < 1e-9);
+                REQUIRE(std::abs(uv_affine[1] - uv[1]) < 1e-9);
+                ++n_hits;
+            }
+        }
+    }
+    REQUIRE(n_hits > 0);
+
+    // The record is twelve scalars
+    REQUIRE(sizeof(AffineTriangle_t<double>) == 12 * sizeof(double));
+    REQUIRE(sizeof(AffineTriangle_t<float>) == 12 * sizeof(float));
+}
+
+TEST_CASE("AffineTriangle_t intersection benchmark", "[.][benchmark]") {
+    std::mt19937 rng(72);
+    auto triangles = get_random_triangles(rng, N_RANDOM_TRIANGLES);
+    auto rays      = get_random_rays(rng, N_BENCHMARK_RAYS);
+
+    benchmark_triangle_intersection<float>(triangles, rays);
+    benchmark_triangle_intersection<double>(triangles, rays);
+}
+
+TEST_CASE("Scene_t transformation palette", "Compares the closest hit found with shapes transformed by a shared palette of matrices to the brute force intersection, as one matrix is changed") {
+    constexpr size_t n_objects = 4;
+    std::mt19937 rng(73);
+    std::uniform_real_distribution<double> angle(0, 6.28);
+    std::uniform_real_distribution<double> offset(-4, 4);
+    auto triangles = get_random_triangles(rng, N_RANDOM_TRIANGLES);
+    auto rays      = get_random_rays(rng);
+
+    // The triangles are split between objects, each with its own matrix after the identity
+    for (size_t i = 0; i < triangles.size(); ++i) {
+        triangles[i].transformation_ = static_cast<uint32_t>(1 + i % n_objects);
+    }
+    std::vector<TransformMatrix_t<double>> transformations(n_objects);
+    for (auto& transformation: transformations) {
+        transformation.rotateZ(angle(rng)).translate(Vec3<double>(offset(rng), offset(rng), offset(rng)));
+    }
+
+    auto scene = make_scene(triangles);
+    REQUIRE(scene.add_transformations(transformations) == 1);
+    REQUIRE(scene.transformations_.get_range()[0] == n_objects + 1);
+    scene.build_acc();
+
+    sycl::queue queue(sycl::default_selector_v);
+    const auto compare_shapes = [&]() {
+        const sycl::host_accessor<Triangle_t<double>, 1, sycl::access_mode::read> shape_accessor(scene.shapes_);
+        for (size_t i = 0; i < triangles.size(); ++i) {
+            Triangle_t<double> triangle = triangles[i];
+            triangle.update(transformations[i % n_objects]);
+            for (size_t j = 0; j < triangle.points_.size(); ++j) {
+                REQUIRE(shape_accessor[i].points_[j] == triangle.points_[j]);
+            }
+        }
+    };
+
+    scene.update(queue);
+    compare_shapes();
+    compare_intersections(queue, scene, rays);
+
+    // Moving an object only writes its matrix
+    transformations[2].rotateX(angle(rng)).translate(Vec3<double>(offset(rng), offset(rng), offset(rng)));
+    {
+        const sycl::host_accessor<TransformMatrix_t<double>, 1, sycl::access_mode::write> transformation_accessor(scene.transformations_);
+        transformation_accessor[3] = transformations[2];
+    }
+    scene.update(queue);
+    compare_shapes();
+    compare_intersections(queue, scene, rays);
+}
+
+TEST_CASE("Scene_t Morton order", "Compares the closest hit found after sorting the shapes along the Morton curve to the brute force intersection, and maps the sorted shapes back") {
+    std::mt19937 rng(74);
+    auto triangles       = get_random_triangles(rng, N_RANDOM_TRIANGLES_LBVH);
+    auto added_triangles = get_random_triangles(rng, N_RANDOM_TRIANGLES / 4);
+    auto rays            = get_random_rays(rng);
+    auto scene           = make_scene(triangles);
+
+    // The given shapes are in random order, so sorting them brings neighbouring shapes much closer in memory
+    constexpr size_t page_size = 4096;
+    sycl::queue queue(sycl::default_selector_v);
+    scene.build_acc();
+    const double pages_before = count_touched_blocks(scene, rays, page_size);
+    const double cost_before  = scene.acc_.cost(queue);
+    REQUIRE(scene.sort_shapes(queue) > 2);
+    const double pages_after = count_touched_blocks(scene, rays, page_size);
+    REQUIRE(pages_after < pages_before);
+    REQUIRE(scene.acc_.cost(queue) == cost_before);
+    compare_intersections(queue, scene, rays);
+
+    const auto compare_shapes = [&]() {
+        const sycl::host_accessor<Triangle_t<double>, 1, sycl::access_mode::read> shape_accessor(scene.shapes_);
+        REQUIRE(scene.shape_indices_.size() == shape_accessor.size());
+        for (size_t i = 0; i < scene.shape_indices_.size(); ++i) {
+            const size_t index              = scene.shape_indices_[i];
+            const Triangle_t<double>& given = (index < triangles.size()) ? triangles[index] : added_triangles[index - triangles.size()];
+            for (size_t j = 0; j < given.points_.size(); ++j) {
+                REQUIRE(shape_accessor[i].points_[j] == given.points_[j]);
+            }
+        }
+    };
+    compare_shapes();
+
+    // Indices stay valid as shapes are added, removed and sorted again
+    scene.add(added_triangles);
+    const std::array<size_t, 3> removed{0, 17, N_RANDOM_TRIANGLES_LBVH / 2};
+    scene.remove_shapes(removed);
+    compare_shapes();
+    REQUIRE(scene.sort_shapes(queue) > 1);
+    compare_shapes();
+    compare_intersections(queue, scene, rays);
+
+    // A hierarchy built with spatial splits and reordered in treelets is kept as it is, with its shapes renumbered
+    scene.acc_.build_spatial(scene.shapes_);
+    scene.reorder();
+    const double spatial_cost = scene.acc_.cost(queue);
+    const size_t n_nodes      = scene.acc_.n_nodes_;
+    scene.sort_shapes(queue);
+    REQUIRE(scene.acc_.cost(queue) == spatial_cost);
+    REQUIRE(scene.acc_.n_nodes_ == n_nodes);
+    compare_shapes();
+    compare_intersections(queue, scene, rays);
+}
+
+TEST_CASE("Scene_t Morton order benchmark", "[.][benchmark]") {
+    std::mt19937 rng(75);
+    auto triangles = get_random_triangles(rng, N_RANDOM_TRIANGLES_LBVH);
+    auto rays      = get_random_rays(rng, N_BENCHMARK_RAYS);
+    auto scene     = make_scene(triangles);
+    scene.build_acc();
+
+    constexpr size_t cache_line_size = 64;
+    constexpr size_t page_size       = 4096;
+    const double lines_before        = count_touched_blocks(scene, rays, cache_line_size);
+    const double pages_before        = count_touched_blocks(scene, rays, page_size);
+    sycl::queue queue(sycl::default_selector_v);
+    const double gain        = scene.sort_shapes(queue);
+    const double lines_after = count_touched_blocks(scene, rays, cache_line_size);
+    const double pages_after = count_touched_blocks(scene, rays, page_size);
+
+    WARN("Neighbour distance gain of the Morton order: " << gain);
+    WARN("Cache lines touched per ray, given order: " << lines_before << ", Morton order: " << lines_after);
+    WARN("Pages touched per ray, given order: " << pages_before << ", Morton order: " << pages_after);
+}
@@ -1,9 +1,13 @@
+#include "entities/Octahedral.hpp"
 #include "shapes/Triangle_t.hpp"
 #include <array>
 #include <catch2/catch_test_macros.hpp>
+#include <cmath>
 #include <iostream>
 #include <numbers>
+#include <random>
 #include <sycl/sycl.hpp>
+#include <vector>
 
 using AGPTracer::Entities::TransformMatrix_t;
 using AGPTracer::Entities::Vec3;
@@ -18,18 +22,18 @@ constexpr size_t TRIANGLE_BUFFER_SIZE = 12;
 
 auto get_triangles() -> std::array<Triangle_t<double>, TRIANGLE_BUFFER_SIZE> {
     return {
-        Triangle_t<double>{0, TransformMatrix_t{}, std::array<Vec3<double>, 3>{Vec3<double>{0, 2, 0}, Vec3<double>{1, 2, 0}, Vec3<double>{0, 2, 1}}, {}, {}},
-        Triangle_t<double>{0, TransformMatrix_t{}, std::array<Vec3<double>, 3>{Vec3<double>{1, 2, 0}, Vec3<double>{1, 2, 1}, Vec3<double>{0, 2, 1}}, {}, {}},
-        Triangle_t<double>{0, TransformMatrix_t{}, std::array<Vec3<double>, 3>{Vec3<double>{1, 3, 0}, Vec3<double>{0, 3, 0}, Vec3<double>{0, 3, 1}}, {}, {}},
-        Triangle_t<double>{0, TransformMatrix_t{}, std::array<Vec3<double>, 3>{Vec3<double>{0, 3, 1}, Vec3<double>{1, 3, 1}, Vec3<double>{1, 3, 0}}, {}, {}},
-        Triangle_t<double>{0, TransformMatrix_t{}, std::array<Vec3<double>, 3>{Vec3<double>{1, 2, 0}, Vec3<double>{0, 2, 0}, Vec3<double>{0, 3, 0}}, {}, {}},
-        Triangle_t<double>{0, TransformMatrix_t{}, std::array<Vec3<double>, 3>{Vec3<double>{0, 3, 0}, Vec3<double>{1, 3, 0}, Vec3<double>{1, 2, 0}}, {}, {}},
-        Triangle_t<double>{0, TransformMatrix_t{}, std::array<Vec3<double>, 3>{Vec3<double>{0, 3, 1}, Vec3<double>{0, 2, 1}, Vec3<double>{1, 2, 1}}, {}, {}},
-        Triangle_t<double>{0, TransformMatrix_t{}, std::array<Vec3<double>, 3>{Vec3<double>{1, 2, 1}, Vec3<double>{1, 3, 1}, Vec3<double>{0, 3, 1}}, {}, {}},
-        Triangle_t<double>{0, TransformMatrix_t{}, std::array<Vec3<double>, 3>{Vec3<double>{1, 3, 1}, Vec3<double>{1, 2, 1}, Vec3<double>{1, 2, 0}}, {}, {}},
-        Triangle_t<double>{0, TransformMatrix_t{}, std::array<Vec3<double>, 3>{Vec3<double>{1, 2, 0}, Vec3<double>{1, 3, 0}, Vec3<double>{1, 3, 1}}, {}, {}},
-        Triangle_t<double>{0, TransformMatrix_t{}, std::array<Vec3<double>, 3>{Vec3<double>{0, 2, 0}, Vec3<double>{0, 2, 1}, Vec3<double>{0, 3, 1}}, {}, {}},
-        Triangle_t<double>{0, TransformMatrix_t{}, std::array<Vec3<double>, 3>{Vec3<double>{0, 3, 1}, Vec3<double>{0, 3, 0}, Vec3<double>{0, 2, 0}}, {}, {}}
+        Triangle_t<double>{0, 0, std::array<Vec3<double>, 3>{Vec3<double>{0, 2, 0}, Vec3<double>{1, 2, 0}, Vec3<double>{0, 2, 1}}, {}, {}},
+        Triangle_t<double>{0, 0, std::array<Vec3<double>, 3>{Vec3<double>{1, 2, 0}, Vec3<double>{1, 2, 1}, Vec3<double>{0, 2, 1}}, {}, {}},
+        Triangle_t<double>{0, 0, std::array<Vec3<double>, 3>{Vec3<double>{1, 3, 0}, Vec3<double>{0, 3, 0}, Vec3<double>{0, 3, 1}}, {}, {}},
+        Triangle_t<double>{0, 0, std::array<Vec3<double>, 3>{Vec3<double>{0, 3, 1}, Vec3<double>{1, 3, 1}, Vec3<double>{1, 3, 0}}, {}, {}},
+        Triangle_t<double>{0, 0, std::array<Vec3<double>, 3>{Vec3<double>{1, 2, 0}, Vec3<double>{0, 2, 0}, Vec3<double>{0, 3, 0}}, {}, {}},
+        Triangle_t<double>{0, 0, std::array<Vec3<double>, 3>{Vec3<double>{0, 3, 0}, Vec3<double>{1, 3, 0}, Vec3<double>{1, 2, 0}}, {}, {}},
+        Triangle_t<double>{0, 0, std::array<Vec3<double>, 3>{Vec3<double>{0, 3, 1}, Vec3<double>{0, 2, 1}, Vec3<double>{1, 2, 1}}, {}, {}},
+        Triangle_t<double>{0, 0, std::array<Vec3<double>, 3>{Vec3<double>{1, 2, 1}, Vec3<double>{1, 3, 1}, Vec3<double>{0, 3, 1}}, {}, {}},
+        Triangle_t<double>{0, 0, std::array<Vec3<double>, 3>{Vec3<double>{1, 3, 1}, Vec3<double>{1, 2, 1}, Vec3<double>{1, 2, 0}}, {}, {}},
+        Triangle_t<double>{0, 0, std::array<Vec3<double>, 3>{Vec3<double>{1, 2, 0}, Vec3<double>{1, 3, 0}, Vec3<double>{1, 3, 1}}, {}, {}},
+        Triangle_t<double>{0, 0, std::array<Vec3<double>, 3>{Vec3<double>{0, 2, 0}, Vec3<double>{0, 2, 1}, Vec3<double>{0, 3, 1}}, {}, {}},
+        Triangle_t<double>{0, 0, std::array<Vec3<double>, 3>{Vec3<double>{0, 3, 1}, Vec3<double>{0, 3, 0}, Vec3<double>{0, 2, 0}}, {}, {}}
     };
 }
 
@@ -58,8 +62,9 @@ TEST_CASE("TransformMatrix_t rotation", "Compares a triangle rotation between ho
         auto triangle_accessor = triangle_buffer.get_access<sycl::access::mode::read_write>(cgh);
         // Executing kernel
         cgh.parallel_for<class RotateTriangles>(num_work_items, [=](sycl::id<1> WIid) {
-            triangle_accessor[WIid].transformation_.rotateZAxis(std::numbers::pi / 4);
-            triangle_accessor[WIid].update();
+            TransformMatrix_t<double> transformation;
+            transformation.rotateZAxis(std::numbers::pi / 4);
+            triangle_accessor[WIid].update(transformation);
         });
     });
 
@@ -70,11 +75,101 @@ TEST_CASE("TransformMatrix_t rotation", "Compares a triangle rotation between ho
     const auto triangles = get_triangles();
     for (size_t i = 0; i < triangle_buffer.get_range()[0]; ++i) {
         Triangle_t<double> triangle = triangles[i];
-        triangle.transformation_.rotateZAxis(std::numbers::pi / 4);
-        triangle.update();
+        TransformMatrix_t<double> transformation;
+        transformation.rotateZAxis(std::numbers::pi / 4);
+        triangle.update(transformation);
 
         for (size_t j = 0; j < host_accessor[i].points_.size(); ++j) {
             REQUIRE(host_accessor[i].points_[j] == triangle.points_[j]);
         }
     }
 }
+
+TEST_CASE("Triangle_t quantised shading attributes", "Compares the normal, texture coordinates and tangent decoded on the device to the ones computed from the full precision attributes") {
+    constexpr size_t n_triangles = 256;
+    std::mt19937 rng(70);
+    std::uniform_real_distribution<double> unif(-1, 1);
+    std::uniform_real_distribution<double> unit(0, 1);
+    std::normal_distribution<double> gaussian(0, 1);
+
+    // Decoding an encoded direction and encoding it again gives back the same bits, so attributes can be decoded and encoded again without drift
+    for (size_t i = 0; i < 10000; ++i) {
+        const Vec3<double> direction = Vec3<double>(gaussian(rng), gaussian(rng), gaussian(rng)).normalize_inplace();
+        const uint32_t encoded       = AGPTracer::Entities::Octahedral::encode(direction);
+        const Vec3<double> decoded   = AGPTracer::Entities::Octahedral::decode<double>(encoded);
+        REQUIRE(std::acos(std::min(decoded.dot(direction), 1.0)) < 1e-4);
+        REQUIRE(AGPTracer::Entities::Octahedral::encode(decoded) == encoded);
+        REQUIRE(AGPTracer::Entities::Octahedral::encode(AGPTracer::Entities::Octahedral::decode<float>(encoded)) == encoded);
+    }
+
+    std::vector<Triangle_t<double>> triangles;
+    std::vector<TransformMatrix_t<double>> transformations(n_triangles);
+    std::vector<std::array<Vec3<double>, 3>> normals(n_triangles);
+    std::vector<std::array<std::array<double, 2>, 3>> texture_coordinates(n_triangles);
+    std::vector<std::array<double, 2>> uvs(n_triangles);
+    triangles.reserve(n_triangles);
+    for (size_t i = 0; i < n_triangles; ++i) {
+        const std::array<Vec3<double>, 3> points{Vec3<double>(unif(rng), unif(rng), unif(rng)), Vec3<double>(unif(rng), unif(rng), unif(rng)), Vec3<double>(unif(rng), unif(rng), unif(rng))};
+        const Vec3<double> face_normal = (points[1] - points[0]).cross(points[2] - points[0]).normalize_inplace();
+        for (size_t j = 0; j < 3; ++j) {
+            normals[i][j]             = (face_normal + Vec3<double>(unif(rng), unif(rng), unif(rng)) * 0.2).normalize_inplace();
+            texture_coordinates[i][j] = {unit(rng), unit(rng)};
+        }
+        uvs[i] = {unit(rng) / 2, unit(rng) / 2};
+
+        transformations[i].rotateXAxis(unif(rng)).rotateZAxis(unif(rng)).translate(Vec3<double>(unif(rng), unif(rng), unif(rng)));
+        triangles.emplace_back(i, 0, points, normals[i], texture_coordinates[i]);
+        triangles.back().update(transformations[i]);
+    }
+
+    struct Shading_t {
+            Vec3<double> normal;
+            std::array<double, 2> texture_coordinates;
+            Vec3<double> tangent;
+    };
+
+    sycl::buffer<Triangle_t<double>, 1> triangle_buffer(triangles.data(), sycl::range<1>{n_triangles});
+    sycl::buffer<std::array<double, 2>, 1> uv_buffer(uvs.data(), sycl::range<1>{n_triangles});
+    sycl::buffer<Shading_t, 1> shading_buffer(sycl::range<1>{n_triangles});
+    sycl::queue queue(sycl::default_selector_v);
+    queue.submit([&](sycl::handler& cgh) {
+        auto triangle_accessor = triangle_buffer.get_access<sycl::access::mode::read>(cgh);
+        auto uv_accessor       = uv_buffer.get_access<sycl::access::mode::read>(cgh);
+        auto shading_accessor  = shading_buffer.get_access<sycl::access::mode::discard_write>(cgh);
+
+        cgh.parallel_for<class ShadeTriangles>(sycl::range<1>{n_triangles}, [=](sycl::id<1> WIid) {
+            Shading_t shading{};
+            shading.normal         = triangle_accessor[WIid].normal_uv_tangent(0.0, uv_accessor[WIid], shading.texture_coordinates, shading.tangent);
+            shading_accessor[WIid] = shading;
+        });
+    });
+
+    const sycl::host_accessor<Shading_t, 1, sycl::access_mode::read> shading_accessor(shading_buffer);
+    for (size_t i = 0; i < n_triangles; ++i) {
+        REQUIRE(triangles[i].material_ == i);
+
+        const Vec3<double> distance(1 - uvs[i][0] - uvs[i][1], uvs[i][0], uvs[i][1]);
+        Vec3<double> normal(0.0);
+        for (size_t j = 0; j < 3; ++j) {
+            normal += transformations[i].multDir(normals[i][j]) * distance[j];
+        }
+        REQUIRE((shading_accessor[i].normal - normal).magnitude() < 1e-4);
+
+        for (size_t k = 0; k < 2; ++k) {
+            const double texture_coordinate = distance[0] * texture_coordinates[i][0][k] + distance[1] * texture_coordinates[i][1][k] + distance[2] * texture_coordinates[i][2][k];
+            REQUIRE(std::abs(shading_accessor[i].texture_coordinates[k] - texture_coordinate) < 1e-3);
+        }
+
+        // The tangent follows the texture coordinates, whose half precision error is amplified when they are close together
+        const std::array<double, 2> tuv0v1 = {texture_coordinates[i][1][0] - texture_coordinates[i][0][0], texture_coordinates[i][1][1] - texture_coordinates[i][0][1]};
+        const std::array<double, 2> tuv0v2 = {texture_coordinates[i][2][0] - texture_coordinates[i][0][0], texture_coordinates[i][2][1] - texture_coordinates[i][0][1]};
+        const double determinant           = tuv0v1[0] * tuv0v2[1] - tuv0v1[1] * tuv0v2[0];
+        if (std::abs(determinant) > 0.1) {
+            const Vec3<double> tangent = (triangles[i].v0v1_ * -tuv0v2[0] + triangles[i].v0v2_ * tuv0v1[0]) / determinant;
+            REQUIRE((shading_accessor[i].tangent - tangent.cross(normal).normalize_inplace()).magnitude() < 1e-2);
+        }
+    }
+
+    // Normals, tangent and texture coordinates take 40 bytes instead of 216
+    REQUIRE(sizeof(triangles[0].normals_orig_) + sizeof(triangles[0].normals_) + sizeof(triangles[0].tangent_vec_) + sizeof(triangles[0].texture_coordinates_) == 40);
+}